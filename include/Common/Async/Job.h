@@ -18,6 +18,7 @@
 #pragma once
 #include "Common/Macros.h"
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -39,6 +40,9 @@ public:
 	void AddDependency( std::weak_ptr< Job > Job );
 	bool CanRun       ( void ) const;
 
+	// Marks a job that was deferred with JobSystem::Defer() as finished, which lets the jobs that depend on it run
+	void Finish       ( void ) { m_HasFinishedRunning = true; }
+
 //////////////////////////////////////////////////////////////////////////
 
 private:
@@ -46,7 +50,8 @@ private:
 	std::vector< std::weak_ptr< Job > > m_Dependencies       = { };
 	std::function< void( void ) >       m_Function           = { };
 
-	bool                                m_HasFinishedRunning = false;
+	std::atomic< bool >                 m_HasFinishedRunning = false;
+	bool                                m_Deferred           = false;
 
 }; // Job
 
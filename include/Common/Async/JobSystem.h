@@ -19,6 +19,7 @@
 #include "Common/Async/Job.h"
 #include "Common/Macros.h"
 
+#include <atomic>
 #include <deque>
 #include <mutex>
 #include <span>
@@ -42,12 +43,17 @@ public:
 
 //////////////////////////////////////////////////////////////////////////
 
-	void StartThreads( size_t ThreadCount );
+	void StartThreads  ( size_t ThreadCount );
+	void ReserveThreads( size_t ThreadCount );
 
 //////////////////////////////////////////////////////////////////////////
 
 	template< typename Functor > JobPtr NewJob( Functor&& rrFunctor, std::span< JobPtr > Dependencies = { } );
 
+	// Keeps the job that is running on this thread from finishing when it returns. For jobs that hand their work off (e.g. to the
+	// ProcessReactor), so that the jobs depending on them wait for the real result. Call Finish() on the returned job once that is in.
+	JobPtr Defer( void );
+
 //////////////////////////////////////////////////////////////////////////
 
 private:
@@ -57,11 +63,12 @@ private:
 
 //////////////////////////////////////////////////////////////////////////
 
-	std::vector< std::thread > m_Threads   = { };
-	std::deque< JobPtr >       m_Jobs      = { };
-	std::mutex                 m_JobsMutex = { };
+	std::vector< std::thread > m_Threads      = { };
+	std::deque< JobPtr >       m_Jobs         = { };
+	std::mutex                 m_JobsMutex    = { };
+	std::mutex                 m_ThreadsMutex = { };
 
-	bool                       m_Running   = false;
+	std::atomic< bool >        m_Running      = false; // Read by the threads without the lock
 
 }; // JobSystem
 
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include "Common/Macros.h"
+
+#include <filesystem>
+#include <string_view>
+
+#if defined( _WIN32 )
+#include <Windows.h>
+#endif // _WIN32
+
+//////////////////////////////////////////////////////////////////////////
+
+// Replaces a file all at once. Everything is written to a temporary file next to it, which Commit() flushes to disk and renames over
+// the old file, so that a crash or a failed write half-way leaves the old file the way it was. Nothing is replaced unless committed.
+class AtomicFile
+{
+	GENO_DISABLE_COPY_AND_MOVE( AtomicFile );
+
+//////////////////////////////////////////////////////////////////////////
+
+public:
+
+	 AtomicFile( void ) = default;
+	~AtomicFile( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool Open   ( const std::filesystem::path& rPath );
+	bool Write  ( std::string_view Bytes );
+	bool Commit ( void );
+	void Discard( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	void CloseTemporary( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::filesystem::path m_Path;
+	std::filesystem::path m_TemporaryPath;
+
+#if defined( _WIN32 )
+
+	HANDLE m_File = INVALID_HANDLE_VALUE;
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	int m_Descriptor = -1;
+
+#endif // __linux__ || __APPLE__
+
+}; // AtomicFile
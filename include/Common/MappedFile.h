@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include "Common/Macros.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+#if defined( _WIN32 )
+#include <Windows.h>
+#endif // _WIN32
+
+//////////////////////////////////////////////////////////////////////////
+
+// A read-only file that is looked at through mappings of parts of it, so that a file larger than memory (or the address space) can be
+// read without loading it. Only the pages of a view that are actually touched are read in, and they are let go of with the view.
+// Mapping is const and may be done from several threads at once.
+class MappedFile
+{
+	GENO_DISABLE_COPY_AND_MOVE( MappedFile );
+
+//////////////////////////////////////////////////////////////////////////
+
+public:
+
+	class View
+	{
+		GENO_DISABLE_COPY( View );
+
+	//////////////////////////////////////////////////////////////////////////
+
+	public:
+
+		 View( void ) = default;
+		 View( View&& rrOther ) noexcept;
+		~View( void );
+
+		View& operator=( View&& rrOther ) noexcept;
+
+	//////////////////////////////////////////////////////////////////////////
+
+		std::string_view Data  ( void ) const { return m_Data; }
+		uint64_t         Offset( void ) const { return m_Offset; }
+
+	//////////////////////////////////////////////////////////////////////////
+
+	private:
+
+		friend class MappedFile;
+
+		void Unmap( void );
+
+	//////////////////////////////////////////////////////////////////////////
+
+		void*            m_pMapping    = nullptr; // Starts on an allocation boundary at or before the data
+		size_t           m_MappingSize = 0;
+		uint64_t         m_Offset      = 0;
+		std::string_view m_Data;
+
+	}; // View
+
+//////////////////////////////////////////////////////////////////////////
+
+	 MappedFile( void ) = default;
+	~MappedFile( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool Open ( const std::filesystem::path& rPath );
+	void Close( void );
+
+	// The view is cut short at the end of the file, and is empty if mapping failed
+	View Map( uint64_t Offset, size_t Length ) const;
+
+	uint64_t Size  ( void ) const { return m_Size; }
+	bool     IsOpen( void ) const;
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	uint64_t m_Size = 0;
+
+#if defined( _WIN32 )
+
+	HANDLE m_File    = INVALID_HANDLE_VALUE;
+	HANDLE m_Mapping = nullptr;
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	int m_Descriptor = -1;
+
+#endif // __linux__ || __APPLE__
+
+}; // MappedFile
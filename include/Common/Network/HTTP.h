@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include "Common/Macros.h"
+#include "Common/Network/Socket.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+//////////////////////////////////////////////////////////////////////////
+
+// Just enough HTTP/1.1 to talk to an artifact cache: keep-alive connections, Content-Length and chunked bodies.
+// Requests may be pipelined, since each connection buffers whatever it read past the end of the previous message.
+namespace HTTP
+{
+	struct URL
+	{
+		std::string Host;
+		std::string Port;
+		std::string Path;
+
+		std::string Endpoint( void ) const { return Host + ":" + Port; }
+
+	}; // URL
+
+	struct Request
+	{
+		std::string Method;
+		std::string Path;
+		std::string Body;
+		bool        KeepAlive = true;
+
+	}; // Request
+
+	struct Response
+	{
+		int         Status    = 0;
+		std::string Body;
+		bool        KeepAlive = true;
+
+	}; // Response
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Only plain 'http://host[:port][/path]' URL's are understood
+	std::optional< URL > ParseURL( std::string_view Text );
+
+//////////////////////////////////////////////////////////////////////////
+
+	class Connection
+	{
+		GENO_DISABLE_COPY( Connection );
+		GENO_DEFAULT_MOVE( Connection );
+
+	//////////////////////////////////////////////////////////////////////////
+
+	public:
+
+		 Connection( void ) = default;
+		 explicit Connection( Socket Socket ) : m_Socket( std::move( Socket ) ) { }
+
+		 explicit operator bool( void ) const { return static_cast< bool >( m_Socket ); }
+
+	//////////////////////////////////////////////////////////////////////////
+
+		bool                      SendRequest    ( std::string_view Host, const Request& rRequest );
+		bool                      SendResponse   ( const Response& rResponse );
+		std::optional< Request >  ReceiveRequest ( size_t MaxBodySize );
+		std::optional< Response > ReceiveResponse( size_t MaxBodySize );
+		void                      Close          ( void );
+
+	//////////////////////////////////////////////////////////////////////////
+
+	private:
+
+		bool ReadHead   ( std::string& rHead );
+		bool ReadBody   ( std::string_view Head, std::string& rBody, size_t MaxBodySize, bool& rUntilClose );
+		bool ReadLine   ( std::string& rLine );
+		bool ReadExactly( size_t Size, std::string& rOut );
+		bool Fill       ( void );
+
+	//////////////////////////////////////////////////////////////////////////
+
+		Socket      m_Socket;
+		std::string m_Buffer;
+
+	}; // Connection
+
+} // HTTP
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////
+
+// Protocol spoken between Geno and geno-worker. Each message is sent as a single frame (see Socket::SendFrame) that starts with its type.
+namespace RemoteCompile
+{
+	constexpr uint32_t         ProtocolVersion   = 2;
+	constexpr size_t           MaxFrameSize      = 512 * 1024 * 1024;
+	constexpr std::string_view DefaultEndpoint   = "127.0.0.1:7820";
+
+	// The worker replaces arguments that are exactly these with the paths of its own copy of the input and of the object it should produce
+	constexpr std::string_view InputPlaceholder  = "{input}";
+	constexpr std::string_view OutputPlaceholder = "{output}";
+
+//////////////////////////////////////////////////////////////////////////
+
+	enum class MessageType : uint8_t
+	{
+		Hello = 1,
+		CompileRequest,
+		CompileResult,
+
+	}; // MessageType
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Sent by the client when it connects. The worker answers with its own version and the number of jobs it runs concurrently.
+	struct Hello
+	{
+		uint32_t Version = ProtocolVersion;
+		uint32_t Slots   = 0;
+
+	}; // Hello
+
+	// The worker runs one of the compilers that it was told to trust, picked by its file name (e.g. "g++"), directly and without a shell.
+	// Arguments that could make the compiler run or load other programs, or write anywhere but the output, are refused.
+	struct CompileRequest
+	{
+		std::string                Compiler;
+		std::vector< std::string > Arguments;
+		std::string                Source;
+
+	}; // CompileRequest
+
+	struct CompileResult
+	{
+		int32_t     ExitCode = -1;
+		std::string Diagnostics;
+		std::string Object;
+
+	}; // CompileResult
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::string Encode( const Hello& rHello );
+	std::string Encode( const CompileRequest& rRequest );
+	std::string Encode( const CompileResult& rResult );
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::optional< MessageType >    TypeOf              ( std::string_view Frame );
+	std::optional< Hello >          DecodeHello         ( std::string_view Frame );
+	std::optional< CompileRequest > DecodeCompileRequest( std::string_view Frame );
+	std::optional< CompileResult >  DecodeCompileResult ( std::string_view Frame );
+
+} // RemoteCompile
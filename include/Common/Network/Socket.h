@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include "Common/Macros.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+//////////////////////////////////////////////////////////////////////////
+
+#if defined( _WIN32 )
+using SocketHandle = uintptr_t;
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+using SocketHandle = int;
+#endif // __linux__ || __APPLE__
+
+//////////////////////////////////////////////////////////////////////////
+
+// Stream socket. Endpoints are either written as 'host:port' for TCP or as 'unix:/path/to/socket' for a local socket.
+class Socket
+{
+	GENO_DISABLE_COPY( Socket );
+
+//////////////////////////////////////////////////////////////////////////
+
+public:
+
+#if defined( _WIN32 )
+	static constexpr SocketHandle InvalidHandle = ~SocketHandle( 0 );
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+	static constexpr SocketHandle InvalidHandle = -1;
+#endif // __linux__ || __APPLE__
+
+//////////////////////////////////////////////////////////////////////////
+
+	 Socket( void ) = default;
+	~Socket( void ) { Close(); }
+	 Socket( Socket&& rrOther ) noexcept;
+
+	 Socket& operator=( Socket&& rrOther ) noexcept;
+
+	 explicit operator bool( void ) const { return m_Handle != InvalidHandle; }
+
+//////////////////////////////////////////////////////////////////////////
+
+	// A timeout makes connecting, sending and receiving give up once nothing has happened for that long. Zero waits forever.
+	static Socket Connect( std::string_view Endpoint, std::chrono::milliseconds Timeout = { } );
+	static Socket Listen ( std::string_view Endpoint );
+
+//////////////////////////////////////////////////////////////////////////
+
+	Socket Accept     ( void );
+	void   Close      ( void );
+	bool   SetTimeout ( std::chrono::milliseconds Timeout );
+	bool   Send       ( const void* pData, size_t Size );
+	bool   Receive    ( void* pData, size_t Size );
+	size_t ReceiveSome( void* pData, size_t MaxSize );
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Frames are prefixed with their size, so that the receiver knows how much to read
+	bool                         SendFrame   ( std::string_view Frame );
+	std::optional< std::string > ReceiveFrame( size_t MaxSize );
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	explicit Socket( SocketHandle Handle ) : m_Handle( Handle ) { }
+
+//////////////////////////////////////////////////////////////////////////
+
+	SocketHandle m_Handle   = InvalidHandle;
+
+	// Listening local sockets leave a file behind, which is removed again when the socket is closed
+	std::string  m_UnixPath = { };
+
+}; // Socket
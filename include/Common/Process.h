@@ -17,16 +17,23 @@
 
 #pragma once
 
+#include <chrono>
+#include <functional>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
  //////////////////////////////////////////////////////////////////////////
 
 #if defined( _WIN32 )
 #include <Windows.h>
-using ProcessID = HANDLE;
+using ProcessID  = HANDLE;
+using PipeHandle = HANDLE;
 #elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
-using ProcessID = pid_t;
+using ProcessID  = pid_t;
+using PipeHandle = int;
 #endif // __linux__ || __APPLE__
 
 //////////////////////////////////////////////////////////////////////////
@@ -34,6 +41,20 @@ using ProcessID = pid_t;
 class Process
 {
 public:
+
+	 using OutputCallback = std::function< void( std::string_view Output ) >;
+
+	 struct Captured
+	 {
+		 std::string StdOut;
+		 std::string StdErr;
+		 int         ExitCode = -1;
+		 bool        TimedOut = false;
+
+	 }; // Captured
+
+//////////////////////////////////////////////////////////////////////////
+
 	 Process( void ) { }
 	 Process( const std::wstring_view& rCommandLine );
 	~Process( void ) { Kill(); }
@@ -45,11 +66,14 @@ public:
 		 return *this = Process( rOther );
 	 }
 
-	 Process& operator=( const Process&& rrOther ) noexcept
+	 Process& operator=( Process&& rrOther ) noexcept
 	 {
-		 m_CommandLine = rrOther.m_CommandLine;
-		 m_ExitCode = rrOther.m_ExitCode;
-		 m_Pid = rrOther.m_Pid;
+		 // The other process must let go of the pid, or it would kill the process when it is destroyed
+		 m_CommandLine = std::exchange( rrOther.m_CommandLine, std::wstring_view() );
+		 m_Arguments   = std::move( rrOther.m_Arguments );
+		 m_Environment = std::move( rrOther.m_Environment );
+		 m_ExitCode    = std::exchange( rrOther.m_ExitCode, 0 );
+		 m_Pid         = std::exchange( rrOther.m_Pid, ProcessID() );
 
 		 return *this;
 	 }
@@ -62,17 +86,44 @@ public:
 
 //////////////////////////////////////////////////////////////////////////
 
-	 void         SetCommandLine( const std::wstring_view& rCommandLine ) { m_CommandLine = rCommandLine; }
-	 void         Kill          ( void );
-	 void         Start         ( FILE* pOutputStream );
-	 int          Wait          ( void );
-	 int          ResultOf      ( void );
-	 std::wstring OutputOf      ( int& rResult );
-	 std::wstring OutputOf      ( void );
+	 void         SetCommandLine        ( const std::wstring_view& rCommandLine ) { m_CommandLine = rCommandLine; }
+
+	 // Runs the executable at Arguments[ 0 ] directly, with exactly these arguments, instead of the command line. Nothing is looked up in
+	 // PATH, and no shell gets to interpret any of it.
+	 void         SetArguments          ( std::vector< std::string > Arguments )  { m_Arguments = std::move( Arguments ); }
+	 void         AddEnvironmentVariable( std::wstring Name, std::wstring Value ) { m_Environment.emplace_back( std::move( Name ), std::move( Value ) ); }
+	 void         Kill                  ( void );
+	 // Returns false if the process couldn't be started, which leaves nothing for Wait() or Kill() to do
+	 bool         Start                 ( FILE* pOutputStream ) { return Start( pOutputStream, pOutputStream ); }
+	 bool         Start                 ( FILE* pOutputStream, FILE* pErrorStream );
+	 int          Wait                  ( void );
+	 int          ResultOf              ( void );
+	 std::wstring OutputOf              ( int& rResult );
+	 std::wstring OutputOf              ( void );
+
+	 // Runs the process and passes its combined stdout and stderr to the callback as it arrives. Returns the same as Wait().
+	 int          Stream                ( const OutputCallback& rCallback );
+
+	 // Runs the process and passes stdout and stderr to their own callbacks as they arrive. Both pipes are read while the process
+	 // runs, so it never blocks on a full pipe. A process that hasn't finished by the timeout is killed, and nothing is returned.
+	 // Otherwise, returns the same as Wait(), or -1 if the process couldn't be started.
+	 std::optional< int > Stream( const OutputCallback& rOnStdOut, const OutputCallback& rOnStdErr, std::optional< std::chrono::milliseconds > Timeout = std::nullopt );
+
+	 // Same as above, collecting the output
+	 Captured     Capture               ( std::optional< std::chrono::milliseconds > Timeout = std::nullopt );
+
+	 // Starts the process with its combined stdout and stderr going into a new pipe, and returns the end to read from. The caller closes it.
+	 std::optional< PipeHandle > StartPiped( void );
+
+	 ProcessID    GetPid                ( void ) const { return m_Pid; }
 
 private:
 
-	std::wstring_view m_CommandLine;
+	std::wstring_view                                       m_CommandLine;
+	std::vector< std::string >                              m_Arguments;
+
+	// Set for the child on top of our own environment
+	std::vector< std::pair< std::wstring, std::wstring > > m_Environment;
 
 	int m_ExitCode  = 0;
 
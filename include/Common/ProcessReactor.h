@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include "Common/Macros.h"
+#include "Common/Process.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+//////////////////////////////////////////////////////////////////////////
+
+// Watches child processes and their output, so that no job has to block on a process to learn that it has exited.
+// On Linux, one thread watches every child through a pidfd and its output pipe in an epoll set. Kernels without pidfd_open are
+// told about exits through SIGCHLD instead, and a child that can be watched neither way (e.g. because the process is out of descriptors)
+// is handed to a thread of its own that drains the output and waits for it. That is what other platforms do for every child.
+class ProcessReactor
+{
+	GENO_SINGLETON( ProcessReactor );
+
+	 ProcessReactor( void );
+	~ProcessReactor( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+public:
+
+	using OutputCallback = std::function< void( std::string_view Output ) >;
+	using ExitCallback   = std::function< void( int ExitCode ) >;
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Starts the process and takes it over. Its command line only has to outlive this call. OnOutput is called from the reactor
+	// thread as the combined stdout and stderr come in, so it should be quick. Once the process has exited and all of its output
+	// has been read, OnExit is run as a job with the same result that Process::Wait() would have returned.
+	bool Spawn( Process Child, OutputCallback OnOutput, ExitCallback OnExit );
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+#if defined( __linux__ )
+
+	struct Child
+	{
+		Process        Handle;
+		OutputCallback OnOutput;
+		ExitCallback   OnExit;
+		int            Output       = -1;
+		int            PidFd        = -1;
+		int            ExitCode     = 0;
+		bool           OutputClosed = false;
+		bool           Exited       = false;
+
+	}; // Child
+
+//////////////////////////////////////////////////////////////////////////
+
+	void ThreadEntry ( void );
+	void ReadOutput  ( Child& rChild );
+	void CheckExited ( Child& rChild );
+	void FinishIfDone( uint64_t Key, Child& rChild );
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::mutex                                     m_Mutex;
+	std::map< uint64_t, std::unique_ptr< Child > > m_Children;
+	std::thread                                    m_Thread;
+	std::atomic< bool >                            m_Running  = false;
+	uint64_t                                       m_NextKey  = 0;
+	int                                            m_Epoll    = -1;
+	int                                            m_Wake     = -1;
+	bool                                           m_UsePidFd = false;
+
+#endif // __linux__
+
+}; // ProcessReactor
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include "Common/Macros.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#if defined( _WIN32 )
+#include <Windows.h>
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+#include <sys/types.h>
+#endif // __linux__ || __APPLE__
+
+//////////////////////////////////////////////////////////////////////////
+
+// Runs a command on a pseudo terminal, so that it sees an interactive console: line buffered output, colors, and input that is
+// echoed and line-edited by the terminal driver. The output is a stream of bytes with ANSI escape sequences in it.
+class PseudoTerminal
+{
+	GENO_DISABLE_COPY_AND_MOVE( PseudoTerminal );
+
+//////////////////////////////////////////////////////////////////////////
+
+public:
+
+	 PseudoTerminal( void ) = default;
+	~PseudoTerminal( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool Start ( std::wstring_view CommandLine, uint16_t Columns, uint16_t Rows );
+	void Resize( uint16_t Columns, uint16_t Rows );
+	bool Write ( std::string_view Input );
+	void Kill  ( void );
+
+	// Blocks until there is output. Returns 0 once the program and everything it started have closed the terminal.
+	size_t Read( void* pBuffer, size_t MaxSize );
+
+	// Blocks until the program has exited and returns its exit code. A program that was killed by a signal returns 128 + the signal.
+	std::optional< int > Wait( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	// Guards the process against being signalled after it has been reaped, and the pseudo console against being resized after it was closed
+	std::mutex m_Mutex;
+
+#if defined( _WIN32 )
+
+	static DWORD WINAPI CloseWhenExited( LPVOID pParameter );
+
+	HPCON  m_PseudoConsole = nullptr;
+	HANDLE m_Input         = nullptr;
+	HANDLE m_Output        = nullptr;
+	HANDLE m_Process       = nullptr;
+	HANDLE m_Watcher       = nullptr;
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	int    m_Master        = -1;
+	pid_t  m_Pid           = 0;
+
+#endif // __linux__ || __APPLE__
+
+}; // PseudoTerminal
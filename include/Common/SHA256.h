@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Incremental SHA-256, as used for content-addressed cache keys
+class SHA256
+{
+public:
+
+	using Digest = std::array< uint8_t, 32 >;
+
+//////////////////////////////////////////////////////////////////////////
+
+	SHA256( void ) = default;
+
+//////////////////////////////////////////////////////////////////////////
+
+	void   Update( const void* pData, size_t Size );
+	void   Update( std::string_view Data ) { Update( Data.data(), Data.size() ); }
+	Digest Finish( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+	static std::string ToHex( const Digest& rDigest );
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	void Transform( const uint8_t* pBlock );
+
+//////////////////////////////////////////////////////////////////////////
+
+	uint32_t m_State[ 8 ]   = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+	uint8_t  m_Buffer[ 64 ] = { };
+	uint64_t m_TotalSize    = 0;
+	size_t   m_BufferSize   = 0;
+
+}; // SHA256
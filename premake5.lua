@@ -42,6 +42,7 @@ app( 'Geno' )
 			'opengl32',
 			'dwmapi',
 			'advapi32',
+			'ws2_32',
 		}
 
 	filter 'system:linux'
@@ -63,3 +64,22 @@ app( 'Geno' )
 			'AppKit.framework',
 			'OpenGL.framework',
 		}
+
+app( 'GenoWorker' )
+	kind 'ConsoleApp'
+	targetname 'geno-worker'
+
+	filter 'system:windows'
+		removefiles {
+			'src/%{prj.name}/Resources/win32-icons.rc',
+			'src/%{prj.name}/Resources/win32-resource.h',
+		}
+		links {
+			'ws2_32',
+		}
+
+	filter 'system:linux'
+		links {
+			'stdc++fs',
+			'pthread',
+		}
@@ -21,6 +21,10 @@
 
 //////////////////////////////////////////////////////////////////////////
 
+static thread_local JobSystem::JobPtr CurrentJob;
+
+//////////////////////////////////////////////////////////////////////////
+
 JobSystem::~JobSystem( void )
 {
 	StopThreads();
@@ -32,6 +36,9 @@ JobSystem::~JobSystem( void )
 void JobSystem::StartThreads( size_t ThreadCount )
 {
 	StopThreads();
+
+	std::scoped_lock Lock( m_ThreadsMutex );
+
 	m_Threads.clear();
 
 	m_Running = true;
@@ -43,11 +50,42 @@ void JobSystem::StartThreads( size_t ThreadCount )
 
 //////////////////////////////////////////////////////////////////////////
 
+void JobSystem::ReserveThreads( size_t ThreadCount )
+{
+	std::scoped_lock Lock( m_ThreadsMutex );
+
+	// Only ever grow. Jobs may spend most of their time waiting on other machines, so there can be more threads than cores.
+	while( m_Running && m_Threads.size() < ThreadCount )
+		m_Threads.emplace_back( &JobSystem::ThreadEntry, this );
+
+} // ReserveThreads
+
+//////////////////////////////////////////////////////////////////////////
+
+JobSystem::JobPtr JobSystem::Defer( void )
+{
+	if( CurrentJob )
+		CurrentJob->m_Deferred = true;
+
+	return CurrentJob;
+
+} // Defer
+
+//////////////////////////////////////////////////////////////////////////
+
 void JobSystem::StopThreads( void )
 {
-	m_Running = false;
+	std::vector< std::thread > Threads;
 
-	for( std::thread& rThread : m_Threads )
+	// A job may be waiting for the lock in ReserveThreads(), and it can only finish once it has it, so the threads are joined without it
+	{
+		std::scoped_lock Lock( m_ThreadsMutex );
+
+		m_Running = false;
+		Threads.swap( m_Threads );
+	}
+
+	for( std::thread& rThread : Threads )
 		rThread.join();
 
 } // StopThreads
@@ -80,8 +118,12 @@ void JobSystem::ThreadEntry( void )
 
 			if( Job )
 			{
+				CurrentJob = Job;
 				Job->m_Function();
-				Job->m_HasFinishedRunning = true;
+				CurrentJob = nullptr;
+
+				if( !Job->m_Deferred )
+					Job->m_HasFinishedRunning = true;
 			}
 		}
 
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "Common/AtomicFile.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#if defined( __linux__ ) || defined( __APPLE__ )
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#endif // __linux__ || __APPLE__
+
+//////////////////////////////////////////////////////////////////////////
+
+AtomicFile::~AtomicFile( void )
+{
+	Discard();
+
+} // ~AtomicFile
+
+//////////////////////////////////////////////////////////////////////////
+
+bool AtomicFile::Open( const std::filesystem::path& rPath )
+{
+	Discard();
+
+	std::error_code Error;
+
+	// Renaming over a symbolic link would replace the link rather than the file it points to
+	m_Path = std::filesystem::is_symlink( rPath, Error ) ? std::filesystem::canonical( rPath, Error ) : rPath;
+	if( Error )
+		m_Path = rPath;
+
+	m_TemporaryPath = m_Path;
+	m_TemporaryPath += ".saving";
+
+#if defined( _WIN32 )
+
+	m_File = CreateFileW( m_TemporaryPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( m_File == INVALID_HANDLE_VALUE )
+	{
+		std::cerr << "CreateFileW failed for " << m_TemporaryPath << " with " << GetLastError() << "\n";
+		m_TemporaryPath.clear();
+		return false;
+	}
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	// The new file gets the permissions of the one it replaces
+	struct stat Status;
+	const bool  Exists = stat( m_Path.c_str(), &Status ) == 0;
+
+	m_Descriptor = open( m_TemporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666 );
+	if( m_Descriptor < 0 )
+	{
+		std::cerr << "open failed for " << m_TemporaryPath << ": " << strerror( errno ) << "\n";
+		m_TemporaryPath.clear();
+		return false;
+	}
+
+	if( Exists )
+		fchmod( m_Descriptor, Status.st_mode & 07777 );
+
+#endif // __linux__ || __APPLE__
+
+	return true;
+
+} // Open
+
+//////////////////////////////////////////////////////////////////////////
+
+bool AtomicFile::Write( std::string_view Bytes )
+{
+
+#if defined( _WIN32 )
+
+	if( m_File == INVALID_HANDLE_VALUE )
+		return false;
+
+	while( !Bytes.empty() )
+	{
+		const DWORD ToWrite = static_cast< DWORD >( std::min< size_t >( Bytes.size(), 1u << 30 ) );
+		DWORD       Written = 0;
+
+		if( !WriteFile( m_File, Bytes.data(), ToWrite, &Written, nullptr ) )
+		{
+			std::cerr << "WriteFile failed for " << m_TemporaryPath << " with " << GetLastError() << "\n";
+			return false;
+		}
+
+		Bytes.remove_prefix( Written );
+	}
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	if( m_Descriptor < 0 )
+		return false;
+
+	while( !Bytes.empty() )
+	{
+		const ssize_t Written = write( m_Descriptor, Bytes.data(), Bytes.size() );
+
+		if( Written < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+
+			std::cerr << "write failed for " << m_TemporaryPath << ": " << strerror( errno ) << "\n";
+			return false;
+		}
+
+		Bytes.remove_prefix( static_cast< size_t >( Written ) );
+	}
+
+#endif // __linux__ || __APPLE__
+
+	return true;
+
+} // Write
+
+//////////////////////////////////////////////////////////////////////////
+
+bool AtomicFile::Commit( void )
+{
+
+#if defined( _WIN32 )
+
+	if( m_File == INVALID_HANDLE_VALUE )
+		return false;
+
+	// The data has to be on disk before the rename is, or a crash could leave the new name pointing at an empty file
+	const bool Flushed = FlushFileBuffers( m_File );
+
+	CloseTemporary();
+
+	if( !Flushed || !MoveFileExW( m_TemporaryPath.c_str(), m_Path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH ) )
+	{
+		std::cerr << "Failed to replace " << m_Path << " with " << GetLastError() << "\n";
+		Discard();
+		return false;
+	}
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	if( m_Descriptor < 0 )
+		return false;
+
+	// The data has to be on disk before the rename is, or a crash could leave the new name pointing at an empty file
+	const bool Flushed = fsync( m_Descriptor ) == 0;
+
+	CloseTemporary();
+
+	if( !Flushed || rename( m_TemporaryPath.c_str(), m_Path.c_str() ) != 0 )
+	{
+		std::cerr << "Failed to replace " << m_Path << ": " << strerror( errno ) << "\n";
+		Discard();
+		return false;
+	}
+
+	// And so does the rename itself
+	if( const int Directory = open( m_Path.parent_path().empty() ? "." : m_Path.parent_path().c_str(), O_RDONLY | O_CLOEXEC ); Directory >= 0 )
+	{
+		fsync( Directory );
+		close( Directory );
+	}
+
+#endif // __linux__ || __APPLE__
+
+	m_TemporaryPath.clear();
+
+	return true;
+
+} // Commit
+
+//////////////////////////////////////////////////////////////////////////
+
+void AtomicFile::Discard( void )
+{
+	CloseTemporary();
+
+	if( !m_TemporaryPath.empty() )
+	{
+		std::error_code Error;
+		std::filesystem::remove( m_TemporaryPath, Error );
+
+		m_TemporaryPath.clear();
+	}
+
+} // Discard
+
+//////////////////////////////////////////////////////////////////////////
+
+void AtomicFile::CloseTemporary( void )
+{
+
+#if defined( _WIN32 )
+
+	if( m_File != INVALID_HANDLE_VALUE )
+		CloseHandle( std::exchange( m_File, INVALID_HANDLE_VALUE ) );
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	if( m_Descriptor >= 0 )
+		close( std::exchange( m_Descriptor, -1 ) );
+
+#endif // __linux__ || __APPLE__
+
+} // CloseTemporary
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "Common/MappedFile.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#if defined( __linux__ ) || defined( __APPLE__ )
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#endif // __linux__ || __APPLE__
+
+//////////////////////////////////////////////////////////////////////////
+
+// Views have to start on a multiple of this
+static uint64_t MappingGranularity( void )
+{
+
+#if defined( _WIN32 )
+
+	static const uint64_t Granularity = []( void )
+	{
+		SYSTEM_INFO Info;
+		GetSystemInfo( &Info );
+		return static_cast< uint64_t >( Info.dwAllocationGranularity );
+	}();
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	static const uint64_t Granularity = static_cast< uint64_t >( sysconf( _SC_PAGESIZE ) );
+
+#endif // __linux__ || __APPLE__
+
+	return Granularity;
+
+} // MappingGranularity
+
+//////////////////////////////////////////////////////////////////////////
+
+MappedFile::View::View( View&& rrOther ) noexcept
+	: m_pMapping   ( std::exchange( rrOther.m_pMapping, nullptr ) )
+	, m_MappingSize( std::exchange( rrOther.m_MappingSize, 0 ) )
+	, m_Offset     ( std::exchange( rrOther.m_Offset, 0 ) )
+	, m_Data       ( std::exchange( rrOther.m_Data, std::string_view() ) )
+{
+} // View
+
+//////////////////////////////////////////////////////////////////////////
+
+MappedFile::View::~View( void )
+{
+	Unmap();
+
+} // ~View
+
+//////////////////////////////////////////////////////////////////////////
+
+MappedFile::View& MappedFile::View::operator=( View&& rrOther ) noexcept
+{
+	if( this != &rrOther )
+	{
+		Unmap();
+
+		m_pMapping    = std::exchange( rrOther.m_pMapping, nullptr );
+		m_MappingSize = std::exchange( rrOther.m_MappingSize, 0 );
+		m_Offset      = std::exchange( rrOther.m_Offset, 0 );
+		m_Data        = std::exchange( rrOther.m_Data, std::string_view() );
+	}
+
+	return *this;
+
+} // operator=
+
+//////////////////////////////////////////////////////////////////////////
+
+void MappedFile::View::Unmap( void )
+{
+	if( !m_pMapping )
+		return;
+
+#if defined( _WIN32 )
+	UnmapViewOfFile( m_pMapping );
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+	munmap( m_pMapping, m_MappingSize );
+#endif // __linux__ || __APPLE__
+
+	m_pMapping = nullptr;
+
+} // Unmap
+
+//////////////////////////////////////////////////////////////////////////
+
+MappedFile::~MappedFile( void )
+{
+	Close();
+
+} // ~MappedFile
+
+//////////////////////////////////////////////////////////////////////////
+
+bool MappedFile::Open( const std::filesystem::path& rPath )
+{
+	Close();
+
+#if defined( _WIN32 )
+
+	m_File = CreateFileW( rPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( m_File == INVALID_HANDLE_VALUE )
+	{
+		std::cerr << "CreateFileW failed for " << rPath << " with " << GetLastError() << "\n";
+		return false;
+	}
+
+	LARGE_INTEGER Size;
+	if( !GetFileSizeEx( m_File, &Size ) )
+	{
+		Close();
+		return false;
+	}
+
+	m_Size = static_cast< uint64_t >( Size.QuadPart );
+
+	// An empty file can't be mapped, but then there is nothing to map either
+	if( m_Size > 0 && ( m_Mapping = CreateFileMappingW( m_File, nullptr, PAGE_READONLY, 0, 0, nullptr ) ) == nullptr )
+	{
+		std::cerr << "CreateFileMappingW failed for " << rPath << " with " << GetLastError() << "\n";
+		Close();
+		return false;
+	}
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	m_Descriptor = open( rPath.c_str(), O_RDONLY | O_CLOEXEC );
+	if( m_Descriptor < 0 )
+	{
+		std::cerr << "open failed for " << rPath << ": " << strerror( errno ) << "\n";
+		return false;
+	}
+
+	struct stat Status;
+	if( fstat( m_Descriptor, &Status ) != 0 )
+	{
+		Close();
+		return false;
+	}
+
+	m_Size = static_cast< uint64_t >( Status.st_size );
+
+#endif // __linux__ || __APPLE__
+
+	return true;
+
+} // Open
+
+//////////////////////////////////////////////////////////////////////////
+
+void MappedFile::Close( void )
+{
+
+#if defined( _WIN32 )
+
+	if( m_Mapping )
+		CloseHandle( std::exchange( m_Mapping, nullptr ) );
+
+	if( m_File != INVALID_HANDLE_VALUE )
+		CloseHandle( std::exchange( m_File, INVALID_HANDLE_VALUE ) );
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	if( m_Descriptor >= 0 )
+		close( std::exchange( m_Descriptor, -1 ) );
+
+#endif // __linux__ || __APPLE__
+
+	m_Size = 0;
+
+} // Close
+
+//////////////////////////////////////////////////////////////////////////
+
+MappedFile::View MappedFile::Map( uint64_t Offset, size_t Length ) const
+{
+	View Result;
+
+	if( !IsOpen() || Offset >= m_Size )
+		return Result;
+
+	Length = static_cast< size_t >( std::min< uint64_t >( Length, m_Size - Offset ) );
+
+	const uint64_t Start       = Offset - Offset % MappingGranularity();
+	const size_t   MappingSize = static_cast< size_t >( Offset - Start ) + Length;
+
+#if defined( _WIN32 )
+
+	void* pMapping = MapViewOfFile( m_Mapping, FILE_MAP_READ, static_cast< DWORD >( Start >> 32 ), static_cast< DWORD >( Start ), MappingSize );
+	if( !pMapping )
+		return Result;
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	void* pMapping = mmap( nullptr, MappingSize, PROT_READ, MAP_PRIVATE, m_Descriptor, static_cast< off_t >( Start ) );
+	if( pMapping == MAP_FAILED )
+		return Result;
+
+#endif // __linux__ || __APPLE__
+
+	Result.m_pMapping    = pMapping;
+	Result.m_MappingSize = MappingSize;
+	Result.m_Offset      = Offset;
+	Result.m_Data        = std::string_view( static_cast< const char* >( pMapping ) + ( Offset - Start ), Length );
+
+	return Result;
+
+} // Map
+
+//////////////////////////////////////////////////////////////////////////
+
+bool MappedFile::IsOpen( void ) const
+{
+
+#if defined( _WIN32 )
+	return m_File != INVALID_HANDLE_VALUE;
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+	return m_Descriptor >= 0;
+#endif // __linux__ || __APPLE__
+
+} // IsOpen
@@ -0,0 +1,406 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "Common/Network/HTTP.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+
+//////////////////////////////////////////////////////////////////////////
+
+static constexpr size_t MaxHeadSize = 64 * 1024;
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool EqualsIgnoreCase( std::string_view A, std::string_view B )
+{
+	return A.size() == B.size() && std::equal( A.begin(), A.end(), B.begin(), []( char a, char b ) { return std::tolower( static_cast< unsigned char >( a ) ) == std::tolower( static_cast< unsigned char >( b ) ); } );
+
+} // EqualsIgnoreCase
+
+//////////////////////////////////////////////////////////////////////////
+
+static std::string_view Trim( std::string_view Text )
+{
+	while( !Text.empty() && ( Text.front() == ' ' || Text.front() == '\t' ) ) Text.remove_prefix( 1 );
+	while( !Text.empty() && ( Text.back()  == ' ' || Text.back()  == '\t' ) ) Text.remove_suffix( 1 );
+
+	return Text;
+
+} // Trim
+
+//////////////////////////////////////////////////////////////////////////
+
+static std::optional< std::string_view > FindHeader( std::string_view Head, std::string_view Name )
+{
+	// Skip the start line
+	size_t LineStart = Head.find( "\r\n" );
+
+	while( LineStart != std::string_view::npos && LineStart + 2 < Head.size() )
+	{
+		LineStart += 2;
+
+		const size_t           LineEnd = Head.find( "\r\n", LineStart );
+		const std::string_view Line    = Head.substr( LineStart, LineEnd - LineStart );
+		const size_t           Colon   = Line.find( ':' );
+
+		if( Colon != std::string_view::npos && EqualsIgnoreCase( Trim( Line.substr( 0, Colon ) ), Name ) )
+			return Trim( Line.substr( Colon + 1 ) );
+
+		LineStart = LineEnd;
+	}
+
+	return std::nullopt;
+
+} // FindHeader
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool WantsKeepAlive( std::string_view Head, std::string_view Version )
+{
+	// HTTP/1.1 connections persist unless asked not to, while HTTP/1.0 connections have to ask for it
+	const std::optional< std::string_view > ConnectionHeader = FindHeader( Head, "Connection" );
+
+	if( Version == "HTTP/1.0" )
+		return ConnectionHeader && EqualsIgnoreCase( *ConnectionHeader, "keep-alive" );
+
+	return !ConnectionHeader || !EqualsIgnoreCase( *ConnectionHeader, "close" );
+
+} // WantsKeepAlive
+
+//////////////////////////////////////////////////////////////////////////
+
+static std::string_view ReasonPhrase( int Status )
+{
+	switch( Status )
+	{
+		case 200: return "OK";
+		case 201: return "Created";
+		case 204: return "No Content";
+		case 400: return "Bad Request";
+		case 404: return "Not Found";
+		case 405: return "Method Not Allowed";
+		case 413: return "Payload Too Large";
+		case 500: return "Internal Server Error";
+		default:  return "Unknown";
+	}
+
+} // ReasonPhrase
+
+//////////////////////////////////////////////////////////////////////////
+
+std::optional< HTTP::URL > HTTP::ParseURL( std::string_view Text )
+{
+	constexpr std::string_view Scheme = "http://";
+
+	if( Text.substr( 0, Scheme.size() ) != Scheme )
+		return std::nullopt;
+
+	Text.remove_prefix( Scheme.size() );
+
+	const size_t           Slash     = Text.find( '/' );
+	const std::string_view Authority = Text.substr( 0, Slash );
+	const size_t           Colon     = Authority.rfind( ':' );
+	URL                    Result;
+
+	// Colons inside brackets belong to an IPv6 address rather than to the port
+	if( Colon != std::string_view::npos && Authority.find( ']', Colon ) == std::string_view::npos )
+	{
+		Result.Host = Authority.substr( 0, Colon );
+		Result.Port = Authority.substr( Colon + 1 );
+	}
+	else
+	{
+		Result.Host = Authority;
+		Result.Port = "80";
+	}
+
+	if( Result.Host.empty() || Result.Port.empty() )
+		return std::nullopt;
+
+	if( Slash != std::string_view::npos )
+		Result.Path = Text.substr( Slash );
+
+	while( !Result.Path.empty() && Result.Path.back() == '/' )
+		Result.Path.pop_back();
+
+	return Result;
+
+} // ParseURL
+
+//////////////////////////////////////////////////////////////////////////
+
+bool HTTP::Connection::SendRequest( std::string_view Host, const Request& rRequest )
+{
+	std::string Head;
+	Head.reserve( 256 );
+
+	Head += rRequest.Method + " " + rRequest.Path + " HTTP/1.1\r\n";
+	Head += "Host: ";
+	Head += Host;
+	Head += "\r\n";
+
+	if( !rRequest.Body.empty() || rRequest.Method == "PUT" || rRequest.Method == "POST" )
+		Head += "Content-Length: " + std::to_string( rRequest.Body.size() ) + "\r\n";
+
+	if( !rRequest.KeepAlive )
+		Head += "Connection: close\r\n";
+
+	Head += "\r\n";
+
+	return m_Socket.Send( Head.data(), Head.size() ) && m_Socket.Send( rRequest.Body.data(), rRequest.Body.size() );
+
+} // SendRequest
+
+//////////////////////////////////////////////////////////////////////////
+
+bool HTTP::Connection::SendResponse( const Response& rResponse )
+{
+	std::string Head;
+	Head.reserve( 128 );
+
+	Head += "HTTP/1.1 " + std::to_string( rResponse.Status ) + " ";
+	Head += ReasonPhrase( rResponse.Status );
+	Head += "\r\nContent-Length: " + std::to_string( rResponse.Body.size() ) + "\r\n";
+
+	if( !rResponse.KeepAlive )
+		Head += "Connection: close\r\n";
+
+	Head += "\r\n";
+
+	return m_Socket.Send( Head.data(), Head.size() ) && m_Socket.Send( rResponse.Body.data(), rResponse.Body.size() );
+
+} // SendResponse
+
+//////////////////////////////////////////////////////////////////////////
+
+std::optional< HTTP::Request > HTTP::Connection::ReceiveRequest( size_t MaxBodySize )
+{
+	std::string Head;
+
+	if( !ReadHead( Head ) )
+		return std::nullopt;
+
+	// Request line: METHOD SP PATH SP VERSION
+	const std::string_view RequestLine = std::string_view( Head ).substr( 0, Head.find( "\r\n" ) );
+	const size_t           FirstSpace  = RequestLine.find( ' ' );
+	const size_t           SecondSpace = RequestLine.find( ' ', FirstSpace + 1 );
+
+	if( FirstSpace == std::string_view::npos || SecondSpace == std::string_view::npos )
+		return std::nullopt;
+
+	Request Result;
+	Result.Method    = RequestLine.substr( 0, FirstSpace );
+	Result.Path      = RequestLine.substr( FirstSpace + 1, SecondSpace - FirstSpace - 1 );
+	Result.KeepAlive = WantsKeepAlive( Head, RequestLine.substr( SecondSpace + 1 ) );
+
+	// Unlike responses, requests without a length simply don't have a body
+	bool UntilClose = false;
+
+	if( !ReadBody( Head, Result.Body, MaxBodySize, UntilClose ) )
+		return std::nullopt;
+
+	return Result;
+
+} // ReceiveRequest
+
+//////////////////////////////////////////////////////////////////////////
+
+std::optional< HTTP::Response > HTTP::Connection::ReceiveResponse( size_t MaxBodySize )
+{
+	for( ;; )
+	{
+		std::string Head;
+
+		if( !ReadHead( Head ) )
+			return std::nullopt;
+
+		// Status line: VERSION SP STATUS SP REASON
+		const std::string_view StatusLine = std::string_view( Head ).substr( 0, Head.find( "\r\n" ) );
+		const size_t           Space      = StatusLine.find( ' ' );
+		Response               Result;
+
+		if( Space == std::string_view::npos || std::from_chars( StatusLine.data() + Space + 1, StatusLine.data() + StatusLine.size(), Result.Status ).ec != std::errc() )
+			return std::nullopt;
+
+		// Interim responses (e.g. 100 Continue) are followed by the real one
+		if( Result.Status >= 100 && Result.Status < 200 )
+			continue;
+
+		Result.KeepAlive = WantsKeepAlive( Head, StatusLine.substr( 0, Space ) );
+
+		if( Result.Status != 204 && Result.Status != 304 )
+		{
+			bool UntilClose = false;
+
+			if( !ReadBody( Head, Result.Body, MaxBodySize, UntilClose ) )
+				return std::nullopt;
+
+			if( UntilClose )
+			{
+				// Without a length, the body ends when the server closes the connection
+				while( Result.Body.size() <= MaxBodySize && Fill() )
+				{
+					Result.Body += m_Buffer;
+					m_Buffer.clear();
+				}
+
+				Result.KeepAlive = false;
+			}
+		}
+
+		return Result;
+	}
+
+} // ReceiveResponse
+
+//////////////////////////////////////////////////////////////////////////
+
+void HTTP::Connection::Close( void )
+{
+	m_Socket.Close();
+	m_Buffer.clear();
+
+} // Close
+
+//////////////////////////////////////////////////////////////////////////
+
+bool HTTP::Connection::ReadHead( std::string& rHead )
+{
+	size_t End;
+
+	while( ( End = m_Buffer.find( "\r\n\r\n" ) ) == std::string::npos )
+	{
+		if( m_Buffer.size() > MaxHeadSize || !Fill() )
+			return false;
+	}
+
+	rHead.assign( m_Buffer, 0, End + 2 );
+	m_Buffer.erase( 0, End + 4 );
+
+	return true;
+
+} // ReadHead
+
+//////////////////////////////////////////////////////////////////////////
+
+bool HTTP::Connection::ReadBody( std::string_view Head, std::string& rBody, size_t MaxBodySize, bool& rUntilClose )
+{
+	rUntilClose = false;
+
+	if( const std::optional< std::string_view > TransferEncoding = FindHeader( Head, "Transfer-Encoding" ); TransferEncoding && EqualsIgnoreCase( *TransferEncoding, "chunked" ) )
+	{
+		for( ;; )
+		{
+			std::string SizeLine;
+			size_t      ChunkSize = 0;
+
+			if( !ReadLine( SizeLine ) )
+				return false;
+
+			// Chunk extensions follow a semicolon and are of no interest
+			const std::string_view Hex = Trim( std::string_view( SizeLine ).substr( 0, SizeLine.find( ';' ) ) );
+
+			if( std::from_chars( Hex.data(), Hex.data() + Hex.size(), ChunkSize, 16 ).ec != std::errc() || rBody.size() + ChunkSize > MaxBodySize )
+				return false;
+
+			if( ChunkSize == 0 )
+				break;
+
+			std::string Terminator;
+
+			if( !ReadExactly( ChunkSize, rBody ) || !ReadLine( Terminator ) )
+				return false;
+		}
+
+		// Skip the trailer
+		for( std::string Line; ReadLine( Line ) && !Line.empty(); )
+		{
+		}
+
+		return true;
+	}
+
+	if( const std::optional< std::string_view > ContentLength = FindHeader( Head, "Content-Length" ) )
+	{
+		size_t Size = 0;
+
+		if( std::from_chars( ContentLength->data(), ContentLength->data() + ContentLength->size(), Size ).ec != std::errc() || Size > MaxBodySize )
+			return false;
+
+		return ReadExactly( Size, rBody );
+	}
+
+	rUntilClose = true;
+
+	return true;
+
+} // ReadBody
+
+//////////////////////////////////////////////////////////////////////////
+
+bool HTTP::Connection::ReadLine( std::string& rLine )
+{
+	size_t End;
+
+	while( ( End = m_Buffer.find( "\r\n" ) ) == std::string::npos )
+	{
+		if( m_Buffer.size() > MaxHeadSize || !Fill() )
+			return false;
+	}
+
+	rLine.assign( m_Buffer, 0, End );
+	m_Buffer.erase( 0, End + 2 );
+
+	return true;
+
+} // ReadLine
+
+//////////////////////////////////////////////////////////////////////////
+
+bool HTTP::Connection::ReadExactly( size_t Size, std::string& rOut )
+{
+	// Take what has already been buffered, and read the rest straight into the output
+	const size_t Buffered = std::min( Size, m_Buffer.size() );
+
+	rOut.append( m_Buffer, 0, Buffered );
+	m_Buffer.erase( 0, Buffered );
+
+	const size_t Remaining = Size - Buffered;
+	if( Remaining == 0 )
+		return true;
+
+	const size_t Offset = rOut.size();
+	rOut.resize( Offset + Remaining );
+
+	return m_Socket.Receive( rOut.data() + Offset, Remaining );
+
+} // ReadExactly
+
+//////////////////////////////////////////////////////////////////////////
+
+bool HTTP::Connection::Fill( void )
+{
+	char         Chunk[ 16 * 1024 ];
+	const size_t Received = m_Socket.ReceiveSome( Chunk, sizeof( Chunk ) );
+
+	m_Buffer.append( Chunk, Received );
+
+	return Received > 0;
+
+} // Fill
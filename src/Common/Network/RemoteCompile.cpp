@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "Common/Network/RemoteCompile.h"
+
+//////////////////////////////////////////////////////////////////////////
+
+static void WriteU32( std::string& rFrame, uint32_t Value )
+{
+	rFrame += static_cast< char >( Value >> 24 );
+	rFrame += static_cast< char >( Value >> 16 );
+	rFrame += static_cast< char >( Value >> 8 );
+	rFrame += static_cast< char >( Value );
+
+} // WriteU32
+
+//////////////////////////////////////////////////////////////////////////
+
+static void WriteString( std::string& rFrame, std::string_view String )
+{
+	WriteU32( rFrame, static_cast< uint32_t >( String.size() ) );
+	rFrame += String;
+
+} // WriteString
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool ReadU32( std::string_view& rFrame, uint32_t& rValue )
+{
+	if( rFrame.size() < 4 )
+		return false;
+
+	rValue = ( uint32_t( uint8_t( rFrame[ 0 ] ) ) << 24 ) | ( uint32_t( uint8_t( rFrame[ 1 ] ) ) << 16 ) | ( uint32_t( uint8_t( rFrame[ 2 ] ) ) << 8 ) | uint32_t( uint8_t( rFrame[ 3 ] ) );
+	rFrame.remove_prefix( 4 );
+
+	return true;
+
+} // ReadU32
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool ReadString( std::string_view& rFrame, std::string& rString )
+{
+	uint32_t Size;
+
+	if( !ReadU32( rFrame, Size ) || Size > rFrame.size() )
+		return false;
+
+	rString.assign( rFrame.data(), Size );
+	rFrame.remove_prefix( Size );
+
+	return true;
+
+} // ReadString
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool ReadType( std::string_view& rFrame, RemoteCompile::MessageType Expected )
+{
+	if( rFrame.empty() || static_cast< RemoteCompile::MessageType >( rFrame[ 0 ] ) != Expected )
+		return false;
+
+	rFrame.remove_prefix( 1 );
+
+	return true;
+
+} // ReadType
+
+//////////////////////////////////////////////////////////////////////////
+
+std::string RemoteCompile::Encode( const Hello& rHello )
+{
+	std::string Frame;
+	Frame += static_cast< char >( MessageType::Hello );
+
+	WriteU32( Frame, rHello.Version );
+	WriteU32( Frame, rHello.Slots );
+
+	return Frame;
+
+} // Encode
+
+//////////////////////////////////////////////////////////////////////////
+
+std::string RemoteCompile::Encode( const CompileRequest& rRequest )
+{
+	std::string Frame;
+	Frame.reserve( 1 + 12 + rRequest.Compiler.size() + rRequest.Source.size() );
+	Frame += static_cast< char >( MessageType::CompileRequest );
+
+	WriteString( Frame, rRequest.Compiler );
+	WriteU32(    Frame, static_cast< uint32_t >( rRequest.Arguments.size() ) );
+
+	for( const std::string& rArgument : rRequest.Arguments )
+		WriteString( Frame, rArgument );
+
+	WriteString( Frame, rRequest.Source );
+
+	return Frame;
+
+} // Encode
+
+//////////////////////////////////////////////////////////////////////////
+
+std::string RemoteCompile::Encode( const CompileResult& rResult )
+{
+	std::string Frame;
+	Frame.reserve( 1 + 12 + rResult.Diagnostics.size() + rResult.Object.size() );
+	Frame += static_cast< char >( MessageType::CompileResult );
+
+	WriteU32(    Frame, static_cast< uint32_t >( rResult.ExitCode ) );
+	WriteString( Frame, rResult.Diagnostics );
+	WriteString( Frame, rResult.Object );
+
+	return Frame;
+
+} // Encode
+
+//////////////////////////////////////////////////////////////////////////
+
+std::optional< RemoteCompile::MessageType > RemoteCompile::TypeOf( std::string_view Frame )
+{
+	if( Frame.empty() )
+		return std::nullopt;
+
+	return static_cast< MessageType >( Frame[ 0 ] );
+
+} // TypeOf
+
+//////////////////////////////////////////////////////////////////////////
+
+std::optional< RemoteCompile::Hello > RemoteCompile::DecodeHello( std::string_view Frame )
+{
+	Hello Result;
+
+	if( !ReadType( Frame, MessageType::Hello ) || !ReadU32( Frame, Result.Version ) || !ReadU32( Frame, Result.Slots ) )
+		return std::nullopt;
+
+	return Result;
+
+} // DecodeHello
+
+//////////////////////////////////////////////////////////////////////////
+
+std::optional< RemoteCompile::CompileRequest > RemoteCompile::DecodeCompileRequest( std::string_view Frame )
+{
+	CompileRequest Result;
+	uint32_t       NumArguments;
+
+	if( !ReadType( Frame, MessageType::CompileRequest ) || !ReadString( Frame, Result.Compiler ) || !ReadU32( Frame, NumArguments ) )
+		return std::nullopt;
+
+	// Every argument takes at least its size, so a count that doesn't fit in the frame is a lie
+	if( NumArguments > Frame.size() / 4 )
+		return std::nullopt;
+
+	Result.Arguments.resize( NumArguments );
+
+	for( std::string& rArgument : Result.Arguments )
+	{
+		if( !ReadString( Frame, rArgument ) )
+			return std::nullopt;
+	}
+
+	if( !ReadString( Frame, Result.Source ) )
+		return std::nullopt;
+
+	return Result;
+
+} // DecodeCompileRequest
+
+//////////////////////////////////////////////////////////////////////////
+
+std::optional< RemoteCompile::CompileResult > RemoteCompile::DecodeCompileResult( std::string_view Frame )
+{
+	CompileResult Result;
+	uint32_t      ExitCode;
+
+	if( !ReadType( Frame, MessageType::CompileResult ) || !ReadU32( Frame, ExitCode ) || !ReadString( Frame, Result.Diagnostics ) || !ReadString( Frame, Result.Object ) )
+		return std::nullopt;
+
+	Result.ExitCode = static_cast< int32_t >( ExitCode );
+
+	return Result;
+
+} // DecodeCompileResult
@@ -0,0 +1,582 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "Common/Network/Socket.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#if defined( _WIN32 )
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // __linux__ || __APPLE__
+
+//////////////////////////////////////////////////////////////////////////
+
+#if defined( _WIN32 )
+static constexpr int SendFlags = 0;
+#elif defined( __linux__ ) // _WIN32
+static constexpr int SendFlags = MSG_NOSIGNAL;
+#elif defined( __APPLE__ ) // __linux__
+static constexpr int SendFlags = 0;
+#endif // __APPLE__
+
+static constexpr std::string_view UnixPrefix = "unix:";
+
+//////////////////////////////////////////////////////////////////////////
+
+static void CloseHandle( SocketHandle Handle )
+{
+
+#if defined( _WIN32 )
+	closesocket( static_cast< SOCKET >( Handle ) );
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+	close( Handle );
+#endif // __linux__ || __APPLE__
+
+} // CloseHandle
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool InitializeSockets( void )
+{
+
+#if defined( _WIN32 )
+
+	static const bool Initialized = []( void )
+	{
+		WSADATA Data;
+		return WSAStartup( MAKEWORD( 2, 2 ), &Data ) == 0;
+	}();
+
+	return Initialized;
+
+#else // _WIN32
+
+	return true;
+
+#endif // !_WIN32
+
+} // InitializeSockets
+
+//////////////////////////////////////////////////////////////////////////
+
+// Sockets must not leak into the compilers and tests that we start, or a connection would stay open for as long as they run
+static SocketHandle OpenHandle( int Family, int Type, int Protocol )
+{
+
+#if defined( _WIN32 )
+
+	const SOCKET Handle = WSASocketW( Family, Type, Protocol, nullptr, 0, WSA_FLAG_OVERLAPPED | WSA_FLAG_NO_HANDLE_INHERIT );
+
+	return Handle == INVALID_SOCKET ? Socket::InvalidHandle : static_cast< SocketHandle >( Handle );
+
+#elif defined( __linux__ ) // _WIN32
+
+	return socket( Family, Type | SOCK_CLOEXEC, Protocol );
+
+#elif defined( __APPLE__ ) // __linux__
+
+	const int Handle = socket( Family, Type, Protocol );
+
+	if( Handle >= 0 )
+		fcntl( Handle, F_SETFD, FD_CLOEXEC );
+
+	return Handle;
+
+#endif // __APPLE__
+
+} // OpenHandle
+
+//////////////////////////////////////////////////////////////////////////
+
+static SocketHandle AcceptHandle( SocketHandle Listener, sockaddr_storage& rAddress )
+{
+	socklen_t AddressLength = sizeof( rAddress );
+
+#if defined( _WIN32 )
+
+	const SOCKET Handle = accept( static_cast< SOCKET >( Listener ), reinterpret_cast< sockaddr* >( &rAddress ), &AddressLength );
+
+	if( Handle == INVALID_SOCKET )
+		return Socket::InvalidHandle;
+
+	SetHandleInformation( reinterpret_cast< HANDLE >( Handle ), HANDLE_FLAG_INHERIT, 0 );
+
+	return static_cast< SocketHandle >( Handle );
+
+#elif defined( __linux__ ) // _WIN32
+
+	return accept4( Listener, reinterpret_cast< sockaddr* >( &rAddress ), &AddressLength, SOCK_CLOEXEC );
+
+#elif defined( __APPLE__ ) // __linux__
+
+	const int Handle = accept( Listener, reinterpret_cast< sockaddr* >( &rAddress ), &AddressLength );
+
+	if( Handle >= 0 )
+		fcntl( Handle, F_SETFD, FD_CLOEXEC );
+
+	return Handle;
+
+#endif // __APPLE__
+
+} // AcceptHandle
+
+//////////////////////////////////////////////////////////////////////////
+
+static void ConfigureHandle( SocketHandle Handle, int Family )
+{
+	// Frames are small and latency-bound, so don't let Nagle's algorithm hold them back
+	if( Family == AF_INET || Family == AF_INET6 )
+	{
+		int NoDelay = 1;
+		setsockopt( Handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast< const char* >( &NoDelay ), sizeof( NoDelay ) );
+	}
+
+#if defined( __APPLE__ )
+
+	// macOS has no MSG_NOSIGNAL, so a peer that hangs up would otherwise raise SIGPIPE
+	int NoSigPipe = 1;
+	setsockopt( Handle, SOL_SOCKET, SO_NOSIGPIPE, &NoSigPipe, sizeof( NoSigPipe ) );
+
+#endif // __APPLE__
+
+} // ConfigureHandle
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool SplitHostAndPort( std::string_view Endpoint, std::string& rHost, std::string& rPort )
+{
+	const size_t Colon = Endpoint.rfind( ':' );
+	if( Colon == std::string_view::npos || Colon + 1 == Endpoint.size() )
+	{
+		std::cerr << "Invalid endpoint '" << Endpoint << "', expected 'host:port' or 'unix:/path'\n";
+		return false;
+	}
+
+	rHost = Endpoint.substr( 0, Colon );
+	rPort = Endpoint.substr( Colon + 1 );
+
+	// IPv6 addresses are written as '[::1]:port'
+	if( rHost.size() >= 2 && rHost.front() == '[' && rHost.back() == ']' )
+		rHost = rHost.substr( 1, rHost.size() - 2 );
+
+	return true;
+
+} // SplitHostAndPort
+
+//////////////////////////////////////////////////////////////////////////
+
+Socket::Socket( Socket&& rrOther ) noexcept
+	: m_Handle  ( std::exchange( rrOther.m_Handle, InvalidHandle ) )
+	, m_UnixPath( std::move( rrOther.m_UnixPath ) )
+{
+
+} // Socket
+
+//////////////////////////////////////////////////////////////////////////
+
+Socket& Socket::operator=( Socket&& rrOther ) noexcept
+{
+	if( this != &rrOther )
+	{
+		Close();
+
+		m_Handle   = std::exchange( rrOther.m_Handle, InvalidHandle );
+		m_UnixPath = std::move( rrOther.m_UnixPath );
+	}
+
+	return *this;
+
+} // operator=
+
+//////////////////////////////////////////////////////////////////////////
+
+Socket Socket::Connect( std::string_view Endpoint, std::chrono::milliseconds Timeout )
+{
+	if( !InitializeSockets() )
+		return Socket();
+
+	if( Endpoint.substr( 0, UnixPrefix.size() ) == UnixPrefix )
+	{
+
+	#if defined( __linux__ ) || defined( __APPLE__ )
+
+		const std::string_view Path    = Endpoint.substr( UnixPrefix.size() );
+		sockaddr_un            Address = { };
+		Address.sun_family             = AF_UNIX;
+
+		if( Path.size() >= sizeof( Address.sun_path ) )
+		{
+			std::cerr << "Socket path is too long: " << Path << "\n";
+			return Socket();
+		}
+
+		std::memcpy( Address.sun_path, Path.data(), Path.size() );
+
+		Socket Result( OpenHandle( AF_UNIX, SOCK_STREAM, 0 ) );
+		if( !Result )
+			return Socket();
+
+		ConfigureHandle( Result.m_Handle, AF_UNIX );
+		Result.SetTimeout( Timeout );
+
+		if( connect( Result.m_Handle, reinterpret_cast< const sockaddr* >( &Address ), sizeof( Address ) ) != 0 )
+			return Socket();
+
+		return Result;
+
+	#else // __linux__ || __APPLE__
+
+		std::cerr << "Local sockets are not supported on this platform\n";
+		return Socket();
+
+	#endif // !__linux__ && !__APPLE__
+
+	}
+
+	std::string Host;
+	std::string Port;
+
+	if( !SplitHostAndPort( Endpoint, Host, Port ) )
+		return Socket();
+
+	addrinfo  Hints     = { };
+	addrinfo* pAddrInfo = nullptr;
+	Hints.ai_family     = AF_UNSPEC;
+	Hints.ai_socktype   = SOCK_STREAM;
+
+	if( getaddrinfo( Host.c_str(), Port.c_str(), &Hints, &pAddrInfo ) != 0 )
+	{
+		std::cerr << "Failed to resolve " << Endpoint << "\n";
+		return Socket();
+	}
+
+	Socket Result;
+
+	// Try each resolved address in turn, since 'localhost' may resolve to an IPv6 address that nobody listens on
+	for( addrinfo* pInfo = pAddrInfo; pInfo; pInfo = pInfo->ai_next )
+	{
+		Socket Candidate( OpenHandle( pInfo->ai_family, pInfo->ai_socktype, pInfo->ai_protocol ) );
+		if( !Candidate )
+			continue;
+
+		ConfigureHandle( Candidate.m_Handle, pInfo->ai_family );
+		Candidate.SetTimeout( Timeout );
+
+		if( connect( Candidate.m_Handle, pInfo->ai_addr, static_cast< int >( pInfo->ai_addrlen ) ) == 0 )
+		{
+			Result = std::move( Candidate );
+			break;
+		}
+	}
+
+	freeaddrinfo( pAddrInfo );
+
+	return Result;
+
+} // Connect
+
+//////////////////////////////////////////////////////////////////////////
+
+Socket Socket::Listen( std::string_view Endpoint )
+{
+	if( !InitializeSockets() )
+		return Socket();
+
+	if( Endpoint.substr( 0, UnixPrefix.size() ) == UnixPrefix )
+	{
+
+	#if defined( __linux__ ) || defined( __APPLE__ )
+
+		const std::string_view Path    = Endpoint.substr( UnixPrefix.size() );
+		sockaddr_un            Address = { };
+		Address.sun_family             = AF_UNIX;
+
+		if( Path.size() >= sizeof( Address.sun_path ) )
+		{
+			std::cerr << "Socket path is too long: " << Path << "\n";
+			return Socket();
+		}
+
+		std::memcpy( Address.sun_path, Path.data(), Path.size() );
+
+		Socket Result( OpenHandle( AF_UNIX, SOCK_STREAM, 0 ) );
+		if( !Result )
+			return Socket();
+
+		// A previous instance that didn't shut down cleanly leaves its socket file behind
+		unlink( Address.sun_path );
+
+		if( bind( Result.m_Handle, reinterpret_cast< const sockaddr* >( &Address ), sizeof( Address ) ) != 0 || listen( Result.m_Handle, SOMAXCONN ) != 0 )
+		{
+			std::cerr << "Failed to listen on " << Endpoint << ": " << strerror( errno ) << "\n";
+			return Socket();
+		}
+
+		Result.m_UnixPath = Path;
+
+		return Result;
+
+	#else // __linux__ || __APPLE__
+
+		std::cerr << "Local sockets are not supported on this platform\n";
+		return Socket();
+
+	#endif // !__linux__ && !__APPLE__
+
+	}
+
+	std::string Host;
+	std::string Port;
+
+	if( !SplitHostAndPort( Endpoint, Host, Port ) )
+		return Socket();
+
+	addrinfo  Hints     = { };
+	addrinfo* pAddrInfo = nullptr;
+	Hints.ai_family     = AF_UNSPEC;
+	Hints.ai_socktype   = SOCK_STREAM;
+	Hints.ai_flags      = AI_PASSIVE;
+
+	if( getaddrinfo( Host.empty() ? nullptr : Host.c_str(), Port.c_str(), &Hints, &pAddrInfo ) != 0 )
+	{
+		std::cerr << "Failed to resolve " << Endpoint << "\n";
+		return Socket();
+	}
+
+	Socket Result;
+
+	for( addrinfo* pInfo = pAddrInfo; pInfo; pInfo = pInfo->ai_next )
+	{
+		Socket Candidate( OpenHandle( pInfo->ai_family, pInfo->ai_socktype, pInfo->ai_protocol ) );
+		if( !Candidate )
+			continue;
+
+		// Allow restarting a worker right away instead of waiting for the old socket to leave TIME_WAIT
+		int ReuseAddress = 1;
+		setsockopt( Candidate.m_Handle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast< const char* >( &ReuseAddress ), sizeof( ReuseAddress ) );
+
+		if( bind( Candidate.m_Handle, pInfo->ai_addr, static_cast< int >( pInfo->ai_addrlen ) ) == 0 && listen( Candidate.m_Handle, SOMAXCONN ) == 0 )
+		{
+			Result = std::move( Candidate );
+			break;
+		}
+	}
+
+	freeaddrinfo( pAddrInfo );
+
+	if( !Result )
+		std::cerr << "Failed to listen on " << Endpoint << "\n";
+
+	return Result;
+
+} // Listen
+
+//////////////////////////////////////////////////////////////////////////
+
+Socket Socket::Accept( void )
+{
+	sockaddr_storage Address = { };
+	Socket           Client( AcceptHandle( m_Handle, Address ) );
+
+	if( Client )
+		ConfigureHandle( Client.m_Handle, Address.ss_family );
+
+	return Client;
+
+} // Accept
+
+//////////////////////////////////////////////////////////////////////////
+
+void Socket::Close( void )
+{
+	if( m_Handle == InvalidHandle )
+		return;
+
+	CloseHandle( std::exchange( m_Handle, InvalidHandle ) );
+
+#if defined( __linux__ ) || defined( __APPLE__ )
+
+	if( !m_UnixPath.empty() )
+		unlink( m_UnixPath.c_str() );
+
+#endif // __linux__ || __APPLE__
+
+	m_UnixPath.clear();
+
+} // Close
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Socket::SetTimeout( std::chrono::milliseconds Timeout )
+{
+	// A send or receive that times out fails like any other, so callers need no special handling for it
+
+#if defined( _WIN32 )
+
+	const DWORD Value = static_cast< DWORD >( Timeout.count() );
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	timeval Value = { };
+	Value.tv_sec  = static_cast< decltype( Value.tv_sec ) >( Timeout.count() / 1000 );
+	Value.tv_usec = static_cast< decltype( Value.tv_usec ) >( ( Timeout.count() % 1000 ) * 1000 );
+
+#endif // __linux__ || __APPLE__
+
+	const char* pValue = reinterpret_cast< const char* >( &Value );
+
+	return setsockopt( m_Handle, SOL_SOCKET, SO_RCVTIMEO, pValue, sizeof( Value ) ) == 0
+	    && setsockopt( m_Handle, SOL_SOCKET, SO_SNDTIMEO, pValue, sizeof( Value ) ) == 0;
+
+} // SetTimeout
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Socket::Send( const void* pData, size_t Size )
+{
+	const char* pBytes = static_cast< const char* >( pData );
+
+	while( Size > 0 )
+	{
+		// Keep each chunk within the range of an int, which is what Winsock takes
+		const int  Chunk = static_cast< int >( std::min< size_t >( Size, 1 << 30 ) );
+		const auto Sent  = send( m_Handle, pBytes, Chunk, SendFlags );
+
+		if( Sent <= 0 )
+		{
+		#if defined( __linux__ ) || defined( __APPLE__ )
+			if( Sent < 0 && errno == EINTR )
+				continue;
+		#endif // __linux__ || __APPLE__
+
+			return false;
+		}
+
+		pBytes += Sent;
+		Size   -= static_cast< size_t >( Sent );
+	}
+
+	return true;
+
+} // Send
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Socket::Receive( void* pData, size_t Size )
+{
+	char* pBytes = static_cast< char* >( pData );
+
+	while( Size > 0 )
+	{
+		const int  Chunk    = static_cast< int >( std::min< size_t >( Size, 1 << 30 ) );
+		const auto Received = recv( m_Handle, pBytes, Chunk, 0 );
+
+		// Zero means that the peer closed the connection before everything arrived
+		if( Received <= 0 )
+		{
+		#if defined( __linux__ ) || defined( __APPLE__ )
+			if( Received < 0 && errno == EINTR )
+				continue;
+		#endif // __linux__ || __APPLE__
+
+			return false;
+		}
+
+		pBytes += Received;
+		Size   -= static_cast< size_t >( Received );
+	}
+
+	return true;
+
+} // Receive
+
+//////////////////////////////////////////////////////////////////////////
+
+size_t Socket::ReceiveSome( void* pData, size_t MaxSize )
+{
+	const int Chunk = static_cast< int >( std::min< size_t >( MaxSize, 1 << 30 ) );
+
+	for( ;; )
+	{
+		const auto Received = recv( m_Handle, static_cast< char* >( pData ), Chunk, 0 );
+
+	#if defined( __linux__ ) || defined( __APPLE__ )
+		if( Received < 0 && errno == EINTR )
+			continue;
+	#endif // __linux__ || __APPLE__
+
+		// Both errors and a closed connection end the stream
+		return Received > 0 ? static_cast< size_t >( Received ) : 0;
+	}
+
+} // ReceiveSome
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Socket::SendFrame( std::string_view Frame )
+{
+	if( Frame.size() > UINT32_MAX )
+		return false;
+
+	// Sizes are sent in network byte order
+	const uint32_t Size        = static_cast< uint32_t >( Frame.size() );
+	const uint8_t  Header[ 4 ] = { uint8_t( Size >> 24 ), uint8_t( Size >> 16 ), uint8_t( Size >> 8 ), uint8_t( Size ) };
+
+	return Send( Header, sizeof( Header ) ) && Send( Frame.data(), Frame.size() );
+
+} // SendFrame
+
+//////////////////////////////////////////////////////////////////////////
+
+std::optional< std::string > Socket::ReceiveFrame( size_t MaxSize )
+{
+	uint8_t Header[ 4 ];
+
+	if( !Receive( Header, sizeof( Header ) ) )
+		return std::nullopt;
+
+	const size_t Size = ( size_t( Header[ 0 ] ) << 24 ) | ( size_t( Header[ 1 ] ) << 16 ) | ( size_t( Header[ 2 ] ) << 8 ) | size_t( Header[ 3 ] );
+
+	// Don't let a corrupt or hostile header make us allocate an absurd amount of memory
+	if( Size > MaxSize )
+	{
+		std::cerr << "Rejected a frame of " << Size << " bytes\n";
+		return std::nullopt;
+	}
+
+	std::string Frame( Size, '\0' );
+
+	if( !Receive( Frame.data(), Size ) )
+		return std::nullopt;
+
+	return Frame;
+
+} // ReceiveFrame
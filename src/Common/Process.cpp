@@ -21,8 +21,10 @@
 #include "Common/Platform/Win32/Win32Error.h"
 #include "Common/Platform/Win32/Win32ProcessInfo.h"
 
+#include <algorithm>
 #include <chrono>
 #include <codecvt>
+#include <cstring>
 #include <locale>
 #include <thread>
 
@@ -31,12 +33,87 @@
 
 #if defined( _WIN32 )
 #include <corecrt_io.h>
+#include <mutex>
 #define fdopen _fdopen
 #elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
 #include <sys/wait.h>
 #include <sys/signal.h>
+#include <poll.h>
+#include <errno.h>
 #include <signal.h>
 #include <unistd.h>
+
+extern char** environ;
+#endif // __linux__ || __APPLE__
+
+//////////////////////////////////////////////////////////////////////////
+
+#if defined( _WIN32 )
+
+// Processes that are started in the meantime inherit every inheritable handle, and would keep our pipes open past the end of
+// our child. So the write ends are only made inheritable while the child that they are meant for is being started.
+static std::mutex InheritMutex;
+
+//////////////////////////////////////////////////////////////////////////
+
+static FILE* InheritableStream( HANDLE Write )
+{
+	SetHandleInformation( Write, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT );
+
+	return fdopen( _open_osfhandle( reinterpret_cast< intptr_t >( Write ), _O_APPEND ), "w" );
+
+} // InheritableStream
+
+//////////////////////////////////////////////////////////////////////////
+
+// Quotes an argument so that the child's CommandLineToArgvW() gets it back as it was. Backslashes only escape when they come before a quote.
+static void AppendQuotedArgument( std::wstring& rCommandLine, std::wstring_view Argument )
+{
+	if( !rCommandLine.empty() )
+		rCommandLine += L' ';
+
+	rCommandLine += L'"';
+
+	size_t Backslashes = 0;
+
+	for( wchar_t Character : Argument )
+	{
+		if( Character == L'\\' )
+		{
+			++Backslashes;
+			continue;
+		}
+
+		rCommandLine.append( Character == L'"' ? Backslashes * 2 + 1 : Backslashes, L'\\' );
+		rCommandLine += Character;
+		Backslashes   = 0;
+	}
+
+	rCommandLine.append( Backslashes * 2, L'\\' );
+	rCommandLine += L'"';
+
+} // AppendQuotedArgument
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+// Close-on-exec keeps processes that other threads start from holding on to the pipe. The child gets its copies through dup2().
+static bool OpenPipe( int ( &rPipe )[ 2 ] )
+{
+
+#if defined( __linux__ )
+	return pipe2( rPipe, O_CLOEXEC ) == 0;
+#else // __linux__
+	if( pipe( rPipe ) != 0 )
+		return false;
+
+	fcntl( rPipe[ 0 ], F_SETFD, FD_CLOEXEC );
+	fcntl( rPipe[ 1 ], F_SETFD, FD_CLOEXEC );
+
+	return true;
+#endif // !__linux__
+
+} // OpenPipe
+
 #endif // __linux__ || __APPLE__
 
 //////////////////////////////////////////////////////////////////////////
@@ -55,6 +132,8 @@ Process::Process( const std::wstring_view& rCommandLine )
 Process::Process( const Process& rOther )
 {
 	m_CommandLine = rOther.m_CommandLine;
+	m_Arguments   = rOther.m_Arguments;
+	m_Environment = rOther.m_Environment;
 	m_ExitCode    = rOther.m_ExitCode;
 	m_Pid         = rOther.m_Pid;
 } // Process
@@ -63,7 +142,9 @@ Process::Process( const Process& rOther )
 
 Process::Process( Process&& rrOther ) noexcept
 {
-	m_CommandLine = std::exchange( rrOther.m_CommandLine, nullptr );
+	m_CommandLine = std::exchange( rrOther.m_CommandLine, std::wstring_view() );
+	m_Arguments   = std::move( rrOther.m_Arguments );
+	m_Environment = std::move( rrOther.m_Environment );
 	m_ExitCode    = std::exchange( rrOther.m_ExitCode, 0 );
 #if defined( _WIN32 )
 	m_Pid         = std::exchange( rrOther.m_Pid, nullptr );
@@ -74,7 +155,7 @@ Process::Process( Process&& rrOther ) noexcept
 
 //////////////////////////////////////////////////////////////////////////
 
-void Process::Start( FILE* pOutputStream )
+bool Process::Start( FILE* pOutputStream, FILE* pErrorStream )
 {
 
 #if defined( _WIN32 )
@@ -84,31 +165,130 @@ void Process::Start( FILE* pOutputStream )
 	StartupInfo.wShowWindow  = SW_HIDE;
 	StartupInfo.dwFlags      = STARTF_USESHOWWINDOW | STARTF_USESTDHANDLES;
 	StartupInfo.hStdOutput   = reinterpret_cast< HANDLE >( _get_osfhandle( fileno( pOutputStream ) ) );
-	StartupInfo.hStdError    = reinterpret_cast< HANDLE >( _get_osfhandle( fileno( pOutputStream ) ) );
+	StartupInfo.hStdError    = reinterpret_cast< HANDLE >( _get_osfhandle( fileno( pErrorStream ) ) );
 
+	// The block starts out as a copy of our own environment, minus the variables that are overridden
+	std::wstring Environment;
+
+	if( !m_Environment.empty() )
+	{
+		LPWCH pStrings = GetEnvironmentStringsW();
+
+		for( LPWCH pVariable = pStrings; *pVariable; pVariable += wcslen( pVariable ) + 1 )
+		{
+			const std::wstring_view Variable   = pVariable;
+			const std::wstring_view Name       = Variable.substr( 0, Variable.find( L'=', 1 ) );
+			const bool              Overridden = std::any_of( m_Environment.begin(), m_Environment.end(), [ Name ]( const auto& rOverride )
+				{
+					return rOverride.first.size() == Name.size() && _wcsnicmp( rOverride.first.data(), Name.data(), Name.size() ) == 0;
+				} );
+
+			if( !Overridden )
+				Environment.append( Variable ).push_back( L'\0' );
+		}
+
+		FreeEnvironmentStringsW( pStrings );
+
+		for( const auto& [ rName, rValue ] : m_Environment )
+			Environment.append( rName ).append( L"=" ).append( rValue ).push_back( L'\0' );
+
+		Environment.push_back( L'\0' );
+	}
+
+	std::wstring CommandLine( m_CommandLine );
+
+	if( !m_Arguments.empty() )
+	{
+		CommandLine.clear();
+
+		for( const std::string& rArgument : m_Arguments )
+			AppendQuotedArgument( CommandLine, UTF8Converter().from_bytes( rArgument ) );
+	}
+
+	// The executable is named separately when there are arguments, so that it isn't searched for in PATH
+	const std::wstring  Executable    = m_Arguments.empty() ? std::wstring() : UTF8Converter().from_bytes( m_Arguments.front() );
+	LPCWSTR             pExecutable   = m_Arguments.empty() ? nullptr : Executable.c_str();
+	const DWORD         CreationFlags = m_Environment.empty() ? 0 : CREATE_UNICODE_ENVIRONMENT;
+	LPVOID              pEnvironment  = m_Environment.empty() ? nullptr : Environment.data();
 	PROCESS_INFORMATION ProcessInfo;
-	WIN32_CALL( CreateProcessW( nullptr, const_cast< LPWSTR >( m_CommandLine.data() ), nullptr, nullptr, TRUE, 0, nullptr, nullptr, &StartupInfo, &ProcessInfo ) );
+
+	if( !WIN32_CALL( CreateProcessW( pExecutable, CommandLine.data(), nullptr, nullptr, TRUE, CreationFlags, pEnvironment, nullptr, &StartupInfo, &ProcessInfo ) ) )
+		return false;
+
 	CloseHandle( ProcessInfo.hThread );
 
 	m_Pid = ProcessInfo.hProcess;
 
+	return true;
+
 #elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
 
+	// Only async-signal-safe calls are allowed between fork() and exec() in a threaded program, so everything is prepared up front
+	std::string                Command   = m_Arguments.empty() ? UTF8Converter().to_bytes( m_CommandLine.data(), m_CommandLine.data() + m_CommandLine.size() ) : std::string();
+	std::vector< std::string > Overrides;
+	std::vector< char* >       Environment;
+	std::vector< char* >       Arguments;
+	char                       Shell[] = "/bin/sh";
+	char                       Flag[]  = "-c";
+
+	if( m_Arguments.empty() )
+	{
+		Arguments = { Shell, Flag, Command.data() };
+	}
+	else
+	{
+		for( const std::string& rArgument : m_Arguments )
+			Arguments.push_back( const_cast< char* >( rArgument.c_str() ) );
+	}
+
+	Arguments.push_back( nullptr );
+
+	for( const auto& [ rName, rValue ] : m_Environment )
+		Overrides.push_back( UTF8Converter().to_bytes( rName ) + "=" + UTF8Converter().to_bytes( rValue ) );
+
+	// Our own environment, minus the variables that are overridden
+	for( char** ppVariable = environ; *ppVariable; ++ppVariable )
+	{
+		const std::string_view Variable   = *ppVariable;
+		const std::string_view Name       = Variable.substr( 0, Variable.find( '=' ) );
+		const bool             Overridden = std::any_of( Overrides.begin(), Overrides.end(), [ Name ]( const std::string_view Override )
+			{
+				return Override.size() > Name.size() && Override[ Name.size() ] == '=' && Override.starts_with( Name );
+			} );
+
+		if( !Overridden )
+			Environment.push_back( *ppVariable );
+	}
+
+	for( std::string& rOverride : Overrides )
+		Environment.push_back( rOverride.data() );
+
+	Environment.push_back( nullptr );
+
 	ProcessID PID = fork();
 
 	if( !PID ) // The child
 	{
 		// Take control of output
 		dup2( fileno( pOutputStream ), 1 );
-		dup2( fileno( pOutputStream ), 2 );
+		dup2( fileno( pErrorStream ),  2 );
 
-		execl( "/bin/sh", "/bin/sh", "-c", UTF8Converter().to_bytes( m_CommandLine.data(), m_CommandLine.data() + m_CommandLine.size() ).c_str(), NULL );
+		execve( Arguments.front(), Arguments.data(), Environment.data() );
 
-		exit( EXIT_FAILURE );
+		_exit( EXIT_FAILURE );
+	}
+
+	// A pid of -1 would have kill() and waitpid() act on every child we have
+	if( PID < 0 )
+	{
+		std::cerr << "fork failed: " << strerror( errno ) << "\n";
+		return false;
 	}
 
 	m_Pid = PID;
 
+	return true;
+
 #endif // __linux__ || __APPLE__
 
 } // Start
@@ -120,6 +300,9 @@ int Process::Wait( void )
 
 #if defined( _WIN32 )
 
+	if( !m_Pid )
+		return -1;
+
 	BOOL  Result;
 	DWORD ExitCode;
 
@@ -135,8 +318,14 @@ int Process::Wait( void )
 
 #elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
 
+	if( m_Pid <= 0 )
+		return -1;
+
 	waitpid( m_Pid, &m_ExitCode, 0 );
 
+	// The pid is free to be reused from here on, so make sure that Kill() leaves it alone
+	m_Pid = 0;
+
 	return m_ExitCode;
 
 #endif // __linux__ || __APPLE__
@@ -147,6 +336,8 @@ int Process::Wait( void )
 
 void Process::Kill( void )
 {
+	if( !m_Pid )
+		return;
 
 #if defined( _WIN32 )
 
@@ -157,7 +348,8 @@ void Process::Kill( void )
 
 #elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
 
-	m_ExitCode = kill( m_Pid, SIGUSR1 );
+	if( m_Pid > 0 )
+		m_ExitCode = kill( m_Pid, SIGUSR1 );
 
 	m_Pid = 0;
 
@@ -169,7 +361,8 @@ void Process::Kill( void )
 
 int Process::ResultOf( void )
 {
-	Start( stdout );
+	if( !Start( stdout ) )
+		return -1;
 
 	return Wait();
 
@@ -179,76 +372,333 @@ int Process::ResultOf( void )
 
 std::wstring Process::OutputOf( int& rResult )
 {
+	// Read while the process runs. Waiting for it first would leave it stuck on a full pipe.
+	std::string Output;
+	rResult = Stream( [ & ]( std::string_view Chunk ) { Output.append( Chunk ); } );
 
 #if defined( _WIN32 )
 
-	HANDLE              Read;
-	HANDLE              Write;
-	SECURITY_ATTRIBUTES SecurityAttributes  = { };
-	SecurityAttributes.nLength              = sizeof( SECURITY_ATTRIBUTES );
-	SecurityAttributes.bInheritHandle       = TRUE;
-	SecurityAttributes.lpSecurityDescriptor = nullptr;
+	std::wstring WideOutput;
+	WideOutput.resize( MultiByteToWideChar( CP_ACP, 0, Output.data(), static_cast< int >( Output.size() ), nullptr, 0 ) );
+	MultiByteToWideChar( CP_ACP, 0, Output.data(), static_cast< int >( Output.size() ), WideOutput.data(), static_cast< int >( WideOutput.size() ) );
+
+	return WideOutput;
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	return UTF8Converter().from_bytes( Output );
+
+#endif // __linux__ || __APPLE__
+
+} // OutputOf
+
+//////////////////////////////////////////////////////////////////////////
+
+std::wstring Process::OutputOf( void )
+{
+	int Result;
+
+	return OutputOf( Result );
+
+} // OutputOf
+
+//////////////////////////////////////////////////////////////////////////
+
+int Process::Stream( const OutputCallback& rCallback )
+{
+	std::optional< PipeHandle > Read = StartPiped();
+	char                        Buffer[ 4096 ];
+
+	if( !Read )
+		return -1;
+
+#if defined( _WIN32 )
+
+	DWORD Length;
+
+	while( ReadFile( *Read, Buffer, static_cast< DWORD >( std::size( Buffer ) ), &Length, nullptr ) && Length > 0 )
+		rCallback( std::string_view( Buffer, Length ) );
+
+	CloseHandle( *Read );
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
 
-	if( CreatePipe( &Read, &Write, &SecurityAttributes, 0 ) )
+	for( ;; )
 	{
-		std::wstring Output;
-		std::string  AnsiBuffer;
-		FILE*        pProcOutputHandle = fdopen( _open_osfhandle( reinterpret_cast< intptr_t >( Write ), _O_APPEND ), "w" );
-		Start( pProcOutputHandle );
-		rResult                        = Wait();
+		const ssize_t Length = read( *Read, Buffer, std::size( Buffer ) );
 
-		DWORD BytesAvailable;
-		if( PeekNamedPipe( Read, nullptr, 0, nullptr, &BytesAvailable, nullptr ) && BytesAvailable )
+		if( Length > 0 )
+			rCallback( std::string_view( Buffer, static_cast< size_t >( Length ) ) );
+		else if( Length == 0 || errno != EINTR )
+			break;
+	}
+
+	close( *Read );
+
+#endif // __linux__ || __APPLE__
+
+	return Wait();
+
+} // Stream
+
+//////////////////////////////////////////////////////////////////////////
+
+std::optional< PipeHandle > Process::StartPiped( void )
+{
+
+#if defined( _WIN32 )
+
+	HANDLE Read;
+	HANDLE Write;
+
+	if( !CreatePipe( &Read, &Write, nullptr, 0 ) )
+		return std::nullopt;
+
+	std::scoped_lock Lock( InheritMutex );
+
+	FILE*      pStream = InheritableStream( Write );
+	const bool Started = Start( pStream );
+	fclose( pStream );
+
+	if( !Started )
+	{
+		CloseHandle( Read );
+		return std::nullopt;
+	}
+
+	return Read;
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	int Pipe[ 2 ];
+
+	if( !OpenPipe( Pipe ) )
+		return std::nullopt;
+
+	FILE*      pStream = fdopen( Pipe[ 1 ], "w" );
+	const bool Started = Start( pStream );
+	fclose( pStream );
+
+	if( !Started )
+	{
+		close( Pipe[ 0 ] );
+		return std::nullopt;
+	}
+
+	return Pipe[ 0 ];
+
+#endif // __linux__ || __APPLE__
+
+} // StartPiped
+
+//////////////////////////////////////////////////////////////////////////
+
+std::optional< int > Process::Stream( const OutputCallback& rOnStdOut, const OutputCallback& rOnStdErr, std::optional< std::chrono::milliseconds > Timeout )
+{
+	using Clock = std::chrono::steady_clock;
+
+	const Clock::time_point Deadline = Timeout ? Clock::now() + *Timeout : Clock::time_point::max();
+
+#if defined( _WIN32 )
+
+	HANDLE OutputRead, OutputWrite;
+	HANDLE ErrorRead,  ErrorWrite;
+
+	if( !CreatePipe( &OutputRead, &OutputWrite, nullptr, 0 ) )
+		return -1;
+
+	if( !CreatePipe( &ErrorRead, &ErrorWrite, nullptr, 0 ) )
+	{
+		CloseHandle( OutputRead );
+		CloseHandle( OutputWrite );
+		return -1;
+	}
+
+	{
+		std::scoped_lock Lock( InheritMutex );
+
+		FILE*      pOutput = InheritableStream( OutputWrite );
+		FILE*      pError  = InheritableStream( ErrorWrite );
+		const bool Started = Start( pOutput, pError );
+		fclose( pOutput );
+		fclose( pError );
+
+		if( !Started )
 		{
-			AnsiBuffer.resize( BytesAvailable );
-			Output    .resize( BytesAvailable );
+			CloseHandle( OutputRead );
+			CloseHandle( ErrorRead );
+			return -1;
+		}
+	}
+
+	// Anonymous pipes can't be waited on together, so each gets a thread. The callbacks never run at the same time, though.
+	std::mutex CallbackMutex;
+
+	auto Drain = [ & ]( HANDLE Read, const OutputCallback& rCallback )
+	{
+		char  Buffer[ 4096 ];
+		DWORD Length;
 
-			ReadFile( Read, AnsiBuffer.data(), BytesAvailable, nullptr, nullptr );
-			MultiByteToWideChar( CP_ACP, 0, AnsiBuffer.c_str(), BytesAvailable, Output.data(), BytesAvailable );
+		while( ReadFile( Read, Buffer, static_cast< DWORD >( std::size( Buffer ) ), &Length, nullptr ) && Length > 0 )
+		{
+			std::scoped_lock Lock( CallbackMutex );
+			rCallback( std::string_view( Buffer, Length ) );
 		}
+	};
 
-		fclose( pProcOutputHandle );
-		CloseHandle( Read );
+	std::thread OutputReader( Drain, OutputRead, std::cref( rOnStdOut ) );
+	std::thread ErrorReader ( Drain, ErrorRead,  std::cref( rOnStdErr ) );
+
+	auto MillisecondsLeft = [ & ]( void ) -> DWORD
+	{
+		if( !Timeout )
+			return INFINITE;
+
+		return static_cast< DWORD >( std::max< int64_t >( 0, std::chrono::ceil< std::chrono::milliseconds >( Deadline - Clock::now() ).count() ) );
+	};
+
+	bool TimedOut = WaitForSingleObject( m_Pid, MillisecondsLeft() ) == WAIT_TIMEOUT;
+
+	if( TimedOut )
+		TerminateProcess( m_Pid, 1 );
+
+	// Whatever the process started may still hold on to the pipes, so give up on them at the deadline
+	for( std::thread* pReader : { &OutputReader, &ErrorReader } )
+	{
+		const HANDLE Thread = pReader->native_handle();
+
+		if( !TimedOut && WaitForSingleObject( Thread, MillisecondsLeft() ) == WAIT_TIMEOUT )
+			TimedOut = true;
 
-		return Output;
+		while( TimedOut && WaitForSingleObject( Thread, 10 ) == WAIT_TIMEOUT )
+			CancelSynchronousIo( Thread );
+
+		pReader->join();
 	}
 
-	return std::wstring();
+	CloseHandle( OutputRead );
+	CloseHandle( ErrorRead );
+
+	const int ExitCode = Wait();
+
+	if( TimedOut )
+		return std::nullopt;
+
+	return ExitCode;
 
 #elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
 
-	int FileDescriptors[ 2 ];
-	pipe( FileDescriptors );
-	fcntl( FileDescriptors[ 0 ], F_SETFL, O_NONBLOCK ); // Don't want to block on read
+	int OutputPipe[ 2 ];
+	int ErrorPipe[ 2 ];
 
-	FILE*     pStream = fdopen( FileDescriptors[ 1 ], "w" );
-	Start( pStream );
-	rResult           = Wait();
+	if( !OpenPipe( OutputPipe ) )
+		return -1;
 
-	char        Buffer[ 1024 ];
-	ssize_t     Length;
-	std::string Output;
+	if( !OpenPipe( ErrorPipe ) )
+	{
+		close( OutputPipe[ 0 ] );
+		close( OutputPipe[ 1 ] );
+		return -1;
+	}
 
-	while( ( Length = read( FileDescriptors[ 0 ], Buffer, std::size( Buffer ) ) ) > 0 )
+	FILE*      pOutput = fdopen( OutputPipe[ 1 ], "w" );
+	FILE*      pError  = fdopen( ErrorPipe[ 1 ], "w" );
+	const bool Started = Start( pOutput, pError );
+	fclose( pOutput );
+	fclose( pError );
+
+	// There is nothing to read from or to kill at the deadline
+	if( !Started )
 	{
-		Output.append( Buffer, Length );
+		close( OutputPipe[ 0 ] );
+		close( ErrorPipe[ 0 ] );
+		return -1;
 	}
 
-	fclose( pStream );
-	close( FileDescriptors[ 0 ] );
+	pollfd                Pipes[ 2 ]     = { { OutputPipe[ 0 ], POLLIN, 0 }, { ErrorPipe[ 0 ], POLLIN, 0 } };
+	const OutputCallback* pCallbacks[ 2 ] = { &rOnStdOut, &rOnStdErr };
+	bool                  TimedOut        = false;
+	char                  Buffer[ 4096 ];
 
-	return UTF8Converter().from_bytes( Output );
+	// Closed pipes get a negative descriptor, which poll() skips
+	while( Pipes[ 0 ].fd >= 0 || Pipes[ 1 ].fd >= 0 )
+	{
+		int WaitTime = -1;
+
+		if( Timeout )
+		{
+			const int64_t MillisecondsLeft = std::chrono::ceil< std::chrono::milliseconds >( Deadline - Clock::now() ).count();
+
+			if( MillisecondsLeft <= 0 )
+			{
+				TimedOut = true;
+				break;
+			}
+
+			WaitTime = static_cast< int >( std::min< int64_t >( MillisecondsLeft, INT32_MAX ) );
+		}
+
+		if( poll( Pipes, 2, WaitTime ) < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+
+			break;
+		}
+
+		for( size_t i = 0; i < std::size( Pipes ); ++i )
+		{
+			if( Pipes[ i ].fd < 0 || !( Pipes[ i ].revents & ( POLLIN | POLLHUP | POLLERR ) ) )
+				continue;
+
+			const ssize_t Length = read( Pipes[ i ].fd, Buffer, std::size( Buffer ) );
+
+			if( Length > 0 )
+			{
+				( *pCallbacks[ i ] )( std::string_view( Buffer, static_cast< size_t >( Length ) ) );
+			}
+			else if( Length == 0 || errno != EINTR )
+			{
+				close( Pipes[ i ].fd );
+				Pipes[ i ].fd = -1;
+			}
+		}
+	}
+
+	for( pollfd& rPipe : Pipes )
+	{
+		if( rPipe.fd >= 0 )
+			close( rPipe.fd );
+	}
+
+	if( TimedOut )
+	{
+		kill( m_Pid, SIGKILL );
+		Wait();
+
+		return std::nullopt;
+	}
+
+	return Wait();
 
 #endif // __linux__ || __APPLE__
 
-} // OutputOf
+} // Stream
 
 //////////////////////////////////////////////////////////////////////////
 
-std::wstring Process::OutputOf( void )
+Process::Captured Process::Capture( std::optional< std::chrono::milliseconds > Timeout )
 {
-	int Result;
+	Captured             Result;
+	std::optional< int > ExitCode = Stream(
+		[ & ]( std::string_view Output ) { Result.StdOut.append( Output ); },
+		[ & ]( std::string_view Output ) { Result.StdErr.append( Output ); },
+		Timeout
+	);
 
-	return OutputOf( Result );
+	Result.ExitCode = ExitCode.value_or( -1 );
+	Result.TimedOut = !ExitCode;
 
-} // OutputOf
+	return Result;
+
+} // Capture
@@ -0,0 +1,435 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "Common/ProcessReactor.h"
+
+#include "Common/Async/JobSystem.h"
+
+#include <iostream>
+#include <vector>
+
+#if defined( _WIN32 )
+#include <Windows.h>
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+#include <sys/wait.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#endif // __linux__ || __APPLE__
+
+#if defined( __linux__ )
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#endif // __linux__
+
+//////////////////////////////////////////////////////////////////////////
+
+#if defined( __linux__ )
+
+static constexpr uint64_t WAKE_KEY   = UINT64_MAX;
+static constexpr uint64_t SIGNAL_KEY = UINT64_MAX - 1;
+
+// Written to by the SIGCHLD handler, on kernels that don't have pidfd_open
+static int SignalPipe[ 2 ] = { -1, -1 };
+
+//////////////////////////////////////////////////////////////////////////
+
+static int OpenPidFd( pid_t Pid )
+{
+#if defined( SYS_pidfd_open )
+	return static_cast< int >( syscall( SYS_pidfd_open, Pid, 0 ) );
+#else // SYS_pidfd_open
+	errno = ENOSYS;
+	return -1;
+#endif // !SYS_pidfd_open
+
+} // OpenPidFd
+
+//////////////////////////////////////////////////////////////////////////
+
+static void ChildSignalHandler( int /*Signal*/ )
+{
+	const int  SavedErrno = errno;
+	const char Byte       = 0;
+
+	// The pipe is non-blocking. If it is full, the reactor hasn't caught up with the previous signal yet, which is just as good.
+	[[ maybe_unused ]] ssize_t Result = write( SignalPipe[ 1 ], &Byte, 1 );
+
+	errno = SavedErrno;
+
+} // ChildSignalHandler
+
+#endif // __linux__
+
+//////////////////////////////////////////////////////////////////////////
+
+static void DrainOutput( PipeHandle Read, const ProcessReactor::OutputCallback& rOnOutput )
+{
+	char Buffer[ 4096 ];
+
+#if defined( _WIN32 )
+
+	DWORD Length;
+
+	while( ReadFile( Read, Buffer, static_cast< DWORD >( std::size( Buffer ) ), &Length, nullptr ) && Length > 0 )
+		rOnOutput( std::string_view( Buffer, Length ) );
+
+	CloseHandle( Read );
+
+#else // _WIN32
+
+	for( ;; )
+	{
+		const ssize_t Length = read( Read, Buffer, std::size( Buffer ) );
+
+		if( Length > 0 )
+			rOnOutput( std::string_view( Buffer, static_cast< size_t >( Length ) ) );
+		else if( Length == 0 || errno != EINTR )
+			break;
+	}
+
+	close( Read );
+
+#endif // !_WIN32
+
+} // DrainOutput
+
+//////////////////////////////////////////////////////////////////////////
+
+// For children that can't be watched otherwise. A thread of their own still keeps the jobs free.
+static void WatchInThread( Process Handle, PipeHandle Read, ProcessReactor::OutputCallback OnOutput, ProcessReactor::ExitCallback OnExit )
+{
+	std::thread( [ Handle = std::move( Handle ), Read, OnOutput = std::move( OnOutput ), OnExit = std::move( OnExit ) ]( void ) mutable
+		{
+			DrainOutput( Read, OnOutput );
+
+			const int ExitCode = Handle.Wait();
+
+			JobSystem::Instance().NewJob( [ OnExit = std::move( OnExit ), ExitCode ]( void ) { OnExit( ExitCode ); } );
+		}
+	).detach();
+
+} // WatchInThread
+
+//////////////////////////////////////////////////////////////////////////
+
+ProcessReactor::ProcessReactor( void )
+{
+
+#if defined( __linux__ )
+
+	m_Epoll = epoll_create1( EPOLL_CLOEXEC );
+	m_Wake  = eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+
+	if( m_Epoll < 0 || m_Wake < 0 )
+	{
+		std::cerr << "Failed to create the process reactor\n";
+		return;
+	}
+
+	epoll_event WakeEvent = { };
+	WakeEvent.events      = EPOLLIN;
+	WakeEvent.data.u64    = WAKE_KEY;
+	epoll_ctl( m_Epoll, EPOLL_CTL_ADD, m_Wake, &WakeEvent );
+
+	// Probe with our own pid, since pidfd_open (Linux 5.3) may be missing even where the headers know about it
+	if( const int PidFd = OpenPidFd( getpid() ); PidFd >= 0 )
+	{
+		close( PidFd );
+		m_UsePidFd = true;
+	}
+	else if( pipe2( SignalPipe, O_CLOEXEC | O_NONBLOCK ) == 0 )
+	{
+		struct sigaction Action = { };
+		Action.sa_handler       = ChildSignalHandler;
+		Action.sa_flags         = SA_RESTART | SA_NOCLDSTOP;
+		sigemptyset( &Action.sa_mask );
+		sigaction( SIGCHLD, &Action, nullptr );
+
+		epoll_event SignalEvent = { };
+		SignalEvent.events      = EPOLLIN;
+		SignalEvent.data.u64    = SIGNAL_KEY;
+		epoll_ctl( m_Epoll, EPOLL_CTL_ADD, SignalPipe[ 0 ], &SignalEvent );
+	}
+
+	m_Running = true;
+	m_Thread  = std::thread( &ProcessReactor::ThreadEntry, this );
+
+#endif // __linux__
+
+} // ProcessReactor
+
+//////////////////////////////////////////////////////////////////////////
+
+ProcessReactor::~ProcessReactor( void )
+{
+
+#if defined( __linux__ )
+
+	if( m_Thread.joinable() )
+	{
+		const uint64_t One = 1;
+
+		m_Running = false;
+		[[ maybe_unused ]] ssize_t Result = write( m_Wake, &One, sizeof( One ) );
+
+		m_Thread.join();
+	}
+
+	// Children that are still running are killed along with their Process
+	for( auto& [ rKey, rChild ] : m_Children )
+	{
+		if( rChild->Output >= 0 ) close( rChild->Output );
+		if( rChild->PidFd  >= 0 ) close( rChild->PidFd );
+	}
+
+	if( m_Wake  >= 0 ) close( m_Wake );
+	if( m_Epoll >= 0 ) close( m_Epoll );
+
+#endif // __linux__
+
+} // ~ProcessReactor
+
+//////////////////////////////////////////////////////////////////////////
+
+bool ProcessReactor::Spawn( Process Child, OutputCallback OnOutput, ExitCallback OnExit )
+{
+	std::optional< PipeHandle > Read = Child.StartPiped();
+	if( !Read )
+		return false;
+
+#if defined( __linux__ )
+
+	const int PidFd = ( m_Running && m_UsePidFd ) ? OpenPidFd( Child.GetPid() ) : -1;
+
+	// Without a reactor thread, a pidfd (e.g. out of descriptors) or a SIGCHLD pipe, nothing would ever tell that the child has exited
+	if( !m_Running || ( PidFd < 0 && SignalPipe[ 1 ] < 0 ) )
+	{
+		WatchInThread( std::move( Child ), *Read, std::move( OnOutput ), std::move( OnExit ) );
+		return true;
+	}
+
+	if( PidFd >= 0 )
+		fcntl( PidFd, F_SETFD, FD_CLOEXEC );
+
+	auto pChild      = std::make_unique< ProcessReactor::Child >();
+	pChild->Handle   = std::move( Child );
+	pChild->OnOutput = std::move( OnOutput );
+	pChild->OnExit   = std::move( OnExit );
+	pChild->Output   = *Read;
+	pChild->PidFd    = PidFd;
+
+	fcntl( pChild->Output, F_SETFL, fcntl( pChild->Output, F_GETFL ) | O_NONBLOCK );
+
+	uint64_t  Key;
+	const int Output = pChild->Output;
+
+	// The child has to be known before its descriptors are, since events may come in the moment they are added
+	{
+		std::scoped_lock Lock( m_Mutex );
+
+		Key = m_NextKey++;
+		m_Children.emplace( Key, std::move( pChild ) );
+	}
+
+	epoll_event OutputEvent = { };
+	OutputEvent.events      = EPOLLIN;
+	OutputEvent.data.u64    = Key * 2;
+	epoll_ctl( m_Epoll, EPOLL_CTL_ADD, Output, &OutputEvent );
+
+	if( PidFd >= 0 )
+	{
+		epoll_event ExitEvent = { };
+		ExitEvent.events      = EPOLLIN;
+		ExitEvent.data.u64    = Key * 2 + 1;
+		epoll_ctl( m_Epoll, EPOLL_CTL_ADD, PidFd, &ExitEvent );
+	}
+	else
+	{
+		// Without a pidfd, the child may have exited before it was listed, and its SIGCHLD would have gone unnoticed
+		const char Byte = 0;
+		[[ maybe_unused ]] ssize_t Result = write( SignalPipe[ 1 ], &Byte, 1 );
+	}
+
+#else // __linux__
+
+	// There is no readiness API for anonymous pipes here, so every child gets a thread of its own
+	WatchInThread( std::move( Child ), *Read, std::move( OnOutput ), std::move( OnExit ) );
+
+#endif // !__linux__
+
+	return true;
+
+} // Spawn
+
+//////////////////////////////////////////////////////////////////////////
+
+#if defined( __linux__ )
+
+void ProcessReactor::ThreadEntry( void )
+{
+	epoll_event Events[ 64 ];
+
+	while( m_Running )
+	{
+		const int Count = epoll_wait( m_Epoll, Events, static_cast< int >( std::size( Events ) ), -1 );
+
+		if( Count < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+
+			std::cerr << "Process reactor stopped: epoll_wait failed with error " << errno << "\n";
+			return;
+		}
+
+		for( int i = 0; i < Count; ++i )
+		{
+			const uint64_t Key = Events[ i ].data.u64;
+
+			if( Key == WAKE_KEY )
+			{
+				uint64_t Value;
+				[[ maybe_unused ]] ssize_t Result = read( m_Wake, &Value, sizeof( Value ) );
+				continue;
+			}
+
+			if( Key == SIGNAL_KEY )
+			{
+				char Buffer[ 64 ];
+				while( read( SignalPipe[ 0 ], Buffer, sizeof( Buffer ) ) > 0 );
+
+				// SIGCHLD doesn't say which child it was about (signals may be merged), so look at all of them
+				std::vector< std::pair< uint64_t, Child* > > Children;
+				{
+					std::scoped_lock Lock( m_Mutex );
+
+					for( auto& [ rKey, rChild ] : m_Children )
+						Children.emplace_back( rKey, rChild.get() );
+				}
+
+				for( auto& [ rKey, pChild ] : Children )
+				{
+					CheckExited( *pChild );
+					FinishIfDone( rKey, *pChild );
+				}
+
+				continue;
+			}
+
+			// Children are only ever removed by this thread, so the pointer stays valid after the lock is gone
+			Child* pChild;
+			{
+				std::scoped_lock Lock( m_Mutex );
+
+				auto It = m_Children.find( Key / 2 );
+				if( It == m_Children.end() )
+					continue;
+
+				pChild = It->second.get();
+			}
+
+			if( Key % 2 == 0 )
+			{
+				ReadOutput( *pChild );
+			}
+			else
+			{
+				epoll_ctl( m_Epoll, EPOLL_CTL_DEL, pChild->PidFd, nullptr );
+				close( pChild->PidFd );
+
+				pChild->PidFd    = -1;
+				pChild->ExitCode = pChild->Handle.Wait();
+				pChild->Exited   = true;
+			}
+
+			FinishIfDone( Key / 2, *pChild );
+		}
+	}
+
+} // ThreadEntry
+
+//////////////////////////////////////////////////////////////////////////
+
+void ProcessReactor::ReadOutput( Child& rChild )
+{
+	char Buffer[ 16 * 1024 ];
+
+	for( ;; )
+	{
+		const ssize_t Length = read( rChild.Output, Buffer, sizeof( Buffer ) );
+
+		if( Length > 0 )
+		{
+			rChild.OnOutput( std::string_view( Buffer, static_cast< size_t >( Length ) ) );
+			continue;
+		}
+
+		if( Length < 0 && errno == EINTR )
+			continue;
+
+		// Nothing more for now
+		if( Length < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) )
+			return;
+
+		break;
+	}
+
+	// End of output (or an error that won't go away)
+	epoll_ctl( m_Epoll, EPOLL_CTL_DEL, rChild.Output, nullptr );
+	close( rChild.Output );
+
+	rChild.Output       = -1;
+	rChild.OutputClosed = true;
+
+} // ReadOutput
+
+//////////////////////////////////////////////////////////////////////////
+
+void ProcessReactor::CheckExited( Child& rChild )
+{
+	if( rChild.Exited || rChild.PidFd >= 0 )
+		return;
+
+	// Only peek, so that Process::Wait() is the one that reaps the child
+	siginfo_t Info = { };
+
+	if( waitid( P_PID, static_cast< id_t >( rChild.Handle.GetPid() ), &Info, WEXITED | WNOHANG | WNOWAIT ) == 0 && Info.si_pid != 0 )
+	{
+		rChild.ExitCode = rChild.Handle.Wait();
+		rChild.Exited   = true;
+	}
+
+} // CheckExited
+
+//////////////////////////////////////////////////////////////////////////
+
+void ProcessReactor::FinishIfDone( uint64_t Key, Child& rChild )
+{
+	if( !rChild.Exited || !rChild.OutputClosed )
+		return;
+
+	JobSystem::Instance().NewJob( [ OnExit = std::move( rChild.OnExit ), ExitCode = rChild.ExitCode ]( void ) { OnExit( ExitCode ); } );
+
+	std::scoped_lock Lock( m_Mutex );
+	m_Children.erase( Key );
+
+} // FinishIfDone
+
+#endif // __linux__
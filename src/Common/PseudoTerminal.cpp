@@ -0,0 +1,415 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "Common/PseudoTerminal.h"
+
+#include "Common/Aliases.h"
+
+#include <iostream>
+#include <vector>
+
+#if defined( __linux__ ) || defined( __APPLE__ )
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif // __linux__ || __APPLE__
+
+//////////////////////////////////////////////////////////////////////////
+
+PseudoTerminal::~PseudoTerminal( void )
+{
+	Kill();
+
+#if defined( _WIN32 )
+
+	if( m_Watcher )
+	{
+		WaitForSingleObject( m_Watcher, INFINITE );
+		CloseHandle( m_Watcher );
+	}
+
+	if( m_Process ) CloseHandle( m_Process );
+	if( m_Input   ) CloseHandle( m_Input );
+	if( m_Output  ) CloseHandle( m_Output );
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	// Don't leave a zombie behind if nobody waited for the program
+	if( m_Pid > 0 )
+		waitpid( m_Pid, nullptr, 0 );
+
+	if( m_Master >= 0 )
+		close( m_Master );
+
+#endif // __linux__ || __APPLE__
+
+} // ~PseudoTerminal
+
+//////////////////////////////////////////////////////////////////////////
+
+bool PseudoTerminal::Start( std::wstring_view CommandLine, uint16_t Columns, uint16_t Rows )
+{
+
+#if defined( _WIN32 )
+
+	HANDLE InputRead;
+	HANDLE InputWrite;
+	HANDLE OutputRead;
+	HANDLE OutputWrite;
+
+	if( !CreatePipe( &InputRead, &InputWrite, nullptr, 0 ) )
+		return false;
+
+	if( !CreatePipe( &OutputRead, &OutputWrite, nullptr, 0 ) )
+	{
+		CloseHandle( InputRead );
+		CloseHandle( InputWrite );
+		return false;
+	}
+
+	const COORD   Size   = { static_cast< SHORT >( Columns ), static_cast< SHORT >( Rows ) };
+	const HRESULT Result = CreatePseudoConsole( Size, InputRead, OutputWrite, 0, &m_PseudoConsole );
+
+	// The pseudo console holds on to its own ends of the pipes
+	CloseHandle( InputRead );
+	CloseHandle( OutputWrite );
+
+	if( FAILED( Result ) )
+	{
+		std::cerr << "CreatePseudoConsole failed with " << Result << "\n";
+		CloseHandle( InputWrite );
+		CloseHandle( OutputRead );
+		m_PseudoConsole = nullptr;
+		return false;
+	}
+
+	SIZE_T AttributeListSize = 0;
+	InitializeProcThreadAttributeList( nullptr, 1, 0, &AttributeListSize );
+
+	std::vector< BYTE > AttributeList( AttributeListSize );
+	STARTUPINFOEXW      StartupInfo     = { };
+	StartupInfo.StartupInfo.cb          = sizeof( STARTUPINFOEXW );
+	StartupInfo.lpAttributeList         = reinterpret_cast< LPPROC_THREAD_ATTRIBUTE_LIST >( AttributeList.data() );
+
+	InitializeProcThreadAttributeList( StartupInfo.lpAttributeList, 1, 0, &AttributeListSize );
+	UpdateProcThreadAttribute( StartupInfo.lpAttributeList, 0, PROC_THREAD_ATTRIBUTE_PSEUDOCONSOLE, m_PseudoConsole, sizeof( HPCON ), nullptr, nullptr );
+
+	// CreateProcessW() may write to the command line
+	std::wstring        Command( CommandLine );
+	PROCESS_INFORMATION ProcessInfo = { };
+	const BOOL          Created     = CreateProcessW( nullptr, Command.data(), nullptr, nullptr, FALSE, EXTENDED_STARTUPINFO_PRESENT, nullptr, nullptr, &StartupInfo.StartupInfo, &ProcessInfo );
+
+	DeleteProcThreadAttributeList( StartupInfo.lpAttributeList );
+
+	if( !Created )
+	{
+		std::cerr << "Failed to start process (error " << GetLastError() << ")\n";
+		ClosePseudoConsole( m_PseudoConsole );
+		CloseHandle( InputWrite );
+		CloseHandle( OutputRead );
+		m_PseudoConsole = nullptr;
+		return false;
+	}
+
+	CloseHandle( ProcessInfo.hThread );
+
+	m_Input   = InputWrite;
+	m_Output  = OutputRead;
+	m_Process = ProcessInfo.hProcess;
+
+	// A pseudo console keeps its output open after the program has exited, which would leave Read() blocked forever
+	m_Watcher = CreateThread( nullptr, 0, CloseWhenExited, this, 0, nullptr );
+
+	return true;
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	// Only async-signal-safe calls are allowed between fork() and exec() in a threaded program, so everything is prepared up front
+	std::string          Command = UTF8Converter().to_bytes( CommandLine.data(), CommandLine.data() + CommandLine.size() );
+	std::vector< char* > Environment;
+	char                 Shell[] = "/bin/sh";
+	char                 Flag[]  = "-c";
+	char                 Term[]  = "TERM=xterm-256color";
+	char*                Arguments[] = { Shell, Flag, Command.data(), nullptr };
+
+	for( char** ppVariable = environ; *ppVariable; ++ppVariable )
+	{
+		if( strncmp( *ppVariable, "TERM=", 5 ) != 0 )
+			Environment.push_back( *ppVariable );
+	}
+
+	Environment.push_back( Term );
+	Environment.push_back( nullptr );
+
+	const int Master = posix_openpt( O_RDWR | O_NOCTTY );
+	if( Master < 0 )
+	{
+		std::cerr << "posix_openpt failed: " << strerror( errno ) << "\n";
+		return false;
+	}
+
+	fcntl( Master, F_SETFD, FD_CLOEXEC );
+
+	const char* pSlaveName = nullptr;
+
+#if defined( __linux__ )
+	// ptsname() returns a static buffer that other threads may be using
+	char SlaveName[ 128 ];
+	if( grantpt( Master ) == 0 && unlockpt( Master ) == 0 && ptsname_r( Master, SlaveName, sizeof( SlaveName ) ) == 0 )
+		pSlaveName = SlaveName;
+#else // __linux__
+	if( grantpt( Master ) == 0 && unlockpt( Master ) == 0 )
+		pSlaveName = ptsname( Master );
+#endif // !__linux__
+
+	const int Slave = pSlaveName ? open( pSlaveName, O_RDWR | O_NOCTTY ) : -1;
+
+	if( Slave < 0 )
+	{
+		std::cerr << "Failed to open pseudo terminal: " << strerror( errno ) << "\n";
+		close( Master );
+		return false;
+	}
+
+	winsize WindowSize = { };
+	WindowSize.ws_col  = Columns;
+	WindowSize.ws_row  = Rows;
+	ioctl( Slave, TIOCSWINSZ, &WindowSize );
+
+	const pid_t Pid = fork();
+
+	if( Pid == 0 ) // The child
+	{
+		// Start a new session with the terminal as the controlling one, so that Ctrl+C and hangups reach the program
+		setsid();
+		ioctl( Slave, TIOCSCTTY, 0 );
+
+		dup2( Slave, 0 );
+		dup2( Slave, 1 );
+		dup2( Slave, 2 );
+
+		if( Slave > 2 )
+			close( Slave );
+
+		execve( Shell, Arguments, Environment.data() );
+
+		_exit( 127 );
+	}
+
+	// The program holds the only other reference to the slave now, so Read() sees the end as soon as it is gone
+	close( Slave );
+
+	if( Pid < 0 )
+	{
+		std::cerr << "fork failed: " << strerror( errno ) << "\n";
+		close( Master );
+		return false;
+	}
+
+	m_Master = Master;
+	m_Pid    = Pid;
+
+	return true;
+
+#endif // __linux__ || __APPLE__
+
+} // Start
+
+//////////////////////////////////////////////////////////////////////////
+
+void PseudoTerminal::Resize( uint16_t Columns, uint16_t Rows )
+{
+
+#if defined( _WIN32 )
+
+	std::scoped_lock Lock( m_Mutex );
+
+	if( m_PseudoConsole )
+		ResizePseudoConsole( m_PseudoConsole, { static_cast< SHORT >( Columns ), static_cast< SHORT >( Rows ) } );
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	winsize WindowSize = { };
+	WindowSize.ws_col  = Columns;
+	WindowSize.ws_row  = Rows;
+
+	// The terminal driver sends SIGWINCH to the program
+	if( m_Master >= 0 )
+		ioctl( m_Master, TIOCSWINSZ, &WindowSize );
+
+#endif // __linux__ || __APPLE__
+
+} // Resize
+
+//////////////////////////////////////////////////////////////////////////
+
+bool PseudoTerminal::Write( std::string_view Input )
+{
+	while( !Input.empty() )
+	{
+
+	#if defined( _WIN32 )
+
+		DWORD Written = 0;
+		if( !m_Input || !WriteFile( m_Input, Input.data(), static_cast< DWORD >( Input.size() ), &Written, nullptr ) )
+			return false;
+
+	#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+		const ssize_t Written = m_Master >= 0 ? write( m_Master, Input.data(), Input.size() ) : -1;
+		if( Written < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+
+			return false;
+		}
+
+	#endif // __linux__ || __APPLE__
+
+		Input.remove_prefix( static_cast< size_t >( Written ) );
+	}
+
+	return true;
+
+} // Write
+
+//////////////////////////////////////////////////////////////////////////
+
+void PseudoTerminal::Kill( void )
+{
+	std::scoped_lock Lock( m_Mutex );
+
+#if defined( _WIN32 )
+
+	if( m_Process )
+		TerminateProcess( m_Process, 1 );
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	// The program is the leader of its own process group, which takes anything it has started down with it
+	if( m_Pid > 0 )
+		kill( -m_Pid, SIGKILL );
+
+#endif // __linux__ || __APPLE__
+
+} // Kill
+
+//////////////////////////////////////////////////////////////////////////
+
+size_t PseudoTerminal::Read( void* pBuffer, size_t MaxSize )
+{
+
+#if defined( _WIN32 )
+
+	DWORD Length = 0;
+	if( !m_Output || !ReadFile( m_Output, pBuffer, static_cast< DWORD >( MaxSize ), &Length, nullptr ) )
+		return 0;
+
+	return Length;
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	for( ;; )
+	{
+		const ssize_t Length = m_Master >= 0 ? read( m_Master, pBuffer, MaxSize ) : 0;
+		if( Length >= 0 )
+			return static_cast< size_t >( Length );
+
+		// Linux reports EIO rather than end-of-file once the last slave has been closed
+		if( errno != EINTR )
+			return 0;
+	}
+
+#endif // __linux__ || __APPLE__
+
+} // Read
+
+//////////////////////////////////////////////////////////////////////////
+
+std::optional< int > PseudoTerminal::Wait( void )
+{
+
+#if defined( _WIN32 )
+
+	DWORD ExitCode;
+
+	if( !m_Process || WaitForSingleObject( m_Process, INFINITE ) != WAIT_OBJECT_0 || !GetExitCodeProcess( m_Process, &ExitCode ) )
+		return std::nullopt;
+
+	return static_cast< int >( ExitCode );
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	pid_t Pid;
+
+	{
+		std::scoped_lock Lock( m_Mutex );
+
+		if( ( Pid = m_Pid ) <= 0 )
+			return std::nullopt;
+	}
+
+	// Wait without reaping, so that Kill() can't hit a recycled process ID in the meantime
+	siginfo_t Info;
+	while( waitid( P_PID, static_cast< id_t >( Pid ), &Info, WEXITED | WNOWAIT ) != 0 && errno == EINTR );
+
+	std::scoped_lock Lock( m_Mutex );
+
+	int Status = 0;
+	if( waitpid( Pid, &Status, 0 ) != Pid )
+		return std::nullopt;
+
+	m_Pid = 0;
+
+	if( WIFSIGNALED( Status ) )
+		return 128 + WTERMSIG( Status );
+
+	return WEXITSTATUS( Status );
+
+#endif // __linux__ || __APPLE__
+
+} // Wait
+
+//////////////////////////////////////////////////////////////////////////
+
+#if defined( _WIN32 )
+
+DWORD WINAPI PseudoTerminal::CloseWhenExited( LPVOID pParameter )
+{
+	PseudoTerminal* pSelf = static_cast< PseudoTerminal* >( pParameter );
+
+	WaitForSingleObject( pSelf->m_Process, INFINITE );
+
+	std::scoped_lock Lock( pSelf->m_Mutex );
+
+	ClosePseudoConsole( pSelf->m_PseudoConsole );
+	pSelf->m_PseudoConsole = nullptr;
+
+	return 0;
+
+} // CloseWhenExited
+
+#endif // _WIN32
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "Common/SHA256.h"
+
+#include <algorithm>
+#include <cstring>
+
+//////////////////////////////////////////////////////////////////////////
+
+static constexpr uint32_t RoundConstants[ 64 ] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+static constexpr uint32_t RotateRight( uint32_t Value, int Count )
+{
+	return ( Value >> Count ) | ( Value << ( 32 - Count ) );
+
+} // RotateRight
+
+//////////////////////////////////////////////////////////////////////////
+
+void SHA256::Update( const void* pData, size_t Size )
+{
+	const uint8_t* pBytes = static_cast< const uint8_t* >( pData );
+
+	m_TotalSize += Size;
+
+	// Top up a partially filled block first
+	if( m_BufferSize > 0 )
+	{
+		const size_t Count = std::min( Size, sizeof( m_Buffer ) - m_BufferSize );
+
+		std::memcpy( m_Buffer + m_BufferSize, pBytes, Count );
+		m_BufferSize += Count;
+		pBytes       += Count;
+		Size         -= Count;
+
+		if( m_BufferSize < sizeof( m_Buffer ) )
+			return;
+
+		Transform( m_Buffer );
+		m_BufferSize = 0;
+	}
+
+	// Then hash whole blocks straight from the input
+	for( ; Size >= sizeof( m_Buffer ); pBytes += sizeof( m_Buffer ), Size -= sizeof( m_Buffer ) )
+		Transform( pBytes );
+
+	std::memcpy( m_Buffer, pBytes, Size );
+	m_BufferSize = Size;
+
+} // Update
+
+//////////////////////////////////////////////////////////////////////////
+
+SHA256::Digest SHA256::Finish( void )
+{
+	const uint64_t TotalBits = m_TotalSize * 8;
+	const uint8_t  Padding   = 0x80;
+	const uint8_t  Zero      = 0x00;
+
+	Update( &Padding, 1 );
+
+	while( m_BufferSize != 56 )
+		Update( &Zero, 1 );
+
+	uint8_t Length[ 8 ];
+	for( int i = 0; i < 8; ++i )
+		Length[ i ] = static_cast< uint8_t >( TotalBits >> ( 56 - i * 8 ) );
+
+	Update( Length, sizeof( Length ) );
+
+	Digest Result;
+	for( int i = 0; i < 8; ++i )
+	{
+		Result[ i * 4 + 0 ] = static_cast< uint8_t >( m_State[ i ] >> 24 );
+		Result[ i * 4 + 1 ] = static_cast< uint8_t >( m_State[ i ] >> 16 );
+		Result[ i * 4 + 2 ] = static_cast< uint8_t >( m_State[ i ] >> 8 );
+		Result[ i * 4 + 3 ] = static_cast< uint8_t >( m_State[ i ] );
+	}
+
+	return Result;
+
+} // Finish
+
+//////////////////////////////////////////////////////////////////////////
+
+std::string SHA256::ToHex( const Digest& rDigest )
+{
+	constexpr char Digits[] = "0123456789abcdef";
+	std::string    Hex;
+	Hex.reserve( rDigest.size() * 2 );
+
+	for( uint8_t Byte : rDigest )
+	{
+		Hex += Digits[ Byte >> 4 ];
+		Hex += Digits[ Byte & 0xF ];
+	}
+
+	return Hex;
+
+} // ToHex
+
+//////////////////////////////////////////////////////////////////////////
+
+void SHA256::Transform( const uint8_t* pBlock )
+{
+	uint32_t Schedule[ 64 ];
+
+	for( int i = 0; i < 16; ++i )
+		Schedule[ i ] = ( uint32_t( pBlock[ i * 4 ] ) << 24 ) | ( uint32_t( pBlock[ i * 4 + 1 ] ) << 16 ) | ( uint32_t( pBlock[ i * 4 + 2 ] ) << 8 ) | uint32_t( pBlock[ i * 4 + 3 ] );
+
+	for( int i = 16; i < 64; ++i )
+	{
+		const uint32_t S0 = RotateRight( Schedule[ i - 15 ], 7 ) ^ RotateRight( Schedule[ i - 15 ], 18 ) ^ ( Schedule[ i - 15 ] >> 3 );
+		const uint32_t S1 = RotateRight( Schedule[ i - 2 ], 17 ) ^ RotateRight( Schedule[ i - 2 ], 19 ) ^ ( Schedule[ i - 2 ] >> 10 );
+
+		Schedule[ i ] = Schedule[ i - 16 ] + S0 + Schedule[ i - 7 ] + S1;
+	}
+
+	uint32_t A = m_State[ 0 ], B = m_State[ 1 ], C = m_State[ 2 ], D = m_State[ 3 ];
+	uint32_t E = m_State[ 4 ], F = m_State[ 5 ], G = m_State[ 6 ], H = m_State[ 7 ];
+
+	for( int i = 0; i < 64; ++i )
+	{
+		const uint32_t S1     = RotateRight( E, 6 ) ^ RotateRight( E, 11 ) ^ RotateRight( E, 25 );
+		const uint32_t Choose = ( E & F ) ^ ( ~E & G );
+		const uint32_t Temp1  = H + S1 + Choose + RoundConstants[ i ] + Schedule[ i ];
+		const uint32_t S0     = RotateRight( A, 2 ) ^ RotateRight( A, 13 ) ^ RotateRight( A, 22 );
+		const uint32_t Major  = ( A & B ) ^ ( A & C ) ^ ( B & C );
+		const uint32_t Temp2  = S0 + Major;
+
+		H = G;
+		G = F;
+		F = E;
+		E = D + Temp1;
+		D = C;
+		C = B;
+		B = A;
+		A = Temp1 + Temp2;
+	}
+
+	m_State[ 0 ] += A; m_State[ 1 ] += B; m_State[ 2 ] += C; m_State[ 3 ] += D;
+	m_State[ 4 ] += E; m_State[ 5 ] += F; m_State[ 6 ] += G; m_State[ 7 ] += H;
+
+} // Transform
@@ -17,9 +17,55 @@
 
 #include "CompilerGCC.h"
 
+#include <Common/Network/RemoteCompile.h>
+
+#include <fstream>
+
+//////////////////////////////////////////////////////////////////////////
+
+#if defined( _WIN32 )
+static constexpr std::wstring_view NullDevice = L"NUL";
+#else // _WIN32
+static constexpr std::wstring_view NullDevice = L"/dev/null";
+#endif // !_WIN32
+
+//////////////////////////////////////////////////////////////////////////
+
+static std::wstring_view GetLanguage( const std::filesystem::path& rFilePath )
+{
+	const auto FileExtension = rFilePath.extension();
+	if     ( FileExtension == ".c"    ) return L"c";
+	else if( FileExtension == ".cpp"  ) return L"c++";
+	else if( FileExtension == ".cxx"  ) return L"c++";
+	else if( FileExtension == ".cc"   ) return L"c++";
+	else if( FileExtension == ".cppm" ) return L"c++";
+	else if( FileExtension == ".ixx"  ) return L"c++";
+	else if( FileExtension == ".asm"  ) return L"assembler";
+	else                                return L"none";
+
+} // GetLanguage
+
 //////////////////////////////////////////////////////////////////////////
 
-std::wstring CompilerGCC::MakeCompilerCommandLineString( const Configuration& rConfiguration, const std::filesystem::path& rFilePath )
+static std::filesystem::path WriteModuleMapper( const std::filesystem::path& rObjectPath, const ModuleUnit& rModule )
+{
+	// GCC locates BMI's through a module mapper. Each line maps a module name to the file that holds its interface.
+	const std::filesystem::path MapperPath = std::filesystem::path( rObjectPath ).concat( ".modmap" );
+	std::ofstream               Mapper( MapperPath, std::ios::trunc );
+
+	if( rModule.IsInterface() )
+		Mapper << rModule.Provides << ' ' << rModule.ProvidedInterface.string() << '\n';
+
+	for( size_t i = 0; i < rModule.Requires.size() && i < rModule.RequiredInterfaces.size(); ++i )
+		Mapper << rModule.Requires[ i ] << ' ' << rModule.RequiredInterfaces[ i ].string() << '\n';
+
+	return MapperPath;
+
+} // WriteModuleMapper
+
+//////////////////////////////////////////////////////////////////////////
+
+std::wstring CompilerGCC::MakeCompilerCommandLineString( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, const ModuleUnit* pModule )
 {
 	std::wstring Command;
 	Command.reserve( 1024 );
@@ -31,16 +77,21 @@ std::wstring CompilerGCC::MakeCompilerCommandLineString( const Configuration& rC
 	Command += L" -c";
 
 	// Language
-	const auto FileExtension = rFilePath.extension();
-	if     ( FileExtension == ".c"   ) Command += L" -x c";
-	else if( FileExtension == ".cpp" ) Command += L" -x c++";
-	else if( FileExtension == ".cxx" ) Command += L" -x c++";
-	else if( FileExtension == ".cc"  ) Command += L" -x c++";
-	else if( FileExtension == ".asm" ) Command += L" -x assembler";
-	else                               Command += L" -x none";
+	Command += L" -x " + std::wstring( GetLanguage( rFilePath ) );
 
 	// TODO: Defines
 
+	// Modules
+	if( pModule && pModule->UsesModules() )
+	{
+		Command += L" -std=c++20 -fmodules-ts";
+		Command += L" -fmodule-mapper=" + WriteModuleMapper( GetCompilerOutputPath( rConfiguration, rFilePath ), *pModule ).wstring();
+	}
+
+	// Include trace and time report for build insights
+	if( rConfiguration.m_BuildInsights.value_or( false ) )
+		Command += L" -H -ftime-report";
+
 	// Verbosity
 	if( rConfiguration.m_Verbose )
 	{
@@ -63,6 +114,104 @@ std::wstring CompilerGCC::MakeCompilerCommandLineString( const Configuration& rC
 
 //////////////////////////////////////////////////////////////////////////
 
+std::wstring CompilerGCC::MakeScanCommandLineString( const Configuration& rConfiguration, const std::filesystem::path& rFilePath )
+{
+	const std::wstring ScanOutput = GetModuleScanOutputPath( rConfiguration, rFilePath ).wstring();
+
+	std::wstring Command;
+	Command.reserve( 1024 );
+
+	// Start with GCC executable
+	Command += L"g++";
+
+	// Only preprocess. The scan is a by-product of the preprocessor.
+	Command += L" -E -x c++ -std=c++20 -fmodules-ts";
+
+	// Emit the included headers, so that later builds can tell whether the scan results are still valid
+	Command += L" -MD -MF " + GetHeaderDependencyPath( rConfiguration, rFilePath ).wstring();
+	Command += L" -MT " + ScanOutput;
+
+	// P1689 output
+	Command += L" -fdeps-format=p1689r5";
+	Command += L" -fdeps-file=" + ScanOutput;
+	Command += L" -fdeps-target=" + GetCompilerOutputPath( rConfiguration, rFilePath ).wstring();
+
+	// We don't need the preprocessed source itself
+	Command += L" -o ";
+	Command += NullDevice;
+
+	// Finally, the input source file
+	Command += L" " + rFilePath.wstring();
+
+	return Command;
+
+} // MakeScanCommandLineString
+
+//////////////////////////////////////////////////////////////////////////
+
+std::wstring CompilerGCC::MakePreprocessCommandLineString( const Configuration& rConfiguration, const std::filesystem::path& rFilePath )
+{
+	const std::wstring_view Language = GetLanguage( rFilePath );
+
+	// Assembly doesn't go through the preprocessor
+	if( Language != L"c" && Language != L"c++" )
+		return { };
+
+	std::wstring Command;
+	Command.reserve( 1024 );
+
+	// Start with GCC executable
+	Command += L"g++";
+
+	// Only preprocess
+	Command += L" -E -x " + std::wstring( Language );
+
+	// Record the included headers, which is what the next build looks the object up by
+	Command += L" -MD -MF " + GetHeaderDependencyPath( rConfiguration, rFilePath ).wstring();
+
+	// Set output file
+	Command += L" -o " + GetPreprocessedOutputPath( rConfiguration, rFilePath ).wstring();
+
+	// Finally, the input source file
+	Command += L" " + rFilePath.wstring();
+
+	return Command;
+
+} // MakePreprocessCommandLineString
+
+//////////////////////////////////////////////////////////////////////////
+
+std::wstring CompilerGCC::MakePreprocessedCompileCommandLineString( const Configuration& rConfiguration, const std::filesystem::path& rFilePath )
+{
+	const std::wstring_view Language = GetLanguage( rFilePath );
+
+	if( Language != L"c" && Language != L"c++" )
+		return { };
+
+	UTF8Converter UTF8;
+	std::wstring  Command;
+	Command.reserve( 256 );
+
+	// Start with GCC executable
+	Command += L"g++";
+
+	// Compile separately. The input has already been through the preprocessor.
+	Command += ( Language == L"c" ) ? L" -c -x cpp-output" : L" -c -x c++-cpp-output";
+
+	// Verbosity
+	if( rConfiguration.m_Verbose )
+		Command += L" -time -v";
+
+	// The worker (or ICompiler, when compiling locally) fills in where its copy of the input is and where the object should go
+	Command += L" -o " + UTF8.from_bytes( RemoteCompile::OutputPlaceholder.data(), RemoteCompile::OutputPlaceholder.data() + RemoteCompile::OutputPlaceholder.size() );
+	Command += L" "    + UTF8.from_bytes( RemoteCompile::InputPlaceholder.data(),  RemoteCompile::InputPlaceholder.data()  + RemoteCompile::InputPlaceholder.size() );
+
+	return Command;
+
+} // MakePreprocessedCompileCommandLineString
+
+//////////////////////////////////////////////////////////////////////////
+
 std::wstring CompilerGCC::MakeLinkerCommandLineString( const Configuration& rConfiguration, std::span< std::filesystem::path > InputFiles, const std::wstring& rOutputName, Project::Kind Kind )
 {
 	std::wstring Command;
@@ -23,13 +23,18 @@ class CompilerGCC : public ICompiler
 {
 public:
 
-	std::string_view GetName( void ) const override { return "GCC"; }
+	std::string_view  GetName                    ( void ) const override { return "GCC"; }
+	std::wstring_view GetModuleInterfaceExtension( void ) const override { return L".gcm"; }
 
 //////////////////////////////////////////////////////////////////////////
 
 private:
 
-	std::wstring MakeCompilerCommandLineString( const Configuration& rConfiguration, const std::filesystem::path& rFilePath ) override;
-	std::wstring MakeLinkerCommandLineString  ( const Configuration& rConfiguration, std::span< std::filesystem::path > InputFiles, const std::wstring& rOutputName, Project::Kind Kind ) override;
+	std::wstring MakeCompilerCommandLineString           ( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, const ModuleUnit* pModule ) override;
+	std::wstring MakeLinkerCommandLineString             ( const Configuration& rConfiguration, std::span< std::filesystem::path > InputFiles, const std::wstring& rOutputName, Project::Kind Kind ) override;
+	std::wstring MakeScanCommandLineString               ( const Configuration& rConfiguration, const std::filesystem::path& rFilePath ) override;
+	std::wstring MakePreprocessCommandLineString         ( const Configuration& rConfiguration, const std::filesystem::path& rFilePath ) override;
+	std::wstring MakePreprocessedCompileCommandLineString( const Configuration& rConfiguration, const std::filesystem::path& rFilePath ) override;
+	std::wstring MakeVersionCommandLineString            ( void ) override { return L"g++ -dumpfullversion"; }
 
 }; // CompilerGCC
@@ -79,15 +79,16 @@ static std::filesystem::path FindMSVCDir( const std::filesystem::path& rProgramF
 	const std::filesystem::path VSWhereLocation = rProgramFilesX86 / "Microsoft Visual Studio" / "Installer" / "vswhere.exe";
 	if( std::filesystem::exists( VSWhereLocation ) )
 	{
-		// Run vswhere.exe to get the installation path of Visual Studio
-		int                Result;
-		std::wstring       VSWhereLocationFull = VSWhereLocation.wstring() + L" -latest -property installationPath";
-		Process            VSWhereProcess = Process( VSWhereLocationFull );
-		const std::wstring VSWhereOutput = VSWhereProcess.OutputOf( Result );
-		if( Result == 0 )
+		// Run vswhere.exe to get the installation path of Visual Studio. Don't let a hung installer service stall the compiler setup.
+		std::wstring      VSWhereLocationFull = VSWhereLocation.wstring() + L" -latest -property installationPath";
+		Process           VSWhereProcess      = Process( VSWhereLocationFull );
+		Process::Captured VSWhere             = VSWhereProcess.Capture( std::chrono::seconds( 10 ) );
+		if( !VSWhere.TimedOut && VSWhere.ExitCode == 0 )
 		{
 			// Trim trailing newlines
-			const std::filesystem::path VisualStudioLocation( VSWhereOutput.begin(), VSWhereOutput.end() - 2 );
+			VSWhere.StdOut.erase( VSWhere.StdOut.find_last_not_of( "\r\n \t" ) + 1 );
+
+			const std::filesystem::path VisualStudioLocation( VSWhere.StdOut );
 			if( std::filesystem::exists( VisualStudioLocation ) )
 			{
 				for( const std::filesystem::directory_entry& rMSVCDir : std::filesystem::directory_iterator( VisualStudioLocation / "VC" / "Tools" / "MSVC" ) )
@@ -124,7 +125,39 @@ static std::wstring FindWindowsSDKVersion( const Configuration& rConfiguration,
 
 //////////////////////////////////////////////////////////////////////////
 
-std::wstring CompilerMSVC::MakeCompilerCommandLineString( const Configuration& rConfiguration, const std::filesystem::path& rFilePath )
+static void AppendDefinesAndIncludeDirs( std::wstring& rCommandLine, const Configuration& rConfiguration, const std::filesystem::path& rProgramFilesX86, const std::filesystem::path& rMSVCDir )
+{
+	UTF8Converter UTF8;
+
+	// Add user-defined preprocessor defines
+	for( const std::string& rDefine : rConfiguration.m_Defines )
+	{
+		rCommandLine += L" /D \"" + UTF8.from_bytes( rDefine ) + L"\"";
+	}
+
+	// Set standard include directories
+	// TODO: Add these to the "Windows" system default configuration's m_IncludeDirs?
+	{
+		const std::wstring          WindowsSDKVersion    = FindWindowsSDKVersion( rConfiguration, rProgramFilesX86 );
+		const std::filesystem::path WindowsSDKIncludeDir = rProgramFilesX86 / "Windows Kits" / "10" / "Include" / WindowsSDKVersion;
+
+		rCommandLine += L" /I\"" + ( rMSVCDir / "include"            ).wstring() + L"\"";
+		rCommandLine += L" /I\"" + ( WindowsSDKIncludeDir / "ucrt"   ).wstring() + L"\"";
+		rCommandLine += L" /I\"" + ( WindowsSDKIncludeDir / "um"     ).wstring() + L"\"";
+		rCommandLine += L" /I\"" + ( WindowsSDKIncludeDir / "shared" ).wstring() + L"\"";
+	}
+
+	// Add user-defined include directories
+	for( const std::filesystem::path& rIncludeDir : rConfiguration.m_IncludeDirs )
+	{
+		rCommandLine += L" /I\"" + rIncludeDir.wstring() + L"\"";
+	}
+
+} // AppendDefinesAndIncludeDirs
+
+//////////////////////////////////////////////////////////////////////////
+
+std::wstring CompilerMSVC::MakeCompilerCommandLineString( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, const ModuleUnit* pModule )
 {
 	const std::filesystem::path ProgramFilesX86 = FindProgramFilesX86Dir();
 	const std::filesystem::path MSVCDir         = FindMSVCDir( ProgramFilesX86 );
@@ -145,30 +178,23 @@ std::wstring CompilerMSVC::MakeCompilerCommandLineString( const Configuration& r
 	else if( FileExtension == ".cpp" ) CommandLine += L" /std:c++latest /D _HAS_EXCEPTIONS=0";
 	else if( FileExtension == ".cxx" ) CommandLine += L" /std:c++latest /D _HAS_EXCEPTIONS=0";
 	else if( FileExtension == ".cc"  ) CommandLine += L" /std:c++latest /D _HAS_EXCEPTIONS=0";
+	else if( FileExtension == ".ixx" ) CommandLine += L" /std:c++latest /D _HAS_EXCEPTIONS=0";
 
-	// Add user-defined preprocessor defines
-	for( const std::string& rDefine : rConfiguration.m_Defines )
-	{
-		CommandLine += L" /D \"" + UTF8.from_bytes( rDefine ) + L"\"";
-	}
+	AppendDefinesAndIncludeDirs( CommandLine, rConfiguration, ProgramFilesX86, MSVCDir );
 
-	// Set standard include directories
-	// TODO: Add these to the "Windows" system default configuration's m_IncludeDirs?
+	// Modules
+	if( pModule )
 	{
-		const std::wstring          WindowsSDKVersion    = FindWindowsSDKVersion( rConfiguration, ProgramFilesX86 );
-		const std::filesystem::path WindowsSDKIncludeDir = ProgramFilesX86 / "Windows Kits" / "10" / "Include" / WindowsSDKVersion;
+		if( pModule->IsInterface() )
+			CommandLine += L" /interface /ifcOutput \"" + pModule->ProvidedInterface.wstring() + L"\"";
 
-		CommandLine += L" /I\"" + ( MSVCDir / "include"             ).wstring() + L"\"";
-		CommandLine += L" /I\"" + ( WindowsSDKIncludeDir / "ucrt"   ).wstring() + L"\"";
-		CommandLine += L" /I\"" + ( WindowsSDKIncludeDir / "um"     ).wstring() + L"\"";
-		CommandLine += L" /I\"" + ( WindowsSDKIncludeDir / "shared" ).wstring() + L"\"";
+		for( size_t i = 0; i < pModule->Requires.size() && i < pModule->RequiredInterfaces.size(); ++i )
+			CommandLine += L" /reference " + UTF8.from_bytes( pModule->Requires[ i ] ) + L"=\"" + pModule->RequiredInterfaces[ i ].wstring() + L"\"";
 	}
 
-	// Add user-defined include directories
-	for( const std::filesystem::path& rIncludeDir : rConfiguration.m_IncludeDirs )
-	{
-		CommandLine += L" /I\"" + rIncludeDir.wstring() + L"\"";
-	}
+	// Include trace and front-end timing for build insights
+	if( rConfiguration.m_BuildInsights.value_or( false ) )
+		CommandLine += L" /showIncludes /Bt+";
 
 	// Set output file
 	CommandLine += L" /Fo\"" + GetCompilerOutputPath( rConfiguration, rFilePath ).wstring() + L"\"";
@@ -178,6 +204,7 @@ std::wstring CompilerMSVC::MakeCompilerCommandLineString( const Configuration& r
 	else if( FileExtension == ".cpp" ) CommandLine += L" /Tp \"" + rFilePath.wstring() + L"\"";
 	else if( FileExtension == ".cxx" ) CommandLine += L" /Tp \"" + rFilePath.wstring() + L"\"";
 	else if( FileExtension == ".cc"  ) CommandLine += L" /Tp \"" + rFilePath.wstring() + L"\"";
+	else if( FileExtension == ".ixx" ) CommandLine += L" /Tp \"" + rFilePath.wstring() + L"\"";
 
 	return CommandLine;
 
@@ -185,6 +212,31 @@ std::wstring CompilerMSVC::MakeCompilerCommandLineString( const Configuration& r
 
 //////////////////////////////////////////////////////////////////////////
 
+std::wstring CompilerMSVC::MakeScanCommandLineString( const Configuration& rConfiguration, const std::filesystem::path& rFilePath )
+{
+	const std::filesystem::path ProgramFilesX86 = FindProgramFilesX86Dir();
+	const std::filesystem::path MSVCDir         = FindMSVCDir( ProgramFilesX86 );
+	const std::wstring          Host            = GetHostString();
+	const std::wstring          Target          = GetTargetString( rConfiguration.m_Architecture.value_or( Configuration::HostArchitecture() ) );
+
+	std::wstring CommandLine;
+	CommandLine += L"\"" + ( MSVCDir / "bin" / Host / Target / "cl.exe" ).wstring() + L"\"";
+	CommandLine += L" /nologo /std:c++latest /D _HAS_EXCEPTIONS=0";
+
+	AppendDefinesAndIncludeDirs( CommandLine, rConfiguration, ProgramFilesX86, MSVCDir );
+
+	// Write P1689 output instead of compiling
+	CommandLine += L" /scanDependencies \"" + GetModuleScanOutputPath( rConfiguration, rFilePath ).wstring() + L"\"";
+
+	// Set input file
+	CommandLine += L" /Tp \"" + rFilePath.wstring() + L"\"";
+
+	return CommandLine;
+
+} // MakeScanCommandLineString
+
+//////////////////////////////////////////////////////////////////////////
+
 std::wstring CompilerMSVC::MakeLinkerCommandLineString( const Configuration& rConfiguration, std::span< std::filesystem::path > InputFiles, const std::wstring& rOutputName, Project::Kind Kind )
 {
 	const std::filesystem::path ProgramFilesX86   = FindProgramFilesX86Dir();
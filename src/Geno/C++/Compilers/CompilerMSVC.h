@@ -25,14 +25,16 @@ class CompilerMSVC : public ICompiler
 {
 public:
 
-	std::string_view GetName( void ) const override { return "MSVC"; }
+	std::string_view  GetName                    ( void ) const override { return "MSVC"; }
+	std::wstring_view GetModuleInterfaceExtension( void ) const override { return L".ifc"; }
 
 //////////////////////////////////////////////////////////////////////////
 
 private:
 
-	std::wstring MakeCompilerCommandLineString( const Configuration& rConfiguration, const std::filesystem::path& rFilePath ) override;
+	std::wstring MakeCompilerCommandLineString( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, const ModuleUnit* pModule ) override;
 	std::wstring MakeLinkerCommandLineString  ( const Configuration& rConfiguration, std::span< std::filesystem::path > InputFiles, const std::wstring& rOutputName, Project::Kind Kind ) override;
+	std::wstring MakeScanCommandLineString    ( const Configuration& rConfiguration, const std::filesystem::path& rFilePath ) override;
 
 }; // CompilerMSVC
 
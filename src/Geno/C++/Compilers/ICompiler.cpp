@@ -19,38 +19,545 @@
 
 #include "Common/Platform/Win32/Win32Error.h"
 #include "Common/Platform/Win32/Win32ProcessInfo.h"
+#include "Common/Async/JobSystem.h"
 #include "Common/LocalAppData.h"
 #include "Common/Process.h"
+#include "Common/ProcessReactor.h"
+#include "Common/SHA256.h"
+#include "Compilers/RemoteCache.h"
+#include "Components/BuildInsights.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <future>
+#include <iostream>
+#include <sstream>
 
 //////////////////////////////////////////////////////////////////////////
 
-std::optional< std::filesystem::path > ICompiler::Compile( const Configuration& rConfiguration, const std::filesystem::path& rFilePath )
+static std::string ReadWholeFile( const std::filesystem::path& rPath )
 {
-	const std::wstring CommandLine    = MakeCompilerCommandLineString( rConfiguration, rFilePath );
-	Process            CompileProcess = Process( CommandLine );
-	const int          ExitCode       = CompileProcess.ResultOf();
+	std::ifstream     File( rPath, std::ios::binary );
+	std::stringstream Stream;
 
-	if( ExitCode == 0 )
-		return GetCompilerOutputPath( rConfiguration, rFilePath );
+	if( File )
+		Stream << File.rdbuf();
 
-	return std::nullopt;
+	return Stream.str();
+
+} // ReadWholeFile
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool WriteWholeFile( const std::filesystem::path& rPath, const std::string& rContents )
+{
+	std::ofstream File( rPath, std::ios::binary | std::ios::trunc );
+
+	File.write( rContents.data(), static_cast< std::streamsize >( rContents.size() ) );
+
+	if( !File )
+	{
+		std::cerr << "Failed to write " << rPath << "\n";
+		return false;
+	}
+
+	return true;
+
+} // WriteWholeFile
+
+//////////////////////////////////////////////////////////////////////////
+
+static void ReplacePlaceholder( std::wstring& rCommandLine, std::string_view Placeholder, const std::wstring& rPath )
+{
+	const std::wstring WidePlaceholder( Placeholder.begin(), Placeholder.end() );
+
+	for( size_t Offset = rCommandLine.find( WidePlaceholder ); Offset != std::wstring::npos; Offset = rCommandLine.find( WidePlaceholder, Offset + rPath.size() ) )
+		rCommandLine.replace( Offset, WidePlaceholder.size(), rPath );
+
+} // ReplacePlaceholder
+
+//////////////////////////////////////////////////////////////////////////
+
+// The command line for preprocessed sources is made up by MakePreprocessedCompileCommandLineString(), which separates its arguments by
+// single spaces and never quotes them. Workers are sent the compiler by name and the arguments one by one.
+static RemoteCompile::CompileRequest MakeCompileRequest( std::string_view CommandLine, std::string Source )
+{
+	RemoteCompile::CompileRequest Request;
+
+	while( !CommandLine.empty() )
+	{
+		const size_t           End      = std::min( CommandLine.find( ' ' ), CommandLine.size() );
+		const std::string_view Argument = CommandLine.substr( 0, End );
+
+		CommandLine.remove_prefix( std::min( End + 1, CommandLine.size() ) );
+
+		if( Argument.empty() )
+			continue;
+
+		if( Request.Compiler.empty() )
+			Request.Compiler = std::filesystem::path( Argument ).filename().string();
+		else
+			Request.Arguments.emplace_back( Argument );
+	}
+
+	Request.Source = std::move( Source );
+
+	return Request;
+
+} // MakeCompileRequest
+
+//////////////////////////////////////////////////////////////////////////
+
+void ICompiler::ScanModules( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, ScannedCallback OnScanned )
+{
+	const std::filesystem::path ScanOutput       = GetModuleScanOutputPath( rConfiguration, rFilePath );
+	const std::filesystem::path HeaderDependency = GetHeaderDependencyPath( rConfiguration, rFilePath );
+	const std::filesystem::path Outputs[]        = { ScanOutput, HeaderDependency };
+
+	auto Finish = [ ScanOutput, OnScanned ]( std::vector< std::filesystem::path > Headers )
+	{
+		std::optional< ModuleUnit > Unit = ModuleScanner::ParseP1689( ScanOutput );
+
+		if( Unit )
+			Unit->Headers = std::move( Headers );
+
+		OnScanned( std::move( Unit ) );
+	};
+
+	// Reuse the results of the previous scan if neither the source nor any of the headers it included have changed since
+	std::vector< std::filesystem::path > Inputs = ModuleScanner::ParseMakeDependencies( HeaderDependency );
+	Inputs.push_back( rFilePath );
+
+	if( ModuleScanner::IsUpToDate( Outputs, Inputs ) )
+	{
+		Finish( std::move( Inputs ) );
+		return;
+	}
+
+	const std::wstring CommandLine = MakeScanCommandLineString( rConfiguration, rFilePath );
+
+	if( CommandLine.empty() )
+	{
+		OnScanned( std::nullopt );
+		return;
+	}
+
+	auto OnExit = [ HeaderDependency, OnScanned, Finish ]( int ExitCode )
+	{
+		if( ExitCode != 0 )
+			OnScanned( std::nullopt );
+		else
+			Finish( ModuleScanner::ParseMakeDependencies( HeaderDependency ) );
+	};
+
+	if( !ProcessReactor::Instance().Spawn( Process( CommandLine ), []( std::string_view Output ) { std::cout << Output; }, OnExit ) )
+	{
+		std::cerr << "Failed to start the module scanner for " << rFilePath << "\n";
+		OnExit( -1 );
+	}
+
+} // ScanModules
+
+//////////////////////////////////////////////////////////////////////////
+
+void ICompiler::Compile( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, const ModuleUnit* pModule, FinishedCallback OnFinished )
+{
+	const std::filesystem::path OutputPath = GetCompilerOutputPath( rConfiguration, rFilePath );
+
+	if( pModule && pModule->IsInterface() )
+	{
+		// Rebuilding an interface invalidates every importer, so reuse the cached object and BMI if nothing they were built from has changed
+		const std::filesystem::path          Outputs[] = { OutputPath, pModule->ProvidedInterface };
+		std::vector< std::filesystem::path > Inputs    = pModule->Headers;
+
+		Inputs.push_back( rFilePath );
+		Inputs.insert( Inputs.end(), pModule->RequiredInterfaces.begin(), pModule->RequiredInterfaces.end() );
+
+		if( ModuleScanner::IsUpToDate( Outputs, Inputs ) )
+		{
+			OnFinished( OutputPath );
+			return;
+		}
+
+		std::error_code Error;
+		std::filesystem::create_directories( pModule->ProvidedInterface.parent_path(), Error );
+	}
+
+	// Units that import modules need the BMIs on this machine, and insights need the local trace, so only plain units are preprocessed up front.
+	// Doing that is only worth it if the result can be looked up in the cache or sent to a worker.
+	const bool         CollectInsights         = rConfiguration.m_BuildInsights.value_or( false );
+	const std::wstring PreprocessedCommandLine = ( pModule && pModule->UsesModules() ) || CollectInsights ? std::wstring() : MakePreprocessedCompileCommandLineString( rConfiguration, rFilePath );
+
+	if( !PreprocessedCommandLine.empty() && ( RemoteCache::Instance().IsEnabled() || WorkerPool::Instance().HasRemoteSlots() ) )
+	{
+		CompilePreprocessed( rConfiguration, rFilePath, PreprocessedCommandLine, std::move( OnFinished ) );
+		return;
+	}
+
+	const std::wstring          CommandLine = MakeCompilerCommandLineString( rConfiguration, rFilePath, pModule );
+	const std::filesystem::path TracePath   = CollectInsights ? GetInsightsOutputPath( rConfiguration, rFilePath ) : std::filesystem::path();
+
+	WorkerPool::Instance().Request( false, [ CommandLine, FilePath = rFilePath, OutputPath, TracePath, OnFinished ]( WorkerPool::Lease Slot )
+		{
+			// The slot is held until the compiler exits, which is after this returns
+			auto                           pSlot = std::make_shared< WorkerPool::Lease >( std::move( Slot ) );
+			ProcessReactor::OutputCallback OnOutput;
+			ProcessReactor::ExitCallback   OnExit;
+
+			if( !TracePath.empty() )
+			{
+				// The include trace and time report are interleaved with diagnostics, so capture everything and only forward the diagnostics
+				FILE* pTrace = fopen( TracePath.string().c_str(), "wb" );
+
+				if( !pTrace )
+				{
+					std::cerr << "Failed to open " << TracePath << " for writing\n";
+					OnFinished( std::nullopt );
+					return;
+				}
+
+				OnOutput = [ pTrace ]( std::string_view Output ) { fwrite( Output.data(), 1, Output.size(), pTrace ); };
+				OnExit   = [ pTrace, TracePath, OutputPath, pSlot, OnFinished ]( int ExitCode )
+				{
+					fclose( pTrace );
+					pSlot->Release();
+
+					std::cout << BuildInsights::ExtractDiagnostics( TracePath );
+
+					OnFinished( ExitCode == 0 ? std::optional( OutputPath ) : std::nullopt );
+				};
+			}
+			else
+			{
+				OnOutput = []( std::string_view Output ) { std::cout << Output; };
+				OnExit   = [ OutputPath, pSlot, OnFinished ]( int ExitCode )
+				{
+					pSlot->Release();
+
+					OnFinished( ExitCode == 0 ? std::optional( OutputPath ) : std::nullopt );
+				};
+			}
+
+			if( !ProcessReactor::Instance().Spawn( Process( CommandLine ), std::move( OnOutput ), OnExit ) )
+			{
+				std::cerr << "Failed to start the compiler for " << FilePath << "\n";
+				OnExit( -1 );
+			}
+		}
+	);
 
 } // Compile
 
 //////////////////////////////////////////////////////////////////////////
 
-std::optional< std::filesystem::path > ICompiler::Link( const Configuration& rConfiguration, std::span< std::filesystem::path > InputFiles, const std::wstring& rOutputName, Project::Kind Kind )
+void ICompiler::CompilePreprocessed( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, const std::wstring& rCommandLine, FinishedCallback OnFinished )
 {
-	const std::wstring CommandLine    = MakeLinkerCommandLineString( rConfiguration, InputFiles, rOutputName, Kind );
-	Process            LinkProcess    = Process( CommandLine );
-	const int          ExitCode       = LinkProcess.ResultOf();
+	RemoteCache& rCache = RemoteCache::Instance();
 
-	if( ExitCode == 0 )
-		return GetLinkerOutputPath( rConfiguration, rOutputName, Kind );
+	if( rCache.IsEnabled() && !m_CacheIdentityResolved )
+	{
+		ResolveCacheIdentity( [ this, Configuration = rConfiguration, FilePath = rFilePath, CommandLine = rCommandLine, OnFinished ]( void )
+			{
+				CompilePreprocessed( Configuration, FilePath, CommandLine, OnFinished );
+			}
+		);
+
+		return;
+	}
 
-	return std::nullopt;
+	// Direct lookup: the previous build recorded which headers the source included. If none of those have changed, the object can be found
+	// without the preprocessed source, so the lookup is sent off first and travels while the preprocessor runs.
+	std::optional< std::string > DirectKey    = rCache.IsEnabled() ? MakeDirectCacheKey( rConfiguration, rFilePath, UTF8Converter().to_bytes( rCommandLine ) ) : std::nullopt;
+	auto                         DirectLookup = std::make_shared< std::future< RemoteCache::Blob > >( DirectKey ? rCache.Get( *DirectKey ) : std::future< RemoteCache::Blob >() );
+
+	const std::wstring             PreprocessCommand = MakePreprocessCommandLineString( rConfiguration, rFilePath );
+	ProcessReactor::OutputCallback OnOutput          = []( std::string_view Output ) { std::cout << Output; };
+	ProcessReactor::ExitCallback   OnExit            = [ this, Configuration = rConfiguration, FilePath = rFilePath, CommandLine = rCommandLine, DirectLookup, OnFinished ]( int ExitCode )
+	{
+		// Errors in the source already show up here. Those won't go away on another machine, so report them right away.
+		if( ExitCode != 0 )
+			OnFinished( std::nullopt );
+		else
+			CompilePreprocessedSource( Configuration, FilePath, CommandLine, *DirectLookup, OnFinished );
+	};
+
+	if( !ProcessReactor::Instance().Spawn( Process( PreprocessCommand ), std::move( OnOutput ), OnExit ) )
+	{
+		std::cerr << "Failed to start the preprocessor for " << rFilePath << "\n";
+		OnExit( -1 );
+	}
+
+} // CompilePreprocessed
+
+//////////////////////////////////////////////////////////////////////////
+
+// Runs as the job that the preprocessor exited with. Waiting on the cache and sending the source off to a worker both block the job thread
+// for a round trip over the network, which is what Workspace reserves extra threads for. Local compiles are left to the ProcessReactor, and
+// the slots for either are queued for rather than waited on.
+void ICompiler::CompilePreprocessedSource( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, const std::wstring& rCommandLine, std::future< RemoteCache::Blob >& rDirectLookup, FinishedCallback OnFinished )
+{
+	const std::filesystem::path OutputPath       = GetCompilerOutputPath( rConfiguration, rFilePath );
+	const std::filesystem::path PreprocessedPath = GetPreprocessedOutputPath( rConfiguration, rFilePath );
+	const std::string           CommandLine      = UTF8Converter().to_bytes( rCommandLine );
+	RemoteCache&                rCache           = RemoteCache::Instance();
+	std::error_code             Error;
+
+	if( std::optional< std::string > Object = RemoteCache::Wait( rDirectLookup ) )
+	{
+		std::filesystem::remove( PreprocessedPath, Error );
+
+		OnFinished( WriteWholeFile( OutputPath, *Object ) ? std::optional( OutputPath ) : std::nullopt );
+		return;
+	}
+
+	std::string Source = ReadWholeFile( PreprocessedPath );
+	std::string PreprocessedKey;
+
+	if( rCache.IsEnabled() )
+	{
+		SHA256 Hash;
+		Hash.Update( "preprocessed\n" );
+		Hash.Update( GetCacheIdentity() );
+		Hash.Update( CommandLine );
+		Hash.Update( Source );
+
+		PreprocessedKey = SHA256::ToHex( Hash.Finish() );
+
+		std::future< RemoteCache::Blob > Lookup = rCache.Get( PreprocessedKey );
+
+		if( std::optional< std::string > Object = RemoteCache::Wait( Lookup ) )
+		{
+			std::filesystem::remove( PreprocessedPath, Error );
+
+			if( !WriteWholeFile( OutputPath, *Object ) )
+			{
+				OnFinished( std::nullopt );
+				return;
+			}
+
+			// Only the direct key missed, so there is nothing new to store under the preprocessed one
+			StoreInCache( rConfiguration, rFilePath, CommandLine, std::string(), std::move( *Object ) );
+			OnFinished( OutputPath );
+			return;
+		}
+	}
+
+	auto pSource = std::make_shared< std::string >( std::move( Source ) );
+
+	WorkerPool::Instance().Request( true, [ this, Configuration = rConfiguration, FilePath = rFilePath, CommandLine = rCommandLine, PreprocessedKey, pSource, OnFinished ]( WorkerPool::Lease Slot )
+		{
+			if( !Slot.IsRemote() )
+			{
+				CompilePreprocessedLocally( Configuration, FilePath, CommandLine, PreprocessedKey, std::move( Slot ), OnFinished );
+				return;
+			}
+
+			const std::filesystem::path OutputPath       = GetCompilerOutputPath( Configuration, FilePath );
+			const std::filesystem::path PreprocessedPath = GetPreprocessedOutputPath( Configuration, FilePath );
+			const std::string           UTF8CommandLine  = UTF8Converter().to_bytes( CommandLine );
+			std::error_code             Error;
+
+			if( std::optional< RemoteCompile::CompileResult > Result = Slot.Compile( MakeCompileRequest( UTF8CommandLine, std::move( *pSource ) ) ) )
+			{
+				std::filesystem::remove( PreprocessedPath, Error );
+				std::cout << Result->Diagnostics;
+
+				if( Result->ExitCode != 0 || !WriteWholeFile( OutputPath, Result->Object ) )
+				{
+					OnFinished( std::nullopt );
+					return;
+				}
+
+				StoreInCache( Configuration, FilePath, UTF8CommandLine, PreprocessedKey, std::move( Result->Object ) );
+				OnFinished( OutputPath );
+				return;
+			}
+
+			// The worker went away. Queue up for a local slot instead.
+			Slot.Release();
+
+			WorkerPool::Instance().Request( false, [ this, Configuration, FilePath, CommandLine, PreprocessedKey, OnFinished ]( WorkerPool::Lease LocalSlot )
+				{
+					CompilePreprocessedLocally( Configuration, FilePath, CommandLine, PreprocessedKey, std::move( LocalSlot ), OnFinished );
+				}
+			);
+		}
+	);
+
+} // CompilePreprocessedSource
+
+//////////////////////////////////////////////////////////////////////////
+
+void ICompiler::CompilePreprocessedLocally( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, const std::wstring& rCommandLine, const std::string& rPreprocessedKey, WorkerPool::Lease Slot, FinishedCallback OnFinished )
+{
+	const std::filesystem::path OutputPath       = GetCompilerOutputPath( rConfiguration, rFilePath );
+	const std::filesystem::path PreprocessedPath = GetPreprocessedOutputPath( rConfiguration, rFilePath );
+	const std::string           CommandLine      = UTF8Converter().to_bytes( rCommandLine );
+
+	// The slot is held until the compiler exits, which is after this returns
+	auto         pSlot            = std::make_shared< WorkerPool::Lease >( std::move( Slot ) );
+	std::wstring LocalCommandLine = rCommandLine;
+
+	ReplacePlaceholder( LocalCommandLine, RemoteCompile::InputPlaceholder,  PreprocessedPath.wstring() );
+	ReplacePlaceholder( LocalCommandLine, RemoteCompile::OutputPlaceholder, OutputPath.wstring() );
+
+	ProcessReactor::OutputCallback OnOutput = []( std::string_view Output ) { std::cout << Output; };
+	ProcessReactor::ExitCallback   OnExit   = [ this, Configuration = rConfiguration, FilePath = rFilePath, CommandLine, PreprocessedKey = rPreprocessedKey, PreprocessedPath, OutputPath, pSlot, OnFinished ]( int ExitCode )
+	{
+		std::error_code Error;
+
+		pSlot->Release();
+		std::filesystem::remove( PreprocessedPath, Error );
+
+		if( ExitCode != 0 )
+		{
+			OnFinished( std::nullopt );
+			return;
+		}
+
+		if( RemoteCache::Instance().IsEnabled() )
+			StoreInCache( Configuration, FilePath, CommandLine, PreprocessedKey, ReadWholeFile( OutputPath ) );
+
+		OnFinished( OutputPath );
+	};
+
+	if( !ProcessReactor::Instance().Spawn( Process( LocalCommandLine ), std::move( OnOutput ), OnExit ) )
+	{
+		std::cerr << "Failed to start the compiler for " << rFilePath << "\n";
+		OnExit( -1 );
+	}
+
+} // CompilePreprocessedLocally
+
+//////////////////////////////////////////////////////////////////////////
+
+void ICompiler::StoreInCache( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, std::string_view CommandLine, const std::string& rPreprocessedKey, std::string Object )
+{
+	RemoteCache& rCache = RemoteCache::Instance();
+
+	if( !rCache.IsEnabled() )
+		return;
+
+	// Only successful builds are shared. Diagnostics aren't stored, so warnings only show up on the machine that compiled the unit.
+	if( !rPreprocessedKey.empty() )
+		rCache.Put( rPreprocessedKey, Object );
+
+	// The direct lookup missed, so record the object under the key that the next build is going to look for first. That key is made from the
+	// headers that were just included, which may differ from the ones the previous build saw.
+	if( std::optional< std::string > DirectKey = MakeDirectCacheKey( rConfiguration, rFilePath, CommandLine ) )
+		rCache.Put( *DirectKey, std::move( Object ) );
+
+} // StoreInCache
+
+//////////////////////////////////////////////////////////////////////////
+
+std::optional< std::string > ICompiler::MakeDirectCacheKey( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, std::string_view CommandLine )
+{
+	// GCC lists the source first, followed by every header it included
+	const std::vector< std::filesystem::path > Inputs = ModuleScanner::ParseMakeDependencies( GetHeaderDependencyPath( rConfiguration, rFilePath ) );
+	if( Inputs.empty() )
+		return std::nullopt;
+
+	const std::string PreprocessCommand = UTF8Converter().to_bytes( MakePreprocessCommandLineString( rConfiguration, rFilePath ) );
+	SHA256            Hash;
+
+	Hash.Update( "direct\n" );
+	Hash.Update( GetCacheIdentity() );
+	Hash.Update( PreprocessCommand );
+	Hash.Update( CommandLine );
+
+	for( const std::filesystem::path& rInput : Inputs )
+	{
+		std::ifstream File( rInput, std::ios::binary );
+		if( !File )
+			return std::nullopt;
+
+		const std::string Name = rInput.string();
+		Hash.Update( Name.data(), Name.size() + 1 );
+
+		char Buffer[ 64 * 1024 ];
+		while( File.read( Buffer, sizeof( Buffer ) ) || File.gcount() > 0 )
+			Hash.Update( Buffer, static_cast< size_t >( File.gcount() ) );
+	}
+
+	return SHA256::ToHex( Hash.Finish() );
+
+} // MakeDirectCacheKey
+
+//////////////////////////////////////////////////////////////////////////
+
+// The compiler is asked for its version through the ProcessReactor, and the compiles that come in meanwhile are kept until it has answered
+void ICompiler::ResolveCacheIdentity( std::function< void( void ) > OnResolved )
+{
+	{
+		std::unique_lock Lock( m_CacheIdentityMutex );
+
+		if( m_CacheIdentityResolved )
+		{
+			Lock.unlock();
+			OnResolved();
+			return;
+		}
+
+		m_CacheIdentityWaiters.push_back( std::move( OnResolved ) );
+
+		// Someone else has already asked
+		if( m_CacheIdentityWaiters.size() > 1 )
+			return;
+	}
+
+	auto pIdentity = std::make_shared< std::string >( GetName() );
+	auto OnExit    = [ this, pIdentity ]( int /*ExitCode*/ )
+	{
+		std::vector< std::function< void( void ) > > Waiters;
+
+		{
+			std::scoped_lock Lock( m_CacheIdentityMutex );
+
+			m_CacheIdentity         = *pIdentity + "\n";
+			m_CacheIdentityResolved = true;
+
+			Waiters.swap( m_CacheIdentityWaiters );
+		}
+
+		for( std::function< void( void ) >& rWaiter : Waiters )
+			JobSystem::Instance().NewJob( std::move( rWaiter ) );
+	};
+
+	const std::wstring VersionCommand = MakeVersionCommandLineString();
+
+	if( VersionCommand.empty() )
+	{
+		OnExit( 0 );
+		return;
+	}
+
+	// Some compilers print their banner to stderr, so both streams make up the identity
+	*pIdentity += " ";
+
+	if( !ProcessReactor::Instance().Spawn( Process( VersionCommand ), [ pIdentity ]( std::string_view Output ) { pIdentity->append( Output ); }, OnExit ) )
+		OnExit( -1 );
+
+} // ResolveCacheIdentity
+
+//////////////////////////////////////////////////////////////////////////
+
+void ICompiler::Link( const Configuration& rConfiguration, std::span< std::filesystem::path > InputFiles, const std::wstring& rOutputName, Project::Kind Kind, FinishedCallback OnFinished )
+{
+	const std::wstring          CommandLine = MakeLinkerCommandLineString( rConfiguration, InputFiles, rOutputName, Kind );
+	const std::filesystem::path OutputPath  = GetLinkerOutputPath( rConfiguration, rOutputName, Kind );
+
+	auto OnExit = [ OutputPath, OnFinished ]( int ExitCode )
+	{
+		OnFinished( ExitCode == 0 ? std::optional( OutputPath ) : std::nullopt );
+	};
+
+	if( !ProcessReactor::Instance().Spawn( Process( CommandLine ), []( std::string_view Output ) { std::cout << Output; }, OnExit ) )
+	{
+		std::cerr << "Failed to start the linker for " << UTF8Converter().to_bytes( rOutputName ) << "\n";
+		OnExit( -1 );
+	}
 
 } // Link
 
@@ -64,6 +571,50 @@ std::filesystem::path ICompiler::GetCompilerOutputPath( const Configuration& rCo
 
 //////////////////////////////////////////////////////////////////////////
 
+std::filesystem::path ICompiler::GetModuleScanOutputPath( const Configuration& rConfiguration, const std::filesystem::path& rFilePath )
+{
+	return ( *rConfiguration.m_OutputDir / rFilePath.stem() ).concat( ".ddi" );
+
+} // GetModuleScanOutputPath
+
+//////////////////////////////////////////////////////////////////////////
+
+std::filesystem::path ICompiler::GetHeaderDependencyPath( const Configuration& rConfiguration, const std::filesystem::path& rFilePath )
+{
+	return ( *rConfiguration.m_OutputDir / rFilePath.stem() ).concat( ".d" );
+
+} // GetHeaderDependencyPath
+
+//////////////////////////////////////////////////////////////////////////
+
+std::filesystem::path ICompiler::GetInsightsOutputPath( const Configuration& rConfiguration, const std::filesystem::path& rFilePath )
+{
+	return ( *rConfiguration.m_OutputDir / rFilePath.stem() ).concat( ".trace" );
+
+} // GetInsightsOutputPath
+
+//////////////////////////////////////////////////////////////////////////
+
+std::filesystem::path ICompiler::GetPreprocessedOutputPath( const Configuration& rConfiguration, const std::filesystem::path& rFilePath )
+{
+	return ( *rConfiguration.m_OutputDir / rFilePath.stem() ).concat( ".i" );
+
+} // GetPreprocessedOutputPath
+
+//////////////////////////////////////////////////////////////////////////
+
+std::filesystem::path ICompiler::GetModuleInterfaceOutputPath( const Configuration& rConfiguration, std::string_view ModuleName ) const
+{
+	// Partitions are named 'Module:Partition', which isn't a valid file name on every platform
+	std::string FileName( ModuleName );
+	std::replace( FileName.begin(), FileName.end(), ':', '-' );
+
+	return ( *rConfiguration.m_OutputDir / "modules" / FileName ).concat( GetModuleInterfaceExtension() );
+
+} // GetModuleInterfaceOutputPath
+
+//////////////////////////////////////////////////////////////////////////
+
 std::filesystem::path ICompiler::GetLinkerOutputPath( const Configuration& rConfiguration, const std::wstring& rOutputName, Project::Kind Kind )
 {
 	std::filesystem::path OutputFile = ( *rConfiguration.m_OutputDir / rOutputName );
@@ -16,12 +16,17 @@
  */
 
 #pragma once
+#include "Compilers/ModuleScanner.h"
+#include "Compilers/RemoteCache.h"
+#include "Compilers/WorkerPool.h"
 #include "Components/Configuration.h"
 #include "Components/Project.h"
 
 #include <atomic>
 #include <filesystem>
+#include <functional>
 #include <future>
+#include <mutex>
 #include <span>
 #include <string_view>
 #include <string>
@@ -42,23 +47,75 @@ public:
 
 //////////////////////////////////////////////////////////////////////////
 
-	std::optional< std::filesystem::path > Compile( const Configuration& rConfiguration, const std::filesystem::path& rFilePath );
-	std::optional< std::filesystem::path > Link   ( const Configuration& rConfiguration, std::span< std::filesystem::path > InputFiles, const std::wstring& rOutputName, Project::Kind Kind );
+	// Called with the output file, or nothing if the compiler or linker failed
+	using FinishedCallback = std::function< void( std::optional< std::filesystem::path > Result ) >;
+
+	// Called with the modules of a unit, or nothing if it couldn't be scanned
+	using ScannedCallback  = std::function< void( std::optional< ModuleUnit > Unit ) >;
 
 //////////////////////////////////////////////////////////////////////////
 
-	virtual std::string_view GetName( void ) const = 0;
+	// The scanner, compiler and linker are left to the ProcessReactor, so these may return before they are done. The callback is called either way.
+	void ScanModules( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, ScannedCallback OnScanned );
+	void Compile    ( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, const ModuleUnit* pModule, FinishedCallback OnFinished );
+	void Link       ( const Configuration& rConfiguration, std::span< std::filesystem::path > InputFiles, const std::wstring& rOutputName, Project::Kind Kind, FinishedCallback OnFinished );
 
 //////////////////////////////////////////////////////////////////////////
 
-	static std::filesystem::path GetCompilerOutputPath( const Configuration& rConfiguration, const std::filesystem::path& rFilePath );
-	static std::filesystem::path GetLinkerOutputPath  ( const Configuration& rConfiguration, const std::wstring& rOutputName, Project::Kind Kind );
+	bool                  SupportsModules             ( void ) const { return !GetModuleInterfaceExtension().empty(); }
+	std::filesystem::path GetModuleInterfaceOutputPath( const Configuration& rConfiguration, std::string_view ModuleName ) const;
+
+//////////////////////////////////////////////////////////////////////////
+
+	virtual std::string_view  GetName                    ( void ) const = 0;
+	virtual std::wstring_view GetModuleInterfaceExtension( void ) const { return { }; }
+
+//////////////////////////////////////////////////////////////////////////
+
+	static std::filesystem::path GetCompilerOutputPath    ( const Configuration& rConfiguration, const std::filesystem::path& rFilePath );
+	static std::filesystem::path GetLinkerOutputPath      ( const Configuration& rConfiguration, const std::wstring& rOutputName, Project::Kind Kind );
+	static std::filesystem::path GetModuleScanOutputPath  ( const Configuration& rConfiguration, const std::filesystem::path& rFilePath );
+	static std::filesystem::path GetHeaderDependencyPath  ( const Configuration& rConfiguration, const std::filesystem::path& rFilePath );
+	static std::filesystem::path GetInsightsOutputPath    ( const Configuration& rConfiguration, const std::filesystem::path& rFilePath );
+	static std::filesystem::path GetPreprocessedOutputPath( const Configuration& rConfiguration, const std::filesystem::path& rFilePath );
 
 //////////////////////////////////////////////////////////////////////////
 
 protected:
 
-	virtual std::wstring MakeCompilerCommandLineString( const Configuration& rConfiguration, const std::filesystem::path& rFilePath ) = 0;
+	virtual std::wstring MakeCompilerCommandLineString( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, const ModuleUnit* pModule ) = 0;
 	virtual std::wstring MakeLinkerCommandLineString  ( const Configuration& rConfiguration, std::span< std::filesystem::path > InputFiles, const std::wstring& rOutputName, Project::Kind Kind ) = 0;
 
+	// Command that writes a P1689 dependency file to GetModuleScanOutputPath(). Compilers that can't scan return an empty string.
+	virtual std::wstring MakeScanCommandLineString( const Configuration& /*rConfiguration*/, const std::filesystem::path& /*rFilePath*/ ) { return { }; }
+
+	// Distributed compilation and caching. The source is preprocessed into GetPreprocessedOutputPath() locally, writing the included headers to
+	// GetHeaderDependencyPath(), and the result is compiled either by a geno-worker or here. The second command refers to its input and output
+	// through the placeholders in RemoteCompile. Compilers that can't do this return empty strings.
+	virtual std::wstring MakePreprocessCommandLineString         ( const Configuration& /*rConfiguration*/, const std::filesystem::path& /*rFilePath*/ ) { return { }; }
+	virtual std::wstring MakePreprocessedCompileCommandLineString( const Configuration& /*rConfiguration*/, const std::filesystem::path& /*rFilePath*/ ) { return { }; }
+
+	// Command that prints the exact compiler version. Objects built by different compilers must never share a cache key.
+	virtual std::wstring MakeVersionCommandLineString( void ) { return { }; }
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	void                         CompilePreprocessed       ( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, const std::wstring& rCommandLine, FinishedCallback OnFinished );
+	void                         CompilePreprocessedSource ( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, const std::wstring& rCommandLine, std::future< RemoteCache::Blob >& rDirectLookup, FinishedCallback OnFinished );
+	void                         CompilePreprocessedLocally( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, const std::wstring& rCommandLine, const std::string& rPreprocessedKey, WorkerPool::Lease Slot, FinishedCallback OnFinished );
+	void                         StoreInCache              ( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, std::string_view CommandLine, const std::string& rPreprocessedKey, std::string Object );
+	std::optional< std::string > MakeDirectCacheKey        ( const Configuration& rConfiguration, const std::filesystem::path& rFilePath, std::string_view CommandLine );
+	void                         ResolveCacheIdentity      ( std::function< void( void ) > OnResolved );
+	const std::string&           GetCacheIdentity          ( void ) const { return m_CacheIdentity; }
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Every cache key is made with the version of the compiler, which is asked for once and then kept
+	std::mutex                                   m_CacheIdentityMutex;
+	std::vector< std::function< void( void ) > > m_CacheIdentityWaiters;
+	std::string                                  m_CacheIdentity;
+	std::atomic< bool >                          m_CacheIdentityResolved = false;
+
 }; // ICompiler
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "ModuleScanner.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <rapidjson/document.h>
+
+//////////////////////////////////////////////////////////////////////////
+
+static std::string ReadWholeFile( const std::filesystem::path& rPath )
+{
+	std::ifstream     File( rPath, std::ios::binary );
+	std::stringstream Stream;
+
+	if( File )
+		Stream << File.rdbuf();
+
+	return Stream.str();
+
+} // ReadWholeFile
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool StartsWithKeyword( std::string_view Line, std::string_view Keyword )
+{
+	if( Line.substr( 0, Keyword.size() ) != Keyword )
+		return false;
+
+	// The keyword must be followed by a separator (e.g. 'import std;', 'import <vector>;', 'module;')
+	if( Line.size() == Keyword.size() )
+		return true;
+
+	const char Next = Line[ Keyword.size() ];
+
+	return Next == ' ' || Next == '\t' || Next == ';' || Next == '<' || Next == '"' || Next == ':';
+
+} // StartsWithKeyword
+
+//////////////////////////////////////////////////////////////////////////
+
+bool ModuleScanner::MightUseModules( const std::filesystem::path& rFilePath )
+{
+	std::ifstream File( rFilePath );
+	std::string   Line;
+
+	while( std::getline( File, Line ) )
+	{
+		std::string_view View = Line;
+
+		const size_t First = View.find_first_not_of( " \t" );
+		if( First == std::string_view::npos )
+			continue;
+
+		View.remove_prefix( First );
+
+		if( StartsWithKeyword( View, "export" ) )
+		{
+			View.remove_prefix( 6 );
+			View.remove_prefix( std::min( View.size(), View.find_first_not_of( " \t" ) ) );
+
+			if( StartsWithKeyword( View, "module" ) || StartsWithKeyword( View, "import" ) )
+				return true;
+		}
+		else if( StartsWithKeyword( View, "module" ) || StartsWithKeyword( View, "import" ) )
+		{
+			return true;
+		}
+	}
+
+	return false;
+
+} // MightUseModules
+
+//////////////////////////////////////////////////////////////////////////
+
+std::optional< ModuleUnit > ModuleScanner::ParseP1689( const std::filesystem::path& rDependencyFile )
+{
+	const std::string   Json = ReadWholeFile( rDependencyFile );
+	rapidjson::Document Document;
+
+	Document.Parse( Json.c_str(), Json.size() );
+
+	if( Document.HasParseError() || !Document.IsObject() )
+	{
+		std::cerr << "Failed to parse module dependency file " << rDependencyFile << "\n";
+		return std::nullopt;
+	}
+
+	auto Rules = Document.FindMember( "rules" );
+	if( Rules == Document.MemberEnd() || !Rules->value.IsArray() )
+		return std::nullopt;
+
+	ModuleUnit Unit;
+
+	for( const auto& rRule : Rules->value.GetArray() )
+	{
+		if( !rRule.IsObject() )
+			continue;
+
+		if( auto Provides = rRule.FindMember( "provides" ); Provides != rRule.MemberEnd() && Provides->value.IsArray() )
+		{
+			for( const auto& rProvided : Provides->value.GetArray() )
+			{
+				if( auto Name = rProvided.FindMember( "logical-name" ); Name != rProvided.MemberEnd() && Name->value.IsString() )
+					Unit.Provides = Name->value.GetString();
+			}
+		}
+
+		if( auto Requires = rRule.FindMember( "requires" ); Requires != rRule.MemberEnd() && Requires->value.IsArray() )
+		{
+			for( const auto& rRequired : Requires->value.GetArray() )
+			{
+				auto Name = rRequired.FindMember( "logical-name" );
+				if( Name == rRequired.MemberEnd() || !Name->value.IsString() )
+					continue;
+
+				// Header units carry a lookup method. Those are built by the compiler implicitly (if at all), so we don't schedule them.
+				if( rRequired.HasMember( "lookup-method" ) )
+				{
+					std::cerr << "Header unit " << Name->value.GetString() << " is not supported and will be treated as an include\n";
+					continue;
+				}
+
+				Unit.Requires.emplace_back( Name->value.GetString() );
+			}
+		}
+	}
+
+	return Unit;
+
+} // ParseP1689
+
+//////////////////////////////////////////////////////////////////////////
+
+std::vector< std::filesystem::path > ModuleScanner::ParseMakeDependencies( const std::filesystem::path& rDependencyFile )
+{
+	const std::string                    Text = ReadWholeFile( rDependencyFile );
+	std::vector< std::filesystem::path > Prerequisites;
+	std::string                          Current;
+	bool                                 InTargets = true;
+
+	for( size_t i = 0; i < Text.size(); ++i )
+	{
+		const char C = Text[ i ];
+
+		if( C == '\\' && i + 1 < Text.size() )
+		{
+			const char Next = Text[ i + 1 ];
+
+			// Line continuation
+			if( Next == '\n' || Next == '\r' )
+			{
+				i += ( Next == '\r' && i + 2 < Text.size() && Text[ i + 2 ] == '\n' ) ? 2 : 1;
+				continue;
+			}
+
+			// Escaped space in a path
+			if( Next == ' ' )
+			{
+				Current += ' ';
+				++i;
+				continue;
+			}
+		}
+
+		// The target list ends at the first colon that is followed by whitespace (so that drive letters survive)
+		if( InTargets && C == ':' && ( i + 1 == Text.size() || Text[ i + 1 ] == ' ' || Text[ i + 1 ] == '\n' || Text[ i + 1 ] == '\r' ) )
+		{
+			InTargets = false;
+			Current.clear();
+			continue;
+		}
+
+		if( C == ' ' || C == '\t' || C == '\n' || C == '\r' )
+		{
+			if( !InTargets && !Current.empty() )
+				Prerequisites.emplace_back( Current );
+
+			Current.clear();
+
+			// A new rule starts on the next line (e.g. the phony targets emitted by -MP)
+			if( C == '\n' )
+				InTargets = true;
+
+			continue;
+		}
+
+		Current += C;
+	}
+
+	if( !InTargets && !Current.empty() )
+		Prerequisites.emplace_back( Current );
+
+	return Prerequisites;
+
+} // ParseMakeDependencies
+
+//////////////////////////////////////////////////////////////////////////
+
+bool ModuleScanner::IsUpToDate( std::span< const std::filesystem::path > Outputs, std::span< const std::filesystem::path > Inputs )
+{
+	std::error_code                 Error;
+	std::filesystem::file_time_type OldestOutput = std::filesystem::file_time_type::max();
+
+	for( const std::filesystem::path& rOutput : Outputs )
+	{
+		const auto Time = std::filesystem::last_write_time( rOutput, Error );
+		if( Error )
+			return false;
+
+		OldestOutput = std::min( OldestOutput, Time );
+	}
+
+	for( const std::filesystem::path& rInput : Inputs )
+	{
+		const auto Time = std::filesystem::last_write_time( rInput, Error );
+		if( Error || Time > OldestOutput )
+			return false;
+	}
+
+	return true;
+
+} // IsUpToDate
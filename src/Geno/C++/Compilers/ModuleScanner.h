@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+// Module information of a single translation unit, as reported by a P1689 dependency scan
+struct ModuleUnit
+{
+	std::string                          Provides;           // Name of the module this unit is an interface for. Empty if it is not an interface unit.
+	std::filesystem::path                ProvidedInterface;  // Where the built module interface (BMI) of this unit is written
+	std::vector< std::string >           Requires;           // Names of the modules imported by this unit
+	std::vector< std::filesystem::path > RequiredInterfaces; // Resolved BMI's of each entry in Requires, in the same order
+	std::vector< std::filesystem::path > Headers;            // Headers included by this unit, used to determine if cached outputs are stale
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool IsInterface( void ) const { return !Provides.empty(); }
+	bool UsesModules( void ) const { return !Provides.empty() || !Requires.empty(); }
+
+}; // ModuleUnit
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace ModuleScanner
+{
+	// Cheap textual check that decides whether a file needs a full dependency scan at all.
+	// Any line that starts with 'module', 'export module' or 'import' qualifies.
+	bool MightUseModules( const std::filesystem::path& rFilePath );
+
+	// Parses a P1689 (r5) dependency file produced by a compiler scan
+	std::optional< ModuleUnit > ParseP1689( const std::filesystem::path& rDependencyFile );
+
+	// Parses a Makefile-style dependency file (-MD -MF) into its list of prerequisites
+	std::vector< std::filesystem::path > ParseMakeDependencies( const std::filesystem::path& rDependencyFile );
+
+	// Returns true if every output exists and is at least as recent as every input
+	bool IsUpToDate( std::span< const std::filesystem::path > Outputs, std::span< const std::filesystem::path > Inputs );
+
+} // ModuleScanner
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "RemoteCache.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////
+
+// Objects are rarely larger than this. A bigger response is taken as a broken cache rather than kept in memory.
+static constexpr size_t               MaxObjectSize = 256 * 1024 * 1024;
+static constexpr size_t               MaxBatchSize  = 64;
+static constexpr std::chrono::seconds LookupTimeout = std::chrono::seconds( 10 );
+static constexpr std::chrono::seconds RetryDelay    = std::chrono::seconds( 30 );
+
+//////////////////////////////////////////////////////////////////////////
+
+RemoteCache::~RemoteCache( void )
+{
+	Stop();
+
+} // ~RemoteCache
+
+//////////////////////////////////////////////////////////////////////////
+
+void RemoteCache::Refresh( void )
+{
+	std::optional< HTTP::URL > URL;
+
+	if( const char* pVariable = std::getenv( "GENO_CACHE" ); pVariable && *pVariable )
+	{
+		if( !( URL = HTTP::ParseURL( pVariable ) ) )
+			std::cerr << "GENO_CACHE: '" << pVariable << "' is not a valid http:// URL\n";
+	}
+
+	std::scoped_lock Lock( m_Mutex );
+
+	if( URL && m_URL && URL->Endpoint() == m_URL->Endpoint() && URL->Path == m_URL->Path )
+		return;
+
+	m_URL        = std::move( URL );
+	m_RetryAfter = { };
+
+	// The pipelines pick up the new address when they reconnect, so they only have to be started once
+	if( m_URL && !m_Lookups.Thread.joinable() )
+	{
+		m_Lookups.Thread = std::thread( &RemoteCache::PipelineMain, this, std::ref( m_Lookups ) );
+		m_Uploads.Thread = std::thread( &RemoteCache::PipelineMain, this, std::ref( m_Uploads ) );
+	}
+
+} // Refresh
+
+//////////////////////////////////////////////////////////////////////////
+
+bool RemoteCache::IsEnabled( void )
+{
+	std::scoped_lock Lock( m_Mutex );
+
+	return m_URL.has_value();
+
+} // IsEnabled
+
+//////////////////////////////////////////////////////////////////////////
+
+std::future< RemoteCache::Blob > RemoteCache::Get( const std::string& rKey )
+{
+	HTTP::Request Request;
+	Request.Method = "GET";
+	Request.Path   = "ac/" + rKey;
+
+	return Enqueue( m_Lookups, std::move( Request ) );
+
+} // Get
+
+//////////////////////////////////////////////////////////////////////////
+
+void RemoteCache::Put( const std::string& rKey, std::string Blob )
+{
+	HTTP::Request Request;
+	Request.Method = "PUT";
+	Request.Path   = "ac/" + rKey;
+	Request.Body   = std::move( Blob );
+
+	// Nobody waits for an upload. A failed one only means that the next build has to compile the unit again.
+	Enqueue( m_Uploads, std::move( Request ) );
+
+} // Put
+
+//////////////////////////////////////////////////////////////////////////
+
+RemoteCache::Blob RemoteCache::Wait( std::future< Blob >& rLookup )
+{
+	if( !rLookup.valid() || rLookup.wait_for( LookupTimeout ) != std::future_status::ready )
+		return std::nullopt;
+
+	return rLookup.get();
+
+} // Wait
+
+//////////////////////////////////////////////////////////////////////////
+
+std::future< RemoteCache::Blob > RemoteCache::Enqueue( Pipeline& rPipeline, HTTP::Request Request )
+{
+	PendingRequest      Pending;
+	std::future< Blob > Future = Pending.Promise.get_future();
+
+	Pending.Request = std::move( Request );
+
+	{
+		std::scoped_lock Lock( m_Mutex );
+
+		// Don't queue anything while the server is known to be unreachable
+		if( !m_URL || std::chrono::steady_clock::now() < m_RetryAfter )
+		{
+			Pending.Promise.set_value( std::nullopt );
+			return Future;
+		}
+
+		Pending.Request.Path.insert( 0, m_URL->Path + "/" );
+	}
+
+	{
+		std::scoped_lock Lock( rPipeline.Mutex );
+		rPipeline.Queue.push_back( std::move( Pending ) );
+	}
+
+	rPipeline.Wake.notify_one();
+
+	return Future;
+
+} // Enqueue
+
+//////////////////////////////////////////////////////////////////////////
+
+void RemoteCache::PipelineMain( Pipeline& rPipeline )
+{
+	HTTP::Connection Connection;
+	std::string      Host;
+
+	for( ;; )
+	{
+		std::vector< PendingRequest > Batch;
+
+		{
+			std::unique_lock Lock( rPipeline.Mutex );
+			rPipeline.Wake.wait( Lock, [ & ] { return rPipeline.Stopping || !rPipeline.Queue.empty(); } );
+
+			if( rPipeline.Stopping )
+				break;
+
+			while( !rPipeline.Queue.empty() && Batch.size() < MaxBatchSize )
+			{
+				Batch.push_back( std::move( rPipeline.Queue.front() ) );
+				rPipeline.Queue.pop_front();
+			}
+		}
+
+		if( !Connection )
+		{
+			std::string Endpoint;
+
+			{
+				std::scoped_lock Lock( m_Mutex );
+
+				if( m_URL )
+				{
+					Endpoint = m_URL->Endpoint();
+					Host     = m_URL->Host;
+				}
+			}
+
+			if( !Endpoint.empty() )
+				Connection = HTTP::Connection( Socket::Connect( Endpoint, LookupTimeout ) );
+
+			if( !Connection )
+			{
+				std::scoped_lock Lock( m_Mutex );
+
+				if( m_URL )
+					std::cerr << "Remote cache at " << m_URL->Endpoint() << " is unreachable. Retrying in " << RetryDelay.count() << " seconds.\n";
+
+				m_RetryAfter = std::chrono::steady_clock::now() + RetryDelay;
+			}
+		}
+
+		// Write every request before reading any of the responses
+		size_t Sent = 0;
+		if( Connection )
+		{
+			while( Sent < Batch.size() && Connection.SendRequest( Host, Batch[ Sent ].Request ) )
+				++Sent;
+		}
+
+		size_t Received  = 0;
+		bool   KeepAlive = Sent == Batch.size();
+
+		while( Received < Sent )
+		{
+			std::optional< HTTP::Response > Response = Connection.ReceiveResponse( MaxObjectSize );
+			if( !Response )
+			{
+				KeepAlive = false;
+				break;
+			}
+
+			PendingRequest& rPending = Batch[ Received++ ];
+
+			if( Response->Status == 200 && rPending.Request.Method == "GET" )
+				rPending.Promise.set_value( std::move( Response->Body ) );
+			else
+				rPending.Promise.set_value( std::nullopt );
+
+			// Anything pipelined behind this response is lost when the server closes the connection
+			if( !Response->KeepAlive )
+			{
+				KeepAlive = false;
+				break;
+			}
+		}
+
+		// Requests that didn't get an answer count as misses
+		for( size_t i = Received; i < Batch.size(); ++i )
+			Batch[ i ].Promise.set_value( std::nullopt );
+
+		if( !KeepAlive )
+			Connection.Close();
+	}
+
+	// Fail whatever is left, so that nobody waits on a promise that will never be kept
+	std::scoped_lock Lock( rPipeline.Mutex );
+
+	for( PendingRequest& rPending : rPipeline.Queue )
+		rPending.Promise.set_value( std::nullopt );
+
+	rPipeline.Queue.clear();
+
+} // PipelineMain
+
+//////////////////////////////////////////////////////////////////////////
+
+void RemoteCache::Stop( void )
+{
+	for( Pipeline* pPipeline : { &m_Lookups, &m_Uploads } )
+	{
+		{
+			std::scoped_lock Lock( pPipeline->Mutex );
+			pPipeline->Stopping = true;
+		}
+
+		pPipeline->Wake.notify_all();
+
+		if( pPipeline->Thread.joinable() )
+			pPipeline->Thread.join();
+	}
+
+} // Stop
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include <Common/Macros.h>
+#include <Common/Network/HTTP.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+// Client for a shared artifact cache that stores blobs by hash with plain HTTP GET/PUT, configured with GENO_CACHE=http://host:port/prefix.
+// Objects live under '<prefix>/ac/<key>', like in bazel-remote (which needs --disable_http_ac_validation for that) and sccache's WebDAV mode.
+class RemoteCache
+{
+	GENO_SINGLETON( RemoteCache );
+
+	 RemoteCache( void ) = default;
+	~RemoteCache( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+public:
+
+	using Blob = std::optional< std::string >;
+
+//////////////////////////////////////////////////////////////////////////
+
+	void                Refresh  ( void );
+	bool                IsEnabled( void );
+	std::future< Blob > Get      ( const std::string& rKey );
+	void                Put      ( const std::string& rKey, std::string Blob );
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Waits for a lookup, but treats a cache that takes too long to answer as a miss
+	static Blob Wait( std::future< Blob >& rLookup );
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	struct PendingRequest
+	{
+		HTTP::Request         Request;
+		std::promise< Blob >  Promise;
+
+	}; // PendingRequest
+
+	// Requests on a pipeline share one keep-alive connection. Whatever has queued up is written in one go before any of the responses
+	// are read, so a burst of lookups costs a single round trip.
+	struct Pipeline
+	{
+		std::thread                  Thread;
+		std::mutex                   Mutex;
+		std::condition_variable      Wake;
+		std::deque< PendingRequest > Queue;
+		bool                         Stopping = false;
+
+	}; // Pipeline
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::future< Blob > Enqueue     ( Pipeline& rPipeline, HTTP::Request Request );
+	void                PipelineMain( Pipeline& rPipeline );
+	void                Stop        ( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::mutex                            m_Mutex;
+	std::optional< HTTP::URL >            m_URL;
+	std::chrono::steady_clock::time_point m_RetryAfter;
+
+	// Uploads get a pipeline of their own, so that large objects don't hold up lookups
+	Pipeline                              m_Lookups;
+	Pipeline                              m_Uploads;
+
+}; // RemoteCache
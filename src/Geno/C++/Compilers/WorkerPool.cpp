@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "WorkerPool.h"
+
+#include <Common/Async/JobSystem.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+//////////////////////////////////////////////////////////////////////////
+
+// A worker that goes quiet for longer than this is given up on, and the source is compiled locally instead. Compiles get a lot more
+// room than the handshake, since nothing is sent back until the object file is done.
+static constexpr std::chrono::seconds ConnectTimeout = std::chrono::seconds( 5 );
+static constexpr std::chrono::minutes CompileTimeout = std::chrono::minutes( 5 );
+
+//////////////////////////////////////////////////////////////////////////
+
+static std::vector< std::string > ParseEndpoints( std::string_view List )
+{
+	std::vector< std::string > Endpoints;
+
+	while( !List.empty() )
+	{
+		const size_t Separator = List.find_first_of( ",; \t" );
+
+		if( Separator != 0 )
+			Endpoints.emplace_back( List.substr( 0, Separator ) );
+
+		if( Separator == std::string_view::npos )
+			break;
+
+		List.remove_prefix( Separator + 1 );
+	}
+
+	return Endpoints;
+
+} // ParseEndpoints
+
+//////////////////////////////////////////////////////////////////////////
+
+static std::unique_ptr< Socket > Handshake( const std::string& rEndpoint, uint32_t& rSlots )
+{
+	auto pConnection = std::make_unique< Socket >( Socket::Connect( rEndpoint, ConnectTimeout ) );
+
+	if( !*pConnection || !pConnection->SendFrame( RemoteCompile::Encode( RemoteCompile::Hello() ) ) )
+		return nullptr;
+
+	const std::optional< std::string >          Frame = pConnection->ReceiveFrame( RemoteCompile::MaxFrameSize );
+	const std::optional< RemoteCompile::Hello > Reply = Frame ? RemoteCompile::DecodeHello( *Frame ) : std::nullopt;
+
+	if( !Reply || Reply->Version != RemoteCompile::ProtocolVersion )
+	{
+		std::cerr << "Worker " << rEndpoint << " speaks an incompatible protocol\n";
+		return nullptr;
+	}
+
+	rSlots = Reply->Slots;
+
+	return pConnection;
+
+} // Handshake
+
+//////////////////////////////////////////////////////////////////////////
+
+WorkerPool::Lease::Lease( Lease&& rrOther ) noexcept
+	: m_pPool  ( std::exchange( rrOther.m_pPool, nullptr ) )
+	, m_pWorker( std::exchange( rrOther.m_pWorker, nullptr ) )
+{
+
+} // Lease
+
+//////////////////////////////////////////////////////////////////////////
+
+WorkerPool::Lease& WorkerPool::Lease::operator=( Lease&& rrOther ) noexcept
+{
+	if( this != &rrOther )
+	{
+		Release();
+
+		m_pPool   = std::exchange( rrOther.m_pPool, nullptr );
+		m_pWorker = std::exchange( rrOther.m_pWorker, nullptr );
+	}
+
+	return *this;
+
+} // operator=
+
+//////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::Lease::Release( void )
+{
+	if( m_pPool )
+		m_pPool->Release( m_pWorker );
+
+	m_pPool   = nullptr;
+	m_pWorker = nullptr;
+
+} // Release
+
+//////////////////////////////////////////////////////////////////////////
+
+std::optional< RemoteCompile::CompileResult > WorkerPool::Lease::Compile( const RemoteCompile::CompileRequest& rRequest )
+{
+	if( !m_pPool || !m_pWorker )
+		return std::nullopt;
+
+	std::unique_ptr< Socket > pConnection = m_pPool->TakeConnection( *m_pWorker );
+
+	if( pConnection && pConnection->SetTimeout( CompileTimeout ) && pConnection->SendFrame( RemoteCompile::Encode( rRequest ) ) )
+	{
+		if( std::optional< std::string > Frame = pConnection->ReceiveFrame( RemoteCompile::MaxFrameSize ) )
+		{
+			if( std::optional< RemoteCompile::CompileResult > Result = RemoteCompile::DecodeCompileResult( *Frame ) )
+			{
+				m_pPool->ReturnConnection( *m_pWorker, std::move( pConnection ) );
+				return Result;
+			}
+		}
+	}
+
+	std::cerr << "Lost connection to worker " << m_pWorker->Endpoint << " or it stopped answering, compiling locally instead\n";
+
+	m_pPool->SetOffline( *m_pWorker );
+
+	return std::nullopt;
+
+} // Compile
+
+//////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::Refresh( void )
+{
+	struct Candidate
+	{
+		std::string               Endpoint;
+		std::unique_ptr< Socket > pConnection;
+		uint32_t                  Slots = 0;
+
+	}; // Candidate
+
+	const char*              pWorkersVariable = std::getenv( "GENO_WORKERS" );
+	std::vector< Candidate > Candidates;
+
+	for( std::string& rEndpoint : ParseEndpoints( pWorkersVariable ? pWorkersVariable : "" ) )
+	{
+		Candidate& rCandidate  = Candidates.emplace_back();
+		rCandidate.pConnection = Handshake( rEndpoint, rCandidate.Slots );
+		rCandidate.Endpoint    = std::move( rEndpoint );
+
+		if( !rCandidate.pConnection )
+			std::cerr << "Worker " << rCandidate.Endpoint << " is not available\n";
+	}
+
+	{
+		std::scoped_lock Lock( m_Mutex );
+
+		m_LocalSlots = std::max( 1u, std::thread::hardware_concurrency() );
+
+		// Leases point into the worker list, so leave it alone while a build is still using it
+		const bool InUse = std::any_of( m_Workers.begin(), m_Workers.end(), []( const std::unique_ptr< RemoteWorker >& rWorker ) { return rWorker->SlotsInUse > 0; } );
+
+		if( !InUse )
+		{
+			m_Workers.clear();
+
+			for( Candidate& rCandidate : Candidates )
+			{
+				auto pWorker      = std::make_unique< RemoteWorker >();
+				pWorker->Endpoint = std::move( rCandidate.Endpoint );
+				pWorker->Slots    = rCandidate.Slots;
+				pWorker->Offline  = !rCandidate.pConnection;
+
+				if( rCandidate.pConnection )
+					pWorker->Connections.push_back( std::move( rCandidate.pConnection ) );
+
+				m_Workers.push_back( std::move( pWorker ) );
+			}
+		}
+	}
+
+	GrantPending();
+
+} // Refresh
+
+//////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::Request( bool AllowRemote, GrantedCallback OnGranted )
+{
+	{
+		std::scoped_lock Lock( m_Mutex );
+
+		m_Pending.push_back( PendingRequest{ .AllowRemote = AllowRemote, .OnGranted = std::move( OnGranted ) } );
+	}
+
+	GrantPending();
+
+} // Request
+
+//////////////////////////////////////////////////////////////////////////
+
+bool WorkerPool::TakeSlot( bool AllowRemote, RemoteWorker*& rpWorker )
+{
+	if( m_LocalSlots == 0 )
+		m_LocalSlots = std::max( 1u, std::thread::hardware_concurrency() );
+
+	// Prefer the local machine, since remote compiles pay for preprocessing and the round trip
+	if( m_LocalSlotsInUse < m_LocalSlots )
+	{
+		++m_LocalSlotsInUse;
+		rpWorker = nullptr;
+		return true;
+	}
+
+	if( !AllowRemote )
+		return false;
+
+	for( std::unique_ptr< RemoteWorker >& rWorker : m_Workers )
+	{
+		if( !rWorker->Offline && rWorker->SlotsInUse < rWorker->Slots )
+		{
+			++rWorker->SlotsInUse;
+			rpWorker = rWorker.get();
+			return true;
+		}
+	}
+
+	return false;
+
+} // TakeSlot
+
+//////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::GrantPending( void )
+{
+	std::vector< std::pair< GrantedCallback, Lease > > Granted;
+
+	{
+		std::scoped_lock Lock( m_Mutex );
+
+		// A request that only takes local slots doesn't hold up the ones behind it that may go to a worker
+		for( auto It = m_Pending.begin(); It != m_Pending.end(); )
+		{
+			RemoteWorker* pWorker;
+
+			if( !TakeSlot( It->AllowRemote, pWorker ) )
+			{
+				++It;
+				continue;
+			}
+
+			Lease Slot;
+			Slot.m_pPool   = this;
+			Slot.m_pWorker = pWorker;
+
+			Granted.emplace_back( std::move( It->OnGranted ), std::move( Slot ) );
+			It = m_Pending.erase( It );
+		}
+	}
+
+	// Granted as jobs of their own, since this may be running inside the release of another lease
+	for( auto& [ rOnGranted, rSlot ] : Granted )
+	{
+		auto pSlot = std::make_shared< Lease >( std::move( rSlot ) );
+
+		JobSystem::Instance().NewJob( [ OnGranted = std::move( rOnGranted ), pSlot ]( void ) { OnGranted( std::move( *pSlot ) ); } );
+	}
+
+} // GrantPending
+
+//////////////////////////////////////////////////////////////////////////
+
+size_t WorkerPool::TotalSlots( void )
+{
+	std::scoped_lock Lock( m_Mutex );
+	size_t           Total = std::max( 1u, std::thread::hardware_concurrency() );
+
+	for( const std::unique_ptr< RemoteWorker >& rWorker : m_Workers )
+	{
+		if( !rWorker->Offline )
+			Total += rWorker->Slots;
+	}
+
+	return Total;
+
+} // TotalSlots
+
+//////////////////////////////////////////////////////////////////////////
+
+bool WorkerPool::HasRemoteSlots( void )
+{
+	std::scoped_lock Lock( m_Mutex );
+
+	return std::any_of( m_Workers.begin(), m_Workers.end(), []( const std::unique_ptr< RemoteWorker >& rWorker ) { return !rWorker->Offline && rWorker->Slots > 0; } );
+
+} // HasRemoteSlots
+
+//////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::Release( RemoteWorker* pWorker )
+{
+	{
+		std::scoped_lock Lock( m_Mutex );
+
+		if( pWorker ) --pWorker->SlotsInUse;
+		else          --m_LocalSlotsInUse;
+	}
+
+	GrantPending();
+
+} // Release
+
+//////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::SetOffline( RemoteWorker& rWorker )
+{
+	std::scoped_lock Lock( m_Mutex );
+
+	// Requests that are still queued will settle for another slot
+	rWorker.Offline = true;
+	rWorker.Connections.clear();
+
+} // SetOffline
+
+//////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr< Socket > WorkerPool::TakeConnection( RemoteWorker& rWorker )
+{
+	{
+		std::scoped_lock Lock( m_Mutex );
+
+		if( !rWorker.Connections.empty() )
+		{
+			std::unique_ptr< Socket > pConnection = std::move( rWorker.Connections.back() );
+			rWorker.Connections.pop_back();
+
+			return pConnection;
+		}
+	}
+
+	// Connecting may take a while, so do it without holding up the other slots
+	auto pConnection = std::make_unique< Socket >( Socket::Connect( rWorker.Endpoint, ConnectTimeout ) );
+
+	if( !*pConnection )
+		return nullptr;
+
+	return pConnection;
+
+} // TakeConnection
+
+//////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::ReturnConnection( RemoteWorker& rWorker, std::unique_ptr< Socket > pConnection )
+{
+	std::scoped_lock Lock( m_Mutex );
+
+	if( !rWorker.Offline )
+		rWorker.Connections.push_back( std::move( pConnection ) );
+
+} // ReturnConnection
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include <Common/Macros.h>
+#include <Common/Network/RemoteCompile.h>
+#include <Common/Network/Socket.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Hands out compile slots across this machine and every geno-worker listed in the GENO_WORKERS environment variable.
+// Remote slots are treated just like local ones: a compile takes whichever slot is free and is queued when there are none.
+// Nothing ever waits for a slot on a job thread. Slots are given back by jobs (e.g. the one that a compiler exited with), so a job
+// thread that waited for one would be a thread less to give them back with.
+class WorkerPool
+{
+	GENO_SINGLETON( WorkerPool );
+
+	WorkerPool( void ) = default;
+
+//////////////////////////////////////////////////////////////////////////
+
+public:
+
+	struct RemoteWorker
+	{
+		std::string                              Endpoint;
+		uint32_t                                 Slots      = 0;
+		uint32_t                                 SlotsInUse = 0;
+		bool                                     Offline    = false;
+
+		// Idle connections, kept open between compiles to save the handshake
+		std::vector< std::unique_ptr< Socket > > Connections;
+
+	}; // RemoteWorker
+
+//////////////////////////////////////////////////////////////////////////
+
+	class Lease
+	{
+		GENO_DISABLE_COPY( Lease );
+
+	//////////////////////////////////////////////////////////////////////////
+
+	public:
+
+		 Lease( void ) = default;
+		 Lease( Lease&& rrOther ) noexcept;
+		~Lease( void ) { Release(); }
+
+		 Lease& operator=( Lease&& rrOther ) noexcept;
+
+	//////////////////////////////////////////////////////////////////////////
+
+		bool IsRemote( void ) const { return m_pWorker != nullptr; }
+		void Release ( void );
+
+	//////////////////////////////////////////////////////////////////////////
+
+		// Sends the request to the leased worker. Returns nothing if the worker couldn't be reached, in which case it is taken offline.
+		std::optional< RemoteCompile::CompileResult > Compile( const RemoteCompile::CompileRequest& rRequest );
+
+	//////////////////////////////////////////////////////////////////////////
+
+	private:
+
+		friend class WorkerPool;
+
+		WorkerPool*   m_pPool   = nullptr;
+		RemoteWorker* m_pWorker = nullptr;
+
+	}; // Lease
+
+//////////////////////////////////////////////////////////////////////////
+
+	using GrantedCallback = std::function< void( Lease Slot ) >;
+
+//////////////////////////////////////////////////////////////////////////
+
+	void   Refresh       ( void );
+	size_t TotalSlots    ( void );
+	bool   HasRemoteSlots( void );
+
+	// Runs OnGranted as a job of its own with a slot, as soon as one is free. Requests are granted in the order they came in.
+	void   Request       ( bool AllowRemote, GrantedCallback OnGranted );
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	struct PendingRequest
+	{
+		bool            AllowRemote = false;
+		GrantedCallback OnGranted;
+
+	}; // PendingRequest
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool                      TakeSlot        ( bool AllowRemote, RemoteWorker*& rpWorker );
+	void                      GrantPending    ( void );
+	void                      Release         ( RemoteWorker* pWorker );
+	void                      SetOffline      ( RemoteWorker& rWorker );
+	std::unique_ptr< Socket > TakeConnection  ( RemoteWorker& rWorker );
+	void                      ReturnConnection( RemoteWorker& rWorker, std::unique_ptr< Socket > pConnection );
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::mutex                                     m_Mutex;
+	std::deque< PendingRequest >                   m_Pending;
+	std::vector< std::unique_ptr< RemoteWorker > > m_Workers;
+	uint32_t                                       m_LocalSlots      = 0;
+	uint32_t                                       m_LocalSlotsInUse = 0;
+
+}; // WorkerPool
@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "BuildInsights.h"
+
+#include <Common/Async/JobSystem.h>
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+//////////////////////////////////////////////////////////////////////////
+
+enum class TraceLine
+{
+	Diagnostic,
+	Include,
+	Timing,
+	Ignored,
+
+}; // TraceLine
+
+//////////////////////////////////////////////////////////////////////////
+
+struct TraceReader
+{
+	bool InGuardList  = false;
+	bool InTimeReport = false;
+
+}; // TraceReader
+
+//////////////////////////////////////////////////////////////////////////
+
+// Cost of a single header within a single translation unit
+struct UnitHeaderCost
+{
+	double InclusiveTime = 0.0;
+	double SelfTime      = 0.0;
+	size_t Occurrences   = 0;
+	size_t FanOut        = 0;
+
+}; // UnitHeaderCost
+
+using UnitCosts = std::unordered_map< std::string, UnitHeaderCost >;
+
+//////////////////////////////////////////////////////////////////////////
+
+static TraceLine ClassifyLine( std::string_view Line, TraceReader& rReader, size_t& rDepth, std::string_view& rValue )
+{
+	if( !Line.empty() && Line.back() == '\r' )
+		Line.remove_suffix( 1 );
+
+	// GCC (-H): One dot per level of nesting, followed by the path
+	if( !Line.empty() && Line.front() == '.' )
+	{
+		const size_t Dots = Line.find_first_not_of( '.' );
+
+		if( Dots != std::string_view::npos && Line[ Dots ] == ' ' )
+		{
+			rDepth = Dots;
+			rValue = Line.substr( Dots + 1 );
+			return TraceLine::Include;
+		}
+	}
+
+	// MSVC (/showIncludes): One space per level of nesting
+	constexpr std::string_view MSVCIncludePrefix = "Note: including file:";
+	if( Line.starts_with( MSVCIncludePrefix ) )
+	{
+		const std::string_view Rest   = Line.substr( MSVCIncludePrefix.size() );
+		const size_t           Spaces = Rest.find_first_not_of( ' ' );
+
+		if( Spaces != std::string_view::npos )
+		{
+			rDepth = Spaces;
+			rValue = Rest.substr( Spaces );
+			return TraceLine::Include;
+		}
+	}
+
+	// GCC lists the headers that lack include guards after the trace, terminated by an empty line
+	if( Line.starts_with( "Multiple include guards may be useful for:" ) )
+	{
+		rReader.InGuardList = true;
+		return TraceLine::Ignored;
+	}
+
+	if( rReader.InGuardList )
+	{
+		rReader.InGuardList = !Line.empty();
+		return TraceLine::Ignored;
+	}
+
+	// GCC (-ftime-report): Always printed last
+	if( Line.starts_with( "Time variable" ) )
+		rReader.InTimeReport = true;
+
+	if( rReader.InTimeReport )
+	{
+		if( const size_t Colon = Line.find( ':' ); Colon != std::string_view::npos && Line.substr( 0, Colon ).find( "phase parsing" ) != std::string_view::npos )
+		{
+			rValue = Line.substr( Colon + 1 );
+			return TraceLine::Timing;
+		}
+
+		return TraceLine::Ignored;
+	}
+
+	// MSVC (/Bt+): 'time(C:\...\c1xx.dll)=0.52s < ... >'. c1xx is the front-end.
+	if( Line.starts_with( "time(" ) )
+	{
+		const size_t Equals = Line.find( ")=" );
+
+		if( Line.find( "c1xx.dll" ) != std::string_view::npos && Equals != std::string_view::npos )
+		{
+			rValue = Line.substr( Equals + 2 );
+			return TraceLine::Timing;
+		}
+
+		return TraceLine::Ignored;
+	}
+
+	return TraceLine::Diagnostic;
+
+} // ClassifyLine
+
+//////////////////////////////////////////////////////////////////////////
+
+static double ParseSeconds( std::string_view Value, bool IsTimeReport )
+{
+	std::vector< double > Numbers;
+
+	while( !Value.empty() )
+	{
+		const size_t Start = Value.find_first_not_of( " \t" );
+		if( Start == std::string_view::npos )
+			break;
+
+		Value.remove_prefix( Start );
+
+		const size_t           End   = std::min( Value.size(), Value.find_first_of( " \t" ) );
+		const std::string_view Token = Value.substr( 0, End );
+
+		Value.remove_prefix( End );
+
+		// Skip percentages, which are printed in parentheses
+		if( Token.front() == '(' || Token.back() == ')' )
+			continue;
+
+		double Number;
+		if( std::from_chars( Token.data(), Token.data() + Token.size(), Number ).ec == std::errc() )
+			Numbers.push_back( Number );
+	}
+
+	// The GCC time report lists user, system and wall time. Wall time is what the user waited for.
+	if( IsTimeReport )
+		return Numbers.size() >= 3 ? Numbers[ 2 ] : 0.0;
+
+	return Numbers.empty() ? 0.0 : Numbers.front();
+
+} // ParseSeconds
+
+//////////////////////////////////////////////////////////////////////////
+
+static UnitCosts ParseTrace( const std::filesystem::path& rSource, const std::filesystem::path& rTraceFile )
+{
+	struct Node
+	{
+		std::string Path;
+		uintmax_t   Size         = 0;
+		uintmax_t   SubtreeSize  = 0;
+		size_t      SubtreeCount = 0;
+		size_t      Parent       = SIZE_MAX;
+
+	}; // Node
+
+	std::ifstream         File( rTraceFile );
+	std::string           Line;
+	TraceReader           Reader;
+	std::vector< Node >   Nodes;
+	std::vector< size_t > Stack;
+	double                ParseTime = 0.0;
+	std::error_code       Error;
+
+	while( std::getline( File, Line ) )
+	{
+		size_t           Depth = 0;
+		std::string_view Value;
+
+		switch( ClassifyLine( Line, Reader, Depth, Value ) )
+		{
+			case TraceLine::Include:
+			{
+				// Depth is 1-based. Everything deeper than the parent of this node has been closed.
+				Stack.resize( std::min( Stack.size(), Depth - 1 ) );
+
+				Node& rNode  = Nodes.emplace_back();
+				rNode.Path   = std::filesystem::path( Value ).lexically_normal().string();
+				rNode.Parent = Stack.empty() ? SIZE_MAX : Stack.back();
+
+				if( const uintmax_t Size = std::filesystem::file_size( rNode.Path, Error ); !Error )
+					rNode.Size = Size;
+
+				Stack.push_back( Nodes.size() - 1 );
+
+			} break;
+
+			case TraceLine::Timing:
+			{
+				ParseTime += ParseSeconds( Value, Reader.InTimeReport );
+
+			} break;
+
+			default:
+			{
+			} break;
+		}
+	}
+
+	// Nodes are stored in pre-order, so walking them backwards visits every child before its parent
+	uintmax_t TotalSize = std::filesystem::file_size( rSource, Error );
+	if( Error )
+		TotalSize = 0;
+
+	for( size_t i = Nodes.size(); i-- > 0; )
+	{
+		Node& rNode = Nodes[ i ];
+
+		rNode.SubtreeSize  += rNode.Size;
+		rNode.SubtreeCount += 1;
+		TotalSize          += rNode.Size;
+
+		if( rNode.Parent != SIZE_MAX )
+		{
+			Nodes[ rNode.Parent ].SubtreeSize  += rNode.SubtreeSize;
+			Nodes[ rNode.Parent ].SubtreeCount += rNode.SubtreeCount;
+		}
+	}
+
+	// Compilers don't report time per header, so attribute the parse time of the unit by the amount of source text each header contributed
+	UnitCosts Costs;
+	const double SecondsPerByte = TotalSize ? ( ParseTime / static_cast< double >( TotalSize ) ) : 0.0;
+
+	for( const Node& rNode : Nodes )
+	{
+		UnitHeaderCost& rCost = Costs[ rNode.Path ];
+
+		rCost.InclusiveTime += SecondsPerByte * static_cast< double >( rNode.SubtreeSize );
+		rCost.SelfTime      += SecondsPerByte * static_cast< double >( rNode.Size );
+		rCost.Occurrences   += 1;
+		rCost.FanOut         = std::max( rCost.FanOut, rNode.SubtreeCount - 1 );
+	}
+
+	return Costs;
+
+} // ParseTrace
+
+//////////////////////////////////////////////////////////////////////////
+
+void BuildInsights::Analyze( std::vector< TraceFile > TraceFiles, std::filesystem::path WorkspaceLocation )
+{
+	std::shared_ptr< std::vector< UnitCosts > > Units = std::make_shared< std::vector< UnitCosts > >( TraceFiles.size() );
+	std::vector< JobSystem::JobPtr >            ParseJobs;
+
+	m_Analyzing = true;
+
+	// Every trace is parsed separately
+	for( size_t i = 0; i < TraceFiles.size(); ++i )
+	{
+		ParseJobs.push_back( JobSystem::Instance().NewJob(
+			[ Units, i, Trace = TraceFiles[ i ] ]( void )
+			{
+				( *Units )[ i ] = ParseTrace( Trace.first, Trace.second );
+			}
+		) );
+	}
+
+	// ... and then merged into one report
+	JobSystem::Instance().NewJob(
+		[ this, Units, WorkspaceLocation = std::move( WorkspaceLocation ) ]( void )
+		{
+			std::unordered_map< std::string, HeaderCost > Merged;
+			size_t                                        UnitCount = 0;
+
+			for( const UnitCosts& rUnit : *Units )
+			{
+				if( rUnit.empty() )
+					continue;
+
+				++UnitCount;
+
+				for( const auto& [ rPath, rCost ] : rUnit )
+				{
+					HeaderCost& rHeader       = Merged[ rPath ];
+					rHeader.InclusiveTime    += rCost.InclusiveTime;
+					rHeader.SelfTime         += rCost.SelfTime;
+					rHeader.IncludeCount     += rCost.Occurrences;
+					rHeader.TranslationUnits += 1;
+					rHeader.FanOut            = std::max( rHeader.FanOut, rCost.FanOut );
+				}
+			}
+
+			std::vector< HeaderCost > Headers;
+			Headers.reserve( Merged.size() );
+
+			const std::string WorkspacePrefix = WorkspaceLocation.lexically_normal().string();
+
+			for( auto& [ rPath, rHeader ] : Merged )
+			{
+				const bool InWorkspace = !WorkspacePrefix.empty() && rPath.starts_with( WorkspacePrefix );
+				const bool WidelyUsed  = rHeader.TranslationUnits >= 2 && rHeader.TranslationUnits * 4 >= UnitCount;
+
+				// Headers that we don't own and that most units pay for are good precompiled header candidates.
+				// Our own headers that drag in a lot of other headers should rather be split or use forward declarations.
+				if( WidelyUsed && !InWorkspace )
+					rHeader.Suggested = Suggestion::Precompile;
+				else if( InWorkspace && rHeader.TranslationUnits >= 2 && rHeader.FanOut >= 16 )
+					rHeader.Suggested = Suggestion::Split;
+
+				rHeader.Path = rPath;
+				Headers.emplace_back( std::move( rHeader ) );
+			}
+
+			std::sort( Headers.begin(), Headers.end(), []( const HeaderCost& rA, const HeaderCost& rB ) { return rA.InclusiveTime > rB.InclusiveTime; } );
+
+			{
+				std::scoped_lock Lock( m_Mutex );
+				m_Headers = std::move( Headers );
+			}
+
+			m_TranslationUnits = UnitCount;
+			m_Analyzing        = false;
+			++m_Generation;
+		},
+		ParseJobs
+	);
+
+} // Analyze
+
+//////////////////////////////////////////////////////////////////////////
+
+std::vector< BuildInsights::HeaderCost > BuildInsights::Headers( void ) const
+{
+	std::scoped_lock Lock( m_Mutex );
+
+	return m_Headers;
+
+} // Headers
+
+//////////////////////////////////////////////////////////////////////////
+
+std::string BuildInsights::ExtractDiagnostics( const std::filesystem::path& rTraceFile )
+{
+	std::ifstream      File( rTraceFile );
+	std::string        Line;
+	std::ostringstream Diagnostics;
+	TraceReader        Reader;
+
+	while( std::getline( File, Line ) )
+	{
+		size_t           Depth;
+		std::string_view Value;
+
+		if( ClassifyLine( Line, Reader, Depth, Value ) == TraceLine::Diagnostic )
+			Diagnostics << Line << '\n';
+	}
+
+	return Diagnostics.str();
+
+} // ExtractDiagnostics
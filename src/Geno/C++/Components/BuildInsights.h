@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include <Common/Macros.h>
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class BuildInsights
+{
+	GENO_SINGLETON( BuildInsights );
+
+	BuildInsights( void ) = default;
+
+//////////////////////////////////////////////////////////////////////////
+
+public:
+
+	enum class Suggestion
+	{
+		None,
+		Precompile,
+		Split,
+
+	}; // Suggestion
+
+	struct HeaderCost
+	{
+		std::filesystem::path Path;
+		double                InclusiveTime    = 0.0; // Estimated seconds spent parsing the header and everything it includes, summed over all units
+		double                SelfTime         = 0.0; // Estimated seconds spent parsing the header itself, summed over all units
+		size_t                IncludeCount     = 0;   // Number of times the header was opened across all units
+		size_t                TranslationUnits = 0;   // Number of units that include the header, directly or indirectly
+		size_t                FanOut           = 0;   // Largest number of headers that it transitively pulled in into a single unit
+		Suggestion            Suggested        = Suggestion::None;
+
+	}; // HeaderCost
+
+	// Pair of source file and the trace that was captured while compiling it
+	using TraceFile = std::pair< std::filesystem::path, std::filesystem::path >;
+
+//////////////////////////////////////////////////////////////////////////
+
+	void Analyze( std::vector< TraceFile > TraceFiles, std::filesystem::path WorkspaceLocation );
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::vector< HeaderCost > Headers         ( void ) const;
+	size_t                    TranslationUnits( void ) const { return m_TranslationUnits; }
+	unsigned                  Generation      ( void ) const { return m_Generation; }
+	bool                      IsAnalyzing     ( void ) const { return m_Analyzing; }
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Reads the include trace and timing report that the compiler wrote alongside any diagnostics, and returns the diagnostics alone
+	static std::string ExtractDiagnostics( const std::filesystem::path& rTraceFile );
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	mutable std::mutex        m_Mutex;
+	std::vector< HeaderCost > m_Headers;
+
+	std::atomic_size_t        m_TranslationUnits = 0;
+	std::atomic_uint          m_Generation       = 0;
+	std::atomic_bool          m_Analyzing        = false;
+
+}; // BuildInsights
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace Reflection
+{
+	constexpr std::string_view EnumToString( BuildInsights::Suggestion Value )
+	{
+		switch( Value )
+		{
+			case BuildInsights::Suggestion::Precompile: return "Precompile";
+			case BuildInsights::Suggestion::Split:      return "Split / forward-declare";
+			default:                                    return "";
+		}
+
+	} // EnumToString
+
+} // Reflection
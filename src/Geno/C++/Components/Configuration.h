@@ -76,6 +76,7 @@ public:
 	std::optional< Architecture >          m_Architecture;
 	std::optional< std::filesystem::path > m_OutputDir;
 	std::optional< bool >                  m_Verbose;
+	std::optional< bool >                  m_BuildInsights;
 
 }; // Configuration
 
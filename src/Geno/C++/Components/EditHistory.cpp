@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "EditHistory.h"
+
+#include <algorithm>
+#include <limits>
+
+//////////////////////////////////////////////////////////////////////////
+
+void EditHistory::Begin( Kind StepKind, std::vector< size_t > Marks )
+{
+	if( m_Pending )
+		return;
+
+	const bool SameKind = !m_Sealed && m_Undone == 0 && !m_Steps.empty() && StepKind != Kind::Other && m_Steps.back().StepKind == StepKind;
+
+	if( SameKind )
+	{
+		const Step& rLast = m_Steps.back();
+		const auto  After = m_Marks.begin() + ( rLast.FirstMark - m_MarksBase ) + rLast.MarksBefore;
+
+		m_Merge = std::equal( Marks.begin(), Marks.end(), After, After + rLast.MarksAfter );
+	}
+	else
+	{
+		m_Merge = false;
+	}
+
+	m_PendingMarks = std::move( Marks );
+	m_PendingKind  = StepKind;
+	m_Pending      = true;
+	m_Open         = false;
+
+} // Begin
+
+//////////////////////////////////////////////////////////////////////////
+
+void EditHistory::End( std::span< const size_t > Marks )
+{
+	if( !m_Pending )
+		return;
+
+	if( m_Open )
+	{
+		m_Steps.back().MarksAfter = static_cast< uint32_t >( Marks.size() );
+		m_Marks.insert( m_Marks.end(), Marks.begin(), Marks.end() );
+
+		m_Sealed = false;
+
+		Trim();
+	}
+
+	m_PendingMarks.clear();
+
+	m_Pending = false;
+	m_Open    = false;
+	m_Merge   = false;
+
+} // End
+
+//////////////////////////////////////////////////////////////////////////
+
+void EditHistory::Record( bool Insert, size_t Offset, std::string_view Text )
+{
+	if( m_Replaying || Text.empty() )
+		return;
+
+	// Edits made outside of a step become a step of their own
+	if( !m_Pending )
+	{
+		Begin( Kind::Other, { } );
+		Record( Insert, Offset, Text );
+		End( { } );
+		return;
+	}
+
+	if( !m_Open )
+		OpenStep();
+
+	while( !Text.empty() )
+	{
+		const size_t           Length = std::min( Text.size(), static_cast< size_t >( std::numeric_limits< uint32_t >::max() ) );
+		const std::string_view Chunk  = Text.substr( 0, Length );
+		const uint64_t         Tail   = m_BytesBase + m_Bytes.size();
+
+		// Text typed right after the last insertion, or deleted right where the last erasure was, extends that delta
+		if( !m_Deltas.empty() && m_DeltasBase + m_Deltas.size() > m_Steps.back().FirstDelta )
+		{
+			Delta& rLast = m_Deltas.back();
+
+			const bool Continues = rLast.Insert == Insert && rLast.Bytes + rLast.Length == Tail && Offset == ( Insert ? rLast.Offset + rLast.Length : rLast.Offset );
+
+			if( Continues && static_cast< uint64_t >( rLast.Length ) + Length <= std::numeric_limits< uint32_t >::max() )
+			{
+				rLast.Length += static_cast< uint32_t >( Length );
+				m_Bytes.append( Chunk );
+
+				Offset += Insert ? Length : 0;
+				Text.remove_prefix( Length );
+				continue;
+			}
+		}
+
+		m_Deltas.push_back( Delta{ .Offset = Offset, .Bytes = Tail, .Length = static_cast< uint32_t >( Length ), .Insert = Insert } );
+		m_Bytes.append( Chunk );
+
+		Offset += Insert ? Length : 0;
+		Text.remove_prefix( Length );
+	}
+
+} // Record
+
+//////////////////////////////////////////////////////////////////////////
+
+bool EditHistory::Undo( const Apply& rApply, std::vector< size_t >& rMarks )
+{
+	if( m_Pending || !CanUndo() )
+		return false;
+
+	const size_t Index = m_Steps.size() - 1 - m_Undone;
+	const Step&  rStep = m_Steps[ Index ];
+
+	// Taken back in reverse, so that every delta sees the text the way it left it
+	m_Replaying = true;
+
+	for( uint64_t i = DeltaEnd( Index ); i-- > rStep.FirstDelta; )
+	{
+		const Delta& rDelta = m_Deltas[ i - m_DeltasBase ];
+
+		rApply( !rDelta.Insert, rDelta.Offset, TextOf( rDelta ) );
+	}
+
+	m_Replaying = false;
+
+	const auto Marks = m_Marks.begin() + ( rStep.FirstMark - m_MarksBase );
+	rMarks.assign( Marks, Marks + rStep.MarksBefore );
+
+	++m_Undone;
+	m_Sealed = true;
+
+	return true;
+
+} // Undo
+
+//////////////////////////////////////////////////////////////////////////
+
+bool EditHistory::Redo( const Apply& rApply, std::vector< size_t >& rMarks )
+{
+	if( m_Pending || !CanRedo() )
+		return false;
+
+	const size_t Index = m_Steps.size() - m_Undone;
+	const Step&  rStep = m_Steps[ Index ];
+
+	m_Replaying = true;
+
+	for( uint64_t i = rStep.FirstDelta; i < DeltaEnd( Index ); ++i )
+	{
+		const Delta& rDelta = m_Deltas[ i - m_DeltasBase ];
+
+		rApply( rDelta.Insert, rDelta.Offset, TextOf( rDelta ) );
+	}
+
+	m_Replaying = false;
+
+	const auto Marks = m_Marks.begin() + ( rStep.FirstMark - m_MarksBase ) + rStep.MarksBefore;
+	rMarks.assign( Marks, Marks + rStep.MarksAfter );
+
+	--m_Undone;
+	m_Sealed = true;
+
+	return true;
+
+} // Redo
+
+//////////////////////////////////////////////////////////////////////////
+
+void EditHistory::Clear( void )
+{
+	m_Bytes .clear();
+	m_Deltas.clear();
+	m_Marks .clear();
+	m_Steps .clear();
+	m_PendingMarks.clear();
+
+	m_BytesBase  = 0;
+	m_DeltasBase = 0;
+	m_MarksBase  = 0;
+	m_Undone     = 0;
+	m_Pending    = false;
+	m_Merge      = false;
+	m_Open       = false;
+	m_Sealed     = true;
+
+} // Clear
+
+//////////////////////////////////////////////////////////////////////////
+
+size_t EditHistory::MemoryUsage( void ) const
+{
+	// Bytes in front of the oldest delta are no longer used, but are only let go of once there are enough of them
+	const size_t Dead = m_Deltas.empty() ? m_Bytes.size() : static_cast< size_t >( m_Deltas.front().Bytes - m_BytesBase );
+
+	return ( m_Bytes.size() - Dead ) + m_Deltas.size() * sizeof( Delta ) + m_Marks.size() * sizeof( size_t ) + m_Steps.size() * sizeof( Step );
+
+} // MemoryUsage
+
+//////////////////////////////////////////////////////////////////////////
+
+void EditHistory::OpenStep( void )
+{
+	DropRedo();
+
+	if( m_Merge )
+	{
+		// The marks from after the last step are replaced once this one ends
+		Step& rLast = m_Steps.back();
+
+		m_Marks.resize( m_Marks.size() - rLast.MarksAfter );
+		rLast.MarksAfter = 0;
+	}
+	else
+	{
+		m_Steps.push_back( Step{ .FirstDelta  = m_DeltasBase + m_Deltas.size(),
+		                         .FirstMark   = m_MarksBase + m_Marks.size(),
+		                         .MarksBefore = static_cast< uint32_t >( m_PendingMarks.size() ),
+		                         .MarksAfter  = 0,
+		                         .StepKind    = m_PendingKind } );
+
+		m_Marks.insert( m_Marks.end(), m_PendingMarks.begin(), m_PendingMarks.end() );
+	}
+
+	m_Open = true;
+
+} // OpenStep
+
+//////////////////////////////////////////////////////////////////////////
+
+void EditHistory::DropRedo( void )
+{
+	for( ; m_Undone > 0; --m_Undone )
+	{
+		const Step& rStep = m_Steps.back();
+
+		if( m_DeltasBase + m_Deltas.size() > rStep.FirstDelta )
+			m_Bytes.resize( m_Deltas[ rStep.FirstDelta - m_DeltasBase ].Bytes - m_BytesBase );
+
+		m_Deltas.resize( rStep.FirstDelta - m_DeltasBase );
+		m_Marks .resize( rStep.FirstMark  - m_MarksBase );
+		m_Steps .pop_back();
+	}
+
+} // DropRedo
+
+//////////////////////////////////////////////////////////////////////////
+
+void EditHistory::Trim( void )
+{
+	// The newest step is kept no matter how large it is
+	while( m_Steps.size() > 1 && m_Undone < m_Steps.size() - 1 && MemoryUsage() > m_Limit )
+		DropFront();
+
+} // Trim
+
+//////////////////////////////////////////////////////////////////////////
+
+void EditHistory::DropFront( void )
+{
+	const Step&    rStep    = m_Steps.front();
+	const uint64_t DeltaEnd = this->DeltaEnd( 0 );
+	const uint64_t MarkEnd  = rStep.FirstMark + rStep.MarksBefore + rStep.MarksAfter;
+
+	m_Deltas.erase( m_Deltas.begin(), m_Deltas.begin() + ( DeltaEnd - m_DeltasBase ) );
+	m_Marks .erase( m_Marks .begin(), m_Marks .begin() + ( MarkEnd  - m_MarksBase ) );
+	m_Steps .pop_front();
+
+	m_DeltasBase = DeltaEnd;
+	m_MarksBase  = MarkEnd;
+
+	const size_t Dead = m_Deltas.empty() ? m_Bytes.size() : static_cast< size_t >( m_Deltas.front().Bytes - m_BytesBase );
+
+	// Moving the remaining bytes down costs no more than the bytes that were dropped
+	if( Dead * 2 >= m_Bytes.size() )
+	{
+		m_Bytes.erase( 0, Dead );
+		m_BytesBase += Dead;
+	}
+
+} // DropFront
+
+//////////////////////////////////////////////////////////////////////////
+
+uint64_t EditHistory::DeltaEnd( size_t StepIndex ) const
+{
+	return ( StepIndex + 1 < m_Steps.size() ) ? m_Steps[ StepIndex + 1 ].FirstDelta : m_DeltasBase + m_Deltas.size();
+
+} // DeltaEnd
+
+//////////////////////////////////////////////////////////////////////////
+
+std::string_view EditHistory::TextOf( const Delta& rDelta ) const
+{
+	return std::string_view( m_Bytes ).substr( rDelta.Bytes - m_BytesBase, rDelta.Length );
+
+} // TextOf
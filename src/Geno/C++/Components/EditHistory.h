@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Undo and redo for a text buffer. Every edit is recorded as a delta (an insertion or an erasure at a byte offset) with its text in
+// one shared byte arena, so a step costs a few bytes on top of the text it touched rather than an object per edit. A step is every
+// delta recorded between Begin() and End(), which is how an edit made with thousands of cursors still is undone in one go. Steps that
+// continue one another (typing a word, holding backspace) are merged, and the oldest steps are dropped once the history grows past its
+// limit. Steps also remember marks (i.e. the cursor offsets) from before and after the edit, for the editor to restore.
+class EditHistory
+{
+public:
+
+	enum class Kind : uint8_t
+	{
+		Other,
+		Typing,
+		Deleting,
+	};
+
+	// Called for every delta that undo or redo applies, in the order that they have to be applied in
+	using Apply = std::function< void( bool Insert, size_t Offset, std::string_view Text ) >;
+
+//////////////////////////////////////////////////////////////////////////
+
+	// A step of the same kind as the last one is merged into it, unless the marks have moved since it ended
+	void Begin ( Kind StepKind, std::vector< size_t > Marks );
+	void End   ( std::span< const size_t > Marks );
+	void Record( bool Insert, size_t Offset, std::string_view Text );
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool Undo ( const Apply& rApply, std::vector< size_t >& rMarks );
+	bool Redo ( const Apply& rApply, std::vector< size_t >& rMarks );
+	void Clear( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+	void   SetLimit   ( size_t Bytes ) { m_Limit = Bytes; }
+	size_t MemoryUsage( void ) const;
+	bool   CanUndo    ( void ) const { return m_Undone < m_Steps.size(); }
+	bool   CanRedo    ( void ) const { return m_Undone > 0; }
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	struct Delta
+	{
+		uint64_t Offset;
+		uint64_t Bytes;  // Where the text starts in the arena
+		uint32_t Length;
+		bool     Insert;
+
+	}; // Delta
+
+	// Everything is numbered from the very first delta, mark and byte that was recorded, so that dropping old steps moves nothing
+	struct Step
+	{
+		uint64_t FirstDelta;
+		uint64_t FirstMark;
+		uint32_t MarksBefore;
+		uint32_t MarksAfter;
+		Kind     StepKind;
+
+	}; // Step
+
+//////////////////////////////////////////////////////////////////////////
+
+	void OpenStep ( void );
+	void DropRedo ( void );
+	void Trim     ( void );
+	void DropFront( void );
+
+	uint64_t         DeltaEnd( size_t StepIndex ) const;
+	std::string_view TextOf  ( const Delta& rDelta ) const;
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::string           m_Bytes;
+	std::deque< Delta >   m_Deltas;
+	std::deque< size_t >  m_Marks;
+	std::deque< Step >    m_Steps;
+
+	uint64_t              m_BytesBase  = 0;
+	uint64_t              m_DeltasBase = 0;
+	uint64_t              m_MarksBase  = 0;
+	size_t                m_Undone     = 0;       // How many of the last steps have been undone and can be redone
+	size_t                m_Limit      = 64 << 20;
+
+	// Between Begin() and End()
+	std::vector< size_t > m_PendingMarks;
+	Kind                  m_PendingKind = Kind::Other;
+	bool                  m_Pending     = false;
+	bool                  m_Merge       = false;
+	bool                  m_Open        = false;   // The pending step has recorded something
+	bool                  m_Sealed      = true;    // The last step can not be merged into
+	bool                  m_Replaying   = false;
+
+}; // EditHistory
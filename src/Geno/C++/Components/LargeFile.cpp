@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "LargeFile.h"
+
+#include "Components/OutputSearch.h"
+
+#include <Common/Async/JobSystem.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined( __SSE2__ ) || defined( _M_AMD64 ) || defined( _M_X64 )
+#include <emmintrin.h>
+#define LARGE_FILE_SSE2
+#endif // __SSE2__ || _M_AMD64 || _M_X64
+
+//////////////////////////////////////////////////////////////////////////
+
+static constexpr uint64_t CheckpointLines = 256;
+static constexpr size_t   ScanWindow      = 64 << 20; // What the jobs map at a time
+static constexpr size_t   ViewWindow      = 4 << 20;  // What is mapped around the lines on screen
+static constexpr size_t   ViewSlack       = 1 << 20;  // Of the view window that goes before the line it was mapped for
+
+//////////////////////////////////////////////////////////////////////////
+
+LargeFile::~LargeFile( void )
+{
+	StopSearch();
+
+	if( m_pIndex )
+		m_pIndex->Cancel.store( true, std::memory_order_relaxed );
+
+} // ~LargeFile
+
+//////////////////////////////////////////////////////////////////////////
+
+bool LargeFile::Open( const std::filesystem::path& rPath )
+{
+	StopSearch();
+
+	if( m_pIndex )
+		m_pIndex->Cancel.store( true, std::memory_order_relaxed );
+
+	m_Window = MappedFile::View();
+	m_Lines.clear();
+	m_LinesCount = 0;
+
+	std::shared_ptr< Index > pIndex = std::make_shared< Index >();
+
+	if( !pIndex->File.Open( rPath ) )
+	{
+		m_pIndex.reset();
+		return false;
+	}
+
+	pIndex->Checkpoints.push_back( 0 );
+
+	// The job keeps its own reference, so closing the file while it's being indexed only stops the job
+	JobSystem::Instance().NewJob( [ pIndex ]( void )
+		{
+			BuildIndex( *pIndex );
+			pIndex->Done.store( true, std::memory_order_release );
+		} );
+
+	m_pIndex = std::move( pIndex );
+
+	return true;
+
+} // Open
+
+//////////////////////////////////////////////////////////////////////////
+
+const std::vector< std::string >& LargeFile::GetLines( uint64_t FirstLine, size_t Count )
+{
+	const uint64_t Known = LineCount();
+
+	if( FirstLine == m_LinesFirst && Count == m_LinesCount && Known == m_LinesKnown )
+		return m_Lines;
+
+	m_Lines.clear();
+	m_LinesFirst = FirstLine;
+	m_LinesCount = Count;
+	m_LinesKnown = Known;
+
+	if( FirstLine >= Known )
+		return m_Lines;
+
+	uint64_t Offset;
+	{
+		std::scoped_lock Lock( m_pIndex->Mutex );
+		Offset = m_pIndex->Checkpoints[ FirstLine / CheckpointLines ];
+	}
+
+	// Skip ahead from the checkpoint to the first line that was asked for
+	for( uint64_t Line = FirstLine - FirstLine % CheckpointLines; Line < FirstLine + Count && Line < Known; ++Line )
+	{
+		const uint64_t End = FindBreak( Offset );
+
+		if( Line >= FirstLine )
+			Read( Offset, std::min( End, Offset + MaxLineLength ), m_Lines.emplace_back() );
+
+		Offset = End + 1;
+	}
+
+	return m_Lines;
+
+} // GetLines
+
+//////////////////////////////////////////////////////////////////////////
+
+uint64_t LargeFile::LineCount( void ) const
+{
+	if( !m_pIndex )
+		return 0;
+
+	// The last line doesn't end in a line break, so it is only known once the whole file has been looked at
+	const bool Done = m_pIndex->Done.load( std::memory_order_acquire );
+
+	return m_pIndex->Breaks.load( std::memory_order_acquire ) + ( Done ? 1 : 0 );
+
+} // LineCount
+
+//////////////////////////////////////////////////////////////////////////
+
+float LargeFile::IndexProgress( void ) const
+{
+	if( !m_pIndex || m_pIndex->File.Size() == 0 )
+		return 1.0f;
+
+	return static_cast< float >( static_cast< double >( m_pIndex->Scanned.load( std::memory_order_relaxed ) ) / static_cast< double >( m_pIndex->File.Size() ) );
+
+} // IndexProgress
+
+//////////////////////////////////////////////////////////////////////////
+
+void LargeFile::StartSearch( std::string Needle, uint64_t FromLine )
+{
+	StopSearch();
+
+	if( Needle.empty() || !m_pIndex )
+		return;
+
+	std::shared_ptr< Search > pSearch = std::make_shared< Search >();
+	pSearch->pIndex                   = m_pIndex;
+	pSearch->Needle                   = std::move( Needle );
+	pSearch->FromLine                 = FromLine;
+
+	{
+		std::scoped_lock Lock( m_pIndex->Mutex );
+
+		const size_t Checkpoint = std::min< size_t >( FromLine / CheckpointLines, m_pIndex->Checkpoints.size() - 1 );
+
+		pSearch->StartLine   = Checkpoint * CheckpointLines;
+		pSearch->StartOffset = m_pIndex->Checkpoints[ Checkpoint ];
+	}
+
+	JobSystem::Instance().NewJob( [ pSearch ]( void )
+		{
+			Scan( *pSearch );
+			pSearch->Done.store( true, std::memory_order_release );
+		} );
+
+	m_pSearch = std::move( pSearch );
+
+} // StartSearch
+
+//////////////////////////////////////////////////////////////////////////
+
+void LargeFile::StopSearch( void )
+{
+	if( m_pSearch )
+		m_pSearch->Cancel.store( true, std::memory_order_relaxed );
+
+	m_pSearch.reset();
+
+} // StopSearch
+
+//////////////////////////////////////////////////////////////////////////
+
+LargeFile::SearchStatus LargeFile::PollSearch( uint64_t& rLine )
+{
+	if( !m_pSearch )
+		return SearchStatus::None;
+
+	if( !m_pSearch->Done.load( std::memory_order_acquire ) )
+		return SearchStatus::Searching;
+
+	// The outcome is only handed out once
+	std::shared_ptr< Search > pSearch = std::move( m_pSearch );
+
+	rLine = pSearch->Line;
+
+	return pSearch->Found ? SearchStatus::Found : SearchStatus::NotFound;
+
+} // PollSearch
+
+//////////////////////////////////////////////////////////////////////////
+
+float LargeFile::SearchProgress( void ) const
+{
+	if( !m_pSearch || m_pSearch->StartOffset >= Size() )
+		return 1.0f;
+
+	return static_cast< float >( static_cast< double >( m_pSearch->Scanned.load( std::memory_order_relaxed ) ) / static_cast< double >( Size() - m_pSearch->StartOffset ) );
+
+} // SearchProgress
+
+//////////////////////////////////////////////////////////////////////////
+
+uint64_t LargeFile::FindBreak( uint64_t Offset )
+{
+	for( std::string_view Bytes; !( Bytes = Window( Offset ) ).empty(); Offset += Bytes.size() )
+	{
+		if( const void* pBreak = std::memchr( Bytes.data(), '\n', Bytes.size() ) )
+			return Offset + ( static_cast< const char* >( pBreak ) - Bytes.data() );
+	}
+
+	return Size();
+
+} // FindBreak
+
+//////////////////////////////////////////////////////////////////////////
+
+std::string_view LargeFile::Window( uint64_t Offset )
+{
+	const uint64_t WindowStart = m_Window.Offset();
+	const uint64_t WindowEnd   = WindowStart + m_Window.Data().size();
+
+	// Scrolling back a little shouldn't have to map the window again, so some of it goes before the offset
+	if( Offset < WindowStart || Offset >= WindowEnd )
+		m_Window = m_pIndex->File.Map( Offset - std::min< uint64_t >( Offset, ViewSlack ), ViewWindow );
+
+	if( Offset < m_Window.Offset() || Offset >= m_Window.Offset() + m_Window.Data().size() )
+		return { };
+
+	return m_Window.Data().substr( static_cast< size_t >( Offset - m_Window.Offset() ) );
+
+} // Window
+
+//////////////////////////////////////////////////////////////////////////
+
+void LargeFile::Read( uint64_t Offset, uint64_t End, std::string& rText )
+{
+	for( std::string_view Bytes; Offset < End && !( Bytes = Window( Offset ) ).empty(); Offset += Bytes.size() )
+	{
+		Bytes = Bytes.substr( 0, static_cast< size_t >( std::min< uint64_t >( Bytes.size(), End - Offset ) ) );
+		rText.append( Bytes );
+	}
+
+} // Read
+
+//////////////////////////////////////////////////////////////////////////
+
+void LargeFile::BuildIndex( Index& rIndex )
+{
+	const uint64_t          Size   = rIndex.File.Size();
+	uint64_t                Breaks = 0;
+	std::vector< uint64_t > Checkpoints;
+
+	for( uint64_t Offset = 0; Offset < Size && !rIndex.Cancel.load( std::memory_order_relaxed ); )
+	{
+		const MappedFile::View View  = rIndex.File.Map( Offset, ScanWindow );
+		const std::string_view Bytes = View.Data();
+
+		if( Bytes.empty() )
+			break;
+
+		const char* p    = Bytes.data();
+		const char* pEnd = p + Bytes.size();
+
+	#if defined( LARGE_FILE_SSE2 )
+
+		// Count the line breaks 64 bytes at a time, and only look at where they are when one of them starts a checkpoint
+		const __m128i Break = _mm_set1_epi8( '\n' );
+
+		for( ; pEnd - p >= 64; p += 64 )
+		{
+			const __m128i* pBlock = reinterpret_cast< const __m128i* >( p );
+			const uint64_t Mask0  = static_cast< uint32_t >( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( pBlock + 0 ), Break ) ) );
+			const uint64_t Mask1  = static_cast< uint32_t >( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( pBlock + 1 ), Break ) ) );
+			const uint64_t Mask2  = static_cast< uint32_t >( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( pBlock + 2 ), Break ) ) );
+			const uint64_t Mask3  = static_cast< uint32_t >( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( pBlock + 3 ), Break ) ) );
+			uint64_t       Mask   = Mask0 | ( Mask1 << 16 ) | ( Mask2 << 32 ) | ( Mask3 << 48 );
+			const uint64_t Count  = static_cast< uint64_t >( std::popcount( Mask ) );
+
+			if( Breaks % CheckpointLines + Count < CheckpointLines )
+			{
+				Breaks += Count;
+				continue;
+			}
+
+			for( ; Mask != 0; Mask &= Mask - 1 )
+			{
+				if( ++Breaks % CheckpointLines == 0 )
+					Checkpoints.push_back( Offset + ( p - Bytes.data() ) + std::countr_zero( Mask ) + 1 );
+			}
+		}
+
+	#endif // LARGE_FILE_SSE2
+
+		// The remainder (or everything, without SSE2)
+		for( ; ( p = static_cast< const char* >( std::memchr( p, '\n', pEnd - p ) ) ) != nullptr; ++p )
+		{
+			if( ++Breaks % CheckpointLines == 0 )
+				Checkpoints.push_back( Offset + ( p - Bytes.data() ) + 1 );
+		}
+
+		Offset += Bytes.size();
+
+		{
+			std::scoped_lock Lock( rIndex.Mutex );
+			rIndex.Checkpoints.insert( rIndex.Checkpoints.end(), Checkpoints.begin(), Checkpoints.end() );
+		}
+
+		Checkpoints.clear();
+
+		rIndex.Breaks .store( Breaks, std::memory_order_release );
+		rIndex.Scanned.store( Offset, std::memory_order_relaxed );
+	}
+
+} // BuildIndex
+
+//////////////////////////////////////////////////////////////////////////
+
+void LargeFile::Scan( Search& rSearch )
+{
+	const MappedFile& rFile   = rSearch.pIndex->File;
+	const size_t      Overlap = rSearch.Needle.size() - 1;
+	uint64_t          Line    = rSearch.StartLine;
+
+	// Windows overlap by the length of the needle, so that a match that straddles two of them is still found
+	for( uint64_t Offset = rSearch.StartOffset; Offset < rFile.Size(); )
+	{
+		if( rSearch.Cancel.load( std::memory_order_relaxed ) || rSearch.pIndex->Cancel.load( std::memory_order_relaxed ) )
+			return;
+
+		const MappedFile::View View    = rFile.Map( Offset, ScanWindow + Overlap );
+		const std::string_view Bytes   = View.Data();
+		const bool             Last    = Offset + Bytes.size() >= rFile.Size();
+		const size_t           Advance = Last ? Bytes.size() : Bytes.size() - Overlap;
+		size_t                 Counted = 0;
+
+		if( Bytes.size() <= Overlap && !Last )
+			return;
+
+		for( size_t Hit = 0; ( Hit = OutputSearch::Find( Bytes, rSearch.Needle, Hit ) ) != std::string_view::npos && Hit < Advance; )
+		{
+			Line    += std::count( Bytes.data() + Counted, Bytes.data() + Hit, '\n' );
+			Counted  = Hit;
+
+			if( Line >= rSearch.FromLine )
+			{
+				rSearch.Line  = Line;
+				rSearch.Found = true;
+				return;
+			}
+
+			// Only the first match on a line matters
+			const size_t Break = Bytes.find( '\n', Hit );
+			if( Break == std::string_view::npos )
+				break;
+
+			Hit = Break;
+		}
+
+		Line   += std::count( Bytes.data() + Counted, Bytes.data() + Advance, '\n' );
+		Offset += Advance;
+
+		rSearch.Scanned.store( Offset - rSearch.StartOffset, std::memory_order_relaxed );
+	}
+
+} // Scan
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include <Common/MappedFile.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// A file that is too large to be edited, shown read-only straight from disk. A job runs through the file once and writes down where
+// every CheckpointLines-th line starts, so that any line is found by skipping less than that many lines from the nearest checkpoint
+// while the index stays a tiny fraction of the file. Lines are read through a window that is mapped around the part that is on
+// screen, and searching streams through the file a window at a time in another job, so neither ever has the whole file paged in.
+class LargeFile
+{
+public:
+
+	enum class SearchStatus
+	{
+		None,
+		Searching,
+		Found,
+		NotFound,
+	};
+
+//////////////////////////////////////////////////////////////////////////
+
+	 LargeFile( void ) = default;
+	~LargeFile( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool Open( const std::filesystem::path& rPath );
+
+	// Lines are known as far as the index has come. Each line is cut short at MaxLineLength.
+	const std::vector< std::string >& GetLines( uint64_t FirstLine, size_t Count );
+
+	uint64_t LineCount    ( void ) const;
+	uint64_t Size         ( void ) const { return m_pIndex ? m_pIndex->File.Size() : 0; }
+	bool     IsIndexed    ( void ) const { return m_pIndex && m_pIndex->Done.load( std::memory_order_acquire ); }
+	float    IndexProgress( void ) const;
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Looks for the first line at or after FromLine that contains Needle
+	void         StartSearch   ( std::string Needle, uint64_t FromLine );
+	void         StopSearch    ( void );
+	SearchStatus PollSearch    ( uint64_t& rLine );
+	float        SearchProgress( void ) const;
+
+//////////////////////////////////////////////////////////////////////////
+
+	static constexpr size_t MaxLineLength = 4096;
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	// Shared with the jobs, which may outlive the file that started them
+	struct Index
+	{
+		MappedFile              File;
+		std::mutex              Mutex;
+		std::vector< uint64_t > Checkpoints; // Start of every CheckpointLines-th line, guarded by Mutex
+		std::atomic< uint64_t > Breaks  = 0; // Line breaks found so far
+		std::atomic< uint64_t > Scanned = 0;
+		std::atomic< bool >     Done    = false;
+		std::atomic< bool >     Cancel  = false;
+
+	}; // Index
+
+	struct Search
+	{
+		std::shared_ptr< Index > pIndex;
+		std::string              Needle;
+		uint64_t                 FromLine    = 0;
+		uint64_t                 StartLine   = 0; // Of the checkpoint that the scan starts from
+		uint64_t                 StartOffset = 0;
+
+		uint64_t                 Line        = 0;
+		bool                     Found       = false;
+		std::atomic< uint64_t >  Scanned     = 0;
+		std::atomic< bool >      Done        = false;
+		std::atomic< bool >      Cancel      = false;
+
+	}; // Search
+
+//////////////////////////////////////////////////////////////////////////
+
+	uint64_t         FindBreak( uint64_t Offset );
+	std::string_view Window   ( uint64_t Offset );
+	void             Read     ( uint64_t Offset, uint64_t End, std::string& rText );
+
+	static void BuildIndex( Index& rIndex );
+	static void Scan      ( Search& rSearch );
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::shared_ptr< Index >   m_pIndex;
+	std::shared_ptr< Search >  m_pSearch;
+	MappedFile::View           m_Window;
+
+	// The lines that were asked for last, which usually are asked for again on the next frame
+	std::vector< std::string > m_Lines;
+	uint64_t                   m_LinesFirst = 0;
+	size_t                     m_LinesCount = 0;
+	uint64_t                   m_LinesKnown = 0;
+
+}; // LargeFile
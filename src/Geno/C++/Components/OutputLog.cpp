@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "OutputLog.h"
+
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////////////
+
+// New lines go into a new chunk once the current one has grown past this. A single line can still make a chunk larger.
+static constexpr size_t ChunkSize = 64 * 1024;
+
+//////////////////////////////////////////////////////////////////////////
+
+std::string_view OutputLog::Chunk::GetLine( size_t Index ) const
+{
+	const uint32_t Start = LineStarts[ Index ];
+	uint32_t       End   = ( Index + 1 < LineStarts.size() ) ? LineStarts[ Index + 1 ] : static_cast< uint32_t >( Text.size() );
+
+	if( End > Start && Text[ End - 1 ] == '\n' ) --End;
+	if( End > Start && Text[ End - 1 ] == '\r' ) --End;
+
+	return std::string_view( Text ).substr( Start, End - Start );
+
+} // GetLine
+
+//////////////////////////////////////////////////////////////////////////
+
+OutputLog::OutputLog( size_t MaxLines )
+	: m_MaxLines( std::max< size_t >( MaxLines, 1 ) )
+{
+} // OutputLog
+
+//////////////////////////////////////////////////////////////////////////
+
+void OutputLog::Append( std::string_view Bytes )
+{
+	while( !Bytes.empty() )
+	{
+		// A line starts with the first byte after a line break, not with the line break itself. That way the last line of the log is
+		// only there once something has been written to it.
+		if( m_Chunks.empty() || m_Chunks.back()->Text.empty() || m_Chunks.back()->Text.back() == '\n' )
+		{
+			if( m_Chunks.empty() || m_Chunks.back()->Text.size() >= ChunkSize )
+			{
+				std::shared_ptr< Chunk > pChunk = std::make_shared< Chunk >();
+				pChunk->FirstLine               = m_LinesWritten;
+				pChunk->Text.reserve( ChunkSize );
+
+				m_Chunks.push_back( std::move( pChunk ) );
+			}
+
+			Chunk& rChunk = *m_Chunks.back();
+			rChunk.LineStarts.push_back( static_cast< uint32_t >( rChunk.Text.size() ) );
+
+			++m_LinesWritten;
+		}
+
+		const size_t LineBreak = Bytes.find( '\n' );
+		const size_t Length    = ( LineBreak == std::string_view::npos ) ? Bytes.size() : LineBreak + 1;
+
+		m_Chunks.back()->Text.append( Bytes.substr( 0, Length ) );
+		Bytes.remove_prefix( Length );
+	}
+
+	Trim();
+
+} // Append
+
+//////////////////////////////////////////////////////////////////////////
+
+void OutputLog::Clear( void )
+{
+	m_Chunks.clear();
+
+	m_FirstLine = m_LinesWritten;
+
+} // Clear
+
+//////////////////////////////////////////////////////////////////////////
+
+void OutputLog::SetMaxLines( size_t MaxLines )
+{
+	m_MaxLines = std::max< size_t >( MaxLines, 1 );
+
+	Trim();
+
+} // SetMaxLines
+
+//////////////////////////////////////////////////////////////////////////
+
+uint64_t OutputLog::CompleteLines( void ) const
+{
+	// The last line is still being written to until its line break comes in
+	if( !m_Chunks.empty() && m_Chunks.back()->Text.back() != '\n' )
+		return m_LinesWritten - 1;
+
+	return m_LinesWritten;
+
+} // CompleteLines
+
+//////////////////////////////////////////////////////////////////////////
+
+std::vector< OutputLog::ChunkPtr > OutputLog::Snapshot( uint64_t FirstLine ) const
+{
+	std::vector< ChunkPtr > Chunks;
+
+	for( const std::shared_ptr< Chunk >& rpChunk : m_Chunks )
+	{
+		if( rpChunk->FirstLine + rpChunk->LineStarts.size() <= FirstLine )
+			continue;
+
+		// Appending to the last chunk may move its text, so whoever reads the snapshot on another thread needs a copy of it
+		if( rpChunk == m_Chunks.back() )
+			Chunks.push_back( std::make_shared< const Chunk >( *rpChunk ) );
+		else
+			Chunks.push_back( rpChunk );
+	}
+
+	return Chunks;
+
+} // Snapshot
+
+//////////////////////////////////////////////////////////////////////////
+
+std::string_view OutputLog::GetLine( size_t Index ) const
+{
+	const uint64_t Line = m_FirstLine + Index;
+
+	// Find the last chunk that starts at or before the line
+	auto It = std::upper_bound( m_Chunks.begin(), m_Chunks.end(), Line, []( uint64_t Line, const std::shared_ptr< Chunk >& rpChunk ) { return Line < rpChunk->FirstLine; } );
+	if( It == m_Chunks.begin() )
+		return std::string_view();
+
+	const Chunk& rChunk = **--It;
+
+	return rChunk.GetLine( static_cast< size_t >( Line - rChunk.FirstLine ) );
+
+} // GetLine
+
+//////////////////////////////////////////////////////////////////////////
+
+void OutputLog::Trim( void )
+{
+	// Drop whole chunks as long as the rest still holds the full scrollback
+	while( m_Chunks.size() > 1 && m_LinesWritten - m_Chunks[ 1 ]->FirstLine >= m_MaxLines )
+		m_Chunks.pop_front();
+
+	if( !m_Chunks.empty() )
+		m_FirstLine = std::max( m_FirstLine, m_Chunks.front()->FirstLine );
+
+} // Trim
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Everything that is written to stdout and stderr. The text is kept in chunks of roughly equal size along with the offset of every
+// line in them, so that any line can be found without scanning and the oldest output is dropped a whole chunk at a time once the
+// scrollback is full. A line never straddles two chunks, and only the last chunk is ever written to, so the others can be shared.
+class OutputLog
+{
+public:
+
+	struct Chunk
+	{
+		std::string             Text;
+		std::vector< uint32_t > LineStarts;
+		uint64_t                FirstLine = 0; // Number of lines that were written before this chunk
+
+		std::string_view GetLine( size_t Index ) const;
+
+	}; // Chunk
+
+	using ChunkPtr = std::shared_ptr< const Chunk >;
+
+//////////////////////////////////////////////////////////////////////////
+
+	explicit OutputLog( size_t MaxLines );
+
+//////////////////////////////////////////////////////////////////////////
+
+	void Append     ( std::string_view Bytes );
+	void Clear      ( void );
+	void SetMaxLines( size_t MaxLines );
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Line 0 is the oldest one that is still kept. Lines are returned without their line break.
+	size_t           LineCount    ( void )         const { return static_cast< size_t >( m_LinesWritten - m_FirstLine ); }
+	std::string_view GetLine      ( size_t Index ) const;
+	uint64_t         FirstLine    ( void )         const { return m_FirstLine; }
+	uint64_t         LinesWritten ( void )         const { return m_LinesWritten; }
+	uint64_t         CompleteLines( void )         const;
+	size_t           MaxLines     ( void )         const { return m_MaxLines; }
+
+	// The chunks that hold the complete lines from FirstLine on. The last chunk is copied if it's still being written to.
+	std::vector< ChunkPtr > Snapshot( uint64_t FirstLine ) const;
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	void Trim( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::deque< std::shared_ptr< Chunk > > m_Chunks;
+	size_t                                 m_MaxLines;
+	uint64_t                               m_FirstLine    = 0;
+	uint64_t                               m_LinesWritten = 0;
+
+}; // OutputLog
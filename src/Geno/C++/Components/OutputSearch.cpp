@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "OutputSearch.h"
+
+#include <Common/Async/JobSystem.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <functional>
+
+#if defined( __SSE2__ ) || defined( _M_AMD64 ) || defined( _M_X64 )
+#include <emmintrin.h>
+#define OUTPUT_SEARCH_SSE2
+#endif // __SSE2__ || _M_AMD64 || _M_X64
+
+//////////////////////////////////////////////////////////////////////////
+
+// Marks the lines in [FirstLine, EndLine) of the chunk that contain the needle. The needle can't contain a line break, so a hit never
+// spans two lines.
+static void MarkLines( const OutputLog::Chunk& rChunk, size_t FirstLine, size_t EndLine, std::string_view Needle, std::vector< uint8_t >& rMarks )
+{
+	const auto             LineStarts = rChunk.LineStarts.begin();
+	const size_t           End        = ( EndLine < rChunk.LineStarts.size() ) ? rChunk.LineStarts[ EndLine ] : rChunk.Text.size();
+	const std::string_view Range      = std::string_view( rChunk.Text ).substr( 0, End );
+	size_t                 Offset     = rChunk.LineStarts[ FirstLine ];
+
+	// Scan the whole range at once rather than line by line, and move on to the next line after every hit
+	while( ( Offset = OutputSearch::Find( Range, Needle, Offset ) ) != std::string_view::npos )
+	{
+		const auto Next = std::upper_bound( LineStarts + FirstLine, LineStarts + EndLine, static_cast< uint32_t >( Offset ) );
+
+		rMarks[ ( Next - LineStarts ) - 1 - FirstLine ] = 1;
+
+		if( Next == LineStarts + EndLine )
+			break;
+
+		Offset = *Next;
+	}
+
+} // MarkLines
+
+//////////////////////////////////////////////////////////////////////////
+
+void OutputSearch::SetCriteria( Criteria NewCriteria )
+{
+	if( NewCriteria == m_Criteria )
+		return;
+
+	m_Criteria = std::move( NewCriteria );
+
+	Reset();
+
+} // SetCriteria
+
+//////////////////////////////////////////////////////////////////////////
+
+void OutputSearch::Update( const OutputLog& rLog )
+{
+	if( m_pPass )
+	{
+		if( !m_pPass->Done.load( std::memory_order_acquire ) )
+			return;
+
+		m_Rows   .insert( m_Rows   .end(), m_pPass->Rows   .begin(), m_pPass->Rows   .end() );
+		m_Matches.insert( m_Matches.end(), m_pPass->Matches.begin(), m_pPass->Matches.end() );
+		m_ScannedTo = m_pPass->EndLine;
+		m_pPass.reset();
+	}
+
+	// Forget about the lines that have been dropped from the log
+	m_Rows   .erase( m_Rows   .begin(), std::lower_bound( m_Rows   .begin(), m_Rows   .end(), rLog.FirstLine() ) );
+	m_Matches.erase( m_Matches.begin(), std::lower_bound( m_Matches.begin(), m_Matches.end(), rLog.FirstLine() ) );
+
+	if( m_Criteria.IsEmpty() )
+		return;
+
+	// The last line may still grow, so it is left for a later pass
+	const uint64_t FirstLine = std::max( m_ScannedTo, rLog.FirstLine() );
+	const uint64_t EndLine   = rLog.CompleteLines();
+
+	if( FirstLine >= EndLine )
+		return;
+
+	std::shared_ptr< Pass > pPass = std::make_shared< Pass >();
+	pPass->Search                 = m_Criteria;
+	pPass->Chunks                 = rLog.Snapshot( FirstLine );
+	pPass->FirstLine              = FirstLine;
+	pPass->EndLine                = EndLine;
+
+	// The job keeps its own reference, so a pass that has been replaced or reset in the meantime just goes to waste
+	JobSystem::Instance().NewJob( [ pPass ]( void )
+		{
+			Scan( *pPass );
+			pPass->Done.store( true, std::memory_order_release );
+		} );
+
+	m_pPass = std::move( pPass );
+
+} // Update
+
+//////////////////////////////////////////////////////////////////////////
+
+void OutputSearch::Reset( void )
+{
+	m_pPass.reset();
+	m_Rows   .clear();
+	m_Matches.clear();
+
+	m_ScannedTo = 0;
+
+} // Reset
+
+//////////////////////////////////////////////////////////////////////////
+
+size_t OutputSearch::Find( std::string_view Haystack, std::string_view Needle, size_t Offset )
+{
+	if( Needle.empty() || Haystack.size() < Needle.size() || Offset > Haystack.size() - Needle.size() )
+		return std::string_view::npos;
+
+	const size_t LastStart = Haystack.size() - Needle.size();
+
+#if defined( OUTPUT_SEARCH_SSE2 )
+
+	// Compare the first and the last character of the needle against 16 positions at a time, and only check the rest of the needle at the
+	// positions where both of them match
+	const __m128i First = _mm_set1_epi8( Needle.front() );
+	const __m128i Last  = _mm_set1_epi8( Needle.back() );
+
+	for( ; Offset + 16 <= LastStart + 1; Offset += 16 )
+	{
+		const __m128i FirstBlock = _mm_loadu_si128( reinterpret_cast< const __m128i* >( Haystack.data() + Offset ) );
+		const __m128i LastBlock  = _mm_loadu_si128( reinterpret_cast< const __m128i* >( Haystack.data() + Offset + Needle.size() - 1 ) );
+		unsigned      Mask       = static_cast< unsigned >( _mm_movemask_epi8( _mm_and_si128( _mm_cmpeq_epi8( FirstBlock, First ), _mm_cmpeq_epi8( LastBlock, Last ) ) ) );
+
+		for( ; Mask != 0; Mask &= Mask - 1 )
+		{
+			const size_t Start = Offset + static_cast< size_t >( std::countr_zero( Mask ) );
+
+			if( Needle.size() <= 2 || memcmp( Haystack.data() + Start + 1, Needle.data() + 1, Needle.size() - 2 ) == 0 )
+				return Start;
+		}
+	}
+
+#endif // OUTPUT_SEARCH_SSE2
+
+	// The remainder (or everything, without SSE2). memchr() is vectorized by the C library.
+	while( Offset <= LastStart )
+	{
+		const void* pFirst = memchr( Haystack.data() + Offset, Needle.front(), LastStart + 1 - Offset );
+		if( !pFirst )
+			break;
+
+		Offset = static_cast< size_t >( static_cast< const char* >( pFirst ) - Haystack.data() );
+
+		if( memcmp( Haystack.data() + Offset, Needle.data(), Needle.size() ) == 0 )
+			return Offset;
+
+		++Offset;
+	}
+
+	return std::string_view::npos;
+
+} // Find
+
+//////////////////////////////////////////////////////////////////////////
+
+void OutputSearch::Scan( Pass& rPass )
+{
+	const Criteria&        rSearch = rPass.Search;
+	std::vector< uint8_t > Keep;
+	std::vector< uint8_t > Marks;
+
+	auto Mark = [ & ]( const OutputLog::Chunk& rChunk, size_t FirstLine, size_t EndLine, std::string_view Needle )
+	{
+		Marks.assign( EndLine - FirstLine, 0 );
+		MarkLines( rChunk, FirstLine, EndLine, Needle, Marks );
+	};
+
+	for( const OutputLog::ChunkPtr& rpChunk : rPass.Chunks )
+	{
+		const OutputLog::Chunk& rChunk    = *rpChunk;
+		const uint64_t          ChunkEnd  = rChunk.FirstLine + rChunk.LineStarts.size();
+		const uint64_t          FirstLine = std::max( rPass.FirstLine, rChunk.FirstLine );
+		const uint64_t          EndLine   = std::min( rPass.EndLine, ChunkEnd );
+
+		if( FirstLine >= EndLine )
+			continue;
+
+		const size_t First = static_cast< size_t >( FirstLine - rChunk.FirstLine );
+		const size_t End   = static_cast< size_t >( EndLine   - rChunk.FirstLine );
+
+		Keep.assign( End - First, 1 );
+
+		if( rSearch.Errors || rSearch.Warnings )
+		{
+			std::vector< uint8_t > Severe( End - First, 0 );
+
+			// Compilers and linkers differ in case, but never write these in all caps
+			for( std::string_view Needle : { "error", "Error" } )
+			{
+				if( rSearch.Errors )
+					MarkLines( rChunk, First, End, Needle, Severe );
+			}
+
+			for( std::string_view Needle : { "warning", "Warning" } )
+			{
+				if( rSearch.Warnings )
+					MarkLines( rChunk, First, End, Needle, Severe );
+			}
+
+			std::transform( Keep.begin(), Keep.end(), Severe.begin(), Keep.begin(), std::bit_and<>() );
+		}
+
+		if( !rSearch.Project.empty() )
+		{
+			Mark( rChunk, First, End, rSearch.Project );
+			std::transform( Keep.begin(), Keep.end(), Marks.begin(), Keep.begin(), std::bit_and<>() );
+		}
+
+		if( !rSearch.Text.empty() )
+			Mark( rChunk, First, End, rSearch.Text );
+
+		for( size_t i = 0; i < Keep.size(); ++i )
+		{
+			if( !Keep[ i ] )
+				continue;
+
+			if( rSearch.HasFilters() )
+				rPass.Rows.push_back( FirstLine + i );
+
+			if( !rSearch.Text.empty() && Marks[ i ] )
+				rPass.Matches.push_back( FirstLine + i );
+		}
+	}
+
+} // Scan
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include "Components/OutputLog.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Finds the lines of the output log that pass a set of filters, and those of them that contain a piece of text. The scan runs as a job
+// over a snapshot of the log, and only ever looks at lines that were added since the previous scan, so keeping up with a growing log
+// costs no more than the new output itself.
+class OutputSearch
+{
+public:
+
+	struct Criteria
+	{
+		std::string Text;
+		std::string Project;          // Only lines that mention the location of this project
+		bool        Errors   = false;
+		bool        Warnings = false; // Together with Errors, lines with either
+
+		bool HasFilters( void ) const { return Errors || Warnings || !Project.empty(); }
+		bool IsEmpty   ( void ) const { return Text.empty() && !HasFilters(); }
+
+		bool operator==( const Criteria& ) const = default;
+
+	}; // Criteria
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Call these with the log locked
+	void SetCriteria( Criteria NewCriteria );
+	void Update     ( const OutputLog& rLog );
+	void Reset      ( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Lines are numbered like OutputLog::FirstLine(). Rows are only filled in if there are filters.
+	const Criteria&                GetCriteria( void ) const { return m_Criteria; }
+	const std::vector< uint64_t >& Rows       ( void ) const { return m_Rows; }
+	const std::vector< uint64_t >& Matches    ( void ) const { return m_Matches; }
+	bool                           IsScanning ( void ) const { return m_pPass != nullptr; }
+
+//////////////////////////////////////////////////////////////////////////
+
+	static size_t Find( std::string_view Haystack, std::string_view Needle, size_t Offset = 0 );
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	struct Pass
+	{
+		Criteria                           Search;
+		std::vector< OutputLog::ChunkPtr > Chunks;
+		uint64_t                           FirstLine = 0;
+		uint64_t                           EndLine   = 0;
+
+		std::vector< uint64_t >            Rows;
+		std::vector< uint64_t >            Matches;
+		std::atomic< bool >                Done      = false;
+
+	}; // Pass
+
+//////////////////////////////////////////////////////////////////////////
+
+	static void Scan( Pass& rPass );
+
+//////////////////////////////////////////////////////////////////////////
+
+	Criteria                m_Criteria;
+	std::shared_ptr< Pass > m_pPass;
+	uint64_t                m_ScannedTo = 0;
+
+	std::vector< uint64_t > m_Rows;
+	std::vector< uint64_t > m_Matches;
+
+}; // OutputSearch
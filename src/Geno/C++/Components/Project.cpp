@@ -53,6 +53,7 @@ Project& Project::operator=( Project&& rrOther )
 	m_Location           = std::move( rrOther.m_Location );
 	m_Name               = std::move( rrOther.m_Name );
 	m_FileFilters        = std::move( rrOther.m_FileFilters );
+	m_Tags               = std::move( rrOther.m_Tags );
 
 	rrOther.m_Kind       = Kind::Unspecified;
 
@@ -104,6 +105,19 @@ bool Project::Serialize( void )
 		Serializer.WriteObject( Kind );
 	}
 
+	// Tags
+	if( !m_Tags.empty() )
+	{
+		GCL::Object Tags( "Tags", std::in_place_type< GCL::Object::TableType > );
+
+		for( const std::string& rTag : m_Tags )
+		{
+			Tags.AddChild( GCL::Object( rTag ) );
+		}
+
+		Serializer.WriteObject( Tags );
+	}
+
 	// Filters
 	if( !m_FileFilters.empty() )
 	{
@@ -575,6 +589,14 @@ std::vector< std::filesystem::path > Project::FindSourceFolders( void )
 
 //////////////////////////////////////////////////////////////////////////
 
+bool Project::HasTag( std::string_view Tag ) const
+{
+	return std::find( m_Tags.begin(), m_Tags.end(), Tag ) != m_Tags.end();
+
+} // HasTag
+
+//////////////////////////////////////////////////////////////////////////
+
 void Project::GCLObjectCallback( GCL::Object Object, void* pUser )
 {
 	Project*         pSelf = static_cast< Project* >( pUser );
@@ -594,6 +616,13 @@ void Project::GCLObjectCallback( GCL::Object Object, void* pUser )
 		else if( rKindString == "DynamicLibrary" ) { pSelf->m_Kind = Kind::DynamicLibrary; }
 		else                                       { pSelf->m_Kind = Kind::Unspecified; }
 	}
+	else if( Name == "Tags" )
+	{
+		for( const GCL::Object& rTagObj : Object.Table() )
+		{
+			pSelf->m_Tags.emplace_back( rTagObj.Name() );
+		}
+	}
 	else if( Name == "FileFilters" )
 	{
 		for( const GCL::Object& rFileFilterObj : Object.Table() )
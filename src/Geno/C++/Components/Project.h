@@ -56,6 +56,9 @@ public:
 
 	static constexpr std::string_view EXTENSION = ".gprj";
 
+	// Applications with this tag are run by the test runner
+	static constexpr std::string_view TEST_TAG  = "test";
+
 //////////////////////////////////////////////////////////////////////////
 
 	explicit Project( std::filesystem::path Location );
@@ -81,6 +84,7 @@ public:
 	void                  RemoveFile                      ( const std::filesystem::path& rFile, const std::filesystem::path& rFileFilter );
 	void                  RenameFile                      ( const std::filesystem::path& rFile, const std::filesystem::path& rFileFilter, const std::string& rName );
 	std::vector< std::filesystem::path > FindSourceFolders( void );
+	bool                  HasTag                          ( std::string_view Tag ) const;
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -98,6 +102,7 @@ public:
 	std::filesystem::path                m_Location;
 	std::string                          m_Name;
 	std::vector< FileFilter >            m_FileFilters;
+	std::vector< std::string >           m_Tags;
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -0,0 +1,1286 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "Regex.h"
+
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////////////
+
+static constexpr size_t MaxProgramSize = 1 << 17;
+static constexpr size_t MaxDfaStates   = 2048;
+static constexpr int    MaxRepeat      = 1000;
+
+//////////////////////////////////////////////////////////////////////////
+
+struct Regex::Node
+{
+	enum class Kind : uint8_t
+	{
+		Empty,
+		Bytes,
+		Concat,
+		Alternate,
+		Repeat,
+		Group,
+		LineStart,
+		LineEnd,
+
+	}; // Kind
+
+	static Node Leaf( Kind Type, uint32_t Set = 0 )
+	{
+		Node Result;
+		Result.Type = Type;
+		Result.Set  = Set;
+
+		return Result;
+	}
+
+	bool Nullable( void ) const
+	{
+		switch( Type )
+		{
+			case Kind::Bytes:     return false;
+			case Kind::Concat:    return std::all_of( Children.begin(), Children.end(), []( const Node& rChild ) { return rChild.Nullable(); } );
+			case Kind::Alternate: return std::any_of( Children.begin(), Children.end(), []( const Node& rChild ) { return rChild.Nullable(); } );
+			case Kind::Repeat:    return Min == 0 || Children.front().Nullable();
+			case Kind::Group:     return Children.front().Nullable();
+			default:              return true;
+		}
+	}
+
+	Kind                Type   = Kind::Empty;
+	uint32_t            Set    = 0;
+	int                 Min    = 0;
+	int                 Max    = 0;    // Negative for no limit
+	bool                Greedy = true;
+	uint32_t            Group  = 0;
+	std::vector< Node > Children;
+
+}; // Node
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool IsDigit( char C )
+{
+	return C >= '0' && C <= '9';
+
+} // IsDigit
+
+//////////////////////////////////////////////////////////////////////////
+
+static int HexValue( char C )
+{
+	if( C >= '0' && C <= '9' ) return C - '0';
+	if( C >= 'a' && C <= 'f' ) return C - 'a' + 10;
+	if( C >= 'A' && C <= 'F' ) return C - 'A' + 10;
+
+	return -1;
+
+} // HexValue
+
+//////////////////////////////////////////////////////////////////////////
+
+static size_t Utf8Length( unsigned char Lead )
+{
+	if( Lead >= 0xF0 && Lead <= 0xF4 ) return 4;
+	if( Lead >= 0xE0 )                 return Lead <= 0xEF ? 3 : 1;
+	if( Lead >= 0xC2 )                 return 2;
+
+	return 1;
+
+} // Utf8Length
+
+//////////////////////////////////////////////////////////////////////////
+
+static void AddRange( std::bitset< 256 >& rSet, int First, int Last )
+{
+	for( int C = First; C <= Last; ++C )
+		rSet.set( static_cast< size_t >( C ) );
+
+} // AddRange
+
+//////////////////////////////////////////////////////////////////////////
+
+// \d, \w and \s (and their negations, which the caller takes care of)
+static bool ShorthandClass( char C, std::bitset< 256 >& rSet )
+{
+	switch( C )
+	{
+		case 'd': case 'D':
+			AddRange( rSet, '0', '9' );
+			return true;
+
+		case 'w': case 'W':
+			AddRange( rSet, '0', '9' );
+			AddRange( rSet, 'a', 'z' );
+			AddRange( rSet, 'A', 'Z' );
+			rSet.set( '_' );
+			return true;
+
+		case 's': case 'S':
+			for( char Space : { ' ', '\t', '\n', '\r', '\f', '\v' } )
+				rSet.set( static_cast< unsigned char >( Space ) );
+			return true;
+
+		default:
+			return false;
+	}
+
+} // ShorthandClass
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Regex::Compile( std::string_view Pattern, bool CaseSensitive )
+{
+	m_Program.clear();
+	m_Sets.clear();
+	m_States.clear();
+	m_StateIds.clear();
+	m_StartStates = { -1, -1 };
+	m_GroupCount  = 0;
+	m_Error.clear();
+
+	m_Pattern       = Pattern;
+	m_Position      = 0;
+	m_CaseSensitive = CaseSensitive;
+
+	Node Root;
+
+	if( !ParseAlternation( Root ) )
+		return false;
+
+	if( m_Position < m_Pattern.size() )
+		return Fail( "Unmatched )" );
+
+	// The whole match is group 0. Loops get their own slots after the groups'.
+	m_SlotCount = 2 * ( m_GroupCount + 1 );
+
+	m_Program.push_back( Instruction{ Op::Save, 1, 0, 0 } );
+
+	if( !Emit( Root ) )
+		return Fail( "The pattern is too large" );
+
+	m_Program.push_back( Instruction{ Op::Save, static_cast< uint32_t >( m_Program.size() + 1 ), 0, 1 } );
+	m_Program.push_back( Instruction{ Op::Match } );
+
+	m_Seen.assign( m_Program.size(), 0 );
+	m_Generation = 0;
+	m_Pattern    = { };
+
+	return true;
+
+} // Compile
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Regex::Find( std::string_view Line, size_t Offset, Match& rMatch )
+{
+	if( m_Program.empty() || Offset > Line.size() )
+		return false;
+
+	// The DFA only decides whether there is a match at all, which is asked once per line. The matches after the first one are found by
+	// the simulation, which stops soon after each match and so goes through the line about once altogether.
+	if( Offset == 0 && !IsMatch( Line, 0 ) )
+		return false;
+
+	return Simulate( Line, Offset, rMatch );
+
+} // Find
+
+//////////////////////////////////////////////////////////////////////////
+
+std::string Regex::Expand( std::string_view Replacement, std::string_view Line, const Match& rMatch )
+{
+	std::string Text;
+
+	auto AppendGroup = [ & ]( size_t Group ) -> bool
+	{
+		if( Group == 0 )
+		{
+			Text.append( Line.substr( rMatch.Start, rMatch.End - rMatch.Start ) );
+			return true;
+		}
+
+		if( Group * 2 > rMatch.Groups.size() )
+			return false;
+
+		const size_t Start = rMatch.Groups[ Group * 2 - 2 ];
+		const size_t End   = rMatch.Groups[ Group * 2 - 1 ];
+
+		if( Start != std::string_view::npos && End != std::string_view::npos )
+			Text.append( Line.substr( Start, End - Start ) );
+
+		return true;
+	};
+
+	for( size_t i = 0; i < Replacement.size(); ++i )
+	{
+		const char C = Replacement[ i ];
+
+		if( C != '$' || i + 1 == Replacement.size() )
+		{
+			Text += C;
+			continue;
+		}
+
+		const char Next = Replacement[ i + 1 ];
+
+		if( Next == '$' )
+		{
+			Text += '$';
+			++i;
+		}
+		else if( Next == '&' )
+		{
+			AppendGroup( 0 );
+			++i;
+		}
+		else if( IsDigit( Next ) )
+		{
+			size_t Group  = static_cast< size_t >( Next - '0' );
+			size_t Length = 1;
+
+			if( i + 2 < Replacement.size() && IsDigit( Replacement[ i + 2 ] ) )
+			{
+				Group  = Group * 10 + static_cast< size_t >( Replacement[ i + 2 ] - '0' );
+				Length = 2;
+			}
+
+			if( AppendGroup( Group ) ) i += Length;
+			else                       Text += C;
+		}
+		else if( Next == '{' )
+		{
+			const size_t Close = Replacement.find( '}', i + 2 );
+			size_t       Group = 0;
+			bool         Valid = Close != std::string_view::npos && Close > i + 2;
+
+			for( size_t j = i + 2; Valid && j < Close; ++j )
+			{
+				Valid = IsDigit( Replacement[ j ] ) && Group < 100;
+				Group = Group * 10 + static_cast< size_t >( Replacement[ j ] - '0' );
+			}
+
+			if( Valid && AppendGroup( Group ) ) i = Close;
+			else                                Text += C;
+		}
+		else
+		{
+			Text += C;
+		}
+	}
+
+	return Text;
+
+} // Expand
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Regex::ParseAlternation( Node& rNode )
+{
+	Node First;
+
+	if( !ParseConcat( First ) )
+		return false;
+
+	if( m_Position == m_Pattern.size() || m_Pattern[ m_Position ] != '|' )
+	{
+		rNode = std::move( First );
+		return true;
+	}
+
+	rNode.Type = Node::Kind::Alternate;
+	rNode.Children.push_back( std::move( First ) );
+
+	while( m_Position < m_Pattern.size() && m_Pattern[ m_Position ] == '|' )
+	{
+		++m_Position;
+
+		if( !ParseConcat( rNode.Children.emplace_back() ) )
+			return false;
+	}
+
+	return true;
+
+} // ParseAlternation
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Regex::ParseConcat( Node& rNode )
+{
+	rNode.Type = Node::Kind::Concat;
+
+	while( m_Position < m_Pattern.size() && m_Pattern[ m_Position ] != '|' && m_Pattern[ m_Position ] != ')' )
+	{
+		if( !ParseRepeat( rNode.Children.emplace_back() ) )
+			return false;
+	}
+
+	if( rNode.Children.empty() )
+	{
+		rNode.Type = Node::Kind::Empty;
+	}
+	else if( rNode.Children.size() == 1 )
+	{
+		Node Only = std::move( rNode.Children.front() );
+		rNode     = std::move( Only );
+	}
+
+	return true;
+
+} // ParseConcat
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Regex::ParseRepeat( Node& rNode )
+{
+	if( std::string_view( "*+?" ).find( m_Pattern[ m_Position ] ) != std::string_view::npos )
+		return Fail( "Nothing to repeat" );
+
+	if( !ParseAtom( rNode ) )
+		return false;
+
+	while( m_Position < m_Pattern.size() )
+	{
+		const char C   = m_Pattern[ m_Position ];
+		int        Min = 0;
+		int        Max = -1;
+
+		if( C == '*' )
+		{
+			++m_Position;
+		}
+		else if( C == '+' )
+		{
+			Min = 1;
+			++m_Position;
+		}
+		else if( C == '?' )
+		{
+			Max = 1;
+			++m_Position;
+		}
+		else if( C == '{' )
+		{
+			// {n}, {n,} and {n,m}. Anything else is a literal brace.
+			size_t Position = m_Position + 1;
+			auto   Number   = [ & ]( int& rValue ) -> bool
+			{
+				const size_t Start = Position;
+
+				for( rValue = 0; Position < m_Pattern.size() && IsDigit( m_Pattern[ Position ] ) && rValue <= MaxRepeat; ++Position )
+					rValue = rValue * 10 + ( m_Pattern[ Position ] - '0' );
+
+				return Position > Start;
+			};
+
+			if( !Number( Min ) )
+				break;
+
+			if( Position < m_Pattern.size() && m_Pattern[ Position ] == ',' )
+			{
+				++Position;
+
+				if( !Number( Max ) )
+					Max = -1;
+			}
+			else
+			{
+				Max = Min;
+			}
+
+			if( Position == m_Pattern.size() || m_Pattern[ Position ] != '}' )
+				break;
+
+			if( Min > MaxRepeat || Max > MaxRepeat )
+				return Fail( "Repetition count is too large" );
+
+			if( Max >= 0 && Max < Min )
+				return Fail( "Repetition range is out of order" );
+
+			m_Position = Position + 1;
+		}
+		else
+		{
+			break;
+		}
+
+		Node Repeat;
+		Repeat.Type = Node::Kind::Repeat;
+		Repeat.Min  = Min;
+		Repeat.Max  = Max;
+
+		// A trailing ? makes the repetition lazy
+		if( m_Position < m_Pattern.size() && m_Pattern[ m_Position ] == '?' )
+		{
+			Repeat.Greedy = false;
+			++m_Position;
+		}
+
+		Repeat.Children.push_back( std::move( rNode ) );
+		rNode = std::move( Repeat );
+	}
+
+	return true;
+
+} // ParseRepeat
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Regex::ParseAtom( Node& rNode )
+{
+	const char C = m_Pattern[ m_Position ];
+
+	switch( C )
+	{
+		case '(':
+		{
+			++m_Position;
+
+			rNode.Type = Node::Kind::Group;
+
+			if( m_Pattern.substr( m_Position, 2 ) == "?:" )
+			{
+				rNode.Type  = Node::Kind::Concat;
+				m_Position += 2;
+			}
+			else if( m_Position < m_Pattern.size() && m_Pattern[ m_Position ] == '?' )
+			{
+				return Fail( "Lookarounds and other (? groups are not supported" );
+			}
+			else
+			{
+				rNode.Group = static_cast< uint32_t >( ++m_GroupCount );
+			}
+
+			if( !ParseAlternation( rNode.Children.emplace_back() ) )
+				return false;
+
+			if( m_Position == m_Pattern.size() || m_Pattern[ m_Position ] != ')' )
+				return Fail( "Missing )" );
+
+			++m_Position;
+
+			return true;
+		}
+
+		case '[':
+			++m_Position;
+			return ParseClass( rNode );
+
+		case '.':
+			++m_Position;
+			AnyCharacter( ByteSet(), rNode );
+			return true;
+
+		case '^':
+			++m_Position;
+			rNode.Type = Node::Kind::LineStart;
+			return true;
+
+		case '$':
+			++m_Position;
+			rNode.Type = Node::Kind::LineEnd;
+			return true;
+
+		case '\\':
+		{
+			if( m_Position + 1 == m_Pattern.size() )
+				return Fail( "Trailing \\" );
+
+			const char Escaped = m_Pattern[ m_Position + 1 ];
+			ByteSet    Set;
+
+			if( ShorthandClass( Escaped, Set ) )
+			{
+				m_Position += 2;
+
+				if( Escaped >= 'A' && Escaped <= 'Z' ) AnyCharacter( Set, rNode );
+				else                                   rNode = Node::Leaf( Node::Kind::Bytes, AddSet( Set ) );
+
+				return true;
+			}
+
+			break;
+		}
+
+		default:
+			break;
+	}
+
+	// A single character, which may take several bytes
+	std::string Character;
+
+	if( !ParseCharacter( Character ) )
+		return false;
+
+	rNode.Type = Node::Kind::Concat;
+
+	for( char Byte : Character )
+	{
+		ByteSet Set;
+		Set.set( static_cast< unsigned char >( Byte ) );
+
+		rNode.Children.push_back( Node::Leaf( Node::Kind::Bytes, AddSet( Set ) ) );
+	}
+
+	if( rNode.Children.size() == 1 )
+	{
+		Node Only = std::move( rNode.Children.front() );
+		rNode     = std::move( Only );
+	}
+
+	return true;
+
+} // ParseAtom
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Regex::ParseClass( Node& rNode )
+{
+	ByteSet                    Set;
+	std::vector< std::string > Characters; // Outside of ASCII, matched as sequences
+	bool                       Negated = false;
+
+	if( m_Position < m_Pattern.size() && m_Pattern[ m_Position ] == '^' )
+	{
+		Negated = true;
+		++m_Position;
+	}
+
+	for( bool First = true;; First = false )
+	{
+		if( m_Position == m_Pattern.size() )
+			return Fail( "Missing ]" );
+
+		// A ] right at the start is just a character
+		if( m_Pattern[ m_Position ] == ']' && !First )
+		{
+			++m_Position;
+			break;
+		}
+
+		if( m_Pattern[ m_Position ] == '\\' && m_Position + 1 < m_Pattern.size() )
+		{
+			ByteSet Shorthand;
+
+			if( ShorthandClass( m_Pattern[ m_Position + 1 ], Shorthand ) )
+			{
+				if( m_Pattern[ m_Position + 1 ] >= 'A' && m_Pattern[ m_Position + 1 ] <= 'Z' )
+				{
+					// Only the ASCII part of a negated shorthand fits in a class
+					Shorthand.flip();
+
+					for( int C = 0x80; C < 0x100; ++C )
+						Shorthand.reset( static_cast< size_t >( C ) );
+				}
+
+				Set |= Shorthand;
+				m_Position += 2;
+
+				continue;
+			}
+		}
+
+		std::string Low;
+
+		if( !ParseCharacter( Low ) )
+			return false;
+
+		const bool Range = m_Position + 1 < m_Pattern.size() && m_Pattern[ m_Position ] == '-' && m_Pattern[ m_Position + 1 ] != ']';
+
+		if( !Range )
+		{
+			if( Low.size() == 1 ) Set.set( static_cast< unsigned char >( Low[ 0 ] ) );
+			else                  Characters.push_back( std::move( Low ) );
+
+			continue;
+		}
+
+		++m_Position;
+
+		std::string High;
+
+		if( !ParseCharacter( High ) )
+			return false;
+
+		if( Low.size() != 1 || High.size() != 1 )
+			return Fail( "Ranges of non-ASCII characters are not supported" );
+
+		if( static_cast< unsigned char >( Low[ 0 ] ) > static_cast< unsigned char >( High[ 0 ] ) )
+			return Fail( "Character range is out of order" );
+
+		AddRange( Set, static_cast< unsigned char >( Low[ 0 ] ), static_cast< unsigned char >( High[ 0 ] ) );
+	}
+
+	if( Negated )
+	{
+		if( !Characters.empty() )
+			return Fail( "Non-ASCII characters in negated classes are not supported" );
+
+		AnyCharacter( Set, rNode );
+
+		return true;
+	}
+
+	rNode = Node::Leaf( Node::Kind::Bytes, AddSet( Set ) );
+
+	if( Characters.empty() )
+		return true;
+
+	Node Alternate;
+	Alternate.Type = Node::Kind::Alternate;
+	Alternate.Children.push_back( std::move( rNode ) );
+
+	for( const std::string& rCharacter : Characters )
+	{
+		Node& rSequence = Alternate.Children.emplace_back();
+		rSequence.Type  = Node::Kind::Concat;
+
+		for( char Byte : rCharacter )
+		{
+			ByteSet ByteOnly;
+			ByteOnly.set( static_cast< unsigned char >( Byte ) );
+
+			rSequence.Children.push_back( Node::Leaf( Node::Kind::Bytes, AddSet( ByteOnly ) ) );
+		}
+	}
+
+	rNode = std::move( Alternate );
+
+	return true;
+
+} // ParseClass
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Regex::ParseCharacter( std::string& rCharacter )
+{
+	const char C = m_Pattern[ m_Position ];
+
+	if( C != '\\' )
+	{
+		const size_t Length = std::min( Utf8Length( static_cast< unsigned char >( C ) ), m_Pattern.size() - m_Position );
+
+		rCharacter  = std::string( m_Pattern.substr( m_Position, Length ) );
+		m_Position += Length;
+
+		return true;
+	}
+
+	if( m_Position + 1 == m_Pattern.size() )
+		return Fail( "Trailing \\" );
+
+	const char Escaped = m_Pattern[ m_Position + 1 ];
+	m_Position += 2;
+
+	switch( Escaped )
+	{
+		case 't': rCharacter = "\t"; return true;
+		case 'n': rCharacter = "\n"; return true;
+		case 'r': rCharacter = "\r"; return true;
+		case 'f': rCharacter = "\f"; return true;
+		case 'v': rCharacter = "\v"; return true;
+
+		case 'x':
+		{
+			const int High = m_Position < m_Pattern.size() ? HexValue( m_Pattern[ m_Position ] ) : -1;
+			const int Low  = m_Position + 1 < m_Pattern.size() ? HexValue( m_Pattern[ m_Position + 1 ] ) : -1;
+
+			if( High < 0 || Low < 0 )
+				return Fail( "\\x needs two hexadecimal digits" );
+
+			rCharacter  = std::string( 1, static_cast< char >( High * 16 + Low ) );
+			m_Position += 2;
+
+			return true;
+		}
+
+		default:
+			break;
+	}
+
+	// Letters and digits are reserved for escapes, everything else stands for itself
+	if( ( Escaped >= 'a' && Escaped <= 'z' ) || ( Escaped >= 'A' && Escaped <= 'Z' ) || IsDigit( Escaped ) )
+		return Fail( std::string( "\\" ) + Escaped + " is not supported" );
+
+	rCharacter = std::string( 1, Escaped );
+
+	return true;
+
+} // ParseCharacter
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Regex::Fail( std::string Error )
+{
+	m_Error = std::move( Error );
+	m_Program.clear();
+
+	return false;
+
+} // Fail
+
+//////////////////////////////////////////////////////////////////////////
+
+uint32_t Regex::AddSet( ByteSet Set )
+{
+	if( !m_CaseSensitive )
+	{
+		for( int C = 'a'; C <= 'z'; ++C )
+		{
+			const size_t Upper = static_cast< size_t >( C - 'a' + 'A' );
+
+			if( Set.test( static_cast< size_t >( C ) ) || Set.test( Upper ) )
+			{
+				Set.set( static_cast< size_t >( C ) );
+				Set.set( Upper );
+			}
+		}
+	}
+
+	m_Sets.push_back( Set );
+
+	return static_cast< uint32_t >( m_Sets.size() - 1 );
+
+} // AddSet
+
+//////////////////////////////////////////////////////////////////////////
+
+void Regex::AnyCharacter( const ByteSet& rExcluded, Node& rNode )
+{
+	ByteSet Ascii;
+	AddRange( Ascii, 0x00, 0x7F );
+	Ascii.reset( '\n' );
+
+	ByteSet Excluded = rExcluded;
+
+	// Without case sensitivity, excluding a letter excludes both of its cases
+	if( !m_CaseSensitive )
+	{
+		for( int C = 'a'; C <= 'z'; ++C )
+		{
+			const size_t Upper = static_cast< size_t >( C - 'a' + 'A' );
+
+			if( Excluded.test( static_cast< size_t >( C ) ) || Excluded.test( Upper ) )
+			{
+				Excluded.set( static_cast< size_t >( C ) );
+				Excluded.set( Upper );
+			}
+		}
+	}
+
+	// Sets are added as they are here, or the case folding would put the excluded letters back
+	auto Bytes = [ this ]( int First, int Last )
+	{
+		ByteSet Set;
+		AddRange( Set, First, Last );
+		m_Sets.push_back( Set );
+
+		return Node::Leaf( Node::Kind::Bytes, static_cast< uint32_t >( m_Sets.size() - 1 ) );
+	};
+
+	m_Sets.push_back( Ascii & ~Excluded );
+
+	rNode          = Node::Leaf( Node::Kind::Alternate );
+	rNode.Children = { Node::Leaf( Node::Kind::Bytes, static_cast< uint32_t >( m_Sets.size() - 1 ) ) };
+
+	// Whole UTF-8 sequences come before stray bytes, which are taken one at a time so that nothing is left that can't be matched
+	for( auto [ First, Last, Length ] : { std::array< int, 3 >{ 0xC2, 0xDF, 2 }, std::array< int, 3 >{ 0xE0, 0xEF, 3 }, std::array< int, 3 >{ 0xF0, 0xF4, 4 } } )
+	{
+		Node& rSequence = rNode.Children.emplace_back();
+		rSequence.Type  = Node::Kind::Concat;
+
+		rSequence.Children.push_back( Bytes( First, Last ) );
+
+		for( int i = 1; i < Length; ++i )
+			rSequence.Children.push_back( Bytes( 0x80, 0xBF ) );
+	}
+
+	rNode.Children.push_back( Bytes( 0x80, 0xFF ) );
+
+} // AnyCharacter
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Regex::Emit( const Node& rNode )
+{
+	if( m_Program.size() > MaxProgramSize )
+		return false;
+
+	auto Next = [ this ]( void ) { return static_cast< uint32_t >( m_Program.size() + 1 ); };
+
+	switch( rNode.Type )
+	{
+		case Node::Kind::Empty:
+			return true;
+
+		case Node::Kind::Bytes:
+			m_Program.push_back( Instruction{ Op::Bytes, Next(), 0, rNode.Set } );
+			return true;
+
+		case Node::Kind::LineStart:
+			m_Program.push_back( Instruction{ Op::LineStart, Next() } );
+			return true;
+
+		case Node::Kind::LineEnd:
+			m_Program.push_back( Instruction{ Op::LineEnd, Next() } );
+			return true;
+
+		case Node::Kind::Concat:
+			for( const Node& rChild : rNode.Children )
+			{
+				if( !Emit( rChild ) )
+					return false;
+			}
+			return true;
+
+		case Node::Kind::Group:
+			m_Program.push_back( Instruction{ Op::Save, Next(), 0, rNode.Group * 2 } );
+
+			if( !Emit( rNode.Children.front() ) )
+				return false;
+
+			m_Program.push_back( Instruction{ Op::Save, Next(), 0, rNode.Group * 2 + 1 } );
+			return true;
+
+		case Node::Kind::Alternate:
+		{
+			// Each alternative but the last is tried before the ones after it: split, alternative, jump to the end
+			std::vector< size_t > Jumps;
+
+			for( size_t i = 0; i < rNode.Children.size(); ++i )
+			{
+				const bool   Last  = i + 1 == rNode.Children.size();
+				const size_t Split = m_Program.size();
+
+				if( !Last )
+					m_Program.push_back( Instruction{ Op::Split, Next() } );
+
+				if( !Emit( rNode.Children[ i ] ) )
+					return false;
+
+				if( !Last )
+				{
+					Jumps.push_back( m_Program.size() );
+					m_Program.push_back( Instruction{ Op::Jump } );
+					m_Program[ Split ].Out1 = static_cast< uint32_t >( m_Program.size() );
+				}
+			}
+
+			for( size_t Jump : Jumps )
+				m_Program[ Jump ].Out = static_cast< uint32_t >( m_Program.size() );
+
+			return true;
+		}
+
+		case Node::Kind::Repeat:
+		{
+			const Node& rChild = rNode.Children.front();
+
+			for( int i = 0; i < rNode.Min; ++i )
+			{
+				if( !Emit( rChild ) )
+					return false;
+			}
+
+			// The optional part: a loop without a limit, or one optional copy per count above the minimum
+			for( int i = rNode.Min; rNode.Max < 0 ? i == rNode.Min : i < rNode.Max; ++i )
+			{
+				const size_t Split = m_Program.size();
+
+				m_Program.push_back( Instruction{ Op::Split } );
+
+				// A loop around something that can match nothing must not go around again without moving on. A backtracking engine leaves
+				// the loop at that point, which is what is done here, where otherwise the thread would just die and lower priority ones win.
+				const bool     Guarded = rNode.Max < 0 && rChild.Nullable();
+				const uint32_t Slot    = static_cast< uint32_t >( m_SlotCount );
+
+				if( Guarded )
+				{
+					m_Program.push_back( Instruction{ Op::Save, Next(), 0, Slot } );
+					++m_SlotCount;
+				}
+
+				if( !Emit( rChild ) )
+					return false;
+
+				if( Guarded )
+					m_Program.push_back( Instruction{ Op::Loop, static_cast< uint32_t >( Split ), static_cast< uint32_t >( m_Program.size() + 1 ), Slot } );
+				else if( rNode.Max < 0 )
+					m_Program.push_back( Instruction{ Op::Jump, static_cast< uint32_t >( Split ) } );
+
+				const uint32_t Body = static_cast< uint32_t >( Split + 1 );
+				const uint32_t Skip = static_cast< uint32_t >( m_Program.size() );
+
+				m_Program[ Split ].Out  = rNode.Greedy ? Body : Skip;
+				m_Program[ Split ].Out1 = rNode.Greedy ? Skip : Body;
+			}
+
+			return true;
+		}
+	}
+
+	return false;
+
+} // Emit
+
+//////////////////////////////////////////////////////////////////////////
+
+void Regex::Closure( uint32_t Pc, bool AtLineStart, bool AtLineEnd, std::vector< uint32_t >& rThreads, bool& rMatch )
+{
+	m_Stack.push_back( Pc );
+
+	while( !m_Stack.empty() )
+	{
+		Pc = m_Stack.back();
+		m_Stack.pop_back();
+
+		if( m_Seen[ Pc ] == m_Generation )
+			continue;
+
+		m_Seen[ Pc ] = m_Generation;
+
+		const Instruction& rInstruction = m_Program[ Pc ];
+
+		switch( rInstruction.Code )
+		{
+			case Op::Bytes:
+				rThreads.push_back( Pc );
+				break;
+
+			case Op::Split:
+				m_Stack.push_back( rInstruction.Out1 );
+				m_Stack.push_back( rInstruction.Out );
+				break;
+
+			case Op::Jump:
+			case Op::Save:
+				m_Stack.push_back( rInstruction.Out );
+				break;
+
+			case Op::Loop:
+				// Which way is taken depends on the thread's slots, which aren't kept here. Either way leads to the same matches.
+				m_Stack.push_back( rInstruction.Out1 );
+				m_Stack.push_back( rInstruction.Out );
+				break;
+
+			case Op::LineStart:
+				if( AtLineStart ) m_Stack.push_back( rInstruction.Out );
+				break;
+
+			case Op::LineEnd:
+				// Left waiting, to be looked at again once the end of the line is reached
+				if( AtLineEnd ) m_Stack.push_back( rInstruction.Out );
+				else            rThreads.push_back( Pc );
+				break;
+
+			case Op::Match:
+				rMatch = true;
+				break;
+		}
+	}
+
+} // Closure
+
+//////////////////////////////////////////////////////////////////////////
+
+int32_t Regex::AddState( std::vector< uint32_t >& rThreads, bool Match )
+{
+	std::sort( rThreads.begin(), rThreads.end() );
+
+	// A state that matches is never stepped from, so all of those can be one and the same
+	if( Match )
+		rThreads.clear();
+
+	rThreads.push_back( Match ? 1 : 0 );
+
+	if( auto It = m_StateIds.find( rThreads ); It != m_StateIds.end() )
+		return It->second;
+
+	// Running out of room costs the states that were built so far, but never more memory
+	if( m_States.size() == MaxDfaStates )
+	{
+		m_States.clear();
+		m_StateIds.clear();
+		m_StartStates = { -1, -1 };
+		++m_Flushes;
+	}
+
+	DfaState& rState = m_States.emplace_back();
+	rState.Threads.assign( rThreads.begin(), rThreads.end() - 1 );
+	rState.Match = Match;
+	rState.Next.fill( -1 );
+
+	const int32_t Id = static_cast< int32_t >( m_States.size() - 1 );
+
+	m_StateIds.emplace( std::move( rThreads ), Id );
+
+	return Id;
+
+} // AddState
+
+//////////////////////////////////////////////////////////////////////////
+
+int32_t Regex::StartState( bool AtLineStart )
+{
+	if( m_StartStates[ AtLineStart ] >= 0 )
+		return m_StartStates[ AtLineStart ];
+
+	std::vector< uint32_t > Threads;
+	bool                    Match = false;
+
+	++m_Generation;
+	Closure( 0, AtLineStart, false, Threads, Match );
+
+	const int32_t State = AddState( Threads, Match );
+
+	m_StartStates[ AtLineStart ] = State;
+
+	return State;
+
+} // StartState
+
+//////////////////////////////////////////////////////////////////////////
+
+int32_t Regex::Step( int32_t State, unsigned char Byte )
+{
+	if( const int32_t Next = m_States[ State ].Next[ Byte ]; Next >= 0 )
+		return Next;
+
+	std::vector< uint32_t > Threads;
+	bool                    Match = false;
+
+	++m_Generation;
+
+	for( uint32_t Pc : m_States[ State ].Threads )
+	{
+		const Instruction& rInstruction = m_Program[ Pc ];
+
+		if( rInstruction.Code == Op::Bytes && m_Sets[ rInstruction.Arg ].test( Byte ) )
+			Closure( rInstruction.Out, false, false, Threads, Match );
+	}
+
+	// A match may also start at the next byte
+	Closure( 0, false, false, Threads, Match );
+
+	const uint32_t Flushes = m_Flushes;
+	const int32_t  Next    = AddState( Threads, Match );
+
+	if( Flushes == m_Flushes )
+		m_States[ State ].Next[ Byte ] = Next;
+
+	return Next;
+
+} // Step
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Regex::MatchesAtEnd( int32_t State, bool AtLineStart )
+{
+	DfaState& rState = m_States[ State ];
+
+	if( rState.MatchAtEnd >= 0 && !AtLineStart )
+		return rState.MatchAtEnd != 0;
+
+	std::vector< uint32_t > Threads;
+	bool                    Match = false;
+
+	++m_Generation;
+
+	for( uint32_t Pc : rState.Threads )
+	{
+		if( m_Program[ Pc ].Code == Op::LineEnd )
+			Closure( m_Program[ Pc ].Out, AtLineStart, true, Threads, Match );
+	}
+
+	if( !AtLineStart )
+		rState.MatchAtEnd = Match ? 1 : 0;
+
+	return Match;
+
+} // MatchesAtEnd
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Regex::IsMatch( std::string_view Line, size_t Offset )
+{
+	int32_t State = StartState( Offset == 0 );
+
+	for( size_t i = Offset;; ++i )
+	{
+		const DfaState& rState = m_States[ State ];
+
+		if( rState.Match )
+			return true;
+
+		// Nothing is left waiting, and no match can start from here on (e.g. after the start of the line with a leading ^)
+		if( rState.Threads.empty() )
+			return false;
+
+		if( i == Line.size() )
+			return MatchesAtEnd( State, Line.empty() );
+
+		State = Step( State, static_cast< unsigned char >( Line[ i ] ) );
+	}
+
+} // IsMatch
+
+//////////////////////////////////////////////////////////////////////////
+
+bool Regex::Simulate( std::string_view Line, size_t Offset, Match& rMatch )
+{
+	const size_t Slots  = m_SlotCount;
+	const size_t Groups = 2 * ( m_GroupCount + 1 );
+
+	// Threads are kept in order of priority, each with its own capture slots
+	struct ThreadList
+	{
+		std::vector< uint32_t > Pcs;
+		std::vector< size_t >   Captures;
+	};
+
+	struct Frame
+	{
+		uint32_t Pc;
+		uint32_t Slot;
+		size_t   Value;
+		bool     Restore;
+	};
+
+	ThreadList              Current;
+	ThreadList              Next;
+	std::vector< size_t >   Captures( Slots, std::string_view::npos );
+	std::vector< uint32_t > Seen( m_Program.size(), 0 );
+	std::vector< Frame >    Stack;
+	uint32_t                Generation = 1;
+	bool                    Found      = false;
+
+	auto Add = [ & ]( ThreadList& rList, uint32_t Pc, size_t Position )
+	{
+		Stack.push_back( Frame{ Pc, 0, 0, false } );
+
+		while( !Stack.empty() )
+		{
+			const Frame Top = Stack.back();
+			Stack.pop_back();
+
+			// Saved slots are put back once everything that follows them has been added, before the lower priority branches are
+			if( Top.Restore )
+			{
+				Captures[ Top.Slot ] = Top.Value;
+				continue;
+			}
+
+			const Instruction& rInstruction = m_Program[ Top.Pc ];
+
+			// A loop can be reached a second time with other slots, and take the other way. It only ever leads to instructions that are
+			// checked here, so it can't go around forever.
+			if( rInstruction.Code != Op::Loop )
+			{
+				if( Seen[ Top.Pc ] == Generation )
+					continue;
+
+				Seen[ Top.Pc ] = Generation;
+			}
+
+			switch( rInstruction.Code )
+			{
+				case Op::Bytes:
+				case Op::Match:
+					rList.Pcs.push_back( Top.Pc );
+					rList.Captures.insert( rList.Captures.end(), Captures.begin(), Captures.end() );
+					break;
+
+				case Op::Split:
+					Stack.push_back( Frame{ rInstruction.Out1, 0, 0, false } );
+					Stack.push_back( Frame{ rInstruction.Out, 0, 0, false } );
+					break;
+
+				case Op::Jump:
+					Stack.push_back( Frame{ rInstruction.Out, 0, 0, false } );
+					break;
+
+				case Op::Save:
+					Stack.push_back( Frame{ 0, rInstruction.Arg, Captures[ rInstruction.Arg ], true } );
+					Stack.push_back( Frame{ rInstruction.Out, 0, 0, false } );
+					Captures[ rInstruction.Arg ] = Position;
+					break;
+
+				case Op::Loop:
+					Stack.push_back( Frame{ Position != Captures[ rInstruction.Arg ] ? rInstruction.Out : rInstruction.Out1, 0, 0, false } );
+					break;
+
+				case Op::LineStart:
+					if( Position == 0 ) Stack.push_back( Frame{ rInstruction.Out, 0, 0, false } );
+					break;
+
+				case Op::LineEnd:
+					if( Position == Line.size() ) Stack.push_back( Frame{ rInstruction.Out, 0, 0, false } );
+					break;
+			}
+		}
+	};
+
+	for( size_t Position = Offset; Position <= Line.size(); ++Position )
+	{
+		// Until something matches, a new attempt starts at every position, behind all the earlier ones
+		if( !Found )
+		{
+			std::fill( Captures.begin(), Captures.end(), std::string_view::npos );
+			Add( Current, 0, Position );
+		}
+
+		if( Current.Pcs.empty() )
+			break;
+
+		++Generation;
+
+		Next.Pcs.clear();
+		Next.Captures.clear();
+
+		for( size_t i = 0; i < Current.Pcs.size(); ++i )
+		{
+			const Instruction& rInstruction = m_Program[ Current.Pcs[ i ] ];
+			const size_t*      pCaptures    = Current.Captures.data() + i * Slots;
+
+			// Anything after a match has a lower priority, so it is dropped
+			if( rInstruction.Code == Op::Match )
+			{
+				rMatch.Start = pCaptures[ 0 ];
+				rMatch.End   = pCaptures[ 1 ];
+				rMatch.Groups.assign( pCaptures + 2, pCaptures + Groups );
+				Found = true;
+
+				break;
+			}
+
+			if( Position < Line.size() && m_Sets[ rInstruction.Arg ].test( static_cast< unsigned char >( Line[ Position ] ) ) )
+			{
+				Captures.assign( pCaptures, pCaptures + Slots );
+				Add( Next, rInstruction.Out, Position + 1 );
+			}
+		}
+
+		std::swap( Current, Next );
+	}
+
+	return Found;
+
+} // Simulate
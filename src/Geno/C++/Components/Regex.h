@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A regular expression that is matched within one line, in time linear in the length of the line whatever the pattern is. The pattern
+// is compiled to a Thompson NFA. Lines are first run through a DFA that is built from the NFA lazily, a state and a transition at a time
+// as the text asks for them, which costs a table lookup per byte and throws out the lines without a match. Only the lines that do match
+// are run through a simulation of the NFA (a Pike VM), which finds the leftmost match with the same preferences as a backtracking engine
+// would, groups included (short of some loops within loops that can match nothing). There are no backreferences or lookarounds, which are
+// what make backtracking engines exponential.
+// '.' and negated classes match whole UTF-8 characters, and without case sensitivity ASCII letters match either case.
+class Regex
+{
+public:
+
+	struct Match
+	{
+		size_t                Start = 0;
+		size_t                End   = 0;
+		std::vector< size_t > Groups; // Start and end of every group, npos for groups that took no part in the match
+
+	}; // Match
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Returns false (with an Error()) if the pattern isn't valid
+	bool Compile( std::string_view Pattern, bool CaseSensitive );
+
+	// Finds the first match that starts at or after Offset. Line is without its line break, so ^ and $ match at its ends only.
+	bool Find( std::string_view Line, size_t Offset, Match& rMatch );
+
+	// $0 (or $&) is replaced by the whole match, $1 to $99 (or ${n}) by a group and $$ by a dollar sign
+	static std::string Expand( std::string_view Replacement, std::string_view Line, const Match& rMatch );
+
+	const std::string& Error     ( void ) const { return m_Error; }
+	size_t             GroupCount( void ) const { return m_GroupCount; }
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	using ByteSet = std::bitset< 256 >;
+
+	enum class Op : uint8_t
+	{
+		Bytes,     // Consumes a byte from the set Arg
+		Split,     // Goes on at Out, and at Out1 with lower priority
+		Jump,
+		Save,      // Writes the position to the capture slot Arg
+		Loop,      // Goes back to Out if the position moved on since slot Arg was saved, else leaves the loop through Out1
+		LineStart,
+		LineEnd,
+		Match,
+
+	}; // Op
+
+	struct Instruction
+	{
+		Op       Code;
+		uint32_t Out  = 0;
+		uint32_t Out1 = 0;
+		uint32_t Arg  = 0;
+
+	}; // Instruction
+
+	struct Node;
+
+	struct DfaState
+	{
+		std::vector< uint32_t >    Threads;          // The Bytes (and LineEnd) instructions that are waiting, sorted
+		std::array< int32_t, 256 > Next;             // -1 until the transition is first taken
+		bool                       Match      = false;
+		int8_t                     MatchAtEnd = -1;
+
+	}; // DfaState
+
+//////////////////////////////////////////////////////////////////////////
+
+	bool     ParseAlternation( Node& rNode );
+	bool     ParseConcat     ( Node& rNode );
+	bool     ParseRepeat     ( Node& rNode );
+	bool     ParseAtom       ( Node& rNode );
+	bool     ParseClass      ( Node& rNode );
+	bool     ParseCharacter  ( std::string& rCharacter );
+	bool     Fail            ( std::string Error );
+	uint32_t AddSet          ( ByteSet Set );
+	void     AnyCharacter    ( const ByteSet& rExcluded, Node& rNode );
+	bool     Emit            ( const Node& rNode );
+
+	void    Closure     ( uint32_t Pc, bool AtLineStart, bool AtLineEnd, std::vector< uint32_t >& rThreads, bool& rMatch );
+	int32_t AddState    ( std::vector< uint32_t >& rThreads, bool Match );
+	int32_t StartState  ( bool AtLineStart );
+	int32_t Step        ( int32_t State, unsigned char Byte );
+	bool    MatchesAtEnd( int32_t State, bool AtLineStart );
+	bool    IsMatch     ( std::string_view Line, size_t Offset );
+	bool    Simulate    ( std::string_view Line, size_t Offset, Match& rMatch );
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::vector< Instruction >                   m_Program;
+	std::vector< ByteSet >                       m_Sets;
+	size_t                                       m_GroupCount    = 0;
+	size_t                                       m_SlotCount     = 0;
+	std::string                                  m_Error;
+
+	// Only used while compiling
+	std::string_view                             m_Pattern;
+	size_t                                       m_Position      = 0;
+	bool                                         m_CaseSensitive = true;
+
+	// The lazily built DFA, which is thrown away and started over if it grows too big
+	std::vector< DfaState >                      m_States;
+	std::map< std::vector< uint32_t >, int32_t > m_StateIds;
+	std::array< int32_t, 2 >                     m_StartStates   = { -1, -1 };
+	std::vector< uint32_t >                      m_Seen;
+	std::vector< uint32_t >                      m_Stack;
+	uint32_t                                     m_Generation    = 0;
+	uint32_t                                     m_Flushes       = 0;
+
+}; // Regex
@@ -0,0 +1,541 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "SyntaxHighlighter.h"
+
+#include <Common/Async/JobSystem.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+//////////////////////////////////////////////////////////////////////////
+
+// How many lines a background pass lexes at most, and how far above the visible lines the lexer may start on the UI thread
+static constexpr int BatchLines = 4096;
+static constexpr int SyncLines  = 1024;
+
+// Sorted, so that they can be binary searched
+static constexpr std::string_view Keywords[] =
+{
+	"_Bool",            "_Static_assert",   "__declspec",       "__forceinline",    "alignas",          "alignof",
+	"asm",              "auto",             "bool",             "break",            "case",             "catch",
+	"char",             "char16_t",         "char32_t",         "char8_t",          "class",            "co_await",
+	"co_return",        "co_yield",         "concept",          "const",            "const_cast",       "consteval",
+	"constexpr",        "constinit",        "continue",         "decltype",         "default",          "delete",
+	"do",               "double",           "dynamic_cast",     "else",             "enum",             "explicit",
+	"export",           "extern",           "false",            "final",            "float",            "for",
+	"friend",           "goto",             "if",               "import",           "inline",           "int",
+	"long",             "module",           "mutable",          "namespace",        "new",              "noexcept",
+	"nullptr",          "operator",         "override",         "private",          "protected",        "public",
+	"register",         "reinterpret_cast", "requires",         "restrict",         "return",           "short",
+	"signed",           "sizeof",           "static",           "static_assert",    "static_cast",      "struct",
+	"switch",           "template",         "this",             "thread_local",     "throw",            "true",
+	"try",              "typedef",          "typeid",           "typename",         "union",            "unsigned",
+	"using",            "virtual",          "void",             "volatile",         "wchar_t",          "while",
+};
+
+static_assert( std::is_sorted( std::begin( Keywords ), std::end( Keywords ) ) );
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool IsIdentifierStart( char C )
+{
+	return ( C >= 'a' && C <= 'z' ) || ( C >= 'A' && C <= 'Z' ) || C == '_' || static_cast< unsigned char >( C ) >= 0x80;
+
+} // IsIdentifierStart
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool IsIdentifier( char C )
+{
+	return IsIdentifierStart( C ) || ( C >= '0' && C <= '9' );
+
+} // IsIdentifier
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool IsKeyword( std::string_view Word )
+{
+	return std::binary_search( std::begin( Keywords ), std::end( Keywords ), Word );
+
+} // IsKeyword
+
+//////////////////////////////////////////////////////////////////////////
+
+// Returns the offset just past the closing quote, or npos if the literal does not end on this line
+static size_t SkipQuoted( std::string_view Text, size_t Offset, char Quote )
+{
+	for( size_t i = Offset; i < Text.size(); ++i )
+	{
+		if( Text[ i ] == '\\' ) ++i;
+		else if( Text[ i ] == Quote ) return i + 1;
+	}
+
+	return std::string_view::npos;
+
+} // SkipQuoted
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool EndsWithBackslash( std::string_view Text )
+{
+	return !Text.empty() && Text.back() == '\\';
+
+} // EndsWithBackslash
+
+//////////////////////////////////////////////////////////////////////////
+
+void SyntaxHighlighter::Reset( size_t LineCount )
+{
+	m_Lines.assign( LineCount, LineState{ .End = State{ .Inside = State::Unknown } } );
+	m_pPass.reset();
+
+	m_FirstDirty = 0;
+	m_Enabled    = true;
+
+} // Reset
+
+//////////////////////////////////////////////////////////////////////////
+
+void SyntaxHighlighter::LinesChanged( int FirstLine, int OldLastLine, int NewLastLine )
+{
+	if( !m_Enabled )
+		return;
+
+	if( NewLastLine != OldLastLine )
+	{
+		// The line after the edit was lexed in the state that the old last line ended in, which is then the best guess for the new one
+		const State OldEnd = m_Lines[ OldLastLine ].End;
+
+		m_Lines.erase ( m_Lines.begin() + FirstLine, m_Lines.begin() + OldLastLine + 1 );
+		m_Lines.insert( m_Lines.begin() + FirstLine, NewLastLine - FirstLine + 1, LineState{ .End = State{ .Inside = State::Unknown } } );
+
+		m_Lines[ NewLastLine ].End = OldEnd;
+	}
+	else
+	{
+		for( int i = FirstLine; i <= NewLastLine; ++i )
+			m_Lines[ i ].Valid = false;
+	}
+
+	m_FirstDirty = std::min( m_FirstDirty, FirstLine );
+
+	// A pass over lines below the edit only has to follow them, but one that has been edited into is of no use anymore
+	if( m_pPass && !m_PassStale && FirstLine < m_PassLine + static_cast< int >( m_pPass->Lines.size() ) )
+	{
+		if( OldLastLine < m_PassLine ) m_PassLine += NewLastLine - OldLastLine;
+		else                           m_PassStale = true;
+	}
+
+} // LinesChanged
+
+//////////////////////////////////////////////////////////////////////////
+
+void SyntaxHighlighter::Update( const TextBuffer& rBuffer, int FirstVisible, int LastVisible, const std::function< void( int FirstLine, int LastLine ) >& rRecolor )
+{
+	if( !m_Enabled )
+		return;
+
+	if( m_Lines.size() != rBuffer.LineCount() )
+		Reset( rBuffer.LineCount() );
+
+	Range Recolor;
+
+	Collect( Recolor );
+
+	int Line = FirstDirtyLine();
+
+	// Lines on screen are lexed right away, unless that means lexing a lot of lines above them first
+	while( Line <= LastVisible && Line >= FirstVisible - SyncLines )
+	{
+		Relex( rBuffer, Line, LastVisible, Recolor );
+
+		Line = FirstDirtyLine();
+	}
+
+	if( !m_pPass && Line < static_cast< int >( m_Lines.size() ) )
+		StartPass( rBuffer, Line );
+
+	if( Recolor.First <= Recolor.Last )
+		rRecolor( Recolor.First, Recolor.Last );
+
+} // Update
+
+//////////////////////////////////////////////////////////////////////////
+
+std::vector< SyntaxHighlighter::Span > SyntaxHighlighter::Lex( int Line, std::string_view Text ) const
+{
+	std::vector< Span > Spans;
+
+	if( !m_Enabled )
+	{
+		Spans.push_back( Span{ 0, Token::Default } );
+		return Spans;
+	}
+
+	LexLine( Text, ( Line > 0 && Line <= static_cast< int >( m_Lines.size() ) ) ? m_Lines[ Line - 1 ].End : State{ }, &Spans );
+
+	return Spans;
+
+} // Lex
+
+//////////////////////////////////////////////////////////////////////////
+
+bool SyntaxHighlighter::Supports( const std::filesystem::path& rPath )
+{
+	static constexpr std::array< std::string_view, 14 > Extensions = { ".c", ".cc", ".cpp", ".cxx", ".c++", ".h", ".hh", ".hpp", ".hxx", ".h++", ".inl", ".ipp", ".ixx", ".cppm" };
+
+	std::string Extension = rPath.extension().string();
+	std::transform( Extension.begin(), Extension.end(), Extension.begin(), []( char C ) { return static_cast< char >( ( C >= 'A' && C <= 'Z' ) ? C - 'A' + 'a' : C ); } );
+
+	return std::find( Extensions.begin(), Extensions.end(), Extension ) != Extensions.end();
+
+} // Supports
+
+//////////////////////////////////////////////////////////////////////////
+
+int SyntaxHighlighter::FirstDirtyLine( void )
+{
+	while( m_FirstDirty < static_cast< int >( m_Lines.size() ) && m_Lines[ m_FirstDirty ].Valid )
+		++m_FirstDirty;
+
+	return m_FirstDirty;
+
+} // FirstDirtyLine
+
+//////////////////////////////////////////////////////////////////////////
+
+void SyntaxHighlighter::Relex( const TextBuffer& rBuffer, int Line, int LastLine, Range& rRecolor )
+{
+	for( int i = Line; ; ++i )
+	{
+		Store( i, LexLine( rBuffer.GetLine( i ), ( i > 0 ) ? m_Lines[ i - 1 ].End : State{ }, nullptr ), rRecolor );
+
+		// Keep going for as long as the next line starts in a different state than it was lexed in
+		if( i >= LastLine || i + 1 >= static_cast< int >( m_Lines.size() ) || m_Lines[ i + 1 ].Valid )
+			break;
+	}
+
+} // Relex
+
+//////////////////////////////////////////////////////////////////////////
+
+void SyntaxHighlighter::Store( int Line, const State& rEnd, Range& rRecolor )
+{
+	LineState& rLine = m_Lines[ Line ];
+
+	if( m_pPass && Line >= m_PassLine && Line < m_PassLine + static_cast< int >( m_pPass->Lines.size() ) )
+		m_PassStale = true;
+
+	rLine.Valid = true;
+
+	if( rLine.End == rEnd )
+		return;
+
+	rLine.End = rEnd;
+
+	if( Line + 1 < static_cast< int >( m_Lines.size() ) )
+	{
+		m_Lines[ Line + 1 ].Valid = false;
+
+		rRecolor.First = ( rRecolor.First <= rRecolor.Last ) ? std::min( rRecolor.First, Line + 1 ) : Line + 1;
+		rRecolor.Last  = std::max( rRecolor.Last, Line + 1 );
+	}
+
+} // Store
+
+//////////////////////////////////////////////////////////////////////////
+
+void SyntaxHighlighter::Collect( Range& rRecolor )
+{
+	if( !m_pPass || !m_pPass->Done.load( std::memory_order_acquire ) )
+		return;
+
+	std::shared_ptr< Pass > pPass = std::move( m_pPass );
+	const int               First = m_PassLine;
+
+	// The results only hold if the line before the pass still ends in the state that the pass started in
+	if( m_PassStale || ( First > 0 && ( !m_Lines[ First - 1 ].Valid || !( m_Lines[ First - 1 ].End == pPass->Start ) ) ) )
+		return;
+
+	for( size_t i = 0; i < pPass->Lexed; ++i )
+		Store( First + static_cast< int >( i ), pPass->Lines[ i ].End, rRecolor );
+
+} // Collect
+
+//////////////////////////////////////////////////////////////////////////
+
+void SyntaxHighlighter::StartPass( const TextBuffer& rBuffer, int Line )
+{
+	const size_t Count = std::min( static_cast< size_t >( BatchLines ), m_Lines.size() - Line );
+	const size_t Begin = rBuffer.LineStart( Line );
+	const size_t End   = ( Line + Count < m_Lines.size() ) ? rBuffer.LineStart( Line + Count ) : rBuffer.Size();
+
+	std::shared_ptr< Pass > pPass = std::make_shared< Pass >();
+	pPass->Text                   = rBuffer.GetText( Begin, End - Begin );
+	pPass->Start                  = ( Line > 0 ) ? m_Lines[ Line - 1 ].End : State{ };
+	pPass->Lines.assign( m_Lines.begin() + Line, m_Lines.begin() + Line + Count );
+
+	// The job keeps its own reference, so a pass that is no longer wanted just goes to waste
+	JobSystem::Instance().NewJob( [ pPass ]( void )
+		{
+			Scan( *pPass );
+			pPass->Done.store( true, std::memory_order_release );
+		} );
+
+	m_pPass     = std::move( pPass );
+	m_PassLine  = Line;
+	m_PassStale = false;
+
+} // StartPass
+
+//////////////////////////////////////////////////////////////////////////
+
+void SyntaxHighlighter::Scan( Pass& rPass )
+{
+	std::string_view Text  = rPass.Text;
+	State            Start = rPass.Start;
+
+	// Same as Relex(), but on the copy
+	for( size_t i = 0; i < rPass.Lines.size(); ++i )
+	{
+		const size_t     Break = Text.find( '\n' );
+		std::string_view Line  = Text.substr( 0, Break );
+		LineState&       rLine = rPass.Lines[ i ];
+		const State      End   = LexLine( Line, Start, nullptr );
+
+		Text.remove_prefix( ( Break == std::string_view::npos ) ? Text.size() : Break + 1 );
+
+		rPass.Lexed = i + 1;
+		rLine.Valid = true;
+
+		if( !( rLine.End == End ) )
+		{
+			rLine.End = End;
+
+			if( i + 1 < rPass.Lines.size() )
+				rPass.Lines[ i + 1 ].Valid = false;
+		}
+
+		if( i + 1 < rPass.Lines.size() && rPass.Lines[ i + 1 ].Valid )
+			break;
+
+		Start = End;
+	}
+
+} // Scan
+
+//////////////////////////////////////////////////////////////////////////
+
+SyntaxHighlighter::State SyntaxHighlighter::LexLine( std::string_view Text, State Start, std::vector< Span >* pSpans )
+{
+	auto Emit = [ pSpans ]( size_t Offset, Token Kind )
+	{
+		if( pSpans && ( pSpans->empty() || pSpans->back().Kind != Kind ) )
+			pSpans->push_back( Span{ static_cast< uint32_t >( Offset ), Kind } );
+	};
+
+	size_t i = 0;
+
+	// Finish whatever was left open on the line before
+	switch( Start.Inside )
+	{
+		case State::BlockComment:
+		{
+			Emit( 0, Token::Comment );
+
+			if( ( i = Text.find( "*/" ) ) == std::string_view::npos )
+				return State{ .Inside = State::BlockComment };
+
+			i += 2;
+		}
+		break;
+
+		case State::LineComment:
+		{
+			Emit( 0, Token::Comment );
+
+			return State{ .Inside = EndsWithBackslash( Text ) ? State::LineComment : State::Code };
+		}
+
+		case State::String:
+		case State::Character:
+		{
+			Emit( 0, Token::String );
+
+			if( ( i = SkipQuoted( Text, 0, ( Start.Inside == State::String ) ? '"' : '\'' ) ) == std::string_view::npos )
+				return State{ .Inside = EndsWithBackslash( Text ) ? Start.Inside : State::Code };
+		}
+		break;
+
+		case State::RawString:
+		{
+			Emit( 0, Token::String );
+
+			const std::string Terminator = ")" + std::string( Start.Delimiter, Start.DelimiterLength ) + "\"";
+
+			if( ( i = Text.find( Terminator ) ) == std::string_view::npos )
+				return Start;
+
+			i += Terminator.size();
+		}
+		break;
+
+		default:
+		{
+		}
+		break;
+	}
+
+	const size_t FirstNonBlank = Text.find_first_not_of( " \t" );
+
+	while( i < Text.size() )
+	{
+		const char C    = Text[ i ];
+		const char Next = ( i + 1 < Text.size() ) ? Text[ i + 1 ] : '\0';
+
+		if( C == ' ' || C == '\t' )
+		{
+			++i;
+		}
+		else if( C == '/' && Next == '/' )
+		{
+			Emit( i, Token::Comment );
+
+			return State{ .Inside = EndsWithBackslash( Text ) ? State::LineComment : State::Code };
+		}
+		else if( C == '/' && Next == '*' )
+		{
+			Emit( i, Token::Comment );
+
+			const size_t End = Text.find( "*/", i + 2 );
+			if( End == std::string_view::npos )
+				return State{ .Inside = State::BlockComment };
+
+			i = End + 2;
+		}
+		else if( C == '"' || C == '\'' )
+		{
+			Emit( i, Token::String );
+
+			const size_t End = SkipQuoted( Text, i + 1, C );
+			if( End == std::string_view::npos )
+				return State{ .Inside = !EndsWithBackslash( Text ) ? State::Code : ( C == '"' ) ? State::String : State::Character };
+
+			i = End;
+		}
+		else if( ( C >= '0' && C <= '9' ) || ( C == '.' && Next >= '0' && Next <= '9' ) )
+		{
+			Emit( i, Token::Number );
+
+			// Covers hex, binary, floats with exponents, digit separators and suffixes
+			for( ++i; i < Text.size(); ++i )
+			{
+				const char Digit = Text[ i ];
+				const char Last  = Text[ i - 1 ];
+
+				if( IsIdentifier( Digit ) || Digit == '.' || Digit == '\'' ) continue;
+				if( ( Digit == '+' || Digit == '-' ) && ( Last == 'e' || Last == 'E' || Last == 'p' || Last == 'P' ) ) continue;
+
+				break;
+			}
+		}
+		else if( IsIdentifierStart( C ) )
+		{
+			size_t End = i + 1;
+			while( End < Text.size() && IsIdentifier( Text[ End ] ) )
+				++End;
+
+			const std::string_view Word  = Text.substr( i, End - i );
+			const char             Quote = ( End < Text.size() ) ? Text[ End ] : '\0';
+
+			if( Quote == '"' && ( Word == "R" || Word == "u8R" || Word == "uR" || Word == "UR" || Word == "LR" ) )
+			{
+				const size_t Open = Text.find( '(', End + 1 );
+
+				if( Open != std::string_view::npos && Open - End - 1 <= sizeof( State::Delimiter ) )
+				{
+					Emit( i, Token::String );
+
+					State Raw = { .Inside = State::RawString, .DelimiterLength = static_cast< uint8_t >( Open - End - 1 ) };
+					std::memcpy( Raw.Delimiter, Text.data() + End + 1, Raw.DelimiterLength );
+
+					const std::string Terminator = ")" + std::string( Raw.Delimiter, Raw.DelimiterLength ) + "\"";
+					const size_t      Close      = Text.find( Terminator, Open + 1 );
+
+					if( Close == std::string_view::npos )
+						return Raw;
+
+					i = Close + Terminator.size();
+					continue;
+				}
+			}
+
+			// Encoding prefixes are part of the literal that follows
+			if( ( Quote == '"' || Quote == '\'' ) && ( Word == "u8" || Word == "u" || Word == "U" || Word == "L" ) )
+			{
+				Emit( i, Token::String );
+
+				i = End;
+				continue;
+			}
+
+			Emit( i, IsKeyword( Word ) ? Token::Keyword : Token::Default );
+
+			i = End;
+		}
+		else if( C == '#' && i == FirstNonBlank )
+		{
+			Emit( i, Token::Keyword );
+
+			size_t End = Text.find_first_not_of( " \t", i + 1 );
+			if( End == std::string_view::npos )
+				break;
+
+			const size_t Directive = End;
+			while( End < Text.size() && IsIdentifier( Text[ End ] ) )
+				++End;
+
+			i = End;
+
+			// The header name of an include is a string, whether it's in quotes or angle brackets
+			if( Text.substr( Directive, End - Directive ) == "include" )
+			{
+				const size_t Header = Text.find_first_not_of( " \t", End );
+
+				if( Header != std::string_view::npos && Text[ Header ] == '<' )
+				{
+					const size_t Close = Text.find( '>', Header );
+
+					Emit( Header, Token::String );
+
+					i = ( Close == std::string_view::npos ) ? Text.size() : Close + 1;
+				}
+			}
+		}
+		else
+		{
+			Emit( i, Token::Default );
+
+			++i;
+		}
+	}
+
+	return State{ };
+
+} // LexLine
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include "Components/TextBuffer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Colors C and C++ source. The lexer carries a small state from one line to the next (e.g. inside a block comment or a raw string),
+// and the state at the end of every line is remembered. An edit only invalidates the lines it touched, and relexing starts there and
+// stops at the first line that ends in the same state as before, which usually is the edited line itself. Lines on screen are brought
+// up to date right away, and whatever is left (e.g. the rest of the file after opening a block comment) is lexed by jobs that work
+// through a copy of the lines one batch at a time.
+class SyntaxHighlighter
+{
+public:
+
+	enum class Token : uint8_t
+	{
+		Default,
+		Keyword,
+		Number,
+		String,
+		Comment,
+	};
+
+	// A run of tokens of the same kind, from Start up to the start of the next span on the same line
+	struct Span
+	{
+		uint32_t Start;
+		Token    Kind;
+
+	}; // Span
+
+	struct State
+	{
+		enum Context : uint8_t
+		{
+			Code,
+			BlockComment,
+			LineComment, // Continued with a backslash
+			String,      // Continued with a backslash
+			Character,   // Continued with a backslash
+			RawString,
+			Unknown,
+		};
+
+		Context Inside          = Code;
+		uint8_t DelimiterLength = 0;
+		char    Delimiter[ 16 ] = { }; // Of the raw string
+
+		bool operator==( const State& ) const = default;
+
+	}; // State
+
+//////////////////////////////////////////////////////////////////////////
+
+	void Reset       ( size_t LineCount );
+	void LinesChanged( int FirstLine, int OldLastLine, int NewLastLine );
+
+	// Lexes the visible lines that are out of date, and collects and starts background passes for the rest. rRecolor is called with the
+	// range of lines that have to be colored anew because the state they start in has changed.
+	void Update( const TextBuffer& rBuffer, int FirstVisible, int LastVisible, const std::function< void( int FirstLine, int LastLine ) >& rRecolor );
+
+	std::vector< Span > Lex      ( int Line, std::string_view Text ) const;
+	bool                IsEnabled( void )                            const { return m_Enabled; }
+
+//////////////////////////////////////////////////////////////////////////
+
+	static bool Supports( const std::filesystem::path& rPath );
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	struct LineState
+	{
+		State End;
+		bool  Valid = false; // End is right, given that the line before is
+
+	}; // LineState
+
+	struct Pass
+	{
+		std::string              Text;  // Every line of the batch, separated by '\n'
+		State                    Start;
+		std::vector< LineState > Lines; // The lines as they were, and as they are after lexing
+		size_t                   Lexed = 0;
+		std::atomic< bool >      Done  = false;
+
+	}; // Pass
+
+	struct Range
+	{
+		int First = 0;
+		int Last  = -1;
+
+	}; // Range
+
+//////////////////////////////////////////////////////////////////////////
+
+	int  FirstDirtyLine( void );
+	void Relex         ( const TextBuffer& rBuffer, int Line, int LastLine, Range& rRecolor );
+	void Store         ( int Line, const State& rEnd, Range& rRecolor );
+	void Collect       ( Range& rRecolor );
+	void StartPass     ( const TextBuffer& rBuffer, int Line );
+
+	static State LexLine( std::string_view Text, State Start, std::vector< Span >* pSpans );
+	static void  Scan   ( Pass& rPass );
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::vector< LineState > m_Lines;
+	std::shared_ptr< Pass >  m_pPass;
+	int                      m_PassLine   = 0;     // Where the lines of the pass are now, which moves along with edits above them
+	int                      m_FirstDirty = 0;     // No line above this is invalid
+	bool                     m_PassStale  = false;
+	bool                     m_Enabled    = false;
+
+}; // SyntaxHighlighter
@@ -0,0 +1,366 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "TerminalBuffer.h"
+
+#include <algorithm>
+#include <charconv>
+
+//////////////////////////////////////////////////////////////////////////
+
+// Lines longer than this are wrapped, so that output without any newlines doesn't end up in one huge line
+static constexpr size_t MaxLineLength = 4096;
+
+// Longer parameter lists than this are garbage
+static constexpr size_t MaxParameters = 64;
+
+//////////////////////////////////////////////////////////////////////////
+
+static constexpr uint32_t PackColor( uint32_t Red, uint32_t Green, uint32_t Blue )
+{
+	return 0xFF000000u | ( Blue << 16 ) | ( Green << 8 ) | Red;
+
+} // PackColor
+
+//////////////////////////////////////////////////////////////////////////
+
+static uint32_t PaletteColor( int Index )
+{
+	// The 16 basic colors, tuned to be readable on a dark background
+	static constexpr uint32_t BasicColors[ 16 ] =
+	{
+		PackColor(  70,  70,  70 ), PackColor( 205,  49,  49 ), PackColor(  13, 188, 121 ), PackColor( 229, 229,  16 ),
+		PackColor(  36, 114, 200 ), PackColor( 188,  63, 188 ), PackColor(  17, 168, 205 ), PackColor( 229, 229, 229 ),
+		PackColor( 102, 102, 102 ), PackColor( 241,  76,  76 ), PackColor(  35, 209, 139 ), PackColor( 245, 245,  67 ),
+		PackColor(  59, 142, 234 ), PackColor( 214, 112, 214 ), PackColor(  41, 184, 219 ), PackColor( 255, 255, 255 ),
+	};
+
+	if( Index < 16 )
+		return BasicColors[ Index ];
+
+	// 6x6x6 color cube
+	if( Index < 232 )
+	{
+		constexpr uint32_t Levels[ 6 ] = { 0, 95, 135, 175, 215, 255 };
+		const int          Cube        = Index - 16;
+
+		return PackColor( Levels[ Cube / 36 ], Levels[ ( Cube / 6 ) % 6 ], Levels[ Cube % 6 ] );
+	}
+
+	// Grayscale ramp
+	const uint32_t Gray = 8 + 10 * static_cast< uint32_t >( Index - 232 );
+
+	return PackColor( Gray, Gray, Gray );
+
+} // PaletteColor
+
+//////////////////////////////////////////////////////////////////////////
+
+TerminalBuffer::TerminalBuffer( size_t MaxLines )
+	: m_MaxLines( std::max< size_t >( MaxLines, 1 ) )
+{
+	m_Lines.emplace_back();
+
+} // TerminalBuffer
+
+//////////////////////////////////////////////////////////////////////////
+
+void TerminalBuffer::Write( std::string_view Bytes )
+{
+	for( const char Character : Bytes )
+	{
+		switch( m_State )
+		{
+			case State::Text:
+			{
+				switch( Character )
+				{
+					case '\x1B': { m_State = State::Escape; } break;
+					case '\n':   { NewLine();               } break;
+					case '\r':   { m_CarriageReturn = true; } break;
+					case '\b':   { Backspace();             } break;
+					case '\t':   { Put( Character );        } break;
+
+					default:
+					{
+						// Bells and other control characters have nothing to show
+						if( static_cast< unsigned char >( Character ) >= 0x20 && Character != '\x7F' )
+							Put( Character );
+
+					} break;
+				}
+
+			} break;
+
+			case State::Escape:
+			{
+				if( Character == '[' )
+				{
+					m_State = State::ControlSequence;
+					m_Parameters.clear();
+				}
+				else if( Character == ']' )
+				{
+					m_State = State::OperatingSystemCommand;
+				}
+				else if( Character == '(' || Character == ')' || Character == '*' || Character == '+' )
+				{
+					m_State = State::CharacterSet;
+				}
+				else
+				{
+					m_State = State::Text;
+				}
+
+			} break;
+
+			case State::CharacterSet:
+			{
+				m_State = State::Text;
+
+			} break;
+
+			case State::ControlSequence:
+			{
+				// Everything up to the final byte are parameters and intermediates
+				if( Character >= 0x40 && Character <= 0x7E )
+				{
+					if( Character == 'm' )
+						SelectGraphics( m_Parameters );
+
+					m_State = State::Text;
+				}
+				else if( m_Parameters.size() < MaxParameters )
+				{
+					m_Parameters += Character;
+				}
+
+			} break;
+
+			case State::OperatingSystemCommand:
+			{
+				// Window titles, hyperlinks and such. Terminated by BEL or ST (ESC \).
+				if( Character == '\a' )
+					m_State = State::Text;
+				else if( Character == '\x1B' )
+					m_State = State::OperatingSystemCommandEscape;
+
+			} break;
+
+			case State::OperatingSystemCommandEscape:
+			{
+				m_State = State::Text;
+
+			} break;
+		}
+	}
+
+} // Write
+
+//////////////////////////////////////////////////////////////////////////
+
+void TerminalBuffer::Clear( void )
+{
+	m_Lines.clear();
+	m_Lines.emplace_back();
+
+	m_First          = 0;
+	m_CarriageReturn = false;
+
+	if( m_Color )
+		m_Lines.back().Spans.push_back( { 0, m_Color } );
+
+} // Clear
+
+//////////////////////////////////////////////////////////////////////////
+
+void TerminalBuffer::NewLine( void )
+{
+	m_CarriageReturn = false;
+	++m_LinesWritten;
+
+	if( m_Lines.size() < m_MaxLines )
+	{
+		m_Lines.emplace_back();
+	}
+	else
+	{
+		// Recycle the oldest line, keeping its memory
+		m_First = ( m_First + 1 ) % m_Lines.size();
+
+		Line& rLine = CurrentLine();
+		rLine.Text.clear();
+		rLine.Spans.clear();
+	}
+
+	if( m_Color )
+		CurrentLine().Spans.push_back( { 0, m_Color } );
+
+} // NewLine
+
+//////////////////////////////////////////////////////////////////////////
+
+void TerminalBuffer::Put( char Character )
+{
+	// A carriage return that isn't part of a line break means that the program is redrawing the line (e.g. a progress bar)
+	if( m_CarriageReturn )
+	{
+		Line& rLine = CurrentLine();
+		rLine.Text.clear();
+		rLine.Spans.clear();
+
+		if( m_Color )
+			rLine.Spans.push_back( { 0, m_Color } );
+
+		m_CarriageReturn = false;
+	}
+	else if( CurrentLine().Text.size() >= MaxLineLength )
+	{
+		NewLine();
+	}
+
+	CurrentLine().Text += Character;
+
+} // Put
+
+//////////////////////////////////////////////////////////////////////////
+
+void TerminalBuffer::Backspace( void )
+{
+	Line& rLine = CurrentLine();
+
+	if( rLine.Text.empty() )
+		return;
+
+	rLine.Text.pop_back();
+
+	while( !rLine.Spans.empty() && rLine.Spans.back().Offset > rLine.Text.size() )
+		rLine.Spans.pop_back();
+
+} // Backspace
+
+//////////////////////////////////////////////////////////////////////////
+
+void TerminalBuffer::SelectGraphics( std::string_view Parameters )
+{
+	std::vector< int > Codes;
+
+	// Sub-parameters (38:2:R:G:B) are treated like regular ones. An empty parameter means 0.
+	while( true )
+	{
+		const size_t Separator = Parameters.find_first_of( ";:" );
+		const auto   Parameter = Parameters.substr( 0, Separator );
+		int          Code      = 0;
+
+		std::from_chars( Parameter.data(), Parameter.data() + Parameter.size(), Code );
+		Codes.push_back( Code );
+
+		if( Separator == std::string_view::npos )
+			break;
+
+		Parameters.remove_prefix( Separator + 1 );
+	}
+
+	for( size_t i = 0; i < Codes.size(); ++i )
+	{
+		const int Code = Codes[ i ];
+
+		if( Code == 0 )
+		{
+			m_Foreground = -1;
+			m_Bold       = false;
+		}
+		else if( Code == 1 )
+		{
+			m_Bold = true;
+		}
+		else if( Code == 22 )
+		{
+			m_Bold = false;
+		}
+		else if( Code >= 30 && Code <= 37 )
+		{
+			m_Foreground = Code - 30;
+		}
+		else if( Code >= 90 && Code <= 97 )
+		{
+			m_Foreground = Code - 90 + 8;
+		}
+		else if( Code == 39 )
+		{
+			m_Foreground = -1;
+		}
+		else if( Code == 38 || Code == 48 )
+		{
+			// Extended colors. Backgrounds aren't drawn, but their arguments still have to be skipped.
+			if( i + 2 < Codes.size() && Codes[ i + 1 ] == 5 )
+			{
+				if( Code == 38 )
+					m_Foreground = std::clamp( Codes[ i + 2 ], 0, 255 );
+
+				i += 2;
+			}
+			else if( i + 4 < Codes.size() && Codes[ i + 1 ] == 2 )
+			{
+				if( Code == 38 )
+				{
+					m_TrueColor  = PackColor( std::clamp( Codes[ i + 2 ], 0, 255 ), std::clamp( Codes[ i + 3 ], 0, 255 ), std::clamp( Codes[ i + 4 ], 0, 255 ) );
+					m_Foreground = -2;
+				}
+
+				i += 4;
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+
+	UpdateColor();
+
+} // SelectGraphics
+
+//////////////////////////////////////////////////////////////////////////
+
+void TerminalBuffer::UpdateColor( void )
+{
+	uint32_t Color = 0;
+
+	if( m_Foreground == -2 )
+		Color = m_TrueColor;
+	else if( m_Foreground >= 0 )
+		Color = PaletteColor( ( m_Bold && m_Foreground < 8 ) ? m_Foreground + 8 : m_Foreground );
+
+	if( Color == m_Color )
+		return;
+
+	m_Color = Color;
+
+	// A pending redraw is going to start over with the new color anyway
+	if( m_CarriageReturn )
+		return;
+
+	Line&          rLine  = CurrentLine();
+	const uint32_t Offset = static_cast< uint32_t >( rLine.Text.size() );
+
+	if( !rLine.Spans.empty() && rLine.Spans.back().Offset == Offset )
+		rLine.Spans.back().Color = Color;
+	else
+		rLine.Spans.push_back( { Offset, Color } );
+
+} // UpdateColor
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Scrollback for the output of a program on a pseudo terminal. Understands the parts of the ANSI escape codes that matter for a log:
+// SGR colors (16, 256 and 24-bit), carriage returns that redraw a progress line, and backspace. Other sequences are dropped.
+// The oldest lines are recycled once the buffer is full, so a chatty program can run forever without growing it.
+class TerminalBuffer
+{
+public:
+
+	// Colors are packed like an ImU32 (0xAABBGGRR). Zero means the default text color.
+	struct Span
+	{
+		uint32_t Offset = 0;
+		uint32_t Color  = 0;
+
+	}; // Span
+
+	struct Line
+	{
+		std::string         Text;
+		std::vector< Span > Spans;
+
+	}; // Line
+
+//////////////////////////////////////////////////////////////////////////
+
+	explicit TerminalBuffer( size_t MaxLines );
+
+//////////////////////////////////////////////////////////////////////////
+
+	void Write( std::string_view Bytes );
+	void Clear( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Line 0 is the oldest one that is still kept. The last line is the one being written to.
+	size_t      LineCount   ( void )         const { return m_Lines.size(); }
+	const Line& GetLine     ( size_t Index ) const { return m_Lines[ ( m_First + Index ) % m_Lines.size() ]; }
+	uint64_t    LinesWritten( void )         const { return m_LinesWritten; }
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	enum class State
+	{
+		Text,
+		Escape,
+		CharacterSet,
+		ControlSequence,
+		OperatingSystemCommand,
+		OperatingSystemCommandEscape,
+
+	}; // State
+
+//////////////////////////////////////////////////////////////////////////
+
+	Line& CurrentLine   ( void ) { return m_Lines[ ( m_First + m_Lines.size() - 1 ) % m_Lines.size() ]; }
+	void  NewLine       ( void );
+	void  Put           ( char Character );
+	void  Backspace     ( void );
+	void  SelectGraphics( std::string_view Parameters );
+	void  UpdateColor   ( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::vector< Line > m_Lines;
+	size_t              m_MaxLines;
+	size_t              m_First          = 0;
+	uint64_t            m_LinesWritten   = 0;
+
+	State               m_State          = State::Text;
+	std::string         m_Parameters;
+
+	uint32_t            m_Color          = 0;
+	uint32_t            m_TrueColor      = 0;
+	int                 m_Foreground     = -1; // Palette index, -1 for the default color or -2 for m_TrueColor
+	bool                m_Bold           = false;
+	bool                m_CarriageReturn = false;
+
+}; // TerminalBuffer
@@ -0,0 +1,576 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "TestRunner.h"
+
+#include "Compilers/WorkerPool.h"
+
+#include <Common/Aliases.h>
+#include <Common/Async/JobSystem.h>
+#include <Common/Process.h>
+#include <Common/ProcessReactor.h>
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <memory>
+#include <thread>
+
+//////////////////////////////////////////////////////////////////////////
+
+// Tracks what a single shard is in the middle of while its output streams in
+struct TestRunner::ShardReader
+{
+	Shard       Work;
+	Framework   Kind           = Framework::None;
+	std::string Pending;
+	std::string CurrentTest;
+	bool        CurrentDecided = false;
+
+}; // ShardReader
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool ConsumePrefix( std::string_view& rLine, std::string_view Prefix )
+{
+	if( rLine.substr( 0, Prefix.size() ) != Prefix )
+		return false;
+
+	rLine.remove_prefix( Prefix.size() );
+	return true;
+
+} // ConsumePrefix
+
+//////////////////////////////////////////////////////////////////////////
+
+// Splits "Suite.Name (12 ms)" into the test name and the time it took
+static std::string_view GoogleTestName( std::string_view Rest, double* pSeconds )
+{
+	const size_t Time = Rest.rfind( " (" );
+
+	if( Time != std::string_view::npos && Rest.ends_with( " ms)" ) )
+	{
+		unsigned Milliseconds = 0;
+		std::from_chars( Rest.data() + Time + 2, Rest.data() + Rest.size(), Milliseconds );
+
+		*pSeconds = Milliseconds / 1000.0;
+		Rest      = Rest.substr( 0, Time );
+	}
+
+	return Rest;
+
+} // GoogleTestName
+
+//////////////////////////////////////////////////////////////////////////
+
+// Reads the value of an attribute in a TeamCity service message (e.g. ##teamcity[testFailed name='A' message='B'])
+static std::string TeamCityAttribute( std::string_view Message, std::string_view Attribute )
+{
+	std::string Key   = std::string( Attribute ) + "='";
+	std::string Value;
+	size_t      Begin = Message.find( " " + Key );
+
+	if( Begin == std::string_view::npos )
+		return Value;
+
+	for( size_t i = Begin + 1 + Key.size(); i < Message.size() && Message[ i ] != '\''; ++i )
+	{
+		if( Message[ i ] != '|' || i + 1 == Message.size() )
+		{
+			Value += Message[ i ];
+			continue;
+		}
+
+		switch( Message[ ++i ] )
+		{
+			case 'n': { Value += '\n'; } break;
+			case 'r': { Value += '\r'; } break;
+			default:  { Value += Message[ i ]; } break;
+		}
+	}
+
+	return Value;
+
+} // TeamCityAttribute
+
+//////////////////////////////////////////////////////////////////////////
+
+// Quotes a test name for the Catch2 command line, so that commas, brackets and wildcards in the name are taken literally
+static std::string QuoteCatchTestName( std::string_view Name, bool Exclude )
+{
+	std::string Quoted = Exclude ? "\"~" : "\"";
+
+	for( char C : Name )
+	{
+		if( C == ',' || C == '[' || C == ']' || C == '*' || C == '~' )
+			Quoted += '\\';
+		else if( C == '"' || C == '\\' )
+			Quoted += "\\\\\\";
+		else if( C == '$' || C == '`' )
+			Quoted += '\\';
+
+		Quoted += C;
+	}
+
+	return Quoted + "\"";
+
+} // QuoteCatchTestName
+
+//////////////////////////////////////////////////////////////////////////
+
+void TestRunner::Run( std::vector< std::filesystem::path > Executables )
+{
+	{
+		std::scoped_lock Lock( m_Mutex );
+
+		if( m_Running )
+			return;
+
+		m_Running = true;
+		m_Executables.clear();
+		m_TestIndices.clear();
+
+		for( std::filesystem::path& rPath : Executables )
+			m_Executables.emplace_back().Path = std::move( rPath );
+
+		m_TestIndices.resize( m_Executables.size() );
+
+		++m_Generation;
+	}
+
+	JobSystem::Instance().NewJob( [ this ]( void ) { Schedule(); } );
+
+} // Run
+
+//////////////////////////////////////////////////////////////////////////
+
+std::vector< TestRunner::TestExecutable > TestRunner::Results( void ) const
+{
+	std::scoped_lock Lock( m_Mutex );
+
+	return m_Executables;
+
+} // Results
+
+//////////////////////////////////////////////////////////////////////////
+
+TestRunner::Framework TestRunner::Detect( const std::filesystem::path& rExecutable )
+{
+	// Both frameworks leave the name of their sharding switch in the binary. Read it in blocks, since test executables tend to be big.
+	static constexpr std::string_view GOOGLE_TEST_MARKER = "GTEST_SHARD_INDEX";
+	static constexpr std::string_view CATCH2_MARKER      = "--shard-index";
+	static constexpr size_t           BLOCK_SIZE         = 1 << 20;
+
+	std::ifstream File( rExecutable, std::ios::binary );
+	std::string   Block;
+	bool          FoundCatch2 = false;
+
+	while( File )
+	{
+		// Keep the tail of the previous block, in case a marker straddles two blocks
+		const size_t Kept = std::min( Block.size(), GOOGLE_TEST_MARKER.size() );
+		Block.erase( 0, Block.size() - Kept );
+		Block.resize( Kept + BLOCK_SIZE );
+
+		File.read( Block.data() + Kept, BLOCK_SIZE );
+		Block.resize( Kept + static_cast< size_t >( File.gcount() ) );
+
+		if( Block.find( GOOGLE_TEST_MARKER ) != std::string::npos )
+			return Framework::GoogleTest;
+
+		FoundCatch2 |= Block.find( CATCH2_MARKER ) != std::string::npos;
+	}
+
+	return FoundCatch2 ? Framework::Catch2 : Framework::None;
+
+} // Detect
+
+//////////////////////////////////////////////////////////////////////////
+
+void TestRunner::Schedule( void )
+{
+	std::vector< std::filesystem::path >    Paths;
+	std::vector< std::set< std::string > > PreviouslyFailed;
+
+	{
+		std::scoped_lock Lock( m_Mutex );
+
+		for( const TestExecutable& rExecutable : m_Executables )
+		{
+			auto Failed = m_Failed.find( rExecutable.Path );
+
+			Paths.push_back( rExecutable.Path );
+			PreviouslyFailed.push_back( Failed != m_Failed.end() ? Failed->second : std::set< std::string >() );
+		}
+	}
+
+	std::vector< Framework > Kinds;
+	std::vector< bool >      Missing;
+	size_t                   Suites = 0;
+
+	for( const std::filesystem::path& rPath : Paths )
+	{
+		Kinds.push_back( Detect( rPath ) );
+		Missing.push_back( !std::filesystem::exists( rPath ) );
+		Suites += Kinds.back() != Framework::None;
+	}
+
+	{
+		std::scoped_lock Lock( m_Mutex );
+
+		for( size_t i = 0; i < Paths.size(); ++i )
+		{
+			m_Executables[ i ].Kind = Kinds[ i ];
+
+			if( Missing[ i ] )
+			{
+				m_Executables[ i ].Result = Status::Failed;
+				m_Executables[ i ].Output = "Executable not found. Has it been built?\n";
+			}
+		}
+
+		++m_Generation;
+	}
+
+	// Spread the local process slots over the suites that can be split up
+	const size_t Slots       = std::max( 1u, std::thread::hardware_concurrency() );
+	const size_t ShardCount  = std::max< size_t >( 1, Slots / std::max< size_t >( 1, Suites ) );
+	std::vector< Shard >     FirstPass;
+	std::vector< Shard >     SecondPass;
+
+	for( size_t i = 0; i < Paths.size(); ++i )
+	{
+		if( Missing[ i ] )
+			continue;
+
+		std::vector< std::string > Failed( PreviouslyFailed[ i ].begin(), PreviouslyFailed[ i ].end() );
+
+		if( Kinds[ i ] == Framework::None )
+		{
+			// Can't pick individual tests out of these, so the whole executable goes first if it failed last time
+			( Failed.empty() ? SecondPass : FirstPass ).push_back( Shard{ .Executable = i, .Index = 0, .Count = 1, .Only = { }, .Exclude = { } } );
+			continue;
+		}
+
+		// An executable that failed without a failing test (e.g. it crashed during startup) has nothing to re-run on its own
+		std::erase( Failed, std::string() );
+
+		if( !Failed.empty() )
+			FirstPass.push_back( Shard{ .Executable = i, .Index = 0, .Count = 1, .Only = Failed, .Exclude = { } } );
+
+		for( size_t Index = 0; Index < ShardCount; ++Index )
+			SecondPass.push_back( Shard{ .Executable = i, .Index = Index, .Count = ShardCount, .Only = { }, .Exclude = Failed } );
+	}
+
+	std::vector< JobSystem::JobPtr > FirstPassJobs;
+	std::vector< JobSystem::JobPtr > AllJobs;
+
+	for( Shard& rShard : FirstPass )
+		FirstPassJobs.push_back( JobSystem::Instance().NewJob( [ this, rShard ]( void ) { RunShard( rShard ); } ) );
+
+	AllJobs = FirstPassJobs;
+
+	// The rest of the suite waits for the previous failures, so that their verdict comes in first
+	for( Shard& rShard : SecondPass )
+		AllJobs.push_back( JobSystem::Instance().NewJob( [ this, rShard ]( void ) { RunShard( rShard ); }, FirstPassJobs ) );
+
+	JobSystem::Instance().NewJob( [ this ]( void ) { Finish(); }, AllJobs );
+
+} // Schedule
+
+//////////////////////////////////////////////////////////////////////////
+
+void TestRunner::RunShard( const Shard& rShard )
+{
+	Framework    Kind;
+	std::wstring CommandLine;
+
+	{
+		std::scoped_lock Lock( m_Mutex );
+		TestExecutable&  rExecutable = m_Executables[ rShard.Executable ];
+
+		Kind        = rExecutable.Kind;
+		CommandLine = L"\"" + rExecutable.Path.wstring() + L"\"";
+	}
+
+	auto        pTestProcess = std::make_shared< Process >();
+	std::string Arguments;
+
+	switch( Kind )
+	{
+		case Framework::GoogleTest:
+		{
+			const std::vector< std::string >& rNames = rShard.Only.empty() ? rShard.Exclude : rShard.Only;
+
+			Arguments = " --gtest_color=no";
+
+			if( !rNames.empty() )
+			{
+				Arguments += rShard.Only.empty() ? " --gtest_filter=\"-" : " --gtest_filter=\"";
+
+				for( size_t i = 0; i < rNames.size(); ++i )
+					Arguments += ( i ? ":" : "" ) + rNames[ i ];
+
+				Arguments += "\"";
+			}
+
+			if( rShard.Count > 1 )
+			{
+				pTestProcess->AddEnvironmentVariable( L"GTEST_TOTAL_SHARDS", std::to_wstring( rShard.Count ) );
+				pTestProcess->AddEnvironmentVariable( L"GTEST_SHARD_INDEX",  std::to_wstring( rShard.Index ) );
+			}
+
+		} break;
+
+		case Framework::Catch2:
+		{
+			Arguments = " --reporter teamcity";
+
+			if( rShard.Count > 1 )
+				Arguments += " --shard-count " + std::to_string( rShard.Count ) + " --shard-index " + std::to_string( rShard.Index );
+
+			for( const std::string& rName : rShard.Only )
+				Arguments += " " + QuoteCatchTestName( rName, false );
+
+			for( const std::string& rName : rShard.Exclude )
+				Arguments += " " + QuoteCatchTestName( rName, true );
+
+		} break;
+
+		case Framework::None:
+			break;
+	}
+
+	CommandLine += UTF8Converter().from_bytes( Arguments );
+
+	auto pReader   = std::make_shared< ShardReader >();
+	pReader->Work  = rShard;
+	pReader->Kind  = Kind;
+
+	// The executable is left to the process reactor, so this job only counts as done once the shard has exited
+	JobSystem::JobPtr Job = JobSystem::Instance().Defer();
+
+	auto OnOutput = [ this, pReader ]( std::string_view Output )
+	{
+		pReader->Pending.append( Output );
+
+		size_t Begin = 0;
+		for( size_t End; ( End = pReader->Pending.find( '\n', Begin ) ) != std::string::npos; Begin = End + 1 )
+			ReadLine( *pReader, std::string_view( pReader->Pending ).substr( Begin, End - Begin ) );
+
+		pReader->Pending.erase( 0, Begin );
+	};
+
+	// Shards queue for a local process slot rather than waiting for one, since the slots are given back by the jobs that shards exit with
+	WorkerPool::Instance().Request( false, [ this, pTestProcess, CommandLine, pReader, OnOutput, Job ]( WorkerPool::Lease Slot )
+		{
+			auto pSlot  = std::make_shared< WorkerPool::Lease >( std::move( Slot ) );
+			auto OnExit = [ this, pReader, pSlot, Job ]( int ExitCode )
+			{
+				pSlot->Release();
+
+				FinishShard( *pReader, ExitCode );
+
+				if( Job )
+					Job->Finish();
+			};
+
+			{
+				std::scoped_lock Lock( m_Mutex );
+				TestExecutable&  rExecutable = m_Executables[ pReader->Work.Executable ];
+
+				if( rExecutable.Result == Status::Queued )
+					rExecutable.Result = Status::Running;
+
+				++m_Generation;
+			}
+
+			// The process only keeps a view of its command line, which has to last until it has been spawned
+			pTestProcess->SetCommandLine( CommandLine );
+
+			if( !ProcessReactor::Instance().Spawn( std::move( *pTestProcess ), OnOutput, OnExit ) )
+				OnExit( -1 );
+		}
+	);
+
+} // RunShard
+
+//////////////////////////////////////////////////////////////////////////
+
+void TestRunner::ReadLine( ShardReader& rReader, std::string_view Line )
+{
+	std::scoped_lock Lock( m_Mutex );
+	TestExecutable&  rExecutable = m_Executables[ rReader.Work.Executable ];
+	std::string_view Rest        = Line;
+	double           Seconds     = 0.0;
+
+	if( !Rest.empty() && Rest.back() == '\r' )
+		Rest.remove_suffix( 1 );
+
+	if( rReader.Kind == Framework::GoogleTest )
+	{
+		if( ConsumePrefix( Rest, "[ RUN      ] " ) )
+		{
+			rReader.CurrentTest = Rest;
+			FindTest( rReader.Work.Executable, Rest ).Result = Status::Running;
+			++m_Generation;
+			return;
+		}
+
+		// Failures and skips are listed once more in the summary, when no test is running
+		Status Result = Status::Running;
+
+		if(      ConsumePrefix( Rest, "[       OK ] " ) ) Result = Status::Passed;
+		else if( ConsumePrefix( Rest, "[  FAILED  ] " ) ) Result = Status::Failed;
+		else if( ConsumePrefix( Rest, "[  SKIPPED ] " ) ) Result = Status::Skipped;
+
+		if( Result != Status::Running && !rReader.CurrentTest.empty() && GoogleTestName( Rest, &Seconds ) == rReader.CurrentTest )
+		{
+			TestCase& rTest = FindTest( rReader.Work.Executable, rReader.CurrentTest );
+			rTest.Result    = Result;
+			rTest.Seconds   = Seconds;
+
+			rReader.CurrentTest.clear();
+			++m_Generation;
+			return;
+		}
+	}
+	else if( rReader.Kind == Framework::Catch2 && ConsumePrefix( Rest, "##teamcity[" ) )
+	{
+		const std::string Name = TeamCityAttribute( Rest, "name" );
+
+		if( ConsumePrefix( Rest, "testStarted " ) )
+		{
+			rReader.CurrentTest    = Name;
+			rReader.CurrentDecided = false;
+			FindTest( rReader.Work.Executable, Name ).Result = Status::Running;
+		}
+		else if( ConsumePrefix( Rest, "testFailed " ) )
+		{
+			TestCase& rTest = FindTest( rReader.Work.Executable, Name );
+			rTest.Output   += TeamCityAttribute( Rest, "message" ) + "\n" + TeamCityAttribute( Rest, "details" );
+			rTest.Result    = Status::Failed;
+
+			rReader.CurrentDecided = true;
+		}
+		else if( ConsumePrefix( Rest, "testIgnored " ) )
+		{
+			FindTest( rReader.Work.Executable, Name ).Result = Status::Skipped;
+			rReader.CurrentDecided = true;
+		}
+		else if( ConsumePrefix( Rest, "testStdOut " ) || ConsumePrefix( Rest, "testStdErr " ) )
+		{
+			FindTest( rReader.Work.Executable, Name ).Output += TeamCityAttribute( Rest, "out" );
+		}
+		else if( ConsumePrefix( Rest, "testFinished " ) )
+		{
+			TestCase&         rTest        = FindTest( rReader.Work.Executable, Name );
+			const std::string Duration     = TeamCityAttribute( Rest, "duration" );
+			unsigned          Milliseconds = 0;
+
+			std::from_chars( Duration.data(), Duration.data() + Duration.size(), Milliseconds );
+
+			rTest.Seconds = Milliseconds / 1000.0;
+			if( !rReader.CurrentDecided )
+				rTest.Result = Status::Passed;
+
+			rReader.CurrentTest.clear();
+		}
+
+		++m_Generation;
+		return;
+	}
+
+	// Anything else belongs to the test that is running, if any
+	std::string& rOutput = rReader.CurrentTest.empty() ? rExecutable.Output : FindTest( rReader.Work.Executable, rReader.CurrentTest ).Output;
+	rOutput.append( Line );
+	rOutput += '\n';
+
+} // ReadLine
+
+//////////////////////////////////////////////////////////////////////////
+
+void TestRunner::FinishShard( ShardReader& rReader, int ExitCode )
+{
+	if( !rReader.Pending.empty() )
+		ReadLine( rReader, rReader.Pending );
+
+	std::scoped_lock Lock( m_Mutex );
+	TestExecutable&  rExecutable = m_Executables[ rReader.Work.Executable ];
+
+	// A test that never finished took the executable down with it
+	if( !rReader.CurrentTest.empty() )
+	{
+		TestCase& rTest = FindTest( rReader.Work.Executable, rReader.CurrentTest );
+		rTest.Output   += "The test executable exited while this test was running\n";
+		rTest.Result    = Status::Failed;
+	}
+
+	if( ExitCode != 0 )
+		rExecutable.Result = Status::Failed;
+
+	++m_Generation;
+
+} // FinishShard
+
+//////////////////////////////////////////////////////////////////////////
+
+void TestRunner::Finish( void )
+{
+	std::scoped_lock Lock( m_Mutex );
+
+	// Sorting below moves the tests around, and no more results are coming in
+	m_TestIndices.clear();
+
+	for( TestExecutable& rExecutable : m_Executables )
+	{
+		std::set< std::string >& rFailed = m_Failed[ rExecutable.Path ];
+		rFailed.clear();
+
+		for( const TestCase& rTest : rExecutable.Tests )
+		{
+			if( rTest.Result == Status::Failed )
+				rFailed.insert( rTest.Name );
+		}
+
+		// Keep the order stable between runs, however the shards happened to interleave
+		std::sort( rExecutable.Tests.begin(), rExecutable.Tests.end(), []( const TestCase& rLeft, const TestCase& rRight ) { return rLeft.Name < rRight.Name; } );
+
+		if( rExecutable.Result != Status::Failed )
+			rExecutable.Result = rFailed.empty() ? Status::Passed : Status::Failed;
+		else if( rFailed.empty() )
+			rFailed.insert( "" );
+	}
+
+	m_Running = false;
+	++m_Generation;
+
+} // Finish
+
+//////////////////////////////////////////////////////////////////////////
+
+TestRunner::TestCase& TestRunner::FindTest( size_t Executable, std::string_view Name )
+{
+	TestExecutable& rExecutable = m_Executables[ Executable ];
+	auto            Index       = m_TestIndices[ Executable ].try_emplace( std::string( Name ), rExecutable.Tests.size() );
+
+	if( Index.second )
+		rExecutable.Tests.emplace_back().Name = Name;
+
+	return rExecutable.Tests[ Index.first->second ];
+
+} // FindTest
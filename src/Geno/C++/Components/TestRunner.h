@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include <Common/Macros.h>
+
+#include <atomic>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Runs test executables in parallel, as many at a time as there are local process slots. GoogleTest and Catch2 suites are split into
+// shards, so that a single large suite keeps every core busy. Tests that failed in the previous run go first, and results come in as
+// the tests finish rather than when the executable exits.
+class TestRunner
+{
+	GENO_SINGLETON( TestRunner );
+
+	TestRunner( void ) = default;
+
+//////////////////////////////////////////////////////////////////////////
+
+public:
+
+	enum class Framework
+	{
+		None,
+		GoogleTest,
+		Catch2,
+
+	}; // Framework
+
+	enum class Status
+	{
+		Queued,
+		Running,
+		Passed,
+		Failed,
+		Skipped,
+
+	}; // Status
+
+	struct TestCase
+	{
+		std::string Name;
+		std::string Output;
+		double      Seconds = 0.0;
+		Status      Result  = Status::Running;
+
+	}; // TestCase
+
+	struct TestExecutable
+	{
+		std::filesystem::path   Path;
+		Framework               Kind   = Framework::None;
+		Status                  Result = Status::Queued;
+		std::vector< TestCase > Tests;
+
+		// Whatever was printed outside of a test. Without a framework, that is everything.
+		std::string             Output;
+
+	}; // TestExecutable
+
+//////////////////////////////////////////////////////////////////////////
+
+	void Run( std::vector< std::filesystem::path > Executables );
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::vector< TestExecutable > Results   ( void ) const;
+	unsigned                      Generation( void ) const { return m_Generation; }
+	bool                          IsRunning ( void ) const { return m_Running; }
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	struct Shard
+	{
+		size_t                     Executable = 0;
+		size_t                     Index      = 0;
+		size_t                     Count      = 1;
+
+		// Test names to run exclusively, or to leave out
+		std::vector< std::string > Only;
+		std::vector< std::string > Exclude;
+
+	}; // Shard
+
+	struct ShardReader;
+
+//////////////////////////////////////////////////////////////////////////
+
+	static Framework Detect( const std::filesystem::path& rExecutable );
+
+//////////////////////////////////////////////////////////////////////////
+
+	void      Schedule   ( void );
+	void      RunShard   ( const Shard& rShard );
+	void      ReadLine   ( ShardReader& rReader, std::string_view Line );
+	void      FinishShard( ShardReader& rReader, int ExitCode );
+	void      Finish     ( void );
+	TestCase& FindTest   ( size_t Executable, std::string_view Name );
+
+//////////////////////////////////////////////////////////////////////////
+
+	mutable std::mutex                                              m_Mutex;
+	std::vector< TestExecutable >                                   m_Executables;
+	std::vector< std::unordered_map< std::string, size_t > >        m_TestIndices;
+
+	// Tests that failed in the previous run of each executable. An empty name stands for the executable itself.
+	std::map< std::filesystem::path, std::set< std::string > >      m_Failed;
+
+	std::atomic< unsigned >                                         m_Generation = 0;
+	std::atomic< bool >                                             m_Running    = false;
+
+}; // TestRunner
@@ -0,0 +1,532 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "TextBuffer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined( __SSE2__ ) || defined( _M_AMD64 ) || defined( _M_X64 )
+#include <emmintrin.h>
+#define TEXT_BUFFER_SSE2
+#endif // __SSE2__ || _M_AMD64 || _M_X64
+
+//////////////////////////////////////////////////////////////////////////
+
+// Typed text goes into a block of at least this size. A block is never reallocated, so a new one is started once it's full.
+static constexpr size_t BlockSize = 64 * 1024;
+
+// Enough for a search through a big file to be moved along with what is typed in the meantime
+static constexpr size_t MaxLineEdits = 4096;
+
+//////////////////////////////////////////////////////////////////////////
+
+struct TextBuffer::Node
+{
+	uint32_t BlockIndex;
+	size_t   Start;
+	size_t   Length;
+	size_t   FirstBreak; // Index in Block::Breaks of the first line break in the piece
+	size_t   Breaks;
+
+	uint32_t Priority;
+	size_t   TotalLength = 0; // Of the whole subtree
+	size_t   TotalBreaks = 0;
+
+	NodePtr Left;
+	NodePtr Right;
+
+}; // Node
+
+//////////////////////////////////////////////////////////////////////////
+
+static size_t LengthOf( const auto& rpNode ) { return rpNode ? rpNode->TotalLength : 0; }
+static size_t BreaksOf( const auto& rpNode ) { return rpNode ? rpNode->TotalBreaks : 0; }
+
+//////////////////////////////////////////////////////////////////////////
+
+static void FindBreaks( std::string_view Text, size_t Base, std::vector< size_t >& rBreaks )
+{
+	const char* pBegin = Text.data();
+	const char* pEnd   = pBegin + Text.size();
+	const char* p      = pBegin;
+
+#if defined( TEXT_BUFFER_SSE2 )
+
+	// Source code has short lines, so rather than calling memchr() for every one of them, look at 64 bytes at a time and take every
+	// line break out of the mask
+	const __m128i Break = _mm_set1_epi8( '\n' );
+
+	for( ; pEnd - p >= 64; p += 64 )
+	{
+		const __m128i* pBlock = reinterpret_cast< const __m128i* >( p );
+		const uint64_t Mask0  = static_cast< uint32_t >( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( pBlock + 0 ), Break ) ) );
+		const uint64_t Mask1  = static_cast< uint32_t >( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( pBlock + 1 ), Break ) ) );
+		const uint64_t Mask2  = static_cast< uint32_t >( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( pBlock + 2 ), Break ) ) );
+		const uint64_t Mask3  = static_cast< uint32_t >( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( pBlock + 3 ), Break ) ) );
+
+		for( uint64_t Mask = Mask0 | ( Mask1 << 16 ) | ( Mask2 << 32 ) | ( Mask3 << 48 ); Mask != 0; Mask &= Mask - 1 )
+			rBreaks.push_back( Base + ( p - pBegin ) + static_cast< size_t >( std::countr_zero( Mask ) ) );
+	}
+
+#endif // TEXT_BUFFER_SSE2
+
+	// The remainder (or everything, without SSE2)
+	for( ; ( p = static_cast< const char* >( std::memchr( p, '\n', pEnd - p ) ) ) != nullptr; ++p )
+		rBreaks.push_back( Base + ( p - pBegin ) );
+
+} // FindBreaks
+
+//////////////////////////////////////////////////////////////////////////
+
+TextBuffer::TextBuffer( void ) = default;
+
+//////////////////////////////////////////////////////////////////////////
+
+TextBuffer::TextBuffer( std::string Text )
+{
+	Assign( std::move( Text ) );
+
+} // TextBuffer
+
+//////////////////////////////////////////////////////////////////////////
+
+TextBuffer::TextBuffer( TextBuffer&& ) noexcept = default;
+TextBuffer::~TextBuffer( void )                 = default;
+
+TextBuffer& TextBuffer::operator=( TextBuffer&& ) noexcept = default;
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextBuffer::Assign( std::string Text )
+{
+	m_pRoot.reset();
+	m_Blocks.clear();
+	m_LineEdits.clear();
+	++m_Version;
+
+	Block& rBlock = *m_Blocks.emplace_back( std::make_shared< Block >() );
+	rBlock.Text   = std::move( Text );
+
+	FindBreaks( rBlock.Text, 0, rBlock.Breaks );
+
+	if( !rBlock.Text.empty() )
+		m_pRoot = MakeNode( 0, 0, rBlock.Text.size() );
+
+} // Assign
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextBuffer::Insert( size_t Offset, std::string_view Text )
+{
+	if( Text.empty() )
+		return;
+
+	Offset = std::min( Offset, Size() );
+
+	const size_t FirstLine = LineOf( Offset );
+
+	auto [ pLeft, pRight ] = Split( std::move( m_pRoot ), Offset, *this );
+
+	size_t         Start;
+	const uint32_t BlockIndex = Append( Text, Start );
+	const Block&   rBlock     = *m_Blocks[ BlockIndex ];
+	const size_t   NewBreaks  = rBlock.Breaks.size() - ( std::lower_bound( rBlock.Breaks.begin(), rBlock.Breaks.end(), Start ) - rBlock.Breaks.begin() );
+
+	// Consecutive keystrokes end up next to each other in the same block, so the piece that was typed last can simply grow
+	Node* pLast = pLeft.get();
+	while( pLast && pLast->Right )
+		pLast = pLast->Right.get();
+
+	if( pLast && pLast->BlockIndex == BlockIndex && pLast->Start + pLast->Length == Start )
+	{
+		for( Node* pNode = pLeft.get(); pNode; pNode = pNode->Right.get() )
+		{
+			pNode->TotalLength += Text.size();
+			pNode->TotalBreaks += NewBreaks;
+		}
+
+		pLast->Length += Text.size();
+		pLast->Breaks += NewBreaks;
+	}
+	else
+	{
+		pLeft = Merge( std::move( pLeft ), MakeNode( BlockIndex, Start, Text.size() ) );
+	}
+
+	m_pRoot = Merge( std::move( pLeft ), std::move( pRight ) );
+
+	Edited( FirstLine, FirstLine, FirstLine + NewBreaks );
+
+} // Insert
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextBuffer::Erase( size_t Offset, size_t Length )
+{
+	const size_t BufferSize = Size();
+
+	Offset = std::min( Offset, BufferSize );
+	Length = std::min( Length, BufferSize - Offset );
+
+	if( Length == 0 )
+		return;
+
+	const size_t FirstLine = LineOf( Offset );
+
+	auto [ pLeft, pRest ]    = Split( std::move( m_pRoot ), Offset, *this );
+	auto [ pErased, pRight ] = Split( std::move( pRest ), Length, *this );
+
+	m_pRoot = Merge( std::move( pLeft ), std::move( pRight ) );
+
+	Edited( FirstLine, FirstLine + BreaksOf( pErased ), FirstLine );
+
+} // Erase
+
+//////////////////////////////////////////////////////////////////////////
+
+size_t TextBuffer::Size( void ) const
+{
+	return LengthOf( m_pRoot );
+
+} // Size
+
+//////////////////////////////////////////////////////////////////////////
+
+size_t TextBuffer::LineCount( void ) const
+{
+	return BreaksOf( m_pRoot ) + 1;
+
+} // LineCount
+
+//////////////////////////////////////////////////////////////////////////
+
+size_t TextBuffer::LineStart( size_t Line ) const
+{
+	if( Line == 0 )
+		return 0;
+
+	// A line starts right after the line break before it, so look for the Line:th line break
+	size_t      Remaining = std::min( Line, BreaksOf( m_pRoot ) );
+	size_t      Base      = 0;
+	const Node* pNode     = m_pRoot.get();
+
+	while( pNode )
+	{
+		if( Remaining <= BreaksOf( pNode->Left ) )
+		{
+			pNode = pNode->Left.get();
+			continue;
+		}
+
+		Remaining -= BreaksOf( pNode->Left );
+		Base      += LengthOf( pNode->Left );
+
+		if( Remaining <= pNode->Breaks )
+			return Base + ( m_Blocks[ pNode->BlockIndex ]->Breaks[ pNode->FirstBreak + Remaining - 1 ] - pNode->Start ) + 1;
+
+		Remaining -= pNode->Breaks;
+		Base      += pNode->Length;
+		pNode      = pNode->Right.get();
+	}
+
+	return Size();
+
+} // LineStart
+
+//////////////////////////////////////////////////////////////////////////
+
+size_t TextBuffer::LineLength( size_t Line ) const
+{
+	const size_t Start = LineStart( Line );
+	const size_t End   = ( Line + 1 < LineCount() ) ? LineStart( Line + 1 ) - 1 : Size();
+
+	return End - Start;
+
+} // LineLength
+
+//////////////////////////////////////////////////////////////////////////
+
+size_t TextBuffer::LineOf( size_t Offset ) const
+{
+	size_t      Line  = 0;
+	const Node* pNode = m_pRoot.get();
+
+	while( pNode )
+	{
+		if( Offset <= LengthOf( pNode->Left ) )
+		{
+			pNode = pNode->Left.get();
+			continue;
+		}
+
+		Line   += BreaksOf( pNode->Left );
+		Offset -= LengthOf( pNode->Left );
+
+		if( Offset <= pNode->Length )
+		{
+			const std::vector< size_t >& rBreaks = m_Blocks[ pNode->BlockIndex ]->Breaks;
+			auto                         First   = rBreaks.begin() + pNode->FirstBreak;
+
+			return Line + ( std::lower_bound( First, First + pNode->Breaks, pNode->Start + Offset ) - First );
+		}
+
+		Line   += pNode->Breaks;
+		Offset -= pNode->Length;
+		pNode   = pNode->Right.get();
+	}
+
+	return Line;
+
+} // LineOf
+
+//////////////////////////////////////////////////////////////////////////
+
+std::string TextBuffer::GetLine( size_t Line ) const
+{
+	return GetText( LineStart( Line ), LineLength( Line ) );
+
+} // GetLine
+
+//////////////////////////////////////////////////////////////////////////
+
+std::string TextBuffer::GetText( size_t Offset, size_t Length ) const
+{
+	std::string Text;
+	Text.reserve( std::min( Length, Size() ) );
+
+	ForEachChunk( Offset, Length, [ &Text ]( std::string_view Chunk ) { Text.append( Chunk ); } );
+
+	return Text;
+
+} // GetText
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextBuffer::ForEachChunk( size_t Offset, size_t Length, const std::function< void( std::string_view ) >& rFunction ) const
+{
+	const size_t BufferSize = Size();
+
+	Offset = std::min( Offset, BufferSize );
+	Length = std::min( Length, BufferSize - Offset );
+
+	Visit( m_pRoot.get(), 0, Offset, Offset + Length, rFunction );
+
+} // ForEachChunk
+
+//////////////////////////////////////////////////////////////////////////
+
+TextBuffer::Snapshot TextBuffer::TakeSnapshot( void ) const
+{
+	Snapshot Result;
+	Result.m_Blocks.assign( m_Blocks.begin(), m_Blocks.end() );
+	Result.m_Size    = Size();
+	Result.m_Version = m_Version;
+
+	Visit( m_pRoot.get(), 0, 0, Result.m_Size, [ &Result ]( std::string_view Chunk ) { Result.m_Chunks.push_back( Chunk ); } );
+
+	return Result;
+
+} // TakeSnapshot
+
+//////////////////////////////////////////////////////////////////////////
+
+bool TextBuffer::MapLine( uint64_t Version, size_t& rLine ) const
+{
+	if( !CanMapLines( Version ) )
+		return false;
+
+	// Each edit moves the line from the version before it to the one it made
+	for( size_t i = m_LineEdits.size() - static_cast< size_t >( m_Version - Version ); i < m_LineEdits.size(); ++i )
+	{
+		const LineEdit& rEdit = m_LineEdits[ i ];
+
+		if( rLine > rEdit.OldLastLine )
+			rLine = rLine - rEdit.OldLastLine + rEdit.NewLastLine;
+		else if( rLine >= rEdit.FirstLine )
+			return false;
+	}
+
+	return true;
+
+} // MapLine
+
+//////////////////////////////////////////////////////////////////////////
+
+bool TextBuffer::CanMapLines( uint64_t Version ) const
+{
+	return Version <= m_Version && m_Version - Version <= m_LineEdits.size();
+
+} // CanMapLines
+
+//////////////////////////////////////////////////////////////////////////
+
+TextBuffer::NodePtr TextBuffer::MakeNode( uint32_t BlockIndex, size_t Start, size_t Length )
+{
+	const std::vector< size_t >& rBreaks = m_Blocks[ BlockIndex ]->Breaks;
+	NodePtr                      pNode   = std::make_unique< Node >();
+
+	// xorshift32
+	m_Seed ^= m_Seed << 13;
+	m_Seed ^= m_Seed >> 17;
+	m_Seed ^= m_Seed << 5;
+
+	pNode->BlockIndex = BlockIndex;
+	pNode->Start      = Start;
+	pNode->Length     = Length;
+	pNode->FirstBreak = std::lower_bound( rBreaks.begin(), rBreaks.end(), Start ) - rBreaks.begin();
+	pNode->Breaks     = ( std::lower_bound( rBreaks.begin() + pNode->FirstBreak, rBreaks.end(), Start + Length ) - rBreaks.begin() ) - pNode->FirstBreak;
+	pNode->Priority   = m_Seed;
+
+	Update( *pNode );
+
+	return pNode;
+
+} // MakeNode
+
+//////////////////////////////////////////////////////////////////////////
+
+uint32_t TextBuffer::Append( std::string_view Text, size_t& rStart )
+{
+	// Appending never reallocates a block, which is what keeps the bytes of snapshots in place
+	if( m_Blocks.empty() || m_Blocks.back()->Text.capacity() - m_Blocks.back()->Text.size() < Text.size() )
+		m_Blocks.emplace_back( std::make_shared< Block >() )->Text.reserve( std::max( BlockSize, Text.size() ) );
+
+	Block& rBlock = *m_Blocks.back();
+	rStart        = rBlock.Text.size();
+
+	rBlock.Text.append( Text );
+	FindBreaks( Text, rStart, rBlock.Breaks );
+
+	return static_cast< uint32_t >( m_Blocks.size() - 1 );
+
+} // Append
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextBuffer::Edited( size_t FirstLine, size_t OldLastLine, size_t NewLastLine )
+{
+	if( m_LineEdits.size() == MaxLineEdits )
+		m_LineEdits.pop_front();
+
+	m_LineEdits.push_back( LineEdit{ FirstLine, OldLastLine, NewLastLine } );
+	++m_Version;
+
+} // Edited
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextBuffer::Visit( const Node* pNode, size_t Base, size_t Begin, size_t End, const std::function< void( std::string_view ) >& rFunction ) const
+{
+	if( !pNode || Begin >= End )
+		return;
+
+	const size_t PieceStart = Base + LengthOf( pNode->Left );
+	const size_t PieceEnd   = PieceStart + pNode->Length;
+
+	if( Begin < PieceStart )
+		Visit( pNode->Left.get(), Base, Begin, std::min( End, PieceStart ), rFunction );
+
+	if( Begin < PieceEnd && End > PieceStart )
+	{
+		const size_t First = std::max( Begin, PieceStart ) - PieceStart;
+		const size_t Last  = std::min( End, PieceEnd ) - PieceStart;
+
+		rFunction( std::string_view( m_Blocks[ pNode->BlockIndex ]->Text ).substr( pNode->Start + First, Last - First ) );
+	}
+
+	if( End > PieceEnd )
+		Visit( pNode->Right.get(), PieceEnd, std::max( Begin, PieceEnd ), End, rFunction );
+
+} // Visit
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextBuffer::Update( Node& rNode )
+{
+	rNode.TotalLength = LengthOf( rNode.Left ) + rNode.Length + LengthOf( rNode.Right );
+	rNode.TotalBreaks = BreaksOf( rNode.Left ) + rNode.Breaks + BreaksOf( rNode.Right );
+
+} // Update
+
+//////////////////////////////////////////////////////////////////////////
+
+TextBuffer::NodePtr TextBuffer::Merge( NodePtr pLeft, NodePtr pRight )
+{
+	if( !pLeft )  return pRight;
+	if( !pRight ) return pLeft;
+
+	if( pLeft->Priority > pRight->Priority )
+	{
+		pLeft->Right = Merge( std::move( pLeft->Right ), std::move( pRight ) );
+		Update( *pLeft );
+
+		return pLeft;
+	}
+	else
+	{
+		pRight->Left = Merge( std::move( pLeft ), std::move( pRight->Left ) );
+		Update( *pRight );
+
+		return pRight;
+	}
+
+} // Merge
+
+//////////////////////////////////////////////////////////////////////////
+
+std::pair< TextBuffer::NodePtr, TextBuffer::NodePtr > TextBuffer::Split( NodePtr pNode, size_t Offset, TextBuffer& rBuffer )
+{
+	if( !pNode )
+		return { };
+
+	const size_t LeftLength = LengthOf( pNode->Left );
+
+	if( Offset <= LeftLength )
+	{
+		auto [ pLeft, pRight ] = Split( std::move( pNode->Left ), Offset, rBuffer );
+
+		pNode->Left = std::move( pRight );
+		Update( *pNode );
+
+		return { std::move( pLeft ), std::move( pNode ) };
+	}
+
+	if( Offset >= LeftLength + pNode->Length )
+	{
+		auto [ pLeft, pRight ] = Split( std::move( pNode->Right ), Offset - LeftLength - pNode->Length, rBuffer );
+
+		pNode->Right = std::move( pLeft );
+		Update( *pNode );
+
+		return { std::move( pNode ), std::move( pRight ) };
+	}
+
+	// The offset is in the middle of this piece, so cut it in two
+	const size_t Cut   = Offset - LeftLength;
+	NodePtr      pTail = rBuffer.MakeNode( pNode->BlockIndex, pNode->Start + Cut, pNode->Length - Cut );
+
+	pNode->Length  = Cut;
+	pNode->Breaks -= pTail->Breaks;
+
+	NodePtr pRight = Merge( std::move( pTail ), std::move( pNode->Right ) );
+	Update( *pNode );
+
+	return { std::move( pNode ), std::move( pRight ) };
+
+} // Split
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The text of a file that is being edited, as UTF-8 bytes in a piece table. The loaded text and everything that is typed afterwards
+// live in blocks that are only ever appended to, and the document is a sequence of pieces that each refer to a range of one block.
+// The pieces are kept in a treap where every node knows the length and the number of line breaks of its subtree, so inserting,
+// erasing and finding the start of a line are all O(log n) regardless of the size of the file. Only '\n' is a line break.
+// Every edit bumps the version of the buffer and notes which lines it replaced, so that whatever was worked out from a snapshot in the
+// background can be moved to where its lines are now once it is done.
+class TextBuffer
+{
+	struct Block;
+
+//////////////////////////////////////////////////////////////////////////
+
+public:
+
+	// The text as it was when the snapshot was taken. Bytes in a block never change once they are written, so a snapshot only holds on
+	// to the blocks and the ranges of its pieces, and it stays the same whatever is done to the buffer (or from whichever thread).
+	class Snapshot
+	{
+	public:
+
+		size_t                                 Size   ( void ) const { return m_Size; }
+		uint64_t                               Version( void ) const { return m_Version; }
+		const std::vector< std::string_view >& Chunks ( void ) const { return m_Chunks; }
+
+	//////////////////////////////////////////////////////////////////////////
+
+	private:
+
+		friend class TextBuffer;
+
+	//////////////////////////////////////////////////////////////////////////
+
+		std::vector< std::shared_ptr< const Block > > m_Blocks;
+		std::vector< std::string_view >               m_Chunks;
+		size_t                                        m_Size    = 0;
+		uint64_t                                      m_Version = 0;
+
+	}; // Snapshot
+
+//////////////////////////////////////////////////////////////////////////
+
+	 TextBuffer( void );
+	 explicit TextBuffer( std::string Text );
+	 TextBuffer( TextBuffer&& ) noexcept;
+	~TextBuffer( void );
+
+	TextBuffer& operator=( TextBuffer&& ) noexcept;
+
+//////////////////////////////////////////////////////////////////////////
+
+	void Assign( std::string Text );
+	void Insert( size_t Offset, std::string_view Text );
+	void Erase ( size_t Offset, size_t Length );
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Lines are returned without their line break. The last line of the buffer is the one after the last line break.
+	size_t      Size      ( void )                         const;
+	size_t      LineCount ( void )                         const;
+	size_t      LineStart ( size_t Line )                  const;
+	size_t      LineLength( size_t Line )                  const;
+	size_t      LineOf    ( size_t Offset )                const;
+	std::string GetLine   ( size_t Line )                  const;
+	std::string GetText   ( size_t Offset, size_t Length ) const;
+	std::string GetText   ( void )                         const { return GetText( 0, Size() ); }
+
+	// Calls rFunction with the bytes in [Offset, Offset + Length) in order, one contiguous range at a time
+	void ForEachChunk( size_t Offset, size_t Length, const std::function< void( std::string_view ) >& rFunction ) const;
+
+	// Costs one entry per piece, no matter how much text there is
+	Snapshot TakeSnapshot( void ) const;
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Moves rLine of the text as it was in an earlier version to where that line is now. Returns false if the line has been edited since.
+	// Only the last few thousand edits are remembered, and CanMapLines() tells whether those reach back far enough.
+	bool     MapLine    ( uint64_t Version, size_t& rLine ) const;
+	bool     CanMapLines( uint64_t Version )                const;
+	uint64_t Version    ( void )                            const { return m_Version; }
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	struct Block
+	{
+		std::string           Text;
+		std::vector< size_t > Breaks; // Offset of every '\n' in Text
+
+	}; // Block
+
+	// Lines [FirstLine, OldLastLine] became [FirstLine, NewLastLine]
+	struct LineEdit
+	{
+		size_t FirstLine;
+		size_t OldLastLine;
+		size_t NewLastLine;
+
+	}; // LineEdit
+
+	struct Node;
+
+	using NodePtr = std::unique_ptr< Node >;
+
+//////////////////////////////////////////////////////////////////////////
+
+	NodePtr  MakeNode( uint32_t BlockIndex, size_t Start, size_t Length );
+	uint32_t Append  ( std::string_view Text, size_t& rStart );
+	void     Edited  ( size_t FirstLine, size_t OldLastLine, size_t NewLastLine );
+	void     Visit   ( const Node* pNode, size_t Base, size_t Begin, size_t End, const std::function< void( std::string_view ) >& rFunction ) const;
+
+	static void                          Update( Node& rNode );
+	static NodePtr                       Merge ( NodePtr pLeft, NodePtr pRight );
+	static std::pair< NodePtr, NodePtr > Split ( NodePtr pNode, size_t Offset, TextBuffer& rBuffer );
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::vector< std::shared_ptr< Block > > m_Blocks; // Shared with snapshots
+	NodePtr                                 m_pRoot;
+	std::deque< LineEdit >                  m_LineEdits; // The edits that made the last m_LineEdits.size() versions
+	uint64_t                                m_Version = 0;
+	uint32_t                                m_Seed    = 0x9E3779B9;
+
+}; // TextBuffer
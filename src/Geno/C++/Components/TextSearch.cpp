@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "TextSearch.h"
+
+#include <Common/Async/JobSystem.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+#if defined( __SSE2__ ) || defined( _M_AMD64 ) || defined( _M_X64 )
+#include <emmintrin.h>
+#define TEXT_SEARCH_SSE2
+#endif // __SSE2__ || _M_AMD64 || _M_X64
+
+//////////////////////////////////////////////////////////////////////////
+
+static constexpr size_t SliceSize = 1 << 20; // Matches are handed over after every slice
+
+// Lowercase for ASCII letters, everything else (including UTF-8) is left as it is
+static constexpr std::array< unsigned char, 256 > FoldTable = []( void )
+{
+	std::array< unsigned char, 256 > Table = { };
+
+	for( size_t i = 0; i < Table.size(); ++i )
+		Table[ i ] = static_cast< unsigned char >( ( i >= 'A' && i <= 'Z' ) ? i + ( 'a' - 'A' ) : i );
+
+	return Table;
+
+}();
+
+//////////////////////////////////////////////////////////////////////////
+
+static char Fold( char C )
+{
+	return static_cast< char >( FoldTable[ static_cast< unsigned char >( C ) ] );
+
+} // Fold
+
+//////////////////////////////////////////////////////////////////////////
+
+static char OtherCase( char C )
+{
+	if( C >= 'a' && C <= 'z' ) return static_cast< char >( C - ( 'a' - 'A' ) );
+	if( C >= 'A' && C <= 'Z' ) return static_cast< char >( C + ( 'a' - 'A' ) );
+
+	return C;
+
+} // OtherCase
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool IsWordCharacter( char C )
+{
+	return C == '_' || ( C >= 'a' && C <= 'z' ) || ( C >= 'A' && C <= 'Z' ) || ( C >= '0' && C <= '9' );
+
+} // IsWordCharacter
+
+//////////////////////////////////////////////////////////////////////////
+
+// A whole word can't go on at either side of the match
+static bool IsWholeWord( std::string_view Text, size_t Start, size_t End )
+{
+	if( IsWordCharacter( Text[ Start ] ) && Start > 0 && IsWordCharacter( Text[ Start - 1 ] ) )
+		return false;
+
+	return !( IsWordCharacter( Text[ End - 1 ] ) && End < Text.size() && IsWordCharacter( Text[ End ] ) );
+
+} // IsWholeWord
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool EqualFolded( const char* pA, const char* pB, size_t Length )
+{
+	for( size_t i = 0; i < Length; ++i )
+	{
+		if( Fold( pA[ i ] ) != Fold( pB[ i ] ) )
+			return false;
+	}
+
+	return true;
+
+} // EqualFolded
+
+//////////////////////////////////////////////////////////////////////////
+
+TextSearch::~TextSearch( void )
+{
+	Stop();
+
+} // ~TextSearch
+
+//////////////////////////////////////////////////////////////////////////
+
+bool TextSearch::Start( const TextBuffer& rBuffer, Criteria Search )
+{
+	Stop();
+	m_Error.clear();
+	m_Criteria = { };
+
+	if( Search.Text.empty() )
+		return true;
+
+	if( Search.RegularExpression && !m_Pattern.Compile( Search.Text, Search.CaseSensitive ) )
+	{
+		m_Error = m_Pattern.Error();
+		return false;
+	}
+
+	m_Criteria = Search;
+
+	std::shared_ptr< Scan > pScan = std::make_shared< Scan >();
+	pScan->Snapshot               = rBuffer.TakeSnapshot();
+	pScan->Search                 = std::move( Search );
+	pScan->Pattern                = m_Pattern;
+	m_Version                     = pScan->Snapshot.Version();
+
+	// The job keeps its own reference, so a search that is stopped (or whose file is closed) only makes the job return early
+	JobSystem::Instance().NewJob( [ pScan ]( void )
+		{
+			Run( *pScan );
+			pScan->Done.store( true, std::memory_order_release );
+		} );
+
+	m_pScan = std::move( pScan );
+
+	return true;
+
+} // Start
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextSearch::Stop( void )
+{
+	if( m_pScan )
+		m_pScan->Cancel.store( true, std::memory_order_relaxed );
+
+	m_pScan.reset();
+
+} // Stop
+
+//////////////////////////////////////////////////////////////////////////
+
+bool TextSearch::Poll( std::vector< Match >& rMatches )
+{
+	if( !m_pScan )
+		return false;
+
+	// Done has to be read before the matches, or the last of them could be left behind
+	const bool Done = m_pScan->Done.load( std::memory_order_acquire );
+
+	{
+		std::scoped_lock Lock( m_pScan->Mutex );
+
+		rMatches.insert( rMatches.end(), m_pScan->Found.begin(), m_pScan->Found.end() );
+		m_pScan->Found.clear();
+	}
+
+	if( Done )
+		m_pScan.reset();
+
+	return Done;
+
+} // Poll
+
+//////////////////////////////////////////////////////////////////////////
+
+size_t TextSearch::Find( std::string_view Haystack, std::string_view Needle, bool CaseSensitive, size_t Offset )
+{
+	if( Needle.empty() || Haystack.size() < Needle.size() || Offset > Haystack.size() - Needle.size() )
+		return std::string_view::npos;
+
+	const size_t LastStart = Haystack.size() - Needle.size();
+	const char   First     = CaseSensitive ? Needle.front() : Fold( Needle.front() );
+	const char   Last      = CaseSensitive ? Needle.back() : Fold( Needle.back() );
+
+	auto Matches = [ & ]( size_t Start )
+	{
+		if( CaseSensitive )
+			return memcmp( Haystack.data() + Start, Needle.data(), Needle.size() ) == 0;
+
+		return EqualFolded( Haystack.data() + Start, Needle.data(), Needle.size() );
+	};
+
+#if defined( TEXT_SEARCH_SSE2 )
+
+	// Without case sensitivity, a letter is compared against both of its cases
+	const __m128i FirstA = _mm_set1_epi8( First );
+	const __m128i FirstB = _mm_set1_epi8( CaseSensitive ? First : OtherCase( First ) );
+	const __m128i LastA  = _mm_set1_epi8( Last );
+	const __m128i LastB  = _mm_set1_epi8( CaseSensitive ? Last : OtherCase( Last ) );
+
+	for( ; Offset + 16 <= LastStart + 1; Offset += 16 )
+	{
+		const __m128i FirstBlock = _mm_loadu_si128( reinterpret_cast< const __m128i* >( Haystack.data() + Offset ) );
+		const __m128i LastBlock  = _mm_loadu_si128( reinterpret_cast< const __m128i* >( Haystack.data() + Offset + Needle.size() - 1 ) );
+		const __m128i FirstHits  = _mm_or_si128( _mm_cmpeq_epi8( FirstBlock, FirstA ), _mm_cmpeq_epi8( FirstBlock, FirstB ) );
+		const __m128i LastHits   = _mm_or_si128( _mm_cmpeq_epi8( LastBlock, LastA ), _mm_cmpeq_epi8( LastBlock, LastB ) );
+		unsigned      Mask       = static_cast< unsigned >( _mm_movemask_epi8( _mm_and_si128( FirstHits, LastHits ) ) );
+
+		for( ; Mask != 0; Mask &= Mask - 1 )
+		{
+			const size_t Start = Offset + static_cast< size_t >( std::countr_zero( Mask ) );
+
+			if( Matches( Start ) )
+				return Start;
+		}
+	}
+
+#endif // TEXT_SEARCH_SSE2
+
+	// The remainder (or everything, without SSE2)
+	for( ; Offset <= LastStart; ++Offset )
+	{
+		const char C = Haystack[ Offset ];
+
+		if( ( C == First || ( !CaseSensitive && Fold( C ) == First ) ) && Matches( Offset ) )
+			return Offset;
+	}
+
+	return std::string_view::npos;
+
+} // Find
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextSearch::SearchLine( std::string_view Line, size_t LineIndex, std::vector< Match >& rMatches )
+{
+	if( m_Criteria.Text.empty() )
+		return;
+
+	SearchText( Line, m_Criteria, m_Pattern, LineIndex, rMatches );
+
+} // SearchLine
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextSearch::SearchText( std::string_view Text, const Criteria& rSearch, Regex& rPattern, size_t& rLine, std::vector< Match >& rFound )
+{
+	// Regular expressions are matched a line at a time. Empty matches are passed over, since there would be nothing to show for them.
+	if( rSearch.RegularExpression )
+	{
+		Regex::Match Hit;
+
+		for( size_t LineStart = 0; LineStart < Text.size(); )
+		{
+			const size_t     Break    = std::min( Text.find( '\n', LineStart ), Text.size() );
+			std::string_view LineText = Text.substr( LineStart, Break - LineStart );
+
+			for( size_t Offset = 0; Offset <= LineText.size() && rPattern.Find( LineText, Offset, Hit ); )
+			{
+				if( Hit.End > Hit.Start && ( !rSearch.WholeWord || IsWholeWord( LineText, Hit.Start, Hit.End ) ) )
+				{
+					rFound.push_back( Match{ rLine, Hit.Start, Hit.End - Hit.Start } );
+					Offset = Hit.End;
+					continue;
+				}
+
+				// On to the next character, not into the middle of this one
+				Offset = Hit.Start + 1;
+
+				while( Offset < LineText.size() && ( LineText[ Offset ] & 0xC0 ) == 0x80 )
+					++Offset;
+			}
+
+			if( Break < Text.size() )
+				++rLine;
+
+			LineStart = Break + 1;
+		}
+
+		return;
+	}
+
+	size_t LineStart = 0;
+	size_t Counted   = 0;
+
+	for( size_t Hit = 0; ( Hit = Find( Text, rSearch.Text, rSearch.CaseSensitive, Hit ) ) != std::string_view::npos; )
+	{
+		for( const void* pBreak; ( pBreak = memchr( Text.data() + Counted, '\n', Hit - Counted ) ) != nullptr; )
+		{
+			LineStart = static_cast< size_t >( static_cast< const char* >( pBreak ) - Text.data() ) + 1;
+			Counted   = LineStart;
+			++rLine;
+		}
+
+		Counted = Hit;
+
+		const size_t End = Hit + rSearch.Text.size();
+
+		if( rSearch.WholeWord && !IsWholeWord( Text, Hit, End ) )
+		{
+			++Hit;
+			continue;
+		}
+
+		rFound.push_back( Match{ rLine, Hit - LineStart, rSearch.Text.size() } );
+
+		Hit = End;
+	}
+
+	rLine += static_cast< size_t >( std::count( Text.begin() + Counted, Text.end(), '\n' ) );
+
+} // SearchText
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextSearch::Run( Scan& rScan )
+{
+	std::vector< Match > Found;
+	std::string          Carry; // The start of a line that goes on in the next chunk
+	size_t               Line = 0;
+
+	// Text always starts at the start of a line, and ends with a line break (or the end of the buffer)
+	auto SearchLines = [ & ]( std::string_view Text )
+	{
+		SearchText( Text, rScan.Search, rScan.Pattern, Line, Found );
+	};
+
+	auto HandOver = [ & ]( void )
+	{
+		if( Found.empty() )
+			return;
+
+		std::scoped_lock Lock( rScan.Mutex );
+
+		rScan.Found.insert( rScan.Found.end(), Found.begin(), Found.end() );
+		Found.clear();
+	};
+
+	for( std::string_view Chunk : rScan.Snapshot.Chunks() )
+	{
+		while( !Chunk.empty() )
+		{
+			if( rScan.Cancel.load( std::memory_order_relaxed ) )
+				return;
+
+			// Slices end at a line break, so that no line is split between two of them
+			const size_t     Break = Chunk.find( '\n', std::min( Chunk.size(), SliceSize ) - 1 );
+			std::string_view Slice = Chunk.substr( 0, Break == std::string_view::npos ? Chunk.size() : Break + 1 );
+
+			Chunk.remove_prefix( Slice.size() );
+
+			if( Slice.back() != '\n' )
+			{
+				Carry.append( Slice );
+				continue;
+			}
+
+			// The line that was started in an earlier chunk is finished first, on its own
+			if( !Carry.empty() )
+			{
+				const size_t FirstBreak = Slice.find( '\n' ) + 1;
+
+				Carry.append( Slice.substr( 0, FirstBreak ) );
+				Slice.remove_prefix( FirstBreak );
+
+				SearchLines( Carry );
+				Carry.clear();
+			}
+
+			SearchLines( Slice );
+			HandOver();
+		}
+	}
+
+	SearchLines( Carry );
+	HandOver();
+
+} // Run
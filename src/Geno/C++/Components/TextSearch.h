@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include "Components/Regex.h"
+#include "Components/TextBuffer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Finds every occurrence of a piece of text in a TextBuffer. The search runs as a job over a snapshot of the buffer, so the buffer can
+// be edited while it runs, and it hands over what it has found every slice of text so that the first matches show up long before a big
+// file has been searched through. Candidates are found by comparing the first and the last byte of the needle against 16 positions at
+// a time, with ASCII letters folded to both cases, so only a few positions are ever compared in full. Regular expressions are matched
+// line by line instead (see Regex). Matches never span lines, and they are on the lines of the text as it was when the search started,
+// which TextBuffer::MapLine() moves to where they are now.
+class TextSearch
+{
+public:
+
+	struct Criteria
+	{
+		std::string Text;
+		bool        CaseSensitive     = false;
+		bool        WholeWord         = false;
+		bool        RegularExpression = false;
+
+		bool operator==( const Criteria& ) const = default;
+
+	}; // Criteria
+
+	struct Match
+	{
+		size_t Line;
+		size_t Column;
+		size_t Length;
+
+	}; // Match
+
+//////////////////////////////////////////////////////////////////////////
+
+	~TextSearch( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Starting a search stops the one before it. Returns false (with an Error()) if the regular expression doesn't compile.
+	bool Start( const TextBuffer& rBuffer, Criteria Search );
+	void Stop ( void );
+
+	// Moves the matches that were found since the last call to the end of rMatches, in the order they are in. Returns true once, when the
+	// search has finished and all of its matches have been handed over.
+	bool Poll( std::vector< Match >& rMatches );
+
+	// Searches a single line for what the last search was started with, right away. This is how the matches of the lines that were
+	// edited since the search started are brought up to date.
+	void SearchLine( std::string_view Line, size_t LineIndex, std::vector< Match >& rMatches );
+
+	const std::string& Error      ( void ) const { return m_Error; }
+	bool               IsSearching( void ) const { return m_pScan != nullptr; }
+	uint64_t           Version    ( void ) const { return m_Version; } // Of the snapshot that the last search went through
+
+//////////////////////////////////////////////////////////////////////////
+
+	static size_t Find( std::string_view Haystack, std::string_view Needle, bool CaseSensitive, size_t Offset = 0 );
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	// Shared with the job, which may outlive the search that started it
+	struct Scan
+	{
+		TextBuffer::Snapshot Snapshot;
+		Criteria             Search;
+		Regex                Pattern;          // The job's own, since the DFA is built as it goes
+
+		std::mutex           Mutex;
+		std::vector< Match > Found;            // Not yet handed over, guarded by Mutex
+		std::atomic< bool >  Done      = false;
+		std::atomic< bool >  Cancel    = false;
+
+	}; // Scan
+
+//////////////////////////////////////////////////////////////////////////
+
+	static void SearchText( std::string_view Text, const Criteria& rSearch, Regex& rPattern, size_t& rLine, std::vector< Match >& rFound );
+	static void Run       ( Scan& rScan );
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::shared_ptr< Scan > m_pScan;
+	Criteria                m_Criteria;
+	Regex                   m_Pattern;  // Copied into every scan, which builds its own DFA
+	std::string             m_Error;
+	uint64_t                m_Version = 0;
+
+}; // TextSearch
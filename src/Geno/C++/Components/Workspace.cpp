@@ -19,9 +19,13 @@
 
 #include "Compilers/CompilerGCC.h"
 #include "Compilers/CompilerMSVC.h"
+#include "Compilers/RemoteCache.h"
+#include "Compilers/WorkerPool.h"
+#include "Components/BuildInsights.h"
 #include "GUI/Widgets/StatusBar.h"
 
 #include <iostream>
+#include <map>
 
 #include <Common/Async/JobSystem.h>
 #include <GCL/Deserializer.h>
@@ -29,6 +33,156 @@
 
 //////////////////////////////////////////////////////////////////////////
 
+// A source file that is compiled as part of a build
+struct TranslationUnit
+{
+	std::filesystem::path                          File;
+	std::shared_ptr< std::optional< ModuleUnit > > Module     = std::make_shared< std::optional< ModuleUnit > >();
+	std::shared_ptr< std::filesystem::path >       Output     = std::make_shared< std::filesystem::path >();
+	JobSystem::JobPtr                              CompileJob = nullptr;
+	bool                                           Visiting   = false;
+
+}; // TranslationUnit
+
+//////////////////////////////////////////////////////////////////////////
+
+struct ProjectBuild
+{
+	Configuration                  ProjectConfiguration;
+	std::string                    Name;
+	Project::Kind                  Kind;
+	std::vector< TranslationUnit > Units;
+
+}; // ProjectBuild
+
+//////////////////////////////////////////////////////////////////////////
+
+using ModuleProviders = std::map< std::string, std::pair< ProjectBuild*, TranslationUnit* > >;
+
+//////////////////////////////////////////////////////////////////////////
+
+// Returns nothing if the unit can't be ordered after the interfaces that it imports, in which case the build can't go on
+static JobSystem::JobPtr ScheduleCompile( ProjectBuild& rProject, TranslationUnit& rUnit, ModuleProviders& rProviders )
+{
+	if( rUnit.CompileJob )
+		return rUnit.CompileJob;
+
+	std::vector< JobSystem::JobPtr > Dependencies;
+
+	// Interface units must be compiled before the units that import them, so make sure that their jobs exist to be depended upon
+	if( const std::optional< ModuleUnit >& rModule = *rUnit.Module )
+	{
+		if( rUnit.Visiting )
+		{
+			std::cerr << "Circular module dependency detected in " << rUnit.File << "\n";
+			return nullptr;
+		}
+
+		rUnit.Visiting = true;
+
+		for( const std::string& rRequired : rModule->Requires )
+		{
+			auto& [ pProviderProject, pProviderUnit ] = rProviders.at( rRequired );
+
+			if( JobSystem::JobPtr Job = ScheduleCompile( *pProviderProject, *pProviderUnit, rProviders ) )
+			{
+				Dependencies.push_back( std::move( Job ) );
+			}
+			else
+			{
+				// Left set, the next unit that imports this one would take it for a cycle of its own
+				rUnit.Visiting = false;
+				return nullptr;
+			}
+		}
+
+		rUnit.Visiting = false;
+	}
+
+	rUnit.CompileJob = JobSystem::Instance().NewJob(
+		[ Configuration = rProject.ProjectConfiguration, File = rUnit.File, Module = rUnit.Module, Output = rUnit.Output ]( void )
+		{
+			if( !Configuration.m_Compiler )
+			{
+				std::cerr << "Failed to compile " << File << ". No compiler active!\n";
+				return;
+			}
+
+			const ModuleUnit* pModule = ( *Module && ( *Module )->UsesModules() ) ? &**Module : nullptr;
+
+			// The compiler runs on its own, so this job only counts as done once the object file is in
+			JobSystem::JobPtr Job = JobSystem::Instance().Defer();
+
+			Configuration.m_Compiler->Compile( Configuration, File, pModule, [ Job, Output ]( std::optional< std::filesystem::path > Result )
+				{
+					if( Result )
+						*Output = *Result;
+
+					if( Job )
+						Job->Finish();
+				}
+			);
+		},
+		Dependencies
+	);
+
+	return rUnit.CompileJob;
+
+} // ScheduleCompile
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool ResolveModules( std::vector< ProjectBuild >& rProjects, ModuleProviders& rProviders )
+{
+	bool Success = true;
+
+	// Map every module to the unit that provides its interface
+	for( ProjectBuild& rProject : rProjects )
+	{
+		for( TranslationUnit& rUnit : rProject.Units )
+		{
+			if( std::optional< ModuleUnit >& rModule = *rUnit.Module; rModule && rModule->IsInterface() )
+			{
+				rModule->ProvidedInterface = rProject.ProjectConfiguration.m_Compiler->GetModuleInterfaceOutputPath( rProject.ProjectConfiguration, rModule->Provides );
+
+				if( !rProviders.emplace( rModule->Provides, std::make_pair( &rProject, &rUnit ) ).second )
+				{
+					std::cerr << "Module '" << rModule->Provides << "' is provided by more than one file (" << rUnit.File << ")\n";
+					Success = false;
+				}
+			}
+		}
+	}
+
+	// Resolve where the interface of each imported module will be
+	for( ProjectBuild& rProject : rProjects )
+	{
+		for( TranslationUnit& rUnit : rProject.Units )
+		{
+			if( std::optional< ModuleUnit >& rModule = *rUnit.Module )
+			{
+				for( const std::string& rRequired : rModule->Requires )
+				{
+					auto Provider = rProviders.find( rRequired );
+					if( Provider == rProviders.end() )
+					{
+						std::cerr << "Module '" << rRequired << "' imported by " << rUnit.File << " is not provided by any project\n";
+						Success = false;
+						continue;
+					}
+
+					rModule->RequiredInterfaces.push_back( ( *Provider->second.second->Module )->ProvidedInterface );
+				}
+			}
+		}
+	}
+
+	return Success;
+
+} // ResolveModules
+
+//////////////////////////////////////////////////////////////////////////
+
 Workspace::Workspace( std::filesystem::path Location )
 	: m_Location( std::move( Location ) )
 	, m_Name    ( "MyWorkspace" )
@@ -37,14 +191,12 @@ Workspace::Workspace( std::filesystem::path Location )
 
 //////////////////////////////////////////////////////////////////////////
 
-void Workspace::Build( void )
+void Workspace::Build( bool CollectInsights )
 {
 	if( !m_Projects.empty() )
 	{
-		UTF8Converter                            UTF8Converter;
-		std::vector< JobSystem::JobPtr >         LinkerJobs;
-		std::vector< std::string >               LinkerJobProjectNames;
-		std::shared_ptr< std::filesystem::path > LinkerOutput = std::make_shared< std::filesystem::path >();
+		std::shared_ptr< std::vector< ProjectBuild > > ProjectBuilds = std::make_shared< std::vector< ProjectBuild > >();
+		std::vector< JobSystem::JobPtr >               ScanJobs;
 
 		// Sort projects so that the link jobs exist to be depended upon
 		std::vector< std::reference_wrapper< Project > > ProjectRefs;
@@ -58,14 +210,16 @@ void Workspace::Build( void )
 
 		for( Project& rProject : ProjectRefs )
 		{
-			Configuration                                           Configuration = m_BuildMatrix.CurrentConfiguration();
-			std::vector< JobSystem::JobPtr >                        LinkerDependencies;
-			std::vector< std::shared_ptr< std::filesystem::path > > CompilerOutputs;
+			ProjectBuild&  rBuild         = ProjectBuilds->emplace_back();
+			Configuration& rConfiguration = rBuild.ProjectConfiguration;
 
-			Configuration.Override( rProject.m_LocalConfiguration );
+			rConfiguration = ProjectConfiguration( rProject );
 
-			if( !Configuration.m_OutputDir )
-				Configuration.m_OutputDir = rProject.m_Location;
+			if( CollectInsights )
+				rConfiguration.m_BuildInsights = true;
+
+			rBuild.Name = rProject.m_Name;
+			rBuild.Kind = rProject.m_Kind;
 
 			// TODO: Remove any duplicate files, since a single file can exist in multiple filters
 
@@ -81,79 +235,165 @@ void Workspace::Build( void )
 					 && Extension != ".cc"
 					 && Extension != ".cpp"
 					 && Extension != ".cxx"
-					 && Extension != ".c++" )
+					 && Extension != ".c++"
+					 && Extension != ".cppm"
+					 && Extension != ".ixx" )
 						continue;
 
-					auto Output = std::make_shared< std::filesystem::path >();
-
-					CompilerOutputs.push_back( Output );
+					TranslationUnit& rUnit = rBuild.Units.emplace_back();
+					rUnit.File             = rFile;
 
-					LinkerDependencies.push_back( JobSystem::Instance().NewJob(
-						[ Configuration, rFile, Output ]( void )
-						{
-							if( !Configuration.m_Compiler )
+					// Scan C++ sources for module dependencies in parallel. The results decide the order in which the units must be compiled.
+					if( Extension != ".c" && rConfiguration.m_Compiler && rConfiguration.m_Compiler->SupportsModules() )
+					{
+						ScanJobs.push_back( JobSystem::Instance().NewJob(
+							[ Configuration = rConfiguration, File = rUnit.File, Module = rUnit.Module ]( void )
 							{
-								std::cerr << "Failed to compile " << rFile << ". No compiler active!\n";
-								return;
-							}
+								if( !ModuleScanner::MightUseModules( File ) )
+									return;
 
-							if( auto Result = Configuration.m_Compiler->Compile( Configuration, rFile ) )
-							{
-								*Output = *Result;
+								JobSystem::JobPtr Job = JobSystem::Instance().Defer();
+
+								Configuration.m_Compiler->ScanModules( Configuration, File, [ Job, Module ]( std::optional< ModuleUnit > Unit )
+									{
+										*Module = std::move( Unit );
+
+										if( Job )
+											Job->Finish();
+									}
+								);
 							}
-						}
-					) );
+						) );
+					}
 				}
 			}
+		}
 
-			// Assemble a list of link jobs for projects that this depends on
-			for( std::string& rLibrary : Configuration.m_Libraries )
+		// Once every unit has been scanned, build the job graph
+		JobSystem::Instance().NewJob(
+			[ this, ProjectBuilds, CollectInsights ]( void )
 			{
-				auto Name = std::find( LinkerJobProjectNames.begin(), LinkerJobProjectNames.end(), rLibrary );
-				if( Name != LinkerJobProjectNames.end() )
-					LinkerDependencies.push_back( *std::next( LinkerJobs.begin(), std::distance( LinkerJobProjectNames.begin(), Name ) ) );
-			}
+				UTF8Converter                            UTF8Converter;
+				ModuleProviders                          Providers;
+				std::vector< JobSystem::JobPtr >         LinkerJobs;
+				std::vector< std::string >               LinkerJobProjectNames;
+				std::shared_ptr< std::filesystem::path > LinkerOutput = std::make_shared< std::filesystem::path >();
 
-			const std::wstring  ProjectName = UTF8Converter.from_bytes( rProject.m_Name );
-			const Project::Kind Kind        = rProject.m_Kind;
-
-			LinkerJobProjectNames.push_back( rProject.m_Name );
-			LinkerJobs.push_back( JobSystem::Instance().NewJob(
-				[ Configuration, ProjectName, Kind, CompilerOutputs, LinkerOutput ]( void )
+				if( !ResolveModules( *ProjectBuilds, Providers ) )
 				{
-					std::vector< std::filesystem::path > InputFiles;
+					std::cout << "Failed to build workspace\n";
 
-					for( auto& rInputFile : CompilerOutputs )
-						if( !rInputFile->empty() )
-							InputFiles.emplace_back( std::move( *rInputFile ) );
+					Events.BuildFinished( *this, "", false );
+					return;
+				}
 
-					if( !InputFiles.empty() )
+				// Pick up the workers and cache that are available right now, and make sure that there are enough threads to keep every slot busy
+				WorkerPool::Instance().Refresh();
+				RemoteCache::Instance().Refresh();
+				JobSystem::Instance().ReserveThreads( WorkerPool::Instance().TotalSlots() );
+
+				// A unit left out of the job graph would be left out of the link as well, so schedule every unit before any link job exists
+				for( ProjectBuild& rBuild : *ProjectBuilds )
+				{
+					for( TranslationUnit& rUnit : rBuild.Units )
 					{
-						if( auto Result = Configuration.m_Compiler->Link( Configuration, InputFiles, ProjectName, Kind ) )
-							*LinkerOutput = *Result;
+						if( !ScheduleCompile( rBuild, rUnit, Providers ) )
+						{
+							std::cout << "Failed to build workspace\n";
+
+							Events.BuildFinished( *this, "", false );
+							return;
+						}
 					}
-				},
-				LinkerDependencies
-			) );
-		}
+				}
 
-		JobSystem::Instance().NewJob(
-			[ this, LinkerJobs, LinkerOutput ]( void )
-			{
-				if( auto& rLinkerOutput = *LinkerOutput; !rLinkerOutput.empty() )
+				for( ProjectBuild& rBuild : *ProjectBuilds )
 				{
-					std::cout << "Done building workspace\n";
+					std::vector< JobSystem::JobPtr >                        LinkerDependencies;
+					std::vector< std::shared_ptr< std::filesystem::path > > CompilerOutputs;
+
+					for( TranslationUnit& rUnit : rBuild.Units )
+					{
+						LinkerDependencies.push_back( rUnit.CompileJob );
+						CompilerOutputs.push_back( rUnit.Output );
+					}
+
+					// Assemble a list of link jobs for projects that this depends on
+					for( std::string& rLibrary : rBuild.ProjectConfiguration.m_Libraries )
+					{
+						auto Name = std::find( LinkerJobProjectNames.begin(), LinkerJobProjectNames.end(), rLibrary );
+						if( Name != LinkerJobProjectNames.end() )
+							LinkerDependencies.push_back( *std::next( LinkerJobs.begin(), std::distance( LinkerJobProjectNames.begin(), Name ) ) );
+					}
+
+					const std::wstring  ProjectName   = UTF8Converter.from_bytes( rBuild.Name );
+					const Project::Kind Kind          = rBuild.Kind;
+					const Configuration Configuration = rBuild.ProjectConfiguration;
+
+					LinkerJobProjectNames.push_back( rBuild.Name );
+					LinkerJobs.push_back( JobSystem::Instance().NewJob(
+						[ Configuration, ProjectName, Kind, CompilerOutputs, LinkerOutput ]( void )
+						{
+							std::vector< std::filesystem::path > InputFiles;
+
+							for( auto& rInputFile : CompilerOutputs )
+								if( !rInputFile->empty() )
+									InputFiles.emplace_back( std::move( *rInputFile ) );
+
+							if( InputFiles.empty() )
+								return;
 
-					Events.BuildFinished( *this, rLinkerOutput, true );
+							JobSystem::JobPtr Job = JobSystem::Instance().Defer();
+
+							Configuration.m_Compiler->Link( Configuration, InputFiles, ProjectName, Kind, [ Job, LinkerOutput ]( std::optional< std::filesystem::path > Result )
+								{
+									if( Result )
+										*LinkerOutput = *Result;
+
+									if( Job )
+										Job->Finish();
+								}
+							);
+						},
+						LinkerDependencies
+					) );
 				}
-				else
-				{
-					std::cout << "Failed to build workspace\n";
 
-					Events.BuildFinished( *this, "", false );
+				// Traces of the units that were compiled with build insights enabled
+				std::vector< BuildInsights::TraceFile > InsightsTraces;
+
+				if( CollectInsights )
+				{
+					for( const ProjectBuild& rBuild : *ProjectBuilds )
+					{
+						for( const TranslationUnit& rUnit : rBuild.Units )
+							InsightsTraces.emplace_back( rUnit.File, ICompiler::GetInsightsOutputPath( rBuild.ProjectConfiguration, rUnit.File ) );
+					}
 				}
+
+				JobSystem::Instance().NewJob(
+					[ this, LinkerJobs, LinkerOutput, InsightsTraces ]( void )
+					{
+						if( !InsightsTraces.empty() )
+							BuildInsights::Instance().Analyze( InsightsTraces, m_Location );
+
+						if( auto& rLinkerOutput = *LinkerOutput; !rLinkerOutput.empty() )
+						{
+							std::cout << "Done building workspace\n";
+
+							Events.BuildFinished( *this, rLinkerOutput, true );
+						}
+						else
+						{
+							std::cout << "Failed to build workspace\n";
+
+							Events.BuildFinished( *this, "", false );
+						}
+					},
+					LinkerJobs
+				);
 			},
-			LinkerJobs
+			ScanJobs
 		);
 	}
 
@@ -329,6 +569,42 @@ void Workspace::RenameProject( const std::string& rProjectName, std::string Name
 
 //////////////////////////////////////////////////////////////////////////
 
+Configuration Workspace::ProjectConfiguration( const Project& rProject ) const
+{
+	Configuration Result = m_BuildMatrix.CurrentConfiguration();
+	Result.Override( rProject.m_LocalConfiguration );
+
+	if( !Result.m_OutputDir )
+		Result.m_OutputDir = rProject.m_Location;
+
+	return Result;
+
+} // ProjectConfiguration
+
+//////////////////////////////////////////////////////////////////////////
+
+std::vector< std::filesystem::path > Workspace::TestExecutables( void ) const
+{
+	std::vector< std::filesystem::path > Executables;
+	UTF8Converter                        UTF8;
+
+	for( const Project& rProject : m_Projects )
+	{
+		if( rProject.m_Kind != Project::Kind::Application || !rProject.HasTag( Project::TEST_TAG ) )
+			continue;
+
+		const Configuration Configuration = ProjectConfiguration( rProject );
+		const std::wstring  ProjectName   = UTF8.from_bytes( rProject.m_Name );
+
+		Executables.push_back( ICompiler::GetLinkerOutputPath( Configuration, ProjectName, rProject.m_Kind ) );
+	}
+
+	return Executables;
+
+} // TestExecutables
+
+//////////////////////////////////////////////////////////////////////////
+
 void Workspace::GCLObjectCallback( GCL::Object pObject, void* pUser )
 {
 	Workspace*       pSelf = ( Workspace* )pUser;
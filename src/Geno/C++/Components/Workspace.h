@@ -48,7 +48,7 @@ public:
 
 //////////////////////////////////////////////////////////////////////////
 
-	void Build      ( void );
+	void Build      ( bool CollectInsights = false );
 	bool Serialize  ( void );
 	bool Deserialize( void );
 
@@ -61,6 +61,11 @@ public:
 	void     RemoveProject( const std::string& rName );
 	void     RenameProject( const std::string& rProjectName, std::string Name );
 
+//////////////////////////////////////////////////////////////////////////
+
+	Configuration                        ProjectConfiguration( const Project& rProject ) const;
+	std::vector< std::filesystem::path > TestExecutables     ( void ) const;
+
 //////////////////////////////////////////////////////////////////////////
 
 	struct
@@ -75,7 +80,6 @@ public:
 	std::filesystem::path      m_Location;
 	std::string                m_Name;
 	std::vector< Project >     m_Projects;
-	std::unique_ptr< Process > m_AppProcess;
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -28,6 +28,9 @@
 #include "GUI/Widgets/WorkspaceOutliner.h"
 #include "GUI/Widgets/StatusBar.h"
 #include "GUI/Widgets/FindInWorkspace.h"
+#include "GUI/Widgets/BuildInsightsWindow.h"
+#include "GUI/Widgets/RunWindow.h"
+#include "GUI/Widgets/TestWindow.h"
 #include "GUI/Styles.h"
 
 #include <iostream>
@@ -164,11 +167,14 @@ MainWindow::MainWindow( void )
 	ImGui_ImplOpenGL3_Init( "#version 330 core" );
 
 	// Create widgets
-	pTitleBar          = new TitleBar();
-	pWorkspaceOutliner = new WorkspaceOutliner();
-	pTextEdit          = new TextEdit();
-	pOutputWindow      = new OutputWindow();
-	pFindInWorkspace   = new FindInWorkspace();
+	pTitleBar            = new TitleBar();
+	pWorkspaceOutliner   = new WorkspaceOutliner();
+	pTextEdit            = new TextEdit();
+	pOutputWindow        = new OutputWindow();
+	pFindInWorkspace     = new FindInWorkspace();
+	pBuildInsightsWindow = new BuildInsightsWindow();
+	pRunWindow           = new RunWindow();
+	pTestWindow          = new TestWindow();
 
 } // MainWindow
 
@@ -182,6 +188,9 @@ MainWindow::~MainWindow( void )
 	delete pWorkspaceOutliner;
 	delete pTitleBar;
 	delete pFindInWorkspace;
+	delete pBuildInsightsWindow;
+	delete pRunWindow;
+	delete pTestWindow;
 
 #if defined( _WIN32 )
 
@@ -252,10 +261,13 @@ void MainWindow::Render( void )
 
 	if( pTitleBar->ShowDemoWindow                 ) ImGui::ShowDemoWindow(    &pTitleBar->ShowDemoWindow );
 	if( pTitleBar->ShowAboutWindow                ) ImGui::ShowAboutWindow(   &pTitleBar->ShowAboutWindow );
-	if( pTitleBar->ShowWorkspaceOutliner          ) pWorkspaceOutliner->Show( &pTitleBar->ShowWorkspaceOutliner );
-	if( pTitleBar->ShowTextEdit                   ) pTextEdit         ->Show( &pTitleBar->ShowTextEdit );
-	if( pTitleBar->ShowOutputWindow               ) pOutputWindow     ->Show( &pTitleBar->ShowOutputWindow );
-	if( pTitleBar->ShowFindInWorkspaceWindow      ) pFindInWorkspace  ->Show( &pTitleBar->ShowFindInWorkspaceWindow );
+	if( pTitleBar->ShowWorkspaceOutliner          ) pWorkspaceOutliner  ->Show( &pTitleBar->ShowWorkspaceOutliner );
+	if( pTitleBar->ShowTextEdit                   ) pTextEdit           ->Show( &pTitleBar->ShowTextEdit );
+	if( pTitleBar->ShowOutputWindow               ) pOutputWindow       ->Show( &pTitleBar->ShowOutputWindow );
+	if( pTitleBar->ShowFindInWorkspaceWindow      ) pFindInWorkspace    ->Show( &pTitleBar->ShowFindInWorkspaceWindow );
+	if( pTitleBar->ShowBuildInsights              ) pBuildInsightsWindow->Show( &pTitleBar->ShowBuildInsights );
+	if( pTitleBar->ShowRunWindow                  ) pRunWindow          ->Show( &pTitleBar->ShowRunWindow );
+	if( pTitleBar->ShowTestWindow                 ) pTestWindow         ->Show( &pTitleBar->ShowTestWindow );
 
 	StatusBar::Instance().Show();
 
@@ -436,10 +448,16 @@ void MainWindow::ImGuiSettingsReadLineCB( ImGuiContext* /*pContext*/, ImGuiSetti
 	MainWindow*           pSelf = ( MainWindow* )pHandler->UserData;
 	const char*           pName = ( const char* )pEntry;
 	int                   Bool;
+	size_t                Lines;
 
 	if(      strcmp( pName, "Text Edit" ) == 0 ) { if( sscanf( pLine, "Active=%d", &Bool ) == 1 ) pSelf->pTitleBar->ShowTextEdit          = Bool; }
 	else if( strcmp( pName, "Workspace" ) == 0 ) { if( sscanf( pLine, "Active=%d", &Bool ) == 1 ) pSelf->pTitleBar->ShowWorkspaceOutliner = Bool; }
 	else if( strcmp( pName, "Output"    ) == 0 ) { if( sscanf( pLine, "Active=%d", &Bool ) == 1 ) pSelf->pTitleBar->ShowOutputWindow      = Bool; }
+	else if( strcmp( pName, "Run"       ) == 0 ) { if( sscanf( pLine, "Active=%d", &Bool ) == 1 ) pSelf->pTitleBar->ShowRunWindow         = Bool; }
+	else if( strcmp( pName, "Test"      ) == 0 ) { if( sscanf( pLine, "Active=%d", &Bool ) == 1 ) pSelf->pTitleBar->ShowTestWindow        = Bool; }
+
+	// Load Output Settings
+	if( strcmp( pName, "Output Log" ) == 0 && sscanf( pLine, "Scrollback=%zu", &Lines ) == 1 ) { pSelf->pOutputWindow->SetScrollbackLines( Lines ); }
 
 	// Load Recent Workspaces
 	if( strncmp( pLine, "Path=", 5 ) == 0 ) { pSelf->AddRecentWorkspace( pLine + 5 ); }
@@ -457,6 +475,10 @@ void MainWindow::ImGuiSettingsWriteAllCB( ImGuiContext* pContext, ImGuiSettingsH
 		pOutBuffer->append( "\n" );
 	}
 
+	pOutBuffer->appendf( "[%s][%s]\n", pHandler->TypeName, "Output Log" );
+	pOutBuffer->appendf( "Scrollback=%zu\n", MainWindow::Instance().pOutputWindow->ScrollbackLines() );
+	pOutBuffer->append( "\n" );
+
 	for( int I = static_cast< int >( MainWindow::Instance().GetRecentWorkspaces().size() ) - 1; I >= 0; I-- )
 	{
 		pOutBuffer->appendf( "[%s][%s]\n", pHandler->TypeName, "Recent Workspaces" );
@@ -36,6 +36,9 @@ class  TextEdit;
 class  Win32DropTarget;
 class  WorkspaceOutliner;
 class  FindInWorkspace;
+class  BuildInsightsWindow;
+class  RunWindow;
+class  TestWindow;
 struct GLFWwindow;
 struct ImGuiContext;
 struct ImGuiSettingsHandler;
@@ -85,11 +88,14 @@ public:
 
 //////////////////////////////////////////////////////////////////////////
 
-	TitleBar*          pTitleBar          = nullptr;
-	WorkspaceOutliner* pWorkspaceOutliner = nullptr;
-	TextEdit*          pTextEdit          = nullptr;
-	OutputWindow*      pOutputWindow      = nullptr;
-	FindInWorkspace*   pFindInWorkspace   = nullptr;
+	TitleBar*            pTitleBar            = nullptr;
+	WorkspaceOutliner*   pWorkspaceOutliner   = nullptr;
+	TextEdit*            pTextEdit            = nullptr;
+	OutputWindow*        pOutputWindow        = nullptr;
+	FindInWorkspace*     pFindInWorkspace     = nullptr;
+	BuildInsightsWindow* pBuildInsightsWindow = nullptr;
+	RunWindow*           pRunWindow           = nullptr;
+	TestWindow*          pTestWindow          = nullptr;
 
 //////////////////////////////////////////////////////////////////////////
 
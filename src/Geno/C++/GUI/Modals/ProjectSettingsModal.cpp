@@ -116,6 +116,22 @@ void ProjectSettingsModal::UpdateDerived( void )
 						pProject->m_Kind = static_cast< Project::Kind >( CurrentItem + 1 );
 					}
 
+					ImGui::Separator();
+					ImGui::TextUnformatted( "Tags (applications tagged 'test' show up in the Test panel)" );
+
+					for( size_t i = 0; i < pProject->m_Tags.size(); ++i )
+					{
+						std::string&      rTag  = pProject->m_Tags[ i ];
+						const std::string Label = "##TAG_" + std::to_string( i );
+
+						ImGui::InputText( Label.c_str(), &rTag );
+					}
+
+					if( ImGui::SmallButton( "+##ADD_TAG" ) )
+					{
+						pProject->m_Tags.emplace_back();
+					}
+
 				} break;
 
 				case CategoryCompiler:
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "BuildInsightsWindow.h"
+
+#include "GUI/MainWindow.h"
+#include "GUI/Widgets/TextEdit.h"
+#include "GUI/Widgets/TitleBar.h"
+
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////////////
+
+void BuildInsightsWindow::Show( bool* pOpen )
+{
+	ImGui::SetNextWindowSize( ImVec2( 900, 400 ), ImGuiCond_FirstUseEver );
+
+	if( ImGui::Begin( "Build Insights", pOpen ) )
+	{
+		BuildInsights& rInsights = BuildInsights::Instance();
+
+		// Pick up the results of the latest analysis
+		if( const unsigned Generation = rInsights.Generation(); Generation != m_Generation )
+		{
+			m_Generation = Generation;
+			m_Rows.clear();
+
+			for( BuildInsights::HeaderCost& rCost : rInsights.Headers() )
+			{
+				Row& rRow  = m_Rows.emplace_back();
+				rRow.Label = rCost.Path.string();
+				rRow.Cost  = std::move( rCost );
+			}
+
+			m_SortDirty   = true;
+			m_FilterDirty = true;
+		}
+
+		if( rInsights.IsAnalyzing() )
+			ImGui::TextUnformatted( "Analyzing build..." );
+		else if( m_Rows.empty() )
+			ImGui::TextUnformatted( "No data. Use Build > Build With Insights to measure the cost of each header." );
+		else
+			ImGui::Text( "%zu headers included by %zu translation units", m_Rows.size(), rInsights.TranslationUnits() );
+
+		ImGui::SameLine();
+
+		if( m_Filter.Draw( "Filter", 300.0f ) )
+			m_FilterDirty = true;
+
+		constexpr ImGuiTableFlags TableFlags = ImGuiTableFlags_Sortable | ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter | ImGuiTableFlags_BordersV | ImGuiTableFlags_Resizable | ImGuiTableFlags_Hideable;
+
+		if( ImGui::BeginTable( "##HeaderCosts", ColumnCount, TableFlags ) )
+		{
+			ImGui::TableSetupScrollFreeze( 0, 1 );
+			constexpr ImGuiTableColumnFlags NumericColumn = ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_PreferSortDescending;
+
+			ImGui::TableSetupColumn( "Header",       ImGuiTableColumnFlags_WidthStretch,                0.0f, ColumnHeader );
+			ImGui::TableSetupColumn( "Time (incl.)", NumericColumn | ImGuiTableColumnFlags_DefaultSort, 0.0f, ColumnInclusiveTime );
+			ImGui::TableSetupColumn( "Time (self)",  NumericColumn,                                     0.0f, ColumnSelfTime );
+			ImGui::TableSetupColumn( "Units",        NumericColumn,                                     0.0f, ColumnTranslationUnits );
+			ImGui::TableSetupColumn( "Includes",     NumericColumn,                                     0.0f, ColumnIncludeCount );
+			ImGui::TableSetupColumn( "Fan-out",      NumericColumn,                                     0.0f, ColumnFanOut );
+			ImGui::TableSetupColumn( "Suggestion",   ImGuiTableColumnFlags_WidthFixed,                  0.0f, ColumnSuggestion );
+			ImGui::TableHeadersRow();
+
+			if( ImGuiTableSortSpecs* pSortSpecs = ImGui::TableGetSortSpecs(); pSortSpecs && ( pSortSpecs->SpecsDirty || m_SortDirty ) )
+			{
+				SortRows( *pSortSpecs );
+
+				pSortSpecs->SpecsDirty = false;
+				m_SortDirty            = false;
+				m_FilterDirty          = true;
+			}
+
+			if( m_FilterDirty )
+				FilterRows();
+
+			// Only the visible rows are submitted, so that huge reports stay cheap to draw
+			ImGuiListClipper Clipper;
+			Clipper.Begin( static_cast< int >( m_VisibleRows.size() ) );
+
+			while( Clipper.Step() )
+			{
+				for( int i = Clipper.DisplayStart; i < Clipper.DisplayEnd; ++i )
+				{
+					const Row&                       rRow  = m_Rows[ m_VisibleRows[ i ] ];
+					const BuildInsights::HeaderCost& rCost = rRow.Cost;
+
+					ImGui::TableNextRow();
+
+					ImGui::TableSetColumnIndex( ColumnHeader );
+					ImGui::PushID( i );
+
+					if( ImGui::Selectable( rRow.Label.c_str(), false, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick ) && ImGui::IsMouseDoubleClicked( ImGuiMouseButton_Left ) )
+					{
+						MainWindow::Instance().pTitleBar->ShowTextEdit = true;
+						MainWindow::Instance().pTextEdit->AddFile( rCost.Path );
+					}
+
+					ImGui::PopID();
+
+					ImGui::TableSetColumnIndex( ColumnInclusiveTime );
+					ImGui::Text( "%.1f ms", rCost.InclusiveTime * 1000.0 );
+
+					ImGui::TableSetColumnIndex( ColumnSelfTime );
+					ImGui::Text( "%.1f ms", rCost.SelfTime * 1000.0 );
+
+					ImGui::TableSetColumnIndex( ColumnTranslationUnits );
+					ImGui::Text( "%zu", rCost.TranslationUnits );
+
+					ImGui::TableSetColumnIndex( ColumnIncludeCount );
+					ImGui::Text( "%zu", rCost.IncludeCount );
+
+					ImGui::TableSetColumnIndex( ColumnFanOut );
+					ImGui::Text( "%zu", rCost.FanOut );
+
+					ImGui::TableSetColumnIndex( ColumnSuggestion );
+					const std::string_view Suggestion = Reflection::EnumToString( rCost.Suggested );
+					ImGui::TextUnformatted( Suggestion.data(), Suggestion.data() + Suggestion.size() );
+				}
+			}
+
+			ImGui::EndTable();
+		}
+
+	} ImGui::End();
+
+} // Show
+
+//////////////////////////////////////////////////////////////////////////
+
+void BuildInsightsWindow::SortRows( const ImGuiTableSortSpecs& rSortSpecs )
+{
+	if( rSortSpecs.SpecsCount == 0 )
+		return;
+
+	const ImGuiTableColumnSortSpecs& rSpec     = rSortSpecs.Specs[ 0 ];
+	const bool                       Ascending = rSpec.SortDirection == ImGuiSortDirection_Ascending;
+
+	auto Compare = [ & ]( const auto& rA, const auto& rB ) { return Ascending ? ( rA < rB ) : ( rB < rA ); };
+
+	std::stable_sort( m_Rows.begin(), m_Rows.end(), [ & ]( const Row& rA, const Row& rB )
+		{
+			switch( rSpec.ColumnUserID )
+			{
+				case ColumnHeader:           return Compare( rA.Label,                 rB.Label );
+				case ColumnInclusiveTime:    return Compare( rA.Cost.InclusiveTime,    rB.Cost.InclusiveTime );
+				case ColumnSelfTime:         return Compare( rA.Cost.SelfTime,         rB.Cost.SelfTime );
+				case ColumnTranslationUnits: return Compare( rA.Cost.TranslationUnits, rB.Cost.TranslationUnits );
+				case ColumnIncludeCount:     return Compare( rA.Cost.IncludeCount,     rB.Cost.IncludeCount );
+				case ColumnFanOut:           return Compare( rA.Cost.FanOut,           rB.Cost.FanOut );
+				case ColumnSuggestion:       return Compare( rA.Cost.Suggested,        rB.Cost.Suggested );
+				default:                     return false;
+			}
+		}
+	);
+
+} // SortRows
+
+//////////////////////////////////////////////////////////////////////////
+
+void BuildInsightsWindow::FilterRows( void )
+{
+	m_VisibleRows.clear();
+
+	for( int i = 0; i < static_cast< int >( m_Rows.size() ); ++i )
+	{
+		if( m_Filter.PassFilter( m_Rows[ i ].Label.c_str() ) )
+			m_VisibleRows.push_back( i );
+	}
+
+	m_FilterDirty = false;
+
+} // FilterRows
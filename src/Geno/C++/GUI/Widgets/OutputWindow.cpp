@@ -17,15 +17,23 @@
 
 #include "OutputWindow.h"
 
+#include "Application.h"
+#include "Components/Workspace.h"
+
+#include <algorithm>
 #include <filesystem>
 
+#include <GLFW/glfw3.h>
 #include <fcntl.h>
 #include <imgui.h>
+#include <misc/cpp/imgui_stdlib.h>
 
 #if defined( _WIN32 )
 #include <io.h>
 #define pipe( Pipe ) _pipe( Pipe, 64 * 1024, O_BINARY )
 #elif defined( __unix__ ) || defined( __APPLE__ ) // _WIN32
+#include <errno.h>
+#include <poll.h>
 #include <unistd.h>
 #endif // __unix__ || __APPLE__
 
@@ -39,7 +47,12 @@ enum
 
 //////////////////////////////////////////////////////////////////////////
 
+static constexpr size_t DefaultScrollbackLines = 1000000;
+
+//////////////////////////////////////////////////////////////////////////
+
 OutputWindow::OutputWindow( void )
+	: m_Log( DefaultScrollbackLines )
 {
 	RedirectOutputStream( &m_StdOut, stdout );
 	RedirectOutputStream( &m_StdErr, stderr );
@@ -63,10 +76,20 @@ OutputWindow::OutputWindow( void )
 	GENO_ASSERT( dup2( m_Pipe[ WRITE ], m_StdErr ) >= 0 );
 
 #if defined( __linux__ ) || defined( __APPLE__ )
-	// Make reading operations non-blocking
+
+	GENO_ASSERT( pipe( m_WakePipe ) != -1 );
+
+	// Only stdout and stderr themselves are meant to be inherited. A child that outlives us must not keep the pipe ends open.
+	for( int FileDescriptor : { m_Pipe[ READ ], m_Pipe[ WRITE ], m_WakePipe[ READ ], m_WakePipe[ WRITE ] } )
+		fcntl( FileDescriptor, F_SETFD, FD_CLOEXEC );
+
+	// Make reading operations non-blocking, so that the reader can drain the pipe and go back to waiting
 	fcntl( m_Pipe[ READ ], F_SETFL, O_NONBLOCK );
+
 #endif // __linux__ || __APPLE__
 
+	m_Reader = std::thread( &OutputWindow::ReaderMain, this );
+
 } // OutputWidget
 
 //////////////////////////////////////////////////////////////////////////
@@ -76,12 +99,32 @@ OutputWindow::~OutputWindow( void )
 	GENO_ASSERT( dup2( m_OldStdOut, m_StdOut ) >= 0 );
 	GENO_ASSERT( dup2( m_OldStdErr, m_StdErr ) >= 0 );
 
+	// A child process may still hold on to the pipe, so don't wait for the end of the output before stopping the reader
+
+#if defined( _WIN32 )
+
+	while( WaitForSingleObject( m_Reader.native_handle(), 10 ) == WAIT_TIMEOUT )
+		CancelSynchronousIo( m_Reader.native_handle() );
+
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+
+	GENO_ASSERT( write( m_WakePipe[ WRITE ], "", 1 ) == 1 );
+
+#endif // __linux__ || __APPLE__
+
+	m_Reader.join();
+
 	if( m_OldStdOut > 0 ) close( m_OldStdOut );
 	if( m_OldStdErr > 0 ) close( m_OldStdErr );
 
 	if( m_Pipe[ READ  ] > 0 ) close( m_Pipe[ READ ] );
 	if( m_Pipe[ WRITE ] > 0 ) close( m_Pipe[ WRITE ] );
 
+#if defined( __linux__ ) || defined( __APPLE__ )
+	close( m_WakePipe[ READ ] );
+	close( m_WakePipe[ WRITE ] );
+#endif // __linux__ || __APPLE__
+
 } // ~OutputWidget
 
 //////////////////////////////////////////////////////////////////////////
@@ -92,15 +135,16 @@ void OutputWindow::Show( bool* pOpen )
 
 	if( ImGui::Begin( "Output", pOpen ) )
 	{
-		Capture();
+		if( ImGui::IsWindowFocused( ImGuiFocusedFlags_RootAndChildWindows ) && ImGui::GetIO().KeyCtrl && ImGui::IsKeyPressed( GLFW_KEY_F ) )
+			m_FocusSearch = true;
+
+		DrawSearchBar();
 
-		bool ScrollToBottom = ImGui::GetScrollY() == ImGui::GetScrollMaxY();
+		if( ImGui::BeginChild( "##Log", ImVec2( 0.0f, 0.0f ), false, ImGuiWindowFlags_HorizontalScrollbar ) )
+			DrawLog();
 
-		if( m_pCaptured )
-			ImGui::TextUnformatted( m_pCaptured, m_pCaptured + m_CapturedSize );
+		ImGui::EndChild();
 
-		if( ScrollToBottom )
-			ImGui::SetScrollHereY( 1.0f );
 	} ImGui::End();
 
 } // Show
@@ -109,15 +153,272 @@ void OutputWindow::Show( bool* pOpen )
 
 void OutputWindow::ClearCapture( void )
 {
-	free( m_pCaptured );
+	std::scoped_lock Lock( m_Mutex );
 
-	m_pCaptured    = nullptr;
-	m_CapturedSize = 0;
+	Clear();
 
 } // ClearCapture
 
 //////////////////////////////////////////////////////////////////////////
 
+size_t OutputWindow::ScrollbackLines( void ) const
+{
+	std::scoped_lock Lock( m_Mutex );
+
+	return m_Log.MaxLines();
+
+} // ScrollbackLines
+
+//////////////////////////////////////////////////////////////////////////
+
+void OutputWindow::SetScrollbackLines( size_t Lines )
+{
+	std::scoped_lock Lock( m_Mutex );
+
+	m_Log.SetMaxLines( Lines );
+
+} // SetScrollbackLines
+
+//////////////////////////////////////////////////////////////////////////
+
+void OutputWindow::Clear( void )
+{
+	m_Log.Clear();
+	m_Search.Reset();
+
+	m_FirstLine    = m_Log.FirstLine();
+	m_CurrentMatch = NoMatch;
+
+} // Clear
+
+//////////////////////////////////////////////////////////////////////////
+
+void OutputWindow::DrawSearchBar( void )
+{
+	Workspace* pWorkspace = Application::Instance().CurrentWorkspace();
+
+	ImGui::SetNextItemWidth( ImGui::GetFontSize() * 16.0f );
+
+	if( m_FocusSearch )
+	{
+		ImGui::SetKeyboardFocusHere();
+		m_FocusSearch = false;
+	}
+
+	// Enter goes to the next match and Shift+Enter to the previous one, without leaving the search box
+	if( ImGui::InputTextWithHint( "##Search", "Search (Ctrl+F)", &m_SearchText, ImGuiInputTextFlags_EnterReturnsTrue ) )
+	{
+		GoToMatch( ImGui::GetIO().KeyShift ? -1 : 1 );
+		m_FocusSearch = true;
+	}
+
+	ImGui::SameLine();
+	if( ImGui::ArrowButton( "##Previous", ImGuiDir_Up ) )
+		GoToMatch( -1 );
+
+	ImGui::SameLine();
+	if( ImGui::ArrowButton( "##Next", ImGuiDir_Down ) )
+		GoToMatch( 1 );
+
+	ImGui::SameLine();
+	ImGui::Checkbox( "Errors", &m_Errors );
+
+	ImGui::SameLine();
+	ImGui::Checkbox( "Warnings", &m_Warnings );
+
+	// Compilers print the full path of the file they are complaining about, so the lines of a project are the ones with its location
+	const Project* pProject = pWorkspace ? pWorkspace->ProjectByName( m_ProjectName ) : nullptr;
+
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth( ImGui::GetFontSize() * 10.0f );
+
+	if( ImGui::BeginCombo( "##Project", pProject ? pProject->m_Name.c_str() : "All projects" ) )
+	{
+		if( ImGui::Selectable( "All projects", !pProject ) )
+			m_ProjectName.clear();
+
+		if( pWorkspace )
+		{
+			for( const Project& rProject : pWorkspace->m_Projects )
+			{
+				if( ImGui::Selectable( rProject.m_Name.c_str(), &rProject == pProject ) )
+					m_ProjectName = rProject.m_Name;
+			}
+		}
+
+		ImGui::EndCombo();
+	}
+
+	OutputSearch::Criteria Criteria;
+	Criteria.Text     = m_SearchText;
+	Criteria.Project  = pProject ? pProject->m_Location.string() : std::string();
+	Criteria.Errors   = m_Errors;
+	Criteria.Warnings = m_Warnings;
+
+	if( Criteria != m_Search.GetCriteria() )
+		m_CurrentMatch = NoMatch;
+
+	m_Search.SetCriteria( std::move( Criteria ) );
+
+	{
+		std::scoped_lock Lock( m_Mutex );
+
+		m_Search.Update( m_Log );
+	}
+
+	const std::vector< uint64_t >& rMatches = m_Search.Matches();
+
+	ImGui::SameLine();
+
+	if( m_SearchText.empty() )
+		ImGui::TextUnformatted( m_Search.IsScanning() ? "Filtering..." : "" );
+	else if( m_CurrentMatch != NoMatch && std::binary_search( rMatches.begin(), rMatches.end(), m_CurrentMatch ) )
+		ImGui::Text( "%zu of %zu%s", static_cast< size_t >( std::lower_bound( rMatches.begin(), rMatches.end(), m_CurrentMatch ) - rMatches.begin() ) + 1, rMatches.size(), m_Search.IsScanning() ? "..." : "" );
+	else if( !rMatches.empty() || m_Search.IsScanning() )
+		ImGui::Text( "%zu matches%s", rMatches.size(), m_Search.IsScanning() ? "..." : "" );
+	else
+		ImGui::TextUnformatted( "No matches" );
+
+} // DrawSearchBar
+
+//////////////////////////////////////////////////////////////////////////
+
+void OutputWindow::DrawLog( void )
+{
+	uint64_t LogFirstLine;
+	size_t   LogLineCount;
+
+	{
+		std::scoped_lock Lock( m_Mutex );
+
+		LogFirstLine = m_Log.FirstLine();
+		LogLineCount = m_Log.LineCount();
+	}
+
+	const float                    LineHeight     = ImGui::GetTextLineHeightWithSpacing();
+	const bool                     Filtered       = m_Search.GetCriteria().HasFilters();
+	const std::vector< uint64_t >& rRows          = m_Search.Rows();
+	const size_t                   RowCount       = Filtered ? rRows.size() : LogLineCount;
+	bool                           ScrollToBottom = ImGui::GetScrollY() >= ImGui::GetScrollMaxY();
+	std::vector< std::string >     Lines;
+
+	// Once the scrollback is full, old lines are dropped from the top. Unless we are following the output, move the view along with the
+	// lines so that it doesn't drift.
+	if( !ScrollToBottom && !Filtered && LogFirstLine > m_FirstLine )
+		ImGui::SetScrollY( std::max( 0.0f, ImGui::GetScrollY() - static_cast< float >( LogFirstLine - m_FirstLine ) * LineHeight ) );
+
+	m_FirstLine = LogFirstLine;
+
+	if( m_ScrollToMatch && m_CurrentMatch >= LogFirstLine )
+	{
+		const size_t Row = Filtered ? static_cast< size_t >( std::lower_bound( rRows.begin(), rRows.end(), m_CurrentMatch ) - rRows.begin() ) : static_cast< size_t >( m_CurrentMatch - LogFirstLine );
+
+		ImGui::SetScrollY( std::max( 0.0f, static_cast< float >( Row ) * LineHeight - ImGui::GetWindowHeight() * 0.5f ) );
+		ScrollToBottom = false;
+	}
+
+	m_ScrollToMatch = false;
+
+	// Only the visible lines are laid out, so the cost of a frame doesn't depend on the size of the log
+	ImGuiListClipper Clipper;
+	Clipper.Begin( static_cast< int >( RowCount ), LineHeight );
+
+	while( Clipper.Step() )
+	{
+		// Copy the lines out, so that the reader only waits for the copy and not for the layout. Lines that have been dropped since the
+		// row count was taken come out empty.
+		Lines.clear();
+
+		{
+			std::scoped_lock Lock( m_Mutex );
+
+			for( int i = Clipper.DisplayStart; i < Clipper.DisplayEnd; ++i )
+			{
+				const uint64_t Line = Filtered ? rRows[ i ] : LogFirstLine + static_cast< uint64_t >( i );
+
+				Lines.emplace_back( Line >= m_Log.FirstLine() ? m_Log.GetLine( static_cast< size_t >( Line - m_Log.FirstLine() ) ) : std::string_view() );
+			}
+		}
+
+		for( int i = Clipper.DisplayStart; i < Clipper.DisplayEnd; ++i )
+			DrawLine( Filtered ? rRows[ i ] : LogFirstLine + static_cast< uint64_t >( i ), Lines[ i - Clipper.DisplayStart ] );
+	}
+
+	Clipper.End();
+
+	if( ScrollToBottom )
+		ImGui::SetScrollHereY( 1.0f );
+
+	if( ImGui::BeginPopupContextWindow() )
+	{
+		if( ImGui::MenuItem( "Clear" ) )
+			ClearCapture();
+
+		int Scrollback = static_cast< int >( std::min< size_t >( ScrollbackLines(), INT32_MAX ) );
+
+		ImGui::SetNextItemWidth( ImGui::CalcTextSize( "000000000000" ).x );
+		if( ImGui::InputInt( "Scrollback lines", &Scrollback, 0, 0, ImGuiInputTextFlags_EnterReturnsTrue ) )
+			SetScrollbackLines( static_cast< size_t >( std::max( Scrollback, 1 ) ) );
+
+		ImGui::EndPopup();
+	}
+
+} // DrawLog
+
+//////////////////////////////////////////////////////////////////////////
+
+void OutputWindow::DrawLine( uint64_t Line, std::string_view Text )
+{
+	const std::string& rNeedle = m_Search.GetCriteria().Text;
+
+	// Highlights go behind the text, so they are drawn before it. Only visible lines get here, so finding the matches again is cheap.
+	if( !rNeedle.empty() )
+	{
+		ImDrawList*  pDrawList = ImGui::GetWindowDrawList();
+		const ImVec2 Position  = ImGui::GetCursorScreenPos();
+		const float  Height    = ImGui::GetTextLineHeight();
+		const ImU32  Color     = ImGui::GetColorU32( Line == m_CurrentMatch ? ImGuiCol_HeaderActive : ImGuiCol_TextSelectedBg );
+
+		for( size_t Offset = OutputSearch::Find( Text, rNeedle ); Offset != std::string_view::npos; Offset = OutputSearch::Find( Text, rNeedle, Offset + rNeedle.size() ) )
+		{
+			const float Start = ImGui::CalcTextSize( Text.data(), Text.data() + Offset ).x;
+			const float End   = Start + ImGui::CalcTextSize( Text.data() + Offset, Text.data() + Offset + rNeedle.size() ).x;
+
+			pDrawList->AddRectFilled( ImVec2( Position.x + Start, Position.y ), ImVec2( Position.x + End, Position.y + Height ), Color );
+		}
+	}
+
+	ImGui::TextUnformatted( Text.data(), Text.data() + Text.size() );
+
+} // DrawLine
+
+//////////////////////////////////////////////////////////////////////////
+
+void OutputWindow::GoToMatch( int Direction )
+{
+	const std::vector< uint64_t >& rMatches = m_Search.Matches();
+
+	if( rMatches.empty() )
+		return;
+
+	// Wrap around at either end
+	if( Direction > 0 )
+	{
+		auto It        = ( m_CurrentMatch == NoMatch ) ? rMatches.begin() : std::upper_bound( rMatches.begin(), rMatches.end(), m_CurrentMatch );
+		m_CurrentMatch = ( It == rMatches.end() ) ? rMatches.front() : *It;
+	}
+	else
+	{
+		auto It        = ( m_CurrentMatch == NoMatch ) ? rMatches.end() : std::lower_bound( rMatches.begin(), rMatches.end(), m_CurrentMatch );
+		m_CurrentMatch = ( It == rMatches.begin() ) ? rMatches.back() : *--It;
+	}
+
+	m_ScrollToMatch = true;
+
+} // GoToMatch
+
+//////////////////////////////////////////////////////////////////////////
+
 void OutputWindow::RedirectOutputStream( int* pFileDescriptor, FILE* pFileStream )
 {
 	if( ( *pFileDescriptor = fileno( pFileStream ) ) < 0 )
@@ -145,34 +446,46 @@ void OutputWindow::RedirectOutputStream( int* pFileDescriptor, FILE* pFileStream
 
 //////////////////////////////////////////////////////////////////////////
 
-void OutputWindow::Capture( void )
+void OutputWindow::ReaderMain( void )
 {
+	char Buffer[ 4096 ];
 
 #if defined( _WIN32 )
 
-	// We can't make anonymous pipes non-blocking on Windows, but we can seek in them to figure out how many bytes we can read.
+	int BytesRead;
 
-	const long BytesToRead = lseek( m_Pipe[ READ ], 0, SEEK_END );
-
-	if( BytesToRead > 0 )
+	// Blocks until there is output. The destructor cancels the read to stop us.
+	while( ( BytesRead = read( m_Pipe[ READ ], Buffer, static_cast< unsigned int >( std::size( Buffer ) ) ) ) > 0 )
 	{
-		m_pCaptured = static_cast< char* >( realloc( m_pCaptured, m_CapturedSize + BytesToRead ) );
-		read( m_Pipe[ READ ], &m_pCaptured[ m_CapturedSize ], BytesToRead );
-		m_CapturedSize += BytesToRead;
+		std::scoped_lock Lock( m_Mutex );
+		m_Log.Append( std::string_view( Buffer, BytesRead ) );
 	}
 
 #elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
 
-	char      Buffer[ 1024 ];
-	ptrdiff_t BytesRead;
+	pollfd      Pipes[ 2 ] = { { m_Pipe[ READ ], POLLIN, 0 }, { m_WakePipe[ READ ], POLLIN, 0 } };
+	std::string Staging;
 
-	while( ( BytesRead = read( m_Pipe[ READ ], Buffer, std::size( Buffer ) ) ) > 0 )
+	while( !( Pipes[ 1 ].revents & POLLIN ) )
 	{
-		m_pCaptured = static_cast< char* >( realloc( m_pCaptured, m_CapturedSize + BytesRead ) );
-		memcpy( &m_pCaptured[ m_CapturedSize ], Buffer, BytesRead );
-		m_CapturedSize += BytesRead;
+		if( poll( Pipes, 2, -1 ) < 0 && errno != EINTR )
+			break;
+
+		ptrdiff_t BytesRead;
+
+		// Gather a few reads before taking the lock, so that the log is locked once for all of them and only while they are appended
+		Staging.clear();
+
+		for( int i = 0; i < 16 && ( BytesRead = read( m_Pipe[ READ ], Buffer, std::size( Buffer ) ) ) > 0; ++i )
+			Staging.append( Buffer, static_cast< size_t >( BytesRead ) );
+
+		if( Staging.empty() )
+			continue;
+
+		std::scoped_lock Lock( m_Mutex );
+		m_Log.Append( Staging );
 	}
 
 #endif // __linux__ || __APPLE__
 
-} // Capture
+} // ReaderMain
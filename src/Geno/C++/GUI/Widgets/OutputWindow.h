@@ -16,12 +16,24 @@
  */
 
 #pragma once
+#include "Components/OutputLog.h"
+#include "Components/OutputSearch.h"
+
 #include "Common/Macros.h"
 
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
 #if defined( _WIN32 )
 #include <Windows.h>
 #endif // _WIN32
 
+// Shows everything that is written to stdout and stderr, both of which are redirected into a pipe. A thread of its own drains the pipe
+// into the log, so that writers never block on a full pipe while the window is hidden or a frame takes long. The log can be searched
+// (Ctrl+F) and filtered down to errors, warnings or the lines of a single project.
 class OutputWindow
 {
 public:
@@ -33,26 +45,56 @@ public:
 
 public:
 
-	void Show        ( bool* pOpen );
-	void ClearCapture( void );
+	void   Show              ( bool* pOpen );
+	void   ClearCapture      ( void );
+	size_t ScrollbackLines   ( void ) const;
+	void   SetScrollbackLines( size_t Lines );
 
 //////////////////////////////////////////////////////////////////////////
 
 private:
 
+	static constexpr uint64_t NoMatch = UINT64_MAX;
+
+//////////////////////////////////////////////////////////////////////////
+
 	void RedirectOutputStream( int* pFileDescriptor, FILE* pFileStream );
-	void Capture             ( void );
+	void ReaderMain          ( void );
+
+	// The rest is only called from the UI thread. Clear() is called with the log locked, the others lock it themselves for as long as they
+	// read from it, and never across a call into ImGui.
+	void Clear               ( void );
+	void DrawSearchBar       ( void );
+	void DrawLog             ( void );
+	void DrawLine            ( uint64_t Line, std::string_view Text );
+	void GoToMatch           ( int Direction );
 
 //////////////////////////////////////////////////////////////////////////
 
-	char*       m_pCaptured    = nullptr;
+	// Only guards the log. Everything else belongs to the UI thread.
+	mutable std::mutex m_Mutex;
+	OutputLog          m_Log;
+	OutputSearch       m_Search;
+	std::thread        m_Reader;
+
+	uint64_t           m_FirstLine    = 0;
+	uint64_t           m_CurrentMatch = NoMatch;
+
+	std::string        m_SearchText;
+	std::string        m_ProjectName;
+	bool               m_Errors        = false;
+	bool               m_Warnings      = false;
+	bool               m_FocusSearch   = false;
+	bool               m_ScrollToMatch = false;
 
-	size_t      m_CapturedSize = 0;
+	int                m_Pipe[ 2 ]    = { };
+	int                m_StdOut       = 0;
+	int                m_StdErr       = 0;
+	int                m_OldStdOut    = 0;
+	int                m_OldStdErr    = 0;
 
-	int         m_Pipe[ 2 ]    = { };
-	int         m_StdOut       = 0;
-	int         m_StdErr       = 0;
-	int         m_OldStdOut    = 0;
-	int         m_OldStdErr    = 0;
+#if defined( __linux__ ) || defined( __APPLE__ )
+	int                m_WakePipe[ 2 ] = { };
+#endif // __linux__ || __APPLE__
 
 }; // OutputWidget
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "RunWindow.h"
+
+#include "GUI/MainWindow.h"
+#include "GUI/Widgets/StatusBar.h"
+
+#include <algorithm>
+
+#include <imgui.h>
+
+//////////////////////////////////////////////////////////////////////////
+
+static constexpr size_t ScrollbackLines = 10000;
+
+//////////////////////////////////////////////////////////////////////////
+
+RunWindow::RunWindow( void )
+	: m_Buffer( ScrollbackLines )
+{
+} // RunWindow
+
+//////////////////////////////////////////////////////////////////////////
+
+RunWindow::~RunWindow( void )
+{
+	Stop();
+
+	if( m_Reader.joinable() )
+		m_Reader.join();
+
+} // ~RunWindow
+
+//////////////////////////////////////////////////////////////////////////
+
+void RunWindow::Show( bool* pOpen )
+{
+	ImGui::SetNextWindowSize( ImVec2( 350 * 2, 196 ), ImGuiCond_FirstUseEver );
+
+	if( ImGui::Begin( "Run", pOpen ) )
+	{
+		std::unique_lock Lock( m_Mutex );
+
+		if( m_Running )
+		{
+			if( ImGui::Button( "Stop" ) )
+				m_pTerminal->Kill();
+
+			ImGui::SameLine();
+
+			// The terminal driver turns ^C into SIGINT for the program, just like in a real terminal
+			if( ImGui::Button( "Interrupt" ) )
+				m_pTerminal->Write( "\x03" );
+
+			ImGui::SameLine();
+			ImGui::Text( "Running %s", m_Title.c_str() );
+		}
+		else
+		{
+			if( ImGui::Button( "Clear" ) )
+				m_Buffer.Clear();
+
+			if( m_ExitCode )
+			{
+				ImGui::SameLine();
+				ImGui::Text( "%s exited with code %d", m_Title.c_str(), *m_ExitCode );
+			}
+		}
+
+		const float InputHeight = ImGui::GetFrameHeightWithSpacing();
+
+		if( ImGui::BeginChild( "##Output", ImVec2( 0.0f, -InputHeight ), false, ImGuiWindowFlags_HorizontalScrollbar ) )
+		{
+			ImGui::PushFont( MainWindow::Instance().GetFontMono() );
+			ImGui::PushStyleVar( ImGuiStyleVar_ItemSpacing, ImVec2( ImGui::GetStyle().ItemSpacing.x, 0.0f ) );
+
+			// Fit the terminal to the panel, so that programs that format their output for the console line up
+			const ImVec2   CharacterSize = ImGui::CalcTextSize( "M" );
+			const ImVec2   Available     = ImGui::GetContentRegionAvail();
+			const float    LineHeight    = ImGui::GetTextLineHeight();
+			const uint16_t Columns       = static_cast< uint16_t >( std::clamp( Available.x / CharacterSize.x, 20.0f, 1000.0f ) );
+			const uint16_t Rows          = static_cast< uint16_t >( std::clamp( Available.y / LineHeight,      5.0f,  1000.0f ) );
+
+			if( Columns != m_Columns || Rows != m_Rows )
+			{
+				m_Columns = Columns;
+				m_Rows    = Rows;
+
+				if( m_Running )
+					m_pTerminal->Resize( m_Columns, m_Rows );
+			}
+
+			// Once the scrollback is full, every new line pushes the oldest one out. Unless we are following the output, move the
+			// view along with the lines so that it doesn't drift.
+			const uint64_t LinesDropped   = m_Buffer.LinesWritten() + 1 - m_Buffer.LineCount();
+			const bool     ScrollToBottom = m_ScrollToBottom || ImGui::GetScrollY() >= ImGui::GetScrollMaxY();
+
+			if( !ScrollToBottom && LinesDropped > m_LinesDropped )
+				ImGui::SetScrollY( std::max( 0.0f, ImGui::GetScrollY() - static_cast< float >( LinesDropped - m_LinesDropped ) * LineHeight ) );
+
+			m_LinesDropped = LinesDropped;
+
+			ImGuiListClipper Clipper;
+			Clipper.Begin( static_cast< int >( m_Buffer.LineCount() ), LineHeight );
+
+			while( Clipper.Step() )
+			{
+				for( int i = Clipper.DisplayStart; i < Clipper.DisplayEnd; ++i )
+					DrawLine( m_Buffer.GetLine( static_cast< size_t >( i ) ) );
+			}
+
+			Clipper.End();
+
+			if( ScrollToBottom )
+				ImGui::SetScrollHereY( 1.0f );
+
+			m_ScrollToBottom = false;
+
+			ImGui::PopStyleVar();
+			ImGui::PopFont();
+
+		} ImGui::EndChild();
+
+		ImGui::SetNextItemWidth( -1.0f );
+
+		if( ImGui::InputTextWithHint( "##Input", "Input", m_Input, std::size( m_Input ), ImGuiInputTextFlags_EnterReturnsTrue ) )
+		{
+			if( m_Running )
+			{
+				// Enter sends a carriage return, which the terminal driver turns into a newline
+				m_pTerminal->Write( std::string( m_Input ) + "\r" );
+				m_ScrollToBottom = true;
+			}
+
+			m_Input[ 0 ] = '\0';
+			ImGui::SetKeyboardFocusHere( -1 );
+		}
+
+	} ImGui::End();
+
+} // Show
+
+//////////////////////////////////////////////////////////////////////////
+
+void RunWindow::Start( const std::filesystem::path& rExecutable )
+{
+	std::scoped_lock StartLock( m_StartMutex );
+
+	// Only one program runs at a time. The reader of the previous one finishes as soon as its terminal is gone.
+	Stop();
+
+	if( m_Reader.joinable() )
+		m_Reader.join();
+
+	std::shared_ptr< PseudoTerminal > pTerminal = std::make_shared< PseudoTerminal >();
+	std::scoped_lock                  Lock( m_Mutex );
+
+	m_CommandLine    = L"\"" + rExecutable.wstring() + L"\"";
+	m_Title          = rExecutable.filename().string();
+	m_ExitCode       = std::nullopt;
+	m_ScrollToBottom = true;
+	m_Buffer.Clear();
+
+	if( !pTerminal->Start( m_CommandLine, m_Columns, m_Rows ) )
+	{
+		m_Buffer.Write( "\x1B[91mFailed to start " + rExecutable.string() + "\x1B[0m\n" );
+		return;
+	}
+
+	StatusBar::Instance().SetColor( StatusBar::Color::ORANGE );
+
+	m_pTerminal = pTerminal;
+	m_Running   = true;
+	m_Reader    = std::thread( &RunWindow::ReaderMain, this, std::move( pTerminal ) );
+
+} // Start
+
+//////////////////////////////////////////////////////////////////////////
+
+void RunWindow::Stop( void )
+{
+	std::scoped_lock Lock( m_Mutex );
+
+	if( m_Running )
+		m_pTerminal->Kill();
+
+} // Stop
+
+//////////////////////////////////////////////////////////////////////////
+
+bool RunWindow::IsRunning( void ) const
+{
+	std::scoped_lock Lock( m_Mutex );
+
+	return m_Running;
+
+} // IsRunning
+
+//////////////////////////////////////////////////////////////////////////
+
+void RunWindow::ReaderMain( std::shared_ptr< PseudoTerminal > pTerminal )
+{
+	char Buffer[ 4096 ];
+
+	while( const size_t Size = pTerminal->Read( Buffer, std::size( Buffer ) ) )
+	{
+		std::scoped_lock Lock( m_Mutex );
+		m_Buffer.Write( std::string_view( Buffer, Size ) );
+	}
+
+	const std::optional< int > ExitCode = pTerminal->Wait();
+	std::scoped_lock           Lock( m_Mutex );
+
+	m_ExitCode = ExitCode;
+	m_Running  = false;
+
+	// Leave a note in the output as well, since the status line goes away with the next run
+	if( !m_Buffer.GetLine( m_Buffer.LineCount() - 1 ).Text.empty() )
+		m_Buffer.Write( "\n" );
+
+	m_Buffer.Write( "\x1B[90m" + m_Title + " exited with code " + ( ExitCode ? std::to_string( *ExitCode ) : std::string( "?" ) ) + "\x1B[0m\n" );
+
+	StatusBar::Instance().SetColor( StatusBar::Color::RED );
+
+} // ReaderMain
+
+//////////////////////////////////////////////////////////////////////////
+
+void RunWindow::DrawLine( const TerminalBuffer::Line& rLine )
+{
+	ImDrawList*    pDrawList    = ImGui::GetWindowDrawList();
+	const ImU32    DefaultColor = ImGui::GetColorU32( ImGuiCol_Text );
+	const char*    pText        = rLine.Text.data();
+	ImVec2         Position     = ImGui::GetCursorScreenPos();
+	const float    Start        = Position.x;
+	uint32_t       Offset       = 0;
+	uint32_t       Color        = 0;
+
+	// Each span sets the color from its offset on. Text before the first span has the default color.
+	for( size_t i = 0; i <= rLine.Spans.size(); ++i )
+	{
+		const uint32_t End = ( i < rLine.Spans.size() ) ? rLine.Spans[ i ].Offset : static_cast< uint32_t >( rLine.Text.size() );
+
+		if( End > Offset )
+		{
+			pDrawList->AddText( Position, Color ? Color : DefaultColor, pText + Offset, pText + End );
+			Position.x += ImGui::CalcTextSize( pText + Offset, pText + End ).x;
+			Offset      = End;
+		}
+
+		if( i < rLine.Spans.size() )
+			Color = rLine.Spans[ i ].Color;
+	}
+
+	ImGui::Dummy( ImVec2( Position.x - Start, ImGui::GetTextLineHeight() ) );
+
+} // DrawLine
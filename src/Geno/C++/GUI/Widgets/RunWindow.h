@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include "Components/TerminalBuffer.h"
+
+#include <Common/PseudoTerminal.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+// Shows the program started by "Build And Run". It runs on a pseudo terminal, and a thread of its own reads the output, so the program
+// never ties up a job and can be stopped or fed input at any time.
+class RunWindow
+{
+public:
+
+	 RunWindow( void );
+	~RunWindow( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+public:
+
+	void Show     ( bool* pOpen );
+	void Start    ( const std::filesystem::path& rExecutable );
+	void Stop     ( void );
+	bool IsRunning( void ) const;
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	void ReaderMain( std::shared_ptr< PseudoTerminal > pTerminal );
+	void DrawLine  ( const TerminalBuffer::Line& rLine );
+
+//////////////////////////////////////////////////////////////////////////
+
+	// Start() is called from the job that finished the build, so everything the reader shares with the UI is guarded
+	mutable std::mutex                m_Mutex;
+	TerminalBuffer                    m_Buffer;
+	std::shared_ptr< PseudoTerminal > m_pTerminal;
+	std::thread                       m_Reader;
+	std::mutex                        m_StartMutex;
+
+	std::wstring                      m_CommandLine;
+	std::string                       m_Title;
+	std::optional< int >              m_ExitCode;
+	bool                              m_Running        = false;
+
+	char                              m_Input[ 512 ]   = { };
+	uint64_t                          m_LinesDropped   = 0;
+	uint16_t                          m_Columns        = 120;
+	uint16_t                          m_Rows           = 30;
+	bool                              m_ScrollToBottom = false;
+
+}; // RunWindow
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "TestWindow.h"
+
+#include "Application.h"
+#include "Components/Workspace.h"
+
+#include <algorithm>
+
+#include <imgui.h>
+
+//////////////////////////////////////////////////////////////////////////
+
+static constexpr double REFRESH_INTERVAL = 0.1;
+
+//////////////////////////////////////////////////////////////////////////
+
+static ImVec4 StatusColor( TestRunner::Status Status )
+{
+	switch( Status )
+	{
+		case TestRunner::Status::Queued:  return ImVec4( 0.5f, 0.5f, 0.5f, 1.0f );
+		case TestRunner::Status::Running: return ImVec4( 0.2f, 0.6f, 0.8f, 1.0f );
+		case TestRunner::Status::Passed:  return ImVec4( 0.4f, 0.8f, 0.4f, 1.0f );
+		case TestRunner::Status::Failed:  return ImVec4( 0.9f, 0.3f, 0.3f, 1.0f );
+		case TestRunner::Status::Skipped: return ImVec4( 0.8f, 0.7f, 0.3f, 1.0f );
+		default:                          return ImVec4( 1.0f, 1.0f, 1.0f, 1.0f );
+	}
+
+} // StatusColor
+
+//////////////////////////////////////////////////////////////////////////
+
+static const char* StatusLabel( TestRunner::Status Status )
+{
+	switch( Status )
+	{
+		case TestRunner::Status::Queued:  return "    ";
+		case TestRunner::Status::Running: return "RUN ";
+		case TestRunner::Status::Passed:  return "PASS";
+		case TestRunner::Status::Failed:  return "FAIL";
+		case TestRunner::Status::Skipped: return "SKIP";
+		default:                          return "";
+	}
+
+} // StatusLabel
+
+//////////////////////////////////////////////////////////////////////////
+
+void TestWindow::Show( bool* pOpen )
+{
+	ImGui::SetNextWindowSize( ImVec2( 700, 500 ), ImGuiCond_FirstUseEver );
+
+	if( ImGui::Begin( "Test", pOpen ) )
+	{
+		TestRunner& rRunner    = TestRunner::Instance();
+		Workspace*  pWorkspace = Application::Instance().CurrentWorkspace();
+
+		RefreshResults();
+
+		ImGui::BeginDisabled( !pWorkspace || rRunner.IsRunning() );
+
+		if( ImGui::Button( "Run Tests" ) )
+			rRunner.Run( pWorkspace->TestExecutables() );
+
+		ImGui::EndDisabled();
+		ImGui::SameLine();
+
+		if( ImGui::Checkbox( "Failures only", &m_FailuresOnly ) )
+			m_RowsDirty = true;
+
+		ImGui::SameLine();
+
+		if( rRunner.IsRunning() )
+			ImGui::Text( "Running... %zu passed, %zu failed, %zu skipped", m_Passed, m_Failed, m_Skipped );
+		else if( m_Results.empty() )
+			ImGui::TextUnformatted( "No results. Tag application projects with 'test' in their settings, and use Build > Build And Run Tests." );
+		else
+			ImGui::Text( "%zu passed, %zu failed, %zu skipped", m_Passed, m_Failed, m_Skipped );
+
+		if( m_RowsDirty )
+			RebuildRows();
+
+		const bool  HasSelection = !m_SelectedExecutable.empty();
+		const float OutputHeight = HasSelection ? ImGui::GetContentRegionAvail().y * 0.35f : 0.0f;
+
+		if( ImGui::BeginChild( "##Tests", ImVec2( 0.0f, -OutputHeight ), true ) )
+		{
+			ImGuiListClipper Clipper;
+			Clipper.Begin( static_cast< int >( m_Rows.size() ) );
+
+			while( Clipper.Step() )
+			{
+				for( int i = Clipper.DisplayStart; i < Clipper.DisplayEnd; ++i )
+				{
+					ImGui::PushID( i );
+					DrawRow( m_Rows[ i ] );
+					ImGui::PopID();
+				}
+			}
+
+		} ImGui::EndChild();
+
+		if( HasSelection )
+			DrawOutput();
+
+	} ImGui::End();
+
+} // Show
+
+//////////////////////////////////////////////////////////////////////////
+
+void TestWindow::RefreshResults( void )
+{
+	TestRunner&    rRunner    = TestRunner::Instance();
+	const unsigned Generation = rRunner.Generation();
+	const double   Now        = ImGui::GetTime();
+
+	// Results can change with every line a test prints, so pick them up a few times per second at most while tests are running
+	if( Generation == m_Generation || ( rRunner.IsRunning() && Now - m_LastRefresh < REFRESH_INTERVAL ) )
+		return;
+
+	m_Generation  = Generation;
+	m_LastRefresh = Now;
+	m_Results     = rRunner.Results();
+	m_Passed      = 0;
+	m_Failed      = 0;
+	m_Skipped     = 0;
+
+	for( const TestRunner::TestExecutable& rExecutable : m_Results )
+	{
+		for( const TestRunner::TestCase& rTest : rExecutable.Tests )
+		{
+			m_Passed  += rTest.Result == TestRunner::Status::Passed;
+			m_Failed  += rTest.Result == TestRunner::Status::Failed;
+			m_Skipped += rTest.Result == TestRunner::Status::Skipped;
+		}
+	}
+
+	m_RowsDirty = true;
+
+} // RefreshResults
+
+//////////////////////////////////////////////////////////////////////////
+
+void TestWindow::RebuildRows( void )
+{
+	m_Rows.clear();
+
+	for( size_t i = 0; i < m_Results.size(); ++i )
+	{
+		const TestRunner::TestExecutable& rExecutable = m_Results[ i ];
+
+		if( m_FailuresOnly && rExecutable.Result != TestRunner::Status::Failed )
+			continue;
+
+		m_Rows.push_back( Row{ .Executable = i } );
+
+		if( !IsExpanded( rExecutable ) )
+			continue;
+
+		for( size_t Test = 0; Test < rExecutable.Tests.size(); ++Test )
+		{
+			if( m_FailuresOnly && rExecutable.Tests[ Test ].Result != TestRunner::Status::Failed )
+				continue;
+
+			m_Rows.push_back( Row{ .Executable = i, .Test = Test, .IsTest = true } );
+		}
+	}
+
+	m_RowsDirty = false;
+
+} // RebuildRows
+
+//////////////////////////////////////////////////////////////////////////
+
+bool TestWindow::IsExpanded( const TestRunner::TestExecutable& rExecutable ) const
+{
+	if( auto It = m_Expanded.find( rExecutable.Path ); It != m_Expanded.end() )
+		return It->second;
+
+	return std::any_of( rExecutable.Tests.begin(), rExecutable.Tests.end(), []( const TestRunner::TestCase& rTest ) { return rTest.Result == TestRunner::Status::Failed; } );
+
+} // IsExpanded
+
+//////////////////////////////////////////////////////////////////////////
+
+void TestWindow::DrawRow( const Row& rRow )
+{
+	const TestRunner::TestExecutable& rExecutable = m_Results[ rRow.Executable ];
+	const bool                        Selected    = rExecutable.Path == m_SelectedExecutable;
+
+	if( !rRow.IsTest )
+	{
+		size_t Finished = 0;
+		for( const TestRunner::TestCase& rTest : rExecutable.Tests )
+			Finished += rTest.Result != TestRunner::Status::Running;
+
+		const std::string  Label = rExecutable.Path.filename().string() + " (" + std::to_string( Finished ) + "/" + std::to_string( rExecutable.Tests.size() ) + ")";
+		ImGuiTreeNodeFlags Flags = ImGuiTreeNodeFlags_NoTreePushOnOpen | ImGuiTreeNodeFlags_SpanAvailWidth | ImGuiTreeNodeFlags_OpenOnArrow;
+
+		if( Selected && m_SelectedTest.empty() )
+			Flags |= ImGuiTreeNodeFlags_Selected;
+
+		ImGui::TextColored( StatusColor( rExecutable.Result ), "%s", StatusLabel( rExecutable.Result ) );
+		ImGui::SameLine();
+
+		ImGui::SetNextItemOpen( IsExpanded( rExecutable ) );
+		const bool Open = ImGui::TreeNodeEx( Label.c_str(), Flags );
+
+		if( ImGui::IsItemToggledOpen() )
+		{
+			m_Expanded[ rExecutable.Path ] = Open;
+			m_RowsDirty                    = true;
+		}
+		else if( ImGui::IsItemClicked() )
+		{
+			m_SelectedExecutable = rExecutable.Path;
+			m_SelectedTest.clear();
+		}
+
+		return;
+	}
+
+	const TestRunner::TestCase& rTest = rExecutable.Tests[ rRow.Test ];
+	const std::string           Label = rTest.Result == TestRunner::Status::Running ? rTest.Name : rTest.Name + " (" + std::to_string( static_cast< int >( rTest.Seconds * 1000.0 ) ) + " ms)";
+
+	ImGui::Indent();
+	ImGui::TextColored( StatusColor( rTest.Result ), "%s", StatusLabel( rTest.Result ) );
+	ImGui::SameLine();
+
+	if( ImGui::Selectable( Label.c_str(), Selected && m_SelectedTest == rTest.Name ) )
+	{
+		m_SelectedExecutable = rExecutable.Path;
+		m_SelectedTest       = rTest.Name;
+	}
+
+	ImGui::Unindent();
+
+} // DrawRow
+
+//////////////////////////////////////////////////////////////////////////
+
+void TestWindow::DrawOutput( void )
+{
+	const std::string* pOutput = nullptr;
+
+	for( const TestRunner::TestExecutable& rExecutable : m_Results )
+	{
+		if( rExecutable.Path != m_SelectedExecutable )
+			continue;
+
+		if( m_SelectedTest.empty() )
+			pOutput = &rExecutable.Output;
+
+		for( const TestRunner::TestCase& rTest : rExecutable.Tests )
+		{
+			if( !m_SelectedTest.empty() && rTest.Name == m_SelectedTest )
+				pOutput = &rTest.Output;
+		}
+	}
+
+	if( ImGui::BeginChild( "##TestOutput", ImVec2( 0.0f, 0.0f ), true, ImGuiWindowFlags_HorizontalScrollbar ) )
+	{
+		if( !pOutput )
+			ImGui::TextUnformatted( "The selected test is not part of the latest run." );
+		else if( pOutput->empty() )
+			ImGui::TextUnformatted( "No output." );
+		else
+			ImGui::TextUnformatted( pOutput->data(), pOutput->data() + pOutput->size() );
+
+	} ImGui::EndChild();
+
+} // DrawOutput
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include "Components/TestRunner.h"
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+// Lists the results of the test executables in the workspace as a tree, one node per executable with its tests underneath.
+// Only the rows that are on screen are drawn, so suites with thousands of tests stay cheap to show while results stream in.
+class TestWindow
+{
+public:
+
+	 TestWindow( void ) { }
+	~TestWindow( void ) { }
+
+//////////////////////////////////////////////////////////////////////////
+
+public:
+
+	void Show( bool* pOpen );
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	struct Row
+	{
+		size_t Executable = 0;
+		size_t Test       = 0;
+		bool   IsTest     = false;
+
+	}; // Row
+
+//////////////////////////////////////////////////////////////////////////
+
+	void RefreshResults( void );
+	void RebuildRows   ( void );
+	bool IsExpanded    ( const TestRunner::TestExecutable& rExecutable ) const;
+	void DrawRow       ( const Row& rRow );
+	void DrawOutput    ( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::vector< TestRunner::TestExecutable > m_Results;
+	std::vector< Row >                        m_Rows;
+
+	// Executables that were opened or closed by hand. The rest are open when they have failures.
+	std::map< std::filesystem::path, bool >   m_Expanded;
+
+	std::filesystem::path                     m_SelectedExecutable;
+	std::string                               m_SelectedTest;
+
+	double                                    m_LastRefresh  = 0.0;
+	unsigned                                  m_Generation   = 0;
+	size_t                                    m_Passed       = 0;
+	size_t                                    m_Failed       = 0;
+	size_t                                    m_Skipped      = 0;
+	bool                                      m_FailuresOnly = false;
+	bool                                      m_RowsDirty    = false;
+
+}; // TestWindow
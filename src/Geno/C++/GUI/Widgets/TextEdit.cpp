@@ -24,25 +24,167 @@
 #include "GUI/Widgets/TitleBar.h"
 #include "Discord/DiscordRPC.h"
 #include "GUI/Widgets/StatusBar.h"
+#include "Common/AtomicFile.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <numeric>
 
 #include <misc/cpp/imgui_stdlib.h>
 
 const char* WINDOW_NAME = "Text Edit";
 
-constexpr float TabSize                 = 4.0f;
-constexpr float EmptyLineSelectionWidth = 4.0f;
-constexpr int   CursorBlink             = 400;
-constexpr float DummyExtraX             = 10.0f;
-constexpr float DummyExtraY             = 10.0f;
-constexpr int   SearchResultGroupSize   = 1000;
+constexpr float  TabSize                   = 4.0f;
+constexpr float  EmptyLineSelectionWidth   = 4.0f;
+constexpr int    CursorBlink               = 400;
+constexpr float  DummyExtraX               = 10.0f;
+constexpr float  DummyExtraY               = 10.0f;
+constexpr size_t SearchResultGroupCapacity = 256;
+constexpr size_t SaveChunkSize             = 1 << 20;
+constexpr size_t LargeFileSize             = 256 << 20;
+constexpr size_t MaxCachedXOffsets         = 1024;
 
 float TextEdit::FontSize = 15.0f;
 
 //////////////////////////////////////////////////////////////////////////
 
+// Reads the file with a single read into a string of the right size, rather than a character at a time
+static std::string ReadWholeFile( const std::filesystem::path& rPath )
+{
+	std::error_code Error;
+	const uintmax_t Size = std::filesystem::file_size( rPath, Error );
+	std::ifstream   Stream( rPath, std::ios::binary );
+	std::string     Text;
+
+	if( Error || !Stream )
+		return Text;
+
+	Text.resize( static_cast< size_t >( Size ) );
+	Stream.read( Text.data(), static_cast< std::streamsize >( Size ) );
+	Text.resize( static_cast< size_t >( Stream.gcount() ) );
+
+	return Text;
+
+} // ReadWholeFile
+
+//////////////////////////////////////////////////////////////////////////
+
+// Lines [FirstLine, OldLastLine] have become [FirstLine, NewLastLine]. What was kept for them is dropped, and everything below moves along.
+// This happens on every edit (once per cursor), so the nodes below are given their new lines in place instead of building another map.
+template< typename T >
+static void ShiftLines( std::map< int, T >& rLines, int FirstLine, int OldLastLine, int NewLastLine )
+{
+	const int Delta = NewLastLine - OldLastLine;
+	auto      Below = rLines.erase( rLines.lower_bound( FirstLine ), rLines.upper_bound( OldLastLine ) );
+
+	// Nodes are moved in the order that keeps their new lines clear of the ones that haven't moved yet, and each one goes right back
+	// to where it was taken from
+	if( Delta < 0 )
+	{
+		while( Below != rLines.end() )
+		{
+			auto Node   = rLines.extract( Below++ );
+			Node.key() += Delta;
+
+			rLines.insert( Below, std::move( Node ) );
+		}
+	}
+	else if( Delta > 0 )
+	{
+		auto Moved = rLines.end();
+
+		while( Moved != rLines.begin() && std::prev( Moved )->first > OldLastLine )
+		{
+			auto Node   = rLines.extract( std::prev( Moved ) );
+			Node.key() += Delta;
+
+			Moved = rLines.insert( Moved, std::move( Node ) );
+		}
+	}
+
+} // ShiftLines
+
+//////////////////////////////////////////////////////////////////////////
+
+// How far the edits before each one have moved the text, with the total at the end. The edits are sorted and apart from each other.
+template< typename T >
+static std::vector< ptrdiff_t > EditShifts( const std::vector< T >& rEdits )
+{
+	std::vector< ptrdiff_t > Shifts( rEdits.size() + 1, 0 );
+
+	for( size_t i = 0; i < rEdits.size(); i++ )
+		Shifts[ i + 1 ] = Shifts[ i ] + ( ptrdiff_t )rEdits[ i ].Text.size() - ( ptrdiff_t )( rEdits[ i ].End - rEdits[ i ].Start );
+
+	return Shifts;
+
+} // EditShifts
+
+//////////////////////////////////////////////////////////////////////////
+
+// Where Offset ends up once the edits have been made. Anything inside replaced text is kept within the text that replaced it.
+template< typename T >
+static size_t MapEditedOffset( const std::vector< T >& rEdits, const std::vector< ptrdiff_t >& rShifts, size_t Offset )
+{
+	auto It = std::upper_bound( rEdits.begin(), rEdits.end(), Offset, []( size_t Value, const T& rEdit ) { return Value < rEdit.Start; } );
+
+	if( It == rEdits.begin() )
+		return Offset;
+
+	const size_t Index = ( size_t )( It - rEdits.begin() ) - 1;
+	const T&     rEdit = *( It - 1 );
+
+	if( Offset < rEdit.End )
+		return rEdit.Start + rShifts[ Index ] + std::min( Offset - rEdit.Start, rEdit.Text.size() );
+
+	return Offset + rShifts[ Index + 1 ];
+
+} // MapEditedOffset
+
+//////////////////////////////////////////////////////////////////////////
+
+// Writes a snapshot of a file with its original line breaks, in large pieces, and swaps it in for the file on disk once all of it is there
+static bool WriteSnapshot( const std::filesystem::path& rPath, const TextBuffer::Snapshot& rSnapshot, TextEdit::LineEnding Ending )
+{
+	AtomicFile       File;
+	std::string      Pending;
+	std::string_view LineBreak = ( Ending == TextEdit::LineEnding::CRLF ) ? "\r\n" : "\r";
+
+	if( !File.Open( rPath ) )
+		return false;
+
+	Pending.reserve( SaveChunkSize + SaveChunkSize / 8 );
+
+	for( std::string_view Chunk : rSnapshot.Chunks() )
+	{
+		if( Ending == TextEdit::LineEnding::LF )
+		{
+			Pending.append( Chunk );
+		}
+		else
+		{
+			for( size_t Break; ( Break = Chunk.find( '\n' ) ) != std::string_view::npos; Chunk.remove_prefix( Break + 1 ) )
+				Pending.append( Chunk.substr( 0, Break ) ).append( LineBreak );
+
+			Pending.append( Chunk );
+		}
+
+		if( Pending.size() >= SaveChunkSize )
+		{
+			if( !File.Write( Pending ) )
+				return false;
+
+			Pending.clear();
+		}
+	}
+
+	return File.Write( Pending ) && File.Commit();
+
+} // WriteSnapshot
+
+//////////////////////////////////////////////////////////////////////////
+
 TextEdit::TextEdit( void )
 {
 	// Create tab bar
@@ -72,8 +214,23 @@ TextEdit::TextEdit( void )
 
 //////////////////////////////////////////////////////////////////////////
 
+TextEdit::~TextEdit( void )
+{
+	// Files must not be left half-saved when the application exits
+	for( const std::shared_ptr< PendingSave >& rpSave : m_Saves )
+	{
+		while( !rpSave->Done.load( std::memory_order_acquire ) )
+			std::this_thread::yield();
+	}
+
+} // ~TextEdit
+
+//////////////////////////////////////////////////////////////////////////
+
 void TextEdit::Show( bool* pOpen )
 {
+	CollectSaves();
+
 	ImGuiStyle& rStyle          = ImGui::GetStyle();
 	ImVec4      BackgroundColor = rStyle.Colors[ ImGuiCol_WindowBg ];
 
@@ -199,8 +356,8 @@ void TextEdit::Show( bool* pOpen )
 				if( rFile.Cursors.size() )
 				{
 					auto& rCursor = rFile.Cursors.at( 0 );
-					int   Length = static_cast< int >( rFile.Text.size() );
-					int   Lines  = static_cast< int >( rFile.Lines.size() );
+					int   Length = static_cast< int >( rFile.Buffer.Size() );
+					int   Lines  = static_cast< int >( rFile.Buffer.LineCount() );
 
 					StatusBar::Instance().SetCurrentFileInfo( rCursor.Position.x + 1, rCursor.Position.y + 1, Length, Lines );
 				}
@@ -227,8 +384,29 @@ void TextEdit::AddFile( const std::filesystem::path& rPath )
 
 	//////////////////////////////////////////////////////////////////////////
 
-	std::ifstream     InputFileStream( rPath, std::ios::binary );
-	const std::string Text( ( std::istreambuf_iterator< char >( InputFileStream ) ), std::istreambuf_iterator< char >() );
+	std::error_code Error;
+	const bool      Large = std::filesystem::file_size( rPath, Error ) > LargeFileSize && !Error;
+
+	std::unique_ptr< LargeFile > pLarge;
+	std::string                  Text;
+	LineEnding                   Ending = LineEnding::LF;
+
+	// Large files stay on disk
+	if( Large )
+	{
+		pLarge = std::make_unique< LargeFile >();
+
+		if( !pLarge->Open( rPath ) )
+		{
+			std::cerr << "Failed to add '" << rPath << "' to text-edit. File could not be mapped.\n";
+			return;
+		}
+	}
+	else
+	{
+		Text   = ReadWholeFile( rPath );
+		Ending = NormalizeLineBreaks( Text );
+	}
 
 	for( int i = 0; i < ( int )Files.size(); ++i )
 	{
@@ -241,9 +419,18 @@ void TextEdit::AddFile( const std::filesystem::path& rPath )
 			m_pTabBar->NextSelectedTabId = m_pTabBar->Tabs[ static_cast< int >( i ) ].ID;
 
 			// Update text in case rFile changed externally
-			rFile.Text = Text;
+			rFile.Buffer.Assign( std::move( Text ) );
+			rFile.Large.pFile   = std::move( pLarge );
+			rFile.Large.TopLine = 0;
+			rFile.Ending = Ending;
+			rFile.LineColors.clear();
+			rFile.XOffsets.clear();
+			rFile.LineWidthsGeneration = 0;
+
+			if( rFile.Highlighter.IsEnabled() )
+				rFile.Highlighter.Reset( rFile.Buffer.LineCount() );
 
-			SplitLines( rFile );
+			rFile.History.Clear();
 
 			return;
 		}
@@ -251,10 +438,14 @@ void TextEdit::AddFile( const std::filesystem::path& rPath )
 
 	File File;
 	File.Path       = rPath;
-	File.Text       = Text;
-	File.SearchDiag = new SearchDialog;
+	File.SearchDiag = std::make_unique< SearchDialog >();
+	File.Ending     = Ending;
 
-	SplitLines( File );
+	File.Buffer.Assign( std::move( Text ) );
+	File.Large.pFile = std::move( pLarge );
+
+	if( SyntaxHighlighter::Supports( rPath ) && !Large )
+		File.Highlighter.Reset( File.Buffer.LineCount() );
 
 	Files.emplace_back( std::move( File ) );
 
@@ -310,103 +501,402 @@ void TextEdit::SaveFile( File& rFile )
 {
 	if( !rFile.Changed ) return;
 
-	JoinLines( rFile );
+	std::shared_ptr< PendingSave >   pSave = std::make_shared< PendingSave >();
+	std::vector< JobSystem::JobPtr > Earlier;
 
-	std::ofstream ofs( rFile.Path, std::ios::binary | std::ios::trunc );
-	ofs << rFile.Text;
+	pSave->Path = rFile.Path;
 
-	rFile.Changed = false;
+	// An earlier save of the same file has to be done first, since both write the same temporary file
+	for( const std::shared_ptr< PendingSave >& rpOther : m_Saves )
+	{
+		if( rpOther->Path == rFile.Path )
+			Earlier.push_back( rpOther->Job );
+	}
+
+	pSave->Job = JobSystem::Instance().NewJob( [ pSave, Snapshot = rFile.Buffer.TakeSnapshot(), Ending = rFile.Ending ]( void )
+		{
+			pSave->Success = WriteSnapshot( pSave->Path, Snapshot, Ending );
+			pSave->Done.store( true, std::memory_order_release );
+		}, Earlier );
 
-	StatusBar::Instance().SetText( "Item saved : " + rFile.Path.string() );
+	m_Saves.push_back( std::move( pSave ) );
+
+	// Edits made from here on are not part of this save
+	rFile.Changed = false;
 
 } // SaveFile
 
 //////////////////////////////////////////////////////////////////////////
 
-void TextEdit::SplitLines( File& rFile )
+void TextEdit::WaitForSaves( void )
+{
+	for( const std::shared_ptr< PendingSave >& rpSave : m_Saves )
+	{
+		while( !rpSave->Done.load( std::memory_order_acquire ) )
+			std::this_thread::yield();
+	}
+
+	CollectSaves();
+
+} // WaitForSaves
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextEdit::CollectSaves( void )
 {
-	rFile.Lines.clear();
+	for( auto It = m_Saves.begin(); It != m_Saves.end(); )
+	{
+		const PendingSave& rSave = **It;
+
+		if( !rSave.Done.load( std::memory_order_acquire ) )
+		{
+			++It;
+			continue;
+		}
+
+		if( rSave.Success )
+		{
+			StatusBar::Instance().SetText( "Item saved : " + rSave.Path.string() );
+		}
+		else
+		{
+			StatusBar::Instance().SetText( "Failed to save : " + rSave.Path.string() );
+
+			// The file on disk is still the old one
+			for( File& rFile : Files )
+			{
+				if( rFile.Path == rSave.Path )
+					rFile.Changed = true;
+			}
+		}
 
-	rFile.Lines = SplitLines( rFile.Text );
+		It = m_Saves.erase( It );
+	}
 
-} // SplitLines
+} // CollectSaves
 
 //////////////////////////////////////////////////////////////////////////
 
-std::vector< TextEdit::Line > TextEdit::SplitLines( const std::string String, int* Count )
+TextEdit::LineEnding TextEdit::NormalizeLineBreaks( std::string& rText )
 {
-	Line                LineBuffer;
-	std::vector< Line > Lines;
+	const char* pText    = rText.data();
+	const char* pReturn  = static_cast< const char* >( std::memchr( pText, '\r', rText.size() ) );
+	const char* pNewLine = static_cast< const char* >( std::memchr( pText, '\n', rText.size() ) );
+
+	// Most files never have a carriage return in them, and those are left as they are
+	if( !pReturn )
+		return LineEnding::LF;
+
+	// The first line break decides how the file is saved
+	LineEnding Ending = LineEnding::LF;
 
-	for( int i = 0; i < ( int )String.length(); i++ )
+	if( !pNewLine || pReturn < pNewLine )
+		Ending = ( pReturn + 1 < pText + rText.size() && pReturn[ 1 ] == '\n' ) ? LineEnding::CRLF : LineEnding::CR;
+
+	// The buffer only knows about '\n', so both CRLF and lone CR line breaks are turned into LF, in place
+	size_t Write = pReturn - pText;
+
+	for( size_t Read = Write; Read < rText.size(); ++Read )
 	{
-		const char c = String[ i ];
+		const char c = rText[ Read ];
 
-		if( c == '\n' || c == '\r' )
+		if( c == '\r' )
 		{
-			if( c == '\r' ) i++;
+			if( Read + 1 < rText.size() && rText[ Read + 1 ] == '\n' ) ++Read;
 
-			Lines.emplace_back( std::move( LineBuffer ) );
+			rText[ Write++ ] = '\n';
 		}
 		else
 		{
-			LineBuffer.push_back( Glyph( c, m_Palette.Default ) );
+			rText[ Write++ ] = c;
+		}
+	}
+
+	rText.resize( Write );
+
+	return Ending;
+
+} // NormalizeLineBreaks
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextEdit::InsertText( File& rFile, size_t Offset, std::string_view Text )
+{
+	// An edit that changes nothing doesn't make a new version of the buffer either (see TextBuffer::MapLine)
+	if( Text.empty() )
+		return;
+
+	const int Line     = ( int )rFile.Buffer.LineOf( Offset );
+	const int NewLines = ( int )std::count( Text.begin(), Text.end(), '\n' );
+
+	CountLineWidths( rFile, Line, Line, false );
+
+	rFile.Buffer.Insert( Offset, Text );
+	rFile.History.Record( true, Offset, Text );
+
+	InvalidateLines( rFile, Line, Line, Line + NewLines );
+	CountLineWidths( rFile, Line, Line + NewLines, true );
+
+} // InsertText
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextEdit::EraseText( File& rFile, size_t Offset, size_t Length )
+{
+	if( Length == 0 )
+		return;
+
+	const int FirstLine = ( int )rFile.Buffer.LineOf( Offset );
+	const int LastLine  = ( int )rFile.Buffer.LineOf( Offset + Length );
+
+	rFile.History.Record( false, Offset, rFile.Buffer.GetText( Offset, Length ) );
+
+	CountLineWidths( rFile, FirstLine, LastLine, false );
+
+	rFile.Buffer.Erase( Offset, Length );
+
+	InvalidateLines( rFile, FirstLine, LastLine, FirstLine );
+	CountLineWidths( rFile, FirstLine, FirstLine, true );
+
+} // EraseText
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextEdit::InvalidateLines( File& rFile, int FirstLine, int OldLastLine, int NewLastLine )
+{
+	ShiftLines( rFile.LineColors, FirstLine, OldLastLine, NewLastLine );
+	ShiftLines( rFile.XOffsets, FirstLine, OldLastLine, NewLastLine );
+
+	rFile.Highlighter.LinesChanged( FirstLine, OldLastLine, NewLastLine );
+
+	UpdateSearchResults( rFile, FirstLine, OldLastLine, NewLastLine );
+
+} // InvalidateLines
+
+//////////////////////////////////////////////////////////////////////////
+
+std::vector< TextEdit::ColorSpan > TextEdit::ColorLine( File& rFile, int LineIndex, std::string_view Line )
+{
+	std::vector< ColorSpan > Spans;
+
+	for( const SyntaxHighlighter::Span& rSpan : rFile.Highlighter.Lex( LineIndex, Line ) )
+	{
+		unsigned int Color = m_Palette.Default;
+
+		switch( rSpan.Kind )
+		{
+			case SyntaxHighlighter::Token::Keyword: Color = m_Palette.Keyword; break;
+			case SyntaxHighlighter::Token::Number:  Color = m_Palette.Number;  break;
+			case SyntaxHighlighter::Token::String:  Color = m_Palette.String;  break;
+			case SyntaxHighlighter::Token::Comment: Color = m_Palette.Comment; break;
+			default:                                                           break;
 		}
+
+		Spans.push_back( ColorSpan{ rSpan.Start, Color } );
 	}
 
-	if( !LineBuffer.empty() ) Lines.push_back( LineBuffer );
+	return Spans;
 
-	if( Count )
+} // ColorLine
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextEdit::UpdateAdvances( void )
+{
+	const ImFont* pFont = ImGui::GetFont();
+	const float   Size  = ImGui::GetFontSize();
+
+	if( pFont == m_Advances.pFont && Size == m_Advances.Size )
+		return;
+
+	m_Advances.pFont     = pFont;
+	m_Advances.Size      = Size;
+	m_Advances.Scale     = Size / pFont->FontSize;
+	m_Advances.Monospace = true;
+	m_Advances.Generation++;
+
+	for( int c = 0; c < 128; ++c )
 	{
-		*Count = ( int )Lines.size();
+		// Same as CalcTextSizeA, which skips carriage returns
+		m_Advances.Ascii[ c ] = ( c == '\r' ) ? 0.0f : pFont->GetCharAdvance( static_cast< ImWchar >( c ) ) * m_Advances.Scale;
+
+		if( c != '\r' && c != '\t' && m_Advances.Ascii[ c ] != m_Advances.Ascii[ static_cast< int >( ' ' ) ] )
+			m_Advances.Monospace = false;
 	}
 
-	// We make a lot of assumptions that line vectors contain at least one element.
-	// Let's make sure the vector is never empty, even for empty input strings.
-	if( Lines.empty() ) Lines.emplace_back();
+} // UpdateAdvances
 
-	return Lines;
-}
+//////////////////////////////////////////////////////////////////////////
+
+float TextEdit::MeasureText( std::string_view Text, std::vector< float >* pOffsets ) const
+{
+	const float Tab = TabSize * m_Advances.Ascii[ static_cast< int >( ' ' ) ];
+	float       X   = 0.0f;
+	size_t      i   = 0;
+
+	if( pOffsets )
+		pOffsets->resize( Text.size() + 1 );
+
+	// A monospaced font only has to count columns, up until the first character that isn't ASCII
+	if( m_Advances.Monospace )
+	{
+		const size_t TabColumns = static_cast< size_t >( TabSize );
+		size_t       Column     = 0;
+
+		for( ; i < Text.size() && static_cast< unsigned char >( Text[ i ] ) < 0x80; ++i )
+		{
+			if( pOffsets )
+				( *pOffsets )[ i ] = Column * m_Advances.Ascii[ static_cast< int >( ' ' ) ];
+
+			if( Text[ i ] == '\t' ) Column = ( Column / TabColumns + 1 ) * TabColumns;
+			else if( Text[ i ] != '\r' )
+				++Column;
+		}
+
+		X = Column * m_Advances.Ascii[ static_cast< int >( ' ' ) ];
+	}
+
+	while( i < Text.size() )
+	{
+		const unsigned char C = static_cast< unsigned char >( Text[ i ] );
+
+		if( pOffsets )
+			( *pOffsets )[ i ] = X;
+
+		if( C == '\t' )
+		{
+			// A tab goes to the next tab stop, even if the text before it ends right on one (give or take rounding)
+			X = ( floorf( X / Tab + 0.001f ) + 1.0f ) * Tab;
+			++i;
+		}
+		else if( C < 0x80 )
+		{
+			X += m_Advances.Ascii[ C ];
+			++i;
+		}
+		else
+		{
+			unsigned int Codepoint = 0;
+			const int    Length    = std::max( ImTextCharFromUtf8( &Codepoint, Text.data() + i, Text.data() + Text.size() ), 1 );
+
+			X += m_Advances.pFont->GetCharAdvance( static_cast< ImWchar >( Codepoint ) ) * m_Advances.Scale;
+
+			// The bytes inside of a character are put at its end, so that a position never lands in the middle of it
+			for( int j = 1; pOffsets && j < Length && i + j < Text.size(); ++j )
+				( *pOffsets )[ i + j ] = X;
+
+			i += Length;
+		}
+	}
+
+	if( pOffsets )
+		pOffsets->back() = X;
+
+	return X;
+
+} // MeasureText
 
 //////////////////////////////////////////////////////////////////////////
 
-void TextEdit::JoinLines( File& rFile )
+const std::vector< float >& TextEdit::GetXOffsets( File& rFile, int LineIndex ) const
 {
-	rFile.Text.clear();
+	auto It = rFile.XOffsets.find( LineIndex );
 
-	for( size_t i = 0; i < rFile.Lines.size(); i++ )
+	if( It == rFile.XOffsets.end() )
 	{
-		Line&       rLine = rFile.Lines[ i ];
-		std::string Line  = GetString( rLine, 0, ( int )rLine.size() );
+		std::vector< float > Offsets;
+		MeasureText( rFile.Buffer.GetLine( LineIndex ), &Offsets );
+
+		It = rFile.XOffsets.emplace( LineIndex, std::move( Offsets ) ).first;
+	}
+
+	return It->second;
+
+} // GetXOffsets
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextEdit::BeginEdit( File& rFile, EditHistory::Kind Kind )
+{
+	rFile.History.Begin( Kind, CursorOffsets( rFile ) );
 
-		rFile.Text.append( Line );
-		rFile.Text.push_back( '\n' );
+} // BeginEdit
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextEdit::EndEdit( File& rFile )
+{
+	rFile.History.End( CursorOffsets( rFile ) );
+
+} // EndEdit
+
+//////////////////////////////////////////////////////////////////////////
+
+std::vector< size_t > TextEdit::CursorOffsets( File& rFile ) const
+{
+	std::vector< size_t > Offsets;
+	Offsets.reserve( rFile.Cursors.size() );
+
+	for( const Cursor& rCursor : rFile.Cursors )
+	{
+		if( !rCursor.Disabled )
+			Offsets.push_back( GetOffset( rFile, rCursor.Position ) );
 	}
 
-} // JoinLines
+	return Offsets;
+
+} // CursorOffsets
 
 //////////////////////////////////////////////////////////////////////////
 
-std::string TextEdit::GetString( const Line& rLine, int Start, int End )
+void TextEdit::Undo( File& rFile, bool Redo )
 {
-	std::string Result;
-	int         LineSize = ( int )rLine.size();
+	auto Apply = [ this, &rFile ]( bool Insert, size_t Offset, std::string_view Text )
+	{
+		if( Insert ) InsertText( rFile, Offset, Text );
+		else         EraseText( rFile, Offset, Text.size() );
+	};
 
-	End = End > LineSize ? LineSize : End;
+	std::vector< size_t > Marks;
+
+	if( !( Redo ? rFile.History.Redo( Apply, Marks ) : rFile.History.Undo( Apply, Marks ) ) )
+		return;
 
-	for( int i = Start; i < End; i++ )
+	// Put the cursors back where they were on that side of the edit
+	if( !Marks.empty() )
 	{
-		Result.push_back( rLine[ i ].C );
+		rFile.Cursors.clear();
+
+		for( size_t Offset : Marks )
+		{
+			const size_t Line = rFile.Buffer.LineOf( std::min( Offset, rFile.Buffer.Size() ) );
+			Cursor       NewCursor;
+
+			NewCursor.Position = Coordinate( ( int )( std::min( Offset, rFile.Buffer.Size() ) - rFile.Buffer.LineStart( Line ) ), ( int )Line );
+			rFile.Cursors.push_back( NewCursor );
+		}
+
+		YeetDuplicateCursors( rFile );
 	}
 
-	return Result;
+	rFile.CursorMultiMode = MultiCursorMode::Normal;
+	Props.Changes         = true;
+	Props.CursorBlink     = 0;
+
+	ScrollToCursor( rFile );
 
-} // GetLineString
+} // Undo
 
 //////////////////////////////////////////////////////////////////////////
 
 bool TextEdit::RenderEditor( File& rFile )
 {
+	if( rFile.Large.pFile )
+	{
+		RenderLargeFile( rFile );
+		return false;
+	}
+
 	Props.Changes = false;
 	ImGui::PushStyleColor( ImGuiCol_ChildBg, ImGui::ColorConvertU32ToFloat4( 0xFF101010 ) );
 	ImGui::PushStyleVar( ImGuiStyleVar_ItemSpacing, ImVec2( 0.0f, 0.0f ) );
@@ -414,9 +904,19 @@ bool TextEdit::RenderEditor( File& rFile )
 	ImGui::PushAllowKeyboardFocus( true );
 
 	CalculeteLineNumMaxWidth( rFile );
+	UpdateAdvances();
+
+	if( rFile.XOffsetsGeneration != m_Advances.Generation )
+	{
+		rFile.XOffsets.clear();
+		rFile.XOffsetsGeneration = m_Advances.Generation;
+	}
+
+	if( rFile.LineWidthsGeneration != m_Advances.Generation )
+		MeasureAllLines( rFile );
 
 	Props.CharAdvanceY = ImGui::GetTextLineHeightWithSpacing();
-	Props.SpaceSize    = ImGui::GetFont()->CalcTextSizeA( ImGui::GetFontSize(), FLT_MAX, -1.0f, " " ).x;
+	Props.SpaceSize    = m_Advances.Ascii[ static_cast< int >( ' ' ) ];
 
 	ImVec2 Size         = ImGui::GetContentRegionMax();
 	ImVec2 ScreenCursor = ImGui::GetCursorScreenPos();
@@ -438,14 +938,23 @@ bool TextEdit::RenderEditor( File& rFile )
 	HandleMouseInputs( rFile );
 
 	int FirstLine = ( int )( Props.ScrollY / Props.CharAdvanceY );
-	int LastLine  = std::min( FirstLine + ( int )( Size.y / Props.CharAdvanceY + 2 ), ( int )rFile.Lines.size() - 1 );
+	int LastLine  = std::min( FirstLine + ( int )( Size.y / Props.CharAdvanceY + 2 ), ( int )rFile.Buffer.LineCount() - 1 );
+
+	// Lines that now start in a different lexer state are colored anew
+	rFile.Highlighter.Update( rFile.Buffer, FirstLine, LastLine, [ &rFile ]( int First, int Last )
+		{
+			rFile.LineColors.erase( rFile.LineColors.lower_bound( First ), rFile.LineColors.upper_bound( Last ) );
+		} );
+
+	VisibleCursors Visible;
+	BucketCursors( rFile, FirstLine, LastLine, Visible );
 
 	for( int i = FirstLine; i <= LastLine; i++ )
 	{
-		ImVec2 Pos( ScreenCursor.x + Props.LineNumMaxWidth - Props.ScrollX, ScreenCursor.y + ( i - FirstLine ) * Props.CharAdvanceY );
-		Line&  rLine = rFile.Lines[ i ];
+		ImVec2      Pos( ScreenCursor.x + Props.LineNumMaxWidth - Props.ScrollX, ScreenCursor.y + ( i - FirstLine ) * Props.CharAdvanceY );
+		std::string Line = rFile.Buffer.GetLine( i );
 
-		std::vector< LineSelectionItem > Selections = IsLineSelected( rFile, i );
+		std::vector< LineSelectionItem > Selections = IsLineSelected( rFile, i, Visible.Selections[ i - FirstLine ] );
 
 		for( LineSelectionItem& rItem : Selections )
 		{
@@ -464,127 +973,112 @@ bool TextEdit::RenderEditor( File& rFile )
 			pDrawList->AddRectFilled( Start, End, rItem.Type == LineSelectionItem::Search ? m_Palette.SearchHighlight : m_Palette.Selection );
 		}
 
-		for( int j = 0; j < ( int )rFile.Cursors.size(); j++ )
+		for( int j : Visible.Positions[ i - FirstLine ] )
 		{
 			Cursor& rCursor = rFile.Cursors[ j ];
 
-			if( rCursor.Disabled ) continue;
+			bool Focus = ImGui::IsWindowFocused();
 
-			if( rCursor.Position.y == i )
+			if( !HasSelection( rFile, j ) && ( rFile.CursorMultiMode == MultiCursorMode::Normal || rFile.Cursors.size() == 1 ) )
 			{
-				bool Focus = ImGui::IsWindowFocused();
+				ImVec2 Start( ScreenCursor.x + Props.LineNumMaxWidth - 2, Pos.y );
+				ImVec2 End( ScreenCursor.x + Size.x - ImGui::GetStyle().ScrollbarSize, Pos.y + Props.CharAdvanceY );
 
-				if( !HasSelection( rFile, j ) && ( rFile.CursorMultiMode == MultiCursorMode::Normal || rFile.Cursors.size() == 1 ) )
-				{
-					ImVec2 Start( ScreenCursor.x + Props.LineNumMaxWidth - 2, Pos.y );
-					ImVec2 End( ScreenCursor.x + Size.x - ImGui::GetStyle().ScrollbarSize, Pos.y + Props.CharAdvanceY );
+				pDrawList->AddRectFilled( Start, End, Focus ? m_Palette.CurrentLine : m_Palette.CurrentLineInactive );
+				pDrawList->AddRect( Start, End, m_Palette.CurrentLineEdge );
+			}
 
-					pDrawList->AddRectFilled( Start, End, Focus ? m_Palette.CurrentLine : m_Palette.CurrentLineInactive );
-					pDrawList->AddRect( Start, End, m_Palette.CurrentLineEdge );
-				}
+			if( Focus )
+			{
+				static auto Start   = std::chrono::system_clock::now();
+				auto        Now     = std::chrono::system_clock::now();
+				long long   Elapsed = std::chrono::duration_cast< std::chrono::milliseconds >( Now - Start ).count();
 
-				if( Focus )
+				if( Elapsed >= Props.CursorBlink )
 				{
-					static auto Start   = std::chrono::system_clock::now();
-					auto        Now     = std::chrono::system_clock::now();
-					long long   Elapsed = std::chrono::duration_cast< std::chrono::milliseconds >( Now - Start ).count();
-
-					if( Elapsed >= Props.CursorBlink )
-					{
-						Elapsed -= Props.CursorBlink;
+					Elapsed -= Props.CursorBlink;
 
-						float  CursorPos = GetDistance( rFile, rCursor.Position );
-						ImVec2 cStart( Pos.x + CursorPos, Pos.y );
-						ImVec2 cEnd( cStart.x, cStart.y + Props.CharAdvanceY - 1 );
+					float  CursorPos = GetDistance( rFile, rCursor.Position );
+					ImVec2 cStart( Pos.x + CursorPos, Pos.y );
+					ImVec2 cEnd( cStart.x, cStart.y + Props.CharAdvanceY - 1 );
 
-						unsigned int Color = 0;
+					unsigned int Color = 0;
 
-						switch( rFile.CursorMode )
-						{
-							case CursorInputMode::Normal:
-								cEnd.x += 1.0f;
-								Color = m_Palette.Cursor;
-								break;
-							case CursorInputMode::Insert:
-								cEnd.x += Props.SpaceSize - 0.75f;
-								Color = m_Palette.CursorInsert;
-								break;
-						}
+					switch( rFile.CursorMode )
+					{
+						case CursorInputMode::Normal:
+							cEnd.x += 1.0f;
+							Color = m_Palette.Cursor;
+							break;
+						case CursorInputMode::Insert:
+							cEnd.x += Props.SpaceSize - 0.75f;
+							Color = m_Palette.CursorInsert;
+							break;
+					}
 
-						pDrawList->AddRectFilled( cStart, cEnd, Color );
+					pDrawList->AddRectFilled( cStart, cEnd, Color );
 
-						if( Props.CursorBlink ? Elapsed >= Props.CursorBlink : Elapsed >= CursorBlink * 2 )
-						{
-							Start             = Now;
-							Props.CursorBlink = CursorBlink;
-						}
+					if( Props.CursorBlink ? Elapsed >= Props.CursorBlink : Elapsed >= CursorBlink * 2 )
+					{
+						Start             = Now;
+						Props.CursorBlink = CursorBlink;
 					}
 				}
 			}
 		}
 
-		std::string StringBuffer;
-
-		float        XOffset   = 0.0f;
-		unsigned int PrevColor = ( unsigned int )rLine.size() ? rLine[ 0 ].Color : m_Palette.Default;
+		auto ColorsIt = rFile.LineColors.find( i );
 
-		for( Glyph& rGlyph : rLine )
-		{
-			if( rGlyph.Color != PrevColor || ( rGlyph.C == '\t' && !StringBuffer.empty() ) )
-			{
-				ImVec2 RenderStart( Pos.x + XOffset, Pos.y );
+		if( ColorsIt == rFile.LineColors.end() )
+			ColorsIt = rFile.LineColors.emplace( i, ColorLine( rFile, i, Line ) ).first;
 
-				pDrawList->AddText( RenderStart, PrevColor, StringBuffer.c_str() );
-				float TextWidth = ImGui::GetFont()->CalcTextSizeA( ImGui::GetFontSize(), FLT_MAX, -1.0f, StringBuffer.c_str() ).x;
-				XOffset += TextWidth;
-				StringBuffer.clear();
+		const std::vector< ColorSpan >& rSpans   = ColorsIt->second;
+		const std::vector< float >&     rOffsets = GetXOffsets( rFile, i );
 
-				PrevColor = rGlyph.Color;
-
-				if( rGlyph.C == '\t' )
-				{
-					float Tab = TabSize * Props.SpaceSize;
+		const char*  pText     = Line.data();
+		const char*  pRunStart = pText;
+		const char*  pLineEnd  = pText + Line.size();
+		size_t       NextSpan  = 1;
+		unsigned int Color     = rSpans.empty() ? m_Palette.Default : rSpans[ 0 ].Color;
 
-					XOffset += Tab;
+		auto DrawRun = [ & ]( const char* pRunEnd )
+		{
+			if( pRunEnd != pRunStart )
+				pDrawList->AddText( ImVec2( Pos.x + rOffsets[ pRunStart - pText ], Pos.y ), Color, pRunStart, pRunEnd );
 
-					float Fraction = XOffset / Tab;
-					Fraction       = Fraction - floorf( Fraction );
+			pRunStart = pRunEnd;
+		};
 
-					XOffset -= Tab * Fraction;
-				}
-				else
-				{
-					StringBuffer.push_back( rGlyph.C );
-				}
-			}
-			else if( rGlyph.C == '\t' )
-			{
-				XOffset += TabSize * Props.SpaceSize;
-			}
-			else
+		// Text is drawn in runs that end at tabs and wherever the color changes, each one starting where the line was measured to
+		for( const char* p = pText; p != pLineEnd; ++p )
+		{
+			while( NextSpan < rSpans.size() && rSpans[ NextSpan ].Start <= ( uint32_t )( p - pText ) )
 			{
-				StringBuffer.push_back( rGlyph.C );
+				DrawRun( p );
+				Color = rSpans[ NextSpan++ ].Color;
 			}
-		}
 
-		if( !StringBuffer.empty() )
-		{
-			ImVec2 RenderStart( Pos.x + XOffset, Pos.y );
+			if( *p != '\t' ) continue;
+
+			DrawRun( p );
 
-			pDrawList->AddText( RenderStart, PrevColor, StringBuffer.c_str() );
-			float TextWidth = ImGui::GetFont()->CalcTextSizeA( ImGui::GetFontSize(), FLT_MAX, -1.0f, StringBuffer.c_str() ).x;
-			XOffset += TextWidth;
-			StringBuffer.clear();
+			pRunStart = p + 1;
 		}
+
+		DrawRun( pLineEnd );
 	}
 
-	CheckLineLengths( rFile, FirstLine, LastLine );
+	std::erase_if( rFile.LineColors, [ FirstLine, LastLine ]( const auto& rEntry ) { return rEntry.first < FirstLine || rEntry.first > LastLine; } );
+
+	// Offsets of lines that are out of view are kept for a while, since the cursor that is scrolled to is measured every frame
+	if( rFile.XOffsets.size() > MaxCachedXOffsets )
+		std::erase_if( rFile.XOffsets, [ FirstLine, LastLine ]( const auto& rEntry ) { return rEntry.first < FirstLine || rEntry.first > LastLine; } );
 
-	float Width = GetMaxCursorDistance( rFile );
+	float Width = GetMaxCursorDistance( rFile, Visible );
 
-	if( rFile.LongestLineLength > Width ) Width = rFile.LongestLineLength;
+	if( !rFile.LineWidths.empty() ) Width = std::max( Width, rFile.LineWidths.rbegin()->first );
 
-	ImGui::Dummy( ImVec2( Width + DummyExtraX, ( rFile.Lines.size() + DummyExtraY ) * Props.CharAdvanceY ) );
+	ImGui::Dummy( ImVec2( Width + DummyExtraX, ( rFile.Buffer.LineCount() + DummyExtraY ) * Props.CharAdvanceY ) );
 
 	ImGui::PopAllowKeyboardFocus();
 	ImGui::EndChild();
@@ -636,22 +1130,49 @@ void TextEdit::HandleKeyboardInputs( File& rFile )
 		rIO.WantCaptureKeyboard = true;
 		rIO.WantTextInput       = true;
 
+		bool Handled = true;
+
 		if( !Shift && !Ctrl & !Alt && ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_Enter ) ) )
+		{
+			BeginEdit( rFile, EditHistory::Kind::Other );
 			Enter( rFile );
+			EndEdit( rFile );
+		}
 		else if( !Shift && !Ctrl && !Alt && ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_Backspace ) ) )
+		{
+			BeginEdit( rFile, EditHistory::Kind::Deleting );
 			Backspace( rFile );
+			EndEdit( rFile );
+		}
 		else if( !Ctrl && ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_UpArrow ) ) )
+		{
+			// Alt moves the lines themselves
+			if( Alt ) BeginEdit( rFile, EditHistory::Kind::Other );
 			MoveUp( rFile, Shift, Alt );
+			if( Alt ) EndEdit( rFile );
+		}
 		else if( !Ctrl && ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_DownArrow ) ) )
+		{
+			if( Alt ) BeginEdit( rFile, EditHistory::Kind::Other );
 			MoveDown( rFile, Shift, Alt );
+			if( Alt ) EndEdit( rFile );
+		}
 		else if( ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_RightArrow ) ) )
 			MoveRight( rFile, Ctrl, Shift, Alt );
 		else if( ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_LeftArrow ) ) )
 			MoveLeft( rFile, Ctrl, Shift, Alt );
 		else if( !Alt && !Ctrl && ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_Delete ) ) )
+		{
+			BeginEdit( rFile, EditHistory::Kind::Deleting );
 			Del( rFile );
+			EndEdit( rFile );
+		}
 		else if( !Alt && !Ctrl && ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_Tab ) ) )
+		{
+			BeginEdit( rFile, EditHistory::Kind::Other );
 			Tab( rFile, Shift );
+			EndEdit( rFile );
+		}
 		else if( !Alt && ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_Home ) ) )
 			Home( rFile, Ctrl, Shift );
 		else if( !Alt && ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_End ) ) )
@@ -663,21 +1184,42 @@ void TextEdit::HandleKeyboardInputs( File& rFile )
 		else if( !Alt && !Shift && Ctrl && ImGui::IsKeyPressed( 'C' ) )
 			Copy( rFile, false );
 		else if( !Alt && !Shift && Ctrl && ImGui::IsKeyPressed( 'X' ) )
+		{
+			BeginEdit( rFile, EditHistory::Kind::Other );
 			Copy( rFile, true );
+			EndEdit( rFile );
+		}
 		else if( !Alt && !Shift && Ctrl && ImGui::IsKeyPressed( 'V' ) )
+		{
+			BeginEdit( rFile, EditHistory::Kind::Other );
 			Paste( rFile );
+			EndEdit( rFile );
+		}
+		else if( !Alt && !Shift && Ctrl && ImGui::IsKeyPressed( 'Z' ) )
+			Undo( rFile, false );
+		else if( !Alt && Ctrl && ( ( !Shift && ImGui::IsKeyPressed( 'Y' ) ) || ( Shift && ImGui::IsKeyPressed( 'Z' ) ) ) )
+			Undo( rFile, true );
 		else if( !Alt && !Ctrl && !Shift && ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_Insert ) ) && rFile.CursorMultiMode == MultiCursorMode::Normal )
 			rFile.CursorMode = rFile.CursorMode == CursorInputMode::Normal ? CursorInputMode::Insert : CursorInputMode::Normal;
 		else if( !Alt && Ctrl && !Shift && ImGui::IsKeyPressed( 'A' ) )
 			SelectAll( rFile );
 		else if( !Alt && Ctrl && !Shift && ImGui::IsKeyPressed( 'F' ) )
 			rFile.SearchDiag->Searching = true;
+		else
+			Handled = false;
+
+		// The keys may have moved the cursors from under a selection that is being dragged out
+		if( Handled || rIO.InputQueueCharacters.Size > 0 )
+			rFile.SelectionDrag.Valid = false;
 
 		for( int i = 0; i < rIO.InputQueueCharacters.Size; i++ )
 		{
 			char c = ( char )rIO.InputQueueCharacters[ i ];
 
+			// Characters typed in a row are undone together, word by word, while whitespace gets a step of its own
+			BeginEdit( rFile, ( c == ' ' || c == '\t' ) ? EditHistory::Kind::Other : EditHistory::Kind::Typing );
 			EnterTextStuff( rFile, c );
+			EndEdit( rFile );
 		}
 	}
 
@@ -703,6 +1245,10 @@ void TextEdit::HandleMouseInputs( File& rFile )
 		bool   Dragged       = ImGui::IsMouseDragging( ImGuiMouseButton_Left );
 		ImVec2 MouseCoords   = GetMousePosition();
 
+		// A click starts over with a new set of cursors
+		if( Clicked )
+			rFile.SelectionDrag.Valid = false;
+
 		if( ImGui::IsMouseReleased( ImGuiMouseButton_Left ) || ( Props.Changes && ImGui::IsMouseDown( ImGuiMouseButton_Left ) ) )
 		{
 			if( Props.Changes )
@@ -1026,83 +1572,277 @@ void TextEdit::ScrollTo( File& rFile, Coordinate Position, ImGuiWindow* pWindow
 
 //////////////////////////////////////////////////////////////////////////
 
-void TextEdit::CheckLineLengths( File& rFile, int FirstLine, int LastLine )
+void TextEdit::CountLineWidths( File& rFile, int FirstLine, int LastLine, bool Add )
 {
+	// Nothing to keep up to date until the file has been measured
+	if( rFile.LineWidthsGeneration != m_Advances.Generation )
+		return;
+
 	for( int i = FirstLine; i <= LastLine; i++ )
 	{
-		Line& rLine        = rFile.Lines[ i ];
-		float Length       = GetDistance( rFile, Coordinate( ( int )rLine.size(), i ) );
-		int   NumLongLines = ( int )rFile.LongestLines.size();
-		int   Line         = -1;
-		int   j            = 0;
+		auto        OffsetsIt = rFile.XOffsets.find( i );
+		const float Width     = ( OffsetsIt != rFile.XOffsets.end() ) ? OffsetsIt->second.back() : MeasureText( rFile.Buffer.GetLine( i ), nullptr );
 
-		for( ; j < NumLongLines; j++ )
+		if( Add )
 		{
-			Line = rFile.LongestLines[ j ];
-
-			if( i == Line )
-			{
-				break;
-			}
-			else
-			{
-				Line = -1;
-			}
+			rFile.LineWidths[ Width ]++;
 		}
-
-		if( Length > rFile.LongestLineLength )
+		else if( auto It = rFile.LineWidths.find( Width ); It != rFile.LineWidths.end() && --It->second == 0 )
 		{
-			rFile.LongestLines.clear();
-			rFile.LongestLines.push_back( i );
-
-			rFile.LongestLineLength = Length;
+			rFile.LineWidths.erase( It );
 		}
-		else if( Line != -1 )
+	}
+
+} // CountLineWidths
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextEdit::MeasureAllLines( File& rFile )
+{
+	std::string Partial;
+
+	rFile.LineWidths.clear();
+
+	// Lines that are split between pieces are put back together, the rest are measured where they are
+	rFile.Buffer.ForEachChunk( 0, rFile.Buffer.Size(), [ & ]( std::string_view Chunk )
 		{
-			if( Length < rFile.LongestLineLength )
+			for( size_t Break; ( Break = Chunk.find( '\n' ) ) != std::string_view::npos; Chunk.remove_prefix( Break + 1 ) )
 			{
-				rFile.LongestLines.erase( rFile.LongestLines.begin() + j );
-
-				if( NumLongLines == 1 )
+				if( Partial.empty() )
 				{
-					rFile.LongestLineLength = 0.0f;
-
-					CheckLineLengths( rFile, 0, ( int )rFile.Lines.size() - 1 );
+					rFile.LineWidths[ MeasureText( Chunk.substr( 0, Break ), nullptr ) ]++;
+				}
+				else
+				{
+					Partial.append( Chunk.substr( 0, Break ) );
+					rFile.LineWidths[ MeasureText( Partial, nullptr ) ]++;
+					Partial.clear();
 				}
 			}
-		}
-		else if( Length == rFile.LongestLineLength )
+
+			Partial.append( Chunk );
+		} );
+
+	rFile.LineWidths[ MeasureText( Partial, nullptr ) ]++;
+	rFile.LineWidthsGeneration = m_Advances.Generation;
+
+} // MeasureAllLines
+
+//////////////////////////////////////////////////////////////////////////
+
+float TextEdit::GetMaxCursorDistance( File& rFile, const VisibleCursors& rVisible )
+{
+	float Distance = 0.0f;
+
+	// Cursors out of view only count if they are the one being scrolled to, so that there is room to scroll to it
+	if( !rFile.Cursors.empty() )
+		Distance = GetDistance( rFile, rFile.Cursors.back().Position );
+
+	for( const std::vector< int >& rLine : rVisible.Positions )
+	{
+		for( int CursorIndex : rLine )
 		{
-			rFile.LongestLines.push_back( i );
+			float L = GetDistance( rFile, rFile.Cursors[ CursorIndex ].Position );
+
+			if( L > Distance ) Distance = L;
 		}
 	}
 
-} // CheckLineLengths
+	return Distance;
+
+} // GetMaxCursorDistance
 
 //////////////////////////////////////////////////////////////////////////
 
-float TextEdit::GetMaxCursorDistance( File& rFile )
+void TextEdit::BucketCursors( File& rFile, int FirstLine, int LastLine, VisibleCursors& rVisible ) const
 {
-	float Distance = 0.0f;
+	const size_t LineCount = ( size_t )std::max( LastLine - FirstLine + 1, 0 );
 
-	for( Cursor& rCursor : rFile.Cursors )
+	rVisible.FirstLine = FirstLine;
+	rVisible.Positions.assign( LineCount, { } );
+	rVisible.Selections.assign( LineCount, { } );
+
+	for( int i = 0; i < ( int )rFile.Cursors.size(); i++ )
 	{
+		const Cursor& rCursor = rFile.Cursors[ i ];
+
 		if( rCursor.Disabled ) continue;
 
-		float L = GetDistance( rFile, rCursor.Position );
+		if( rCursor.Position.y >= FirstLine && rCursor.Position.y <= LastLine )
+			rVisible.Positions[ rCursor.Position.y - FirstLine ].push_back( i );
 
-		if( L > Distance ) Distance = L;
+		if( rCursor.SelectionStart == rCursor.SelectionEnd ) continue;
+
+		// A selection always shows on its first line, even when it runs backwards
+		const int First = std::max( rCursor.SelectionStart.y, FirstLine );
+		const int Last  = std::min( std::max( rCursor.SelectionStart.y, rCursor.SelectionEnd.y ), LastLine );
+
+		for( int Line = First; Line <= Last; Line++ )
+			rVisible.Selections[ Line - FirstLine ].push_back( i );
 	}
 
-	return Distance;
+} // BucketCursors
 
-} // GetMaxCursorDistance
+//////////////////////////////////////////////////////////////////////////
+
+void TextEdit::RenderLargeFile( File& rFile )
+{
+	LargeFileState& rLarge     = rFile.Large;
+	LargeFile&      rLargeFile = *rLarge.pFile;
+
+	// Header; how far along the index is, and searching
+	if( rLargeFile.IsIndexed() ) ImGui::Text( "Read-only, %llu lines", static_cast< unsigned long long >( rLargeFile.LineCount() ) );
+	else
+		ImGui::Text( "Read-only, indexing %d%% (%llu lines so far)", static_cast< int >( rLargeFile.IndexProgress() * 100.0f ), static_cast< unsigned long long >( rLargeFile.LineCount() ) );
+
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth( 200.0f );
+
+	const bool Submitted = ImGui::InputTextWithHint( "##LargeFileSearch", "Find", &rLarge.SearchTerm, ImGuiInputTextFlags_EnterReturnsTrue );
+
+	ImGui::SameLine();
+
+	if( ( ImGui::Button( "Find next" ) || Submitted ) && !rLarge.SearchTerm.empty() )
+	{
+		rLarge.NotFound = false;
+		rLargeFile.StartSearch( rLarge.SearchTerm, rLarge.TopLine + 1 );
+	}
+
+	uint64_t FoundLine = 0;
+
+	switch( rLargeFile.PollSearch( FoundLine ) )
+	{
+		case LargeFile::SearchStatus::Searching:
+			ImGui::SameLine();
+			ImGui::Text( "Searching %d%%", static_cast< int >( rLargeFile.SearchProgress() * 100.0f ) );
+			break;
+
+		case LargeFile::SearchStatus::Found:
+			rLarge.TopLine = FoundLine;
+			break;
+
+		case LargeFile::SearchStatus::NotFound:
+			rLarge.NotFound = true;
+			break;
+
+		case LargeFile::SearchStatus::None:
+			break;
+	}
+
+	if( rLarge.NotFound )
+	{
+		ImGui::SameLine();
+		ImGui::TextUnformatted( "Not found" );
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	ImGui::PushStyleColor( ImGuiCol_ChildBg, ImGui::ColorConvertU32ToFloat4( 0xFF101010 ) );
+	ImGui::PushStyleVar( ImGuiStyleVar_ItemSpacing, ImVec2( 0.0f, 0.0f ) );
+
+	Props.CharAdvanceY = ImGui::GetTextLineHeightWithSpacing();
+	Props.SpaceSize    = ImGui::GetFont()->CalcTextSizeA( ImGui::GetFontSize(), FLT_MAX, -1.0f, " " ).x;
+
+	const ImVec2   Size       = ImGui::GetContentRegionAvail();
+	const float    ScrollBarW = ImGui::GetStyle().ScrollbarSize;
+	const size_t   PageLines  = static_cast< size_t >( std::max( Size.y / Props.CharAdvanceY, 1.0f ) );
+	const uint64_t LineCount  = rLargeFile.LineCount();
+	const uint64_t MaxTopLine = LineCount > PageLines ? LineCount - PageLines : 0;
+
+	ImGui::BeginChild( "##LargeFile", ImVec2( Size.x - ScrollBarW, Size.y ), false, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoScrollWithMouse | ImGuiWindowFlags_HorizontalScrollbar );
+
+	// Scrolling goes by whole lines rather than pixels, since a float can't tell every line of a file this large apart
+	if( ImGui::IsWindowHovered() )
+	{
+		const float Wheel = ImGui::GetIO().MouseWheel;
+
+		if( Wheel > 0.0f ) rLarge.TopLine -= std::min< uint64_t >( rLarge.TopLine, static_cast< uint64_t >( Wheel * 3.0f ) );
+		else if( Wheel < 0.0f )
+			rLarge.TopLine += static_cast< uint64_t >( -Wheel * 3.0f );
+	}
+
+	if( ImGui::IsWindowFocused() )
+	{
+		const bool Ctrl = ImGui::GetIO().KeyCtrl;
+
+		if( ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_UpArrow ) ) ) rLarge.TopLine -= std::min< uint64_t >( rLarge.TopLine, 1 );
+		if( ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_DownArrow ) ) ) rLarge.TopLine += 1;
+		if( ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_PageUp ) ) ) rLarge.TopLine -= std::min< uint64_t >( rLarge.TopLine, PageLines );
+		if( ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_PageDown ) ) ) rLarge.TopLine += PageLines;
+		if( Ctrl && ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_Home ) ) ) rLarge.TopLine = 0;
+		if( Ctrl && ImGui::IsKeyPressed( ImGui::GetKeyIndex( ImGuiKey_End ) ) ) rLarge.TopLine = MaxTopLine;
+	}
+
+	rLarge.TopLine = std::min( rLarge.TopLine, MaxTopLine );
+
+	const std::vector< std::string >& rLines = rLargeFile.GetLines( rLarge.TopLine, PageLines + 1 );
+
+	char Buf[ 32 ];
+	sprintf( Buf, " %llu | ", static_cast< unsigned long long >( LineCount ) );
+
+	Props.LineNumMaxWidth = ImGui::GetFont()->CalcTextSizeA( ImGui::GetFontSize(), FLT_MAX, -1.0f, Buf ).x;
+
+	ImDrawList*  pDrawList = ImGui::GetWindowDrawList();
+	const ImVec2 Origin    = ImGui::GetCursorScreenPos();
+	const float  ScrollX   = ImGui::GetScrollX();
+	float        Width     = 0.0f;
+	std::string  Expanded;
+
+	for( size_t i = 0; i < rLines.size(); ++i )
+	{
+		// Tabs are simply expanded to the tab grid, since nothing here has to line up with a cursor
+		Expanded.clear();
+
+		for( char C : rLines[ i ] )
+		{
+			if( C == '\t' ) Expanded.append( static_cast< size_t >( TabSize ) - Expanded.size() % static_cast< size_t >( TabSize ), ' ' );
+			else
+				Expanded.push_back( C );
+		}
+
+		const char* pBegin = Expanded.data();
+		const char* pEnd   = pBegin + Expanded.size();
+
+		pDrawList->AddText( ImVec2( Origin.x + Props.LineNumMaxWidth - ScrollX, Origin.y + i * Props.CharAdvanceY ), m_Palette.Default, pBegin, pEnd );
+
+		Width = std::max( Width, ImGui::GetFont()->CalcTextSizeA( ImGui::GetFontSize(), FLT_MAX, -1.0f, pBegin, pEnd ).x );
+	}
+
+	// Line numbers go on top of the text, so that they stay put when scrolling sideways
+	pDrawList->AddRectFilled( Origin, ImVec2( Origin.x + Props.LineNumMaxWidth, Origin.y + Size.y ), 0xFF101010 );
+
+	for( size_t i = 0; i < rLines.size(); ++i )
+	{
+		sprintf( Buf, "%llu | ", static_cast< unsigned long long >( rLarge.TopLine + i + 1 ) );
+
+		const float CurrentLineNumWidth = ImGui::GetFont()->CalcTextSizeA( ImGui::GetFontSize(), FLT_MAX, -1.0f, Buf ).x;
+
+		pDrawList->AddText( ImVec2( Origin.x + Props.LineNumMaxWidth - CurrentLineNumWidth, Origin.y + i * Props.CharAdvanceY ), m_Palette.LineNumber, Buf );
+	}
+
+	ImGui::Dummy( ImVec2( Props.LineNumMaxWidth + Width + DummyExtraX, Size.y - ScrollBarW ) );
+
+	ImGui::EndChild();
+
+	// The scrollbar counts lines as well, with the first line at the top
+	ImGui::SameLine();
+
+	uint64_t       Inverted = MaxTopLine - rLarge.TopLine;
+	const uint64_t Zero     = 0;
+
+	if( ImGui::VSliderScalar( "##LargeFileScroll", ImVec2( ScrollBarW, Size.y ), ImGuiDataType_U64, &Inverted, &Zero, &MaxTopLine, "" ) )
+		rLarge.TopLine = MaxTopLine - std::min( Inverted, MaxTopLine );
+
+	ImGui::PopStyleVar();
+	ImGui::PopStyleColor();
+
+} // RenderLargeFile
 
 //////////////////////////////////////////////////////////////////////////
 
 void TextEdit::CalculeteLineNumMaxWidth( File& rFile )
 {
-	int TotalLines = ( int )rFile.Lines.size();
+	int TotalLines = ( int )rFile.Buffer.LineCount();
 
 	char Buf[ 32 ];
 	sprintf( Buf, " %u | ", TotalLines );
@@ -1165,7 +1905,7 @@ TextEdit::LineSelectionItem TextEdit::IsSelectionOnLine( File& rFile, int LineIn
 		else
 		{
 			Item.End.y = LineIndex;
-			Item.End.x = ( int )rFile.Lines[ LineIndex ].size();
+			Item.End.x = ( int )rFile.Buffer.LineLength( LineIndex );
 		}
 	}
 	else if( LineIndex >= Start.y && LineIndex <= End.y )
@@ -1180,7 +1920,7 @@ TextEdit::LineSelectionItem TextEdit::IsSelectionOnLine( File& rFile, int LineIn
 		else
 		{
 			Item.End.y = LineIndex;
-			Item.End.x = ( int )rFile.Lines[ LineIndex ].size();
+			Item.End.x = ( int )rFile.Buffer.LineLength( LineIndex );
 		}
 	}
 	else
@@ -1191,13 +1931,13 @@ TextEdit::LineSelectionItem TextEdit::IsSelectionOnLine( File& rFile, int LineIn
 	return Item;
 }
 
-std::vector< TextEdit::LineSelectionItem > TextEdit::IsLineSelected( File& rFile, int LineIndex ) const
+std::vector< TextEdit::LineSelectionItem > TextEdit::IsLineSelected( File& rFile, int LineIndex, const std::vector< int >& rCursors ) const
 {
 	std::vector< LineSelectionItem > Selections;
 
-	for( Cursor& rCursor : rFile.Cursors )
+	for( int CursorIndex : rCursors )
 	{
-		if( rCursor.SelectionStart == rCursor.SelectionEnd || rCursor.Disabled ) continue;
+		const Cursor& rCursor = rFile.Cursors[ CursorIndex ];
 
 		LineSelectionItem Item = IsSelectionOnLine( rFile, LineIndex, rCursor.SelectionStart, rCursor.SelectionEnd );
 
@@ -1212,18 +1952,18 @@ std::vector< TextEdit::LineSelectionItem > TextEdit::IsLineSelected( File& rFile
 
 	if( rDiag.SearchResult )
 	{
-		if( rDiag.SearchResult->GroupExist( LineIndex ) )
+		std::vector< LineSelectionItem > Results;
+		rDiag.SearchResult->GetLine( LineIndex, Results );
+
+		for( const LineSelectionItem& rSearch : Results )
 		{
-			for( LineSelectionItem* pSearch : rDiag.SearchResult->GetGroup( LineIndex ) )
-			{
-				LineSelectionItem Item = IsSelectionOnLine( rFile, LineIndex, pSearch->Start, pSearch->End );
+			LineSelectionItem Item = IsSelectionOnLine( rFile, LineIndex, rSearch.Start, rSearch.End );
 
-				if( Item.Type == -1 ) continue;
+			if( Item.Type == -1 ) continue;
 
-				Item.Type = pSearch->Type;
+			Item.Type = rSearch.Type;
 
-				Selections.push_back( Item );
-			}
+			Selections.push_back( Item );
 		}
 	}
 
@@ -1233,53 +1973,27 @@ std::vector< TextEdit::LineSelectionItem > TextEdit::IsLineSelected( File& rFile
 
 //////////////////////////////////////////////////////////////////////////
 
-float TextEdit::GetDistance( File& rFile, Coordinate Position ) const
+size_t TextEdit::GetOffset( File& rFile, Coordinate Position ) const
 {
-	const Line& rLine = rFile.Lines[ Position.y ];
-
-	std::string String;
-
-	float XOffset = 0.0f;
+	const size_t LineLength = rFile.Buffer.LineLength( Position.y );
+	const size_t Column     = static_cast< size_t >( std::max( Position.x, 0 ) );
 
-	int Length = Position.x > ( int )rLine.size() ? ( int )rLine.size() : Position.x;
-
-	for( int i = 0; i < Length; i++ )
-	{
-		char c = rLine[ i ].C;
-
-		if( c == '\t' )
-		{
-			float Tab = TabSize * Props.SpaceSize;
+	return rFile.Buffer.LineStart( Position.y ) + std::min( Column, LineLength );
 
-			XOffset += Tab;
+} // GetOffset
 
-			if( String.empty() ) continue;
-
-			XOffset += ImGui::GetFont()->CalcTextSizeA( ImGui::GetFontSize(), FLT_MAX, -1.0f, String.c_str() ).x;
-
-			float Fraction = XOffset / Tab;
-			Fraction       = Fraction - floorf( Fraction );
-
-			XOffset -= Fraction * Tab;
-			String.clear();
-		}
-		else
-		{
-			String.push_back( c );
-		}
-	}
+//////////////////////////////////////////////////////////////////////////
 
-	if( !String.empty() )
-	{
-		XOffset += ImGui::GetFont()->CalcTextSizeA( ImGui::GetFontSize(), FLT_MAX, -1.0f, String.c_str() ).x;
-	}
+float TextEdit::GetDistance( File& rFile, Coordinate Position ) const
+{
+	if( Position.x <= 0 )
+		return 0.0f;
 
-	if( int Extra = Position.x - Length )
-	{
-		XOffset += ( float )Extra * Props.SpaceSize;
-	}
+	const std::vector< float >& rOffsets = GetXOffsets( rFile, Position.y );
+	const int                   Length   = std::min( Position.x, ( int )rOffsets.size() - 1 );
 
-	return XOffset;
+	// Past the end of the line, it's all spaces
+	return rOffsets[ Length ] + ( float )( Position.x - Length ) * Props.SpaceSize;
 
 } // GetDistance
 
@@ -1295,8 +2009,8 @@ std::string TextEdit::GetWordAt( File& rFile, Cursor& rCursor ) const
 
 std::string TextEdit::GetWordAt( File& rFile, Coordinate Position, Coordinate* pStart, Coordinate* pEnd ) const
 {
-	const Line& rLine    = rFile.Lines[ Position.y ];
-	int         LineSize = ( int )rLine.size();
+	const std::string Line     = rFile.Buffer.GetLine( Position.y );
+	int               LineSize = ( int )Line.size();
 
 	if( LineSize == 0 )
 	{
@@ -1311,19 +2025,19 @@ std::string TextEdit::GetWordAt( File& rFile, Coordinate Position, Coordinate* p
 		Position.x = LineSize - 1;
 	}
 
-	char c = rLine[ Position.x ].C;
+	char c = Line[ Position.x ];
 
 	std::string Buffer;
 
-	auto getRegion = [ &Buffer, &rLine, &Position, pStart, pEnd ]( bool ( *cmpFunc )( char c ) ) -> std::string
+	auto getRegion = [ &Buffer, &Line, &Position, pStart, pEnd ]( bool ( *cmpFunc )( char c ) ) -> std::string
 	{
-		int Len = ( int )rLine.size();
+		int Len = ( int )Line.size();
 		int x0  = 0;
 		int x1  = Len;
 
 		for( int i = Position.x + 1; i < Len; i++ )
 		{
-			char Chr = rLine[ i ].C;
+			char Chr = Line[ i ];
 			if( !cmpFunc( Chr ) )
 			{
 				x1 = i;
@@ -1335,7 +2049,7 @@ std::string TextEdit::GetWordAt( File& rFile, Coordinate Position, Coordinate* p
 
 		for( int i = Position.x; i >= 0; i-- )
 		{
-			char Chr = rLine[ i ].C;
+			char Chr = Line[ i ];
 			if( !cmpFunc( Chr ) )
 			{
 				x0 = i + 1;
@@ -1372,7 +2086,7 @@ std::string TextEdit::GetWordAt( File& rFile, Coordinate Position, Coordinate* p
 	}
 	else if( cmpWhitespace( c ) )
 	{
-		char lc = Position.x == 0 ? ' ' : rLine[ Position.x - 1 ].C;
+		char lc = Position.x == 0 ? ' ' : Line[ Position.x - 1 ];
 
 		if( cmpWhitespace( lc ) )
 		{
@@ -1434,33 +2148,6 @@ bool TextEdit::IsCoordinateInText( File& rFile, Coordinate Position )
 
 //////////////////////////////////////////////////////////////////////////
 
-void TextEdit::AdjustCursorIfInText( File& rFile, Cursor& rCursor, int LineIndex, int XOffset )
-{
-	if( XOffset > 0 )
-	{
-		rCursor.Position.x += XOffset;
-		rCursor.SelectionOrigin.x += XOffset;
-		rCursor.SelectionStart.x += XOffset;
-		rCursor.SelectionEnd.x += XOffset;
-	}
-
-	if( IsCoordinateInText( rFile, rCursor.Position ) && LineIndex == rCursor.Position.y ) rCursor.Position.x += XOffset;
-	if( IsCoordinateInText( rFile, rCursor.SelectionOrigin ) && LineIndex == rCursor.SelectionOrigin.y ) rCursor.SelectionOrigin.x += XOffset;
-	if( IsCoordinateInText( rFile, rCursor.SelectionStart ) && LineIndex == rCursor.SelectionStart.y ) rCursor.SelectionStart.x += XOffset;
-	if( IsCoordinateInText( rFile, rCursor.SelectionEnd ) && LineIndex == rCursor.SelectionEnd.y ) rCursor.SelectionEnd.x += XOffset;
-
-	if( XOffset > 0 )
-	{
-		rCursor.Position.x -= XOffset;
-		rCursor.SelectionOrigin.x -= XOffset;
-		rCursor.SelectionStart.x -= XOffset;
-		rCursor.SelectionEnd.x -= XOffset;
-	}
-
-} // AdjustCursorIfInText
-
-//////////////////////////////////////////////////////////////////////////
-
 void TextEdit::AdjustCursor( Cursor& rCursor, int XOffset )
 {
 	rCursor.Position.x += XOffset;
@@ -1478,12 +2165,10 @@ void TextEdit::AdjustCursor( Cursor& rCursor, int XOffset )
 
 void TextEdit::SetSelectionLine( File& rFile, int LineIndex )
 {
-	if( LineIndex >= ( int )rFile.Lines.size() ) return;
-
-	Line& rLine = rFile.Lines[ LineIndex ];
+	if( LineIndex >= ( int )rFile.Buffer.LineCount() ) return;
 
 	Coordinate Start( 0, LineIndex );
-	Coordinate End( ( int )rLine.size(), LineIndex );
+	Coordinate End( ( int )rFile.Buffer.LineLength( LineIndex ), LineIndex );
 
 	SetSelection( rFile, Start, End, 0 );
 
@@ -1496,14 +2181,14 @@ void TextEdit::SetSelection( File& rFile, Coordinate Start, Coordinate End, int
 	GENO_ASSERT( ( ( Start.x < End.x ) || End.x == -1 ) && ( ( Start.y < End.y ) || End.y == -1 ) );
 	GENO_ASSERT( CursorIndex < ( int )rFile.Cursors.size() );
 
-	std::vector< Line >& rLines = rFile.Lines;
+	const int NumLines = ( int )rFile.Buffer.LineCount();
 
-	if( Start.y >= ( int )rLines.size() ) return;
+	if( Start.y >= NumLines ) return;
 
-	if( End.y >= ( int )rLines.size() || End.y == -1 )
+	if( End.y >= NumLines || End.y == -1 )
 	{
-		End.y = ( int )rLines.size() - 1;
-		End.x = ( int )rLines[ End.y ].size();
+		End.y = NumLines - 1;
+		End.x = ( int )rFile.Buffer.LineLength( End.y );
 	}
 
 	Cursor& rCursor = rFile.Cursors[ CursorIndex ];
@@ -1532,7 +2217,7 @@ void TextEdit::SelectAll( File& rFile )
 int TextEdit::GetCoordinateY( File& rFile, float YPosition )
 {
 	int LineIndex = ( int )( ( YPosition / Props.CharAdvanceY ) );
-	int NumLines  = ( int )rFile.Lines.size();
+	int NumLines  = ( int )rFile.Buffer.LineCount();
 
 	if( LineIndex > NumLines - 1 )
 	{
@@ -1546,53 +2231,43 @@ int TextEdit::GetCoordinateY( File& rFile, float YPosition )
 
 int TextEdit::GetCoordinateX( File& rFile, int LineIndex, float XPosition, bool AllowPastLine )
 {
-	const Line& rLine       = rFile.Lines[ LineIndex ];
-	int         LineSize    = ( int )rLine.size();
-	char        String[ 2 ] = { 0, 0 };
-	float       Length      = 0.0f;
-	float       Diff        = 0.0f;
-	bool        WithinLine  = false;
-	int         Result      = -1;
+	const std::vector< float >& rOffsets = GetXOffsets( rFile, LineIndex );
+	const int                   LineSize = ( int )rOffsets.size() - 1;
+	int                         First    = 0;
 
-	for( int i = 0; i < LineSize; i++ )
+	// The first character whose middle is past the position
+	for( int Count = LineSize; Count > 0; )
 	{
-		String[ 0 ] = rLine[ i ].C;
-		Diff        = 0.0f;
+		const int Half = Count / 2;
+		const int Mid  = First + Half;
 
-		if( String[ 0 ] == '\t' )
+		if( ( rOffsets[ Mid ] + rOffsets[ Mid + 1 ] ) * 0.5f <= XPosition )
 		{
-			float NewLen = GetDistance( rFile, Coordinate( i + 1, LineIndex ) );
-			Diff         = NewLen - Length,
-			Length += Diff;
+			First  = Mid + 1;
+			Count -= Half + 1;
 		}
 		else
 		{
-			Length += Diff = ImGui::GetFont()->CalcTextSizeA( ImGui::GetFontSize(), FLT_MAX, -1.0f, String ).x;
-		}
-
-		if( Length - ( Diff / 2.0f ) > XPosition )
-		{
-			Result     = i;
-			WithinLine = true;
-			break;
+			Count = Half;
 		}
 	}
 
-	if( WithinLine ) return Result;
+	if( First < LineSize )
+	{
+		const size_t LineStart = rFile.Buffer.LineStart( LineIndex );
+
+		// Past the first half of a multi-byte character, the position goes after it
+		while( First < LineSize && ( rFile.Buffer.GetText( LineStart + First, 1 )[ 0 ] & 0xC0 ) == 0x80 )
+			First++;
+
+		return First;
+	}
 
 	if( AllowPastLine )
 	{
-		Diff = Props.SpaceSize;
-
-		for( int i = LineSize;; i++ )
-		{
-			Length += Diff;
+		const float Spaces = ( XPosition - rOffsets.back() ) / Props.SpaceSize - 0.5f;
 
-			if( Length - ( Diff / 2.0f ) > XPosition )
-			{
-				return i;
-			}
-		}
+		return LineSize + std::max( 0, ( int )floorf( Spaces ) + 1 );
 	}
 
 	return LineSize;
@@ -1641,335 +2316,415 @@ float TextEdit::CalculateTabAlignmentDistance( File& rFile, Coordinate FromPosit
 
 //////////////////////////////////////////////////////////////////////////
 
-void TextEdit::AdjustCursors( File& rFile, int CursorIndex, int XOffset, int YOffset )
+std::vector< int > TextEdit::SortedCursors( File& rFile ) const
 {
-	Cursor& rCursor = rFile.Cursors[ CursorIndex ];
-	for( int j = 0; j < ( int )rFile.Cursors.size(); j++ )
-	{
-		if( j == CursorIndex ) continue;
+	std::vector< int > Order( rFile.Cursors.size() );
+	std::iota( Order.begin(), Order.end(), 0 );
 
-		Cursor& rOther = rFile.Cursors[ j ];
-
-		if( rOther.SelectionStart > rCursor.SelectionStart )
+	// Coordinate::operator< also holds for equal coordinates, which is no good for sorting
+	std::stable_sort( Order.begin(), Order.end(), [ &rFile ]( int A, int B )
 		{
-			if( rOther.SelectionStart.y == rCursor.SelectionStart.y )
-			{
-				rOther.SelectionStart.x -= XOffset;
-
-				if( rOther.SelectionEnd.y == rCursor.SelectionStart.y )
-				{
-					rOther.SelectionEnd.x -= XOffset;
-				}
-			}
-			else
-			{
-				rOther.SelectionStart.y -= YOffset;
-				rOther.SelectionEnd.y -= YOffset;
-			}
-		}
+			const Coordinate& rA = rFile.Cursors[ A ].Position;
+			const Coordinate& rB = rFile.Cursors[ B ].Position;
 
-		if( rOther.Position > rCursor.Position )
-		{
-			if( rOther.Position.y == rCursor.Position.y || YOffset > 0 ? rOther.Position.y - YOffset == rCursor.Position.y : false )
-			{
-				rOther.Position.x -= XOffset;
-			}
+			return rA.y < rB.y || ( rA.y == rB.y && rA.x < rB.x );
+		} );
 
-			rOther.Position.y -= YOffset;
-		}
-	}
+	return Order;
 
-} // AdjustCursors
+} // SortedCursors
 
 //////////////////////////////////////////////////////////////////////////
 
 void TextEdit::YeetDuplicateCursors( File& rFile )
 {
-	for( int i = 0; i < ( int )rFile.Cursors.size(); i++ )
-	{
-		Cursor& rCursor = rFile.Cursors[ i ];
-		for( int j = i + 1; j < ( int )rFile.Cursors.size(); j++ )
-		{
-			Cursor& rTmpCursor = rFile.Cursors[ j ];
+	std::vector< int >  Order = SortedCursors( rFile );
+	std::vector< bool > Duplicate( rFile.Cursors.size(), false );
 
-			if( rTmpCursor.Position == rCursor.Position )
-			{
-				rFile.Cursors.erase( rFile.Cursors.begin() + j );
-			}
-		}
+	// Cursors at the same position end up next to each other, with the one that was added first in front
+	for( size_t i = 1; i < Order.size(); i++ )
+		Duplicate[ Order[ i ] ] = rFile.Cursors[ Order[ i ] ].Position == rFile.Cursors[ Order[ i - 1 ] ].Position;
+
+	size_t Kept = 0;
+
+	for( size_t i = 0; i < rFile.Cursors.size(); i++ )
+	{
+		if( !Duplicate[ i ] )
+			rFile.Cursors[ Kept++ ] = rFile.Cursors[ i ];
 	}
 
+	rFile.Cursors.resize( Kept );
+
 } // YeetDuplicateCursors
 
 //////////////////////////////////////////////////////////////////////////
 
-void TextEdit::DisableIntersectionsInSelection( File& rFile, int CursorIndex )
+void TextEdit::ApplyCursorEdits( File& rFile, const CursorEditFunction& rFunction )
 {
-	Cursor& rCursor = rFile.Cursors[ CursorIndex ];
+	YeetDuplicateCursors( rFile );
 
-	for( int i = 0; i < ( int )rFile.Cursors.size(); i++ )
+	// Where each cursor was in the text before any of the edits
+	struct Mark
 	{
-		if( i == CursorIndex ) continue;
+		size_t Position;
+		size_t SelectionStart;
+		size_t SelectionEnd;
+		size_t Origin;
+		int    Virtual;
+		int    SelectionVirtual;
+		int    Edit;
+		bool   Selection;
+	};
 
-		Cursor& rCursor2 = rFile.Cursors[ i ];
+	const int           LineCount = ( int )rFile.Buffer.LineCount();
+	std::vector< Mark > Marks( rFile.Cursors.size() );
+	std::vector< int >  Order( rFile.Cursors.size() );
 
-		if( ( rCursor2.SelectionStart > rCursor.SelectionStart && rCursor2.SelectionStart < rCursor.SelectionEnd ) || ( rCursor2.SelectionEnd > rCursor.SelectionStart && rCursor2.SelectionEnd < rCursor.SelectionEnd ) || ( rCursor2.Position >= rCursor.SelectionStart && rCursor2.Position <= rCursor.SelectionEnd ) )
-		{
-			rCursor2.Disabled = true;
-		}
-		else
+	for( size_t i = 0; i < rFile.Cursors.size(); i++ )
+	{
+		const Cursor& rCursor = rFile.Cursors[ i ];
+		Mark&         rMark   = Marks[ i ];
+
+		rMark.Selection = rCursor.SelectionEnd > rCursor.SelectionStart && rCursor.SelectionStart.y >= 0 && rCursor.SelectionEnd.y < LineCount;
+		rMark.Position  = GetOffset( rFile, rCursor.Position );
+		rMark.Virtual   = std::max( rCursor.Position.x - ( int )rFile.Buffer.LineLength( rCursor.Position.y ), 0 );
+		rMark.Edit      = -1;
+		Order[ i ]      = ( int )i;
+
+		if( rMark.Selection )
 		{
-			rCursor2.Disabled = false;
+			rMark.SelectionStart   = GetOffset( rFile, rCursor.SelectionStart );
+			rMark.SelectionEnd     = GetOffset( rFile, rCursor.SelectionEnd );
+			rMark.SelectionVirtual = std::max( rCursor.SelectionStart.x - ( int )rFile.Buffer.LineLength( rCursor.SelectionStart.y ), 0 );
 		}
+
+		if( rCursor.SelectionOrigin.y >= 0 && rCursor.SelectionOrigin.y < LineCount )
+			rMark.Origin = GetOffset( rFile, rCursor.SelectionOrigin );
 	}
 
-} // DisableIntersectingSelections
+	std::sort( Order.begin(), Order.end(), [ &Marks ]( int A, int B )
+		{
+			const size_t StartA = Marks[ A ].Selection ? Marks[ A ].SelectionStart : Marks[ A ].Position;
+			const size_t StartB = Marks[ B ].Selection ? Marks[ B ].SelectionStart : Marks[ B ].Position;
 
-//////////////////////////////////////////////////////////////////////////
+			return StartA < StartB || ( StartA == StartB && A < B );
+		} );
 
-void TextEdit::DeleteDisabledCursor( File& rFile )
-{
-	for( int i = 0; i < ( int )rFile.Cursors.size(); i++ )
-	{
-		if( rFile.Cursors[ i ].Disabled ) rFile.Cursors.erase( rFile.Cursors.begin() + i-- );
-	}
+	std::vector< CursorEdit > Edits;
+	size_t                    Limit = rFile.Buffer.Size();
 
-} // DeleteDisabledCursor
-
-//////////////////////////////////////////////////////////////////////////
+	// Editing from the bottom up leaves the text above untouched, so the cursors that are yet to be visited stay where they were.
+	// Edits are also kept from overlapping the ones below them, which may happen when selections do.
+	for( auto It = Order.rbegin(); It != Order.rend(); ++It )
+	{
+		const Cursor& rCursor = rFile.Cursors[ *It ];
+		Mark&         rMark   = Marks[ *It ];
 
-void TextEdit::DeleteSelection( File& rFile, int CursorIndex )
-{
-	Cursor& rCursor = rFile.Cursors[ CursorIndex ];
+		if( rCursor.Disabled ) continue;
 
-	if( rCursor.Disabled ) return;
+		CursorEdit Edit;
+		Edit.Selection = rMark.Selection;
+		Edit.Start     = rMark.Selection ? rMark.SelectionStart : rMark.Position;
+		Edit.End       = rMark.Selection ? rMark.SelectionEnd : rMark.Position;
+		Edit.Virtual   = rMark.Selection ? rMark.SelectionVirtual : rMark.Virtual;
 
-	auto& rLines = rFile.Lines;
+		if( !rFunction( Edit ) )
+		{
+			if( !rMark.Selection ) rMark.Virtual = Edit.Virtual;
+			continue;
+		}
 
-	if( HasSelection( rFile, CursorIndex ) )
-	{
-		Line& rLine = rLines[ rCursor.SelectionStart.y ];
+		Edit.End   = std::min( Edit.End, Limit );
+		Edit.Start = std::min( Edit.Start, Edit.End );
 
-		int yOffset = 0;
-		int XOffset = 0;
+		if( Edit.End > Edit.Start ) EraseText( rFile, Edit.Start, Edit.End - Edit.Start );
+		if( !Edit.Text.empty() )    InsertText( rFile, Edit.Start, Edit.Text );
 
-		if( rCursor.SelectionEnd.y == rCursor.SelectionStart.y )
-		{
-			int End        = rCursor.SelectionEnd.x;
-			int Start      = rCursor.SelectionStart.x;
-			int LineLength = ( int )rLine.size();
+		Limit      = Edit.Start;
+		rMark.Edit = ( int )Edits.size();
 
-			if( Start > LineLength )
-			{
-				return;
-			}
-			else if( End > LineLength )
-			{
-				End = LineLength;
-			}
+		Edits.push_back( std::move( Edit ) );
+	}
 
-			rLine.erase( rLine.begin() + Start, rLine.begin() + End );
+	if( !Edits.empty() )
+		Props.Changes = true;
 
-			XOffset = rCursor.SelectionEnd.x - rCursor.SelectionStart.x;
-		}
-		else
-		{
-			rLine.erase( rLine.begin() + rCursor.SelectionStart.x, rLine.end() );
+	// Top-down, each edit has moved everything below it by the difference in length
+	std::reverse( Edits.begin(), Edits.end() );
 
-			int NumLines = ( int )rCursor.SelectionEnd.y - rCursor.SelectionStart.y - 1;
+	const std::vector< ptrdiff_t > Shifts = EditShifts( Edits );
 
-			if( NumLines > 0 )
-			{
-				rLines.erase( rLines.begin() + rCursor.SelectionStart.y + 1, rLines.begin() + rCursor.SelectionStart.y + NumLines + 1 );
-			}
+	auto MapOffset = [ & ]( size_t Offset ) { return MapEditedOffset( Edits, Shifts, Offset ); };
 
-			Line& rLine2 = rLines[ rCursor.SelectionStart.y + 1 ];
+	auto ToCoordinate = [ &rFile ]( size_t Offset, int Virtual )
+	{
+		const size_t Line = rFile.Buffer.LineOf( Offset );
 
-			yOffset = NumLines + 1;
-			XOffset = rCursor.SelectionEnd.x;
+		return Coordinate( ( int )( Offset - rFile.Buffer.LineStart( Line ) ) + Virtual, ( int )Line );
+	};
 
-			if( XOffset == ~0 ) XOffset++;
+	for( size_t i = 0; i < rFile.Cursors.size(); i++ )
+	{
+		Cursor&     rCursor = rFile.Cursors[ i ];
+		const Mark& rMark   = Marks[ i ];
 
-			rLine2.erase( rLine2.begin(), rLine2.begin() + XOffset );
+		if( rMark.Edit >= 0 )
+		{
+			const size_t      Index = Edits.size() - 1 - ( size_t )rMark.Edit;
+			const CursorEdit& rEdit = Edits[ Index ];
 
-			if( !rLine2.empty() )
-			{
-				rLine.insert( rLine.end(), rLine2.begin(), rLine2.end() );
-			}
+			rCursor.Position        = ToCoordinate( rEdit.Start + Shifts[ Index ] + rEdit.Caret, rEdit.Virtual );
+			rCursor.SelectionStart  = Coordinate( 0, 0 );
+			rCursor.SelectionEnd    = Coordinate( 0, 0 );
+			rCursor.SelectionOrigin = Coordinate( -1, -1 );
 
-			rLines.erase( rLines.begin() + rCursor.SelectionStart.y + 1 );
+			continue;
 		}
 
-		AdjustCursors( rFile, CursorIndex, XOffset, yOffset );
+		rCursor.Position = ToCoordinate( MapOffset( rMark.Position ), rMark.Virtual );
 
-		rCursor.Position = rCursor.SelectionStart;
+		if( rMark.Selection )
+		{
+			rCursor.SelectionStart = ToCoordinate( MapOffset( rMark.SelectionStart ), 0 );
+			rCursor.SelectionEnd   = ToCoordinate( MapOffset( rMark.SelectionEnd ), 0 );
+		}
 
-		rCursor.SelectionStart  = { 0, 0 };
-		rCursor.SelectionEnd    = { 0, 0 };
-		rCursor.SelectionOrigin = { -1, -1 };
-	}
-	else
-	{
-		return;
+		if( rCursor.SelectionOrigin.y >= 0 && rCursor.SelectionOrigin.y < LineCount )
+			rCursor.SelectionOrigin = ToCoordinate( MapOffset( rMark.Origin ), 0 );
 	}
 
-	Props.Changes = true;
+	// Cursors that erased their way into each other are merged
+	YeetDuplicateCursors( rFile );
 
-} // DeleteSelection
+} // ApplyCursorEdits
 
 //////////////////////////////////////////////////////////////////////////
 
-void TextEdit::Enter( File& rFile )
+void TextEdit::ApplyTextChanges( File& rFile, std::vector< TextChange > Changes )
 {
-	Props.Changes         = true;
-	rFile.CursorMultiMode = MultiCursorMode::Normal;
+	std::stable_sort( Changes.begin(), Changes.end(), []( const TextChange& rA, const TextChange& rB ) { return rA.Start < rB.Start; } );
 
-	for( int i = 0; i < ( int )rFile.Cursors.size(); ++i )
+	// A change that overlaps the one before it is dropped, which happens when the selections of two cursors share a line
+	std::vector< TextChange > Kept;
+	Kept.reserve( Changes.size() );
+
+	for( TextChange& rChange : Changes )
 	{
-		Cursor& rCursor = rFile.Cursors[ i ];
+		if( Kept.empty() || rChange.Start >= Kept.back().End )
+			Kept.push_back( std::move( rChange ) );
+	}
 
-		if( rCursor.Disabled ) continue;
+	if( Kept.empty() ) return;
 
-		DeleteSelection( rFile, i );
+	// Where a coordinate was in the text before the changes, and how far past the end of its line
+	struct Mark
+	{
+		size_t Offset;
+		int    Virtual;
+	};
 
-		auto& rLines = rFile.Lines;
+	struct CursorMarks
+	{
+		Mark Position;
+		Mark SelectionStart;
+		Mark SelectionEnd;
+		Mark Origin;
+		bool Selection;
+		bool HasOrigin;
+	};
 
-		Line  NewLine;
-		Line& rLine = rLines[ rCursor.Position.y ];
+	const int                  LineCount = ( int )rFile.Buffer.LineCount();
+	std::vector< CursorMarks > Marks( rFile.Cursors.size() );
 
-		bool MoveRemainingTextToNewLine = rCursor.Position.x < ( int )rLine.size();
+	auto ToMark = [ this, &rFile ]( Coordinate Position )
+	{
+		return Mark { GetOffset( rFile, Position ), std::max( Position.x - ( int )rFile.Buffer.LineLength( Position.y ), 0 ) };
+	};
+
+	for( size_t i = 0; i < rFile.Cursors.size(); i++ )
+	{
+		const Cursor& rCursor = rFile.Cursors[ i ];
+		CursorMarks&  rMarks  = Marks[ i ];
 
-		if( MoveRemainingTextToNewLine )
+		rMarks.Selection = rCursor.SelectionEnd > rCursor.SelectionStart && rCursor.SelectionStart.y >= 0 && rCursor.SelectionEnd.y < LineCount;
+		rMarks.HasOrigin = rCursor.SelectionOrigin.y >= 0 && rCursor.SelectionOrigin.y < LineCount;
+		rMarks.Position  = ToMark( rCursor.Position );
+
+		if( rMarks.Selection )
 		{
-			auto Start = rLine.begin() + rCursor.Position.x;
-			NewLine.insert( NewLine.begin(), Start, rLine.end() );
-			rLine.erase( Start, rLine.end() );
+			rMarks.SelectionStart = ToMark( rCursor.SelectionStart );
+			rMarks.SelectionEnd   = ToMark( rCursor.SelectionEnd );
 		}
 
-		AdjustCursors( rFile, i, rCursor.Position.x, -1 );
-
-		rCursor.Position.y++;
-		rCursor.Position.x = 0;
-		rLines.insert( rLines.begin() + rCursor.Position.y, NewLine );
+		if( rMarks.HasOrigin )
+			rMarks.Origin = ToMark( rCursor.SelectionOrigin );
+	}
 
-		Props.Changes = true;
+	// Bottom-up, so that the offsets of the changes above stay as they were
+	for( auto It = Kept.rbegin(); It != Kept.rend(); ++It )
+	{
+		if( It->End > It->Start ) EraseText( rFile, It->Start, It->End - It->Start );
+		if( !It->Text.empty() )    InsertText( rFile, It->Start, It->Text );
 	}
 
-	ScrollToCursor( rFile );
+	Props.Changes = true;
 
-	Props.CursorBlink = 0;
+	const std::vector< ptrdiff_t > Shifts = EditShifts( Kept );
 
-} // Enter
+	auto ToCoordinate = [ & ]( const Mark& rMark )
+	{
+		const size_t Offset = MapEditedOffset( Kept, Shifts, rMark.Offset );
+		const size_t Line   = rFile.Buffer.LineOf( Offset );
 
-//////////////////////////////////////////////////////////////////////////
+		return Coordinate( ( int )( Offset - rFile.Buffer.LineStart( Line ) ) + rMark.Virtual, ( int )Line );
+	};
 
-void TextEdit::Backspace( File& rFile )
-{
-	if( rFile.CursorMultiMode == MultiCursorMode::Box )
+	for( size_t i = 0; i < rFile.Cursors.size(); i++ )
 	{
-		std::vector< int > CurInText    = CursorsInText( rFile );
-		std::vector< int > CurNotInText = CursorsNotInText( rFile );
+		Cursor&            rCursor = rFile.Cursors[ i ];
+		const CursorMarks& rMarks  = Marks[ i ];
 
-		if( ( int )CurInText.size() == 0 )
+		rCursor.Position = ToCoordinate( rMarks.Position );
+
+		if( rMarks.Selection )
 		{
-			Esc( rFile );
+			rCursor.SelectionStart = ToCoordinate( rMarks.SelectionStart );
+			rCursor.SelectionEnd   = ToCoordinate( rMarks.SelectionEnd );
 		}
-		else if( HasSelection( rFile, 0 ) )
-		{
-			for( int CursorIndex : CurInText )
-			{
-				DeleteSelection( rFile, CursorIndex );
-			}
 
-			for( int CursorIndex : CurNotInText )
-			{
-				Cursor& rCursor = rFile.Cursors[ CursorIndex ];
+		if( rMarks.HasOrigin )
+			rCursor.SelectionOrigin = ToCoordinate( rMarks.Origin );
+	}
 
-				rCursor.Position.x      = rCursor.SelectionStart.x;
-				rCursor.SelectionStart  = Coordinate( 0, 0 );
-				rCursor.SelectionEnd    = Coordinate( 0, 0 );
-				rCursor.SelectionOrigin = Coordinate( -1, -1 );
-			}
-		}
-		else
+} // ApplyTextChanges
+
+//////////////////////////////////////////////////////////////////////////
+
+void TextEdit::DisableIntersectionsInSelection( File& rFile, int CursorIndex )
+{
+	SelectionDragState& rDrag   = rFile.SelectionDrag;
+	const Cursor&       rCursor = rFile.Cursors[ CursorIndex ];
+
+	// Coordinate's own operator< lets equal coordinates through, which sorting can't have
+	auto Before = []( Coordinate A, Coordinate B ) { return A.y < B.y || ( A.y == B.y && A.x < B.x ); };
+
+	if( !rDrag.Valid || rDrag.Cursor != CursorIndex )
+	{
+		rDrag.Ends.clear();
+		rDrag.Disabled.clear();
+
+		for( int i = 0; i < ( int )rFile.Cursors.size(); i++ )
 		{
-			for( int CursorIndex : CurInText )
-			{
-				Backspace( rFile, CursorIndex, false );
-			}
+			if( i == CursorIndex ) continue;
 
-			for( int CursorIndex : CurNotInText )
-			{
-				Cursor& rCursor = rFile.Cursors[ CursorIndex ];
+			Cursor& rCursor2 = rFile.Cursors[ i ];
 
-				if( rCursor.Position.x != 0 ) rCursor.Position.x--;
-			}
+			rCursor2.Disabled = false;
+
+			rDrag.Ends.emplace_back( rCursor2.SelectionStart, i );
+			rDrag.Ends.emplace_back( rCursor2.SelectionEnd, i );
+			rDrag.Ends.emplace_back( rCursor2.Position, i );
 		}
+
+		std::sort( rDrag.Ends.begin(), rDrag.Ends.end(), [ &Before ]( const auto& rA, const auto& rB ) { return Before( rA.first, rB.first ); } );
+
+		rDrag.Cursor = CursorIndex;
+		rDrag.Valid  = true;
 	}
-	else
+
+	// A cursor can only intersect the selection if one of its ends lies within it
+	auto First = std::lower_bound( rDrag.Ends.begin(), rDrag.Ends.end(), rCursor.SelectionStart, [ &Before ]( const auto& rEnd, Coordinate Value ) { return Before( rEnd.first, Value ); } );
+	auto Last  = std::upper_bound( First, rDrag.Ends.end(), rCursor.SelectionEnd, [ &Before ]( Coordinate Value, const auto& rEnd ) { return Before( Value, rEnd.first ); } );
+
+	std::vector< int > Disabled;
+
+	for( auto It = First; It != Last; ++It )
 	{
-		for( int i = 0; i < ( int )rFile.Cursors.size(); i++ )
+		const Cursor& rCursor2 = rFile.Cursors[ It->second ];
+
+		if( ( rCursor2.SelectionStart > rCursor.SelectionStart && rCursor2.SelectionStart < rCursor.SelectionEnd ) || ( rCursor2.SelectionEnd > rCursor.SelectionStart && rCursor2.SelectionEnd < rCursor.SelectionEnd ) || ( rCursor2.Position >= rCursor.SelectionStart && rCursor2.Position <= rCursor.SelectionEnd ) )
 		{
-			Backspace( rFile, i, true );
+			Disabled.push_back( It->second );
 		}
 	}
 
-} // Backspace
+	// Only the cursors that the selection has reached or left since the last frame change
+	for( int i : rDrag.Disabled ) rFile.Cursors[ i ].Disabled = false;
+	for( int i : Disabled )       rFile.Cursors[ i ].Disabled = true;
+
+	rDrag.Disabled = std::move( Disabled );
+
+} // DisableIntersectingSelections
 
 //////////////////////////////////////////////////////////////////////////
 
-void TextEdit::Backspace( File& rFile, int CursorIndex, bool DeleteLine )
+void TextEdit::DeleteDisabledCursor( File& rFile )
 {
-	if( HasSelection( rFile, CursorIndex ) )
-	{
-		DeleteSelection( rFile, CursorIndex );
-	}
-	else
-	{
-		Cursor& rCursor = rFile.Cursors[ CursorIndex ];
+	std::erase_if( rFile.Cursors, []( const Cursor& rCursor ) { return rCursor.Disabled; } );
 
-		if( rCursor.Disabled ) return;
+	rFile.SelectionDrag.Valid = false;
 
-		auto& rLines = rFile.Lines;
+} // DeleteDisabledCursor
+
+//////////////////////////////////////////////////////////////////////////
 
-		Line& rLine = rLines[ rCursor.Position.y ];
+void TextEdit::Enter( File& rFile )
+{
+	Props.Changes         = true;
+	rFile.CursorMultiMode = MultiCursorMode::Normal;
 
-		if( rCursor.Position.x == 0 && rCursor.Position.y != 0 && DeleteLine )
+	ApplyCursorEdits( rFile, []( CursorEdit& rEdit )
 		{
-			Line& rLineAbove = rLines[ rCursor.Position.y - 1 ];
+			// Any text after the cursor moves along to the new line
+			rEdit.Text    = "\n";
+			rEdit.Caret   = 1;
+			rEdit.Virtual = 0;
 
-			int x = ( int )rLineAbove.size();
+			return true;
+		} );
 
-			if( !rLine.empty() )
-			{
-				rLineAbove.insert( rLineAbove.end(), rLine.begin(), rLine.end() );
-			}
+	ScrollToCursor( rFile );
 
-			rLines.erase( rLines.begin() + rCursor.Position.y );
+	Props.CursorBlink = 0;
 
-			rCursor.Position.x = x;
-			rCursor.Position.y--;
+} // Enter
 
-			AdjustCursors( rFile, CursorIndex, -x, 1 );
+//////////////////////////////////////////////////////////////////////////
 
-			Props.Changes = true;
-		}
-		else if( !( rCursor.Position.y == 0 && rCursor.Position.x == 0 ) && !( rCursor.Position.x == 0 && !DeleteLine ) )
-		{
-			rCursor.Position.x--;
-			rLine.erase( rLine.begin() + rCursor.Position.x );
+void TextEdit::Backspace( File& rFile )
+{
+	const bool Box = rFile.CursorMultiMode == MultiCursorMode::Box;
 
-			AdjustCursors( rFile, CursorIndex, 1, 0 );
-		}
-		else
+	if( Box && CursorsInText( rFile ).empty() )
+	{
+		Esc( rFile );
+		return;
+	}
+
+	// The selections of a box are erased on their own, without the cursors that have none erasing anything
+	const bool BoxSelection = Box && HasSelection( rFile, 0 );
+
+	ApplyCursorEdits( rFile, [ &rFile, Box, BoxSelection ]( CursorEdit& rEdit )
 		{
-			return;
-		}
+			if( rEdit.Selection || BoxSelection ) return rEdit.Selection;
 
-		Props.Changes = true;
+			// Past the end of the line there is nothing to erase, the cursor just steps back
+			if( rEdit.Virtual > 0 )
+			{
+				rEdit.Virtual--;
+				return false;
+			}
 
-		YeetDuplicateCursors( rFile );
-	}
+			if( rEdit.Start == 0 ) return false;
+
+			// A box keeps to its lines, so it stops at the start of them
+			if( Box && rEdit.Start == rFile.Buffer.LineStart( rFile.Buffer.LineOf( rEdit.Start ) ) ) return false;
+
+			// At the start of a line, this is the line break at the end of the line above
+			rEdit.Start--;
+
+			return true;
+		} );
 
 	ScrollToCursor( rFile );
 
@@ -1981,100 +2736,112 @@ void TextEdit::Backspace( File& rFile, int CursorIndex, bool DeleteLine )
 
 void TextEdit::Del( File& rFile )
 {
-	if( rFile.CursorMultiMode == MultiCursorMode::Box )
+	const bool Box = rFile.CursorMultiMode == MultiCursorMode::Box;
+
+	if( Box && CursorsInText( rFile ).empty() )
 	{
-		std::vector< int > CurInText    = CursorsInText( rFile );
-		std::vector< int > CurNotInText = CursorsNotInText( rFile );
+		Esc( rFile );
+		return;
+	}
 
-		if( ( int )CurInText.size() == 0 )
-		{
-			Esc( rFile );
-		}
-		else if( HasSelection( rFile, 0 ) )
+	const bool BoxSelection = Box && HasSelection( rFile, 0 );
+
+	ApplyCursorEdits( rFile, [ &rFile, Box, BoxSelection ]( CursorEdit& rEdit )
 		{
-			for( int CursorIndex : CurInText )
-			{
-				DeleteSelection( rFile, CursorIndex );
-			}
+			if( rEdit.Selection || BoxSelection ) return rEdit.Selection;
 
-			for( int CursorIndex : CurNotInText )
-			{
-				Cursor& rCursor = rFile.Cursors[ CursorIndex ];
+			if( rEdit.End == rFile.Buffer.Size() ) return false;
 
-				rCursor.Position.x      = rCursor.SelectionStart.x;
-				rCursor.SelectionStart  = Coordinate( 0, 0 );
-				rCursor.SelectionEnd    = Coordinate( 0, 0 );
-				rCursor.SelectionOrigin = Coordinate( -1, -1 );
-			}
-		}
-		else
-		{
-			for( int CursorIndex : CurInText )
+			if( Box )
 			{
-				Del( rFile, CursorIndex, false );
+				const size_t Line = rFile.Buffer.LineOf( rEdit.End );
+
+				// A box keeps to its lines, so there is nothing to delete at or past the end of them
+				if( rEdit.Virtual > 0 || rEdit.End == rFile.Buffer.LineStart( Line ) + rFile.Buffer.LineLength( Line ) ) return false;
 			}
-		}
-	}
-	else
-	{
-		for( int i = 0; i < ( int )rFile.Cursors.size(); i++ )
-		{
-			Del( rFile, i, true );
-		}
-	}
+
+			// At the end of a line, this is the line break, so that the next line is joined with this one
+			rEdit.End++;
+
+			return true;
+		} );
+
+	ScrollToCursor( rFile );
+
+	Props.CursorBlink = 0;
 
 } // Del
 
 //////////////////////////////////////////////////////////////////////////
 
-void TextEdit::Del( File& rFile, int CursorIndex, bool DeleteLine )
+void TextEdit::Tab( File& rFile, bool Shift )
 {
-	Cursor& rCursor = rFile.Cursors[ CursorIndex ];
+	// Takes the whitespace in [Start, End) back to the tab stop before End
+	auto Outdent = [ this, &rFile ]( Coordinate Start, Coordinate End )
+	{
+		Coordinate NewCoord = CalculateTabAlignment( rFile, End );
+
+		if( NewCoord == End ) NewCoord.x--;
 
-	if( rCursor.Disabled ) return;
+		if( Start.x > NewCoord.x ) NewCoord.x = Start.x;
 
-	if( HasSelection( rFile, CursorIndex ) )
-	{
-		DeleteSelection( rFile, CursorIndex );
-	}
-	else
+		const size_t LineStart = rFile.Buffer.LineStart( End.y );
+
+		return TextChange { LineStart + NewCoord.x, LineStart + End.x, std::string() };
+	};
+
+	// Outdents the whitespace right before Pos, if there is any
+	auto OutdentBefore = [ this, &rFile, &Outdent ]( Coordinate Pos, std::vector< TextChange >& rChanges )
 	{
-		Line& rLine = rFile.Lines[ rCursor.Position.y ];
+		if( Pos.x == 0 ) return;
 
-		if( rCursor.Position.x >= ( int )rLine.size() && DeleteLine )
-		{
-			if( rCursor.Position.y == ( ( int )rFile.Lines.size() - 1 ) ) return;
+		char Chr = rFile.Buffer.GetText( GetOffset( rFile, Pos ) - 1, 1 )[ 0 ];
 
-			Line& rNextLine = rFile.Lines[ rCursor.Position.y + 1 ];
+		if( Chr != ' ' && Chr != '\t' ) return;
 
-			rLine.insert( rLine.end(), rNextLine.begin(), rNextLine.end() );
+		Coordinate Start;
+		Coordinate End;
 
-			rFile.Lines.erase( rFile.Lines.begin() + rCursor.Position.y + 1 );
+		GetWordAt( rFile, Coordinate( Pos.x - 1, Pos.y ), &Start, &End );
 
-			AdjustCursors( rFile, CursorIndex, -rCursor.Position.x, 1 );
-		}
-		else if( rCursor.Position.x < ( int )rLine.size() )
-		{
-			rLine.erase( rLine.begin() + rCursor.Position.x );
-			AdjustCursors( rFile, CursorIndex, 1, 0 );
-		}
-		else
+		if( End != Pos )
 		{
-			return;
+			if( End > Pos )
+			{
+				End = Pos;
+			}
+			else
+			{
+				Start = End;
+				End   = Pos;
+			}
 		}
 
-		Props.Changes = true;
-	}
+		rChanges.push_back( Outdent( Start, End ) );
+	};
 
-	ScrollToCursor( rFile );
+	// Selections over several lines are indented and outdented a line at a time. Lines that more than one of them share are only done once.
+	auto SelectedLines = [ this, &rFile ]()
+	{
+		std::vector< int > Lines;
 
-	Props.CursorBlink = 0;
-} // Del
+		for( int i = 0; i < ( int )rFile.Cursors.size(); i++ )
+		{
+			const Cursor& rCursor = rFile.Cursors[ i ];
 
-//////////////////////////////////////////////////////////////////////////
+			if( HasSelection( rFile, i ) && rCursor.SelectionStart.y != rCursor.SelectionEnd.y )
+			{
+				for( int j = rCursor.SelectionStart.y; j <= rCursor.SelectionEnd.y; j++ )
+					Lines.push_back( j );
+			}
+		}
+
+		std::sort( Lines.begin(), Lines.end() );
+		Lines.erase( std::unique( Lines.begin(), Lines.end() ), Lines.end() );
+
+		return Lines;
+	};
 
-void TextEdit::Tab( File& rFile, bool Shift )
-{
 	if( rFile.CursorMultiMode == MultiCursorMode::Box )
 	{
 		std::vector< int > CurInText    = CursorsInText( rFile );
@@ -2164,7 +2931,7 @@ void TextEdit::Tab( File& rFile, bool Shift )
 						break;
 					}
 
-					char Whitespace = rFile.Lines[ Pos.y ][ Pos.x - 1 ].C;
+					char Whitespace = rFile.Buffer.GetText( GetOffset( rFile, Pos ) - 1, 1 )[ 0 ];
 
 					if( Whitespace != ' ' && Whitespace != '\t' )
 					{
@@ -2176,11 +2943,21 @@ void TextEdit::Tab( File& rFile, bool Shift )
 
 			if( AllWhitespace )
 			{
+				std::vector< TextChange > Changes;
+
 				for( int CursorIndex : CurInText )
 				{
-					Tab( rFile, Shift, CursorIndex );
+					const Cursor&    rCursor = rFile.Cursors[ CursorIndex ];
+					const Coordinate Pos     = HasSelection( rFile, CursorIndex ) ? rCursor.SelectionStart : rCursor.Position;
+					const size_t     Offset  = GetOffset( rFile, Pos );
+
+					if( Shift ) OutdentBefore( Pos, Changes );
+					else
+						Changes.push_back( TextChange { Offset, Offset, "\t" } );
 				}
 
+				ApplyTextChanges( rFile, std::move( Changes ) );
+
 				bool Selection = HasSelection( rFile, CurInText[ 0 ] );
 
 				Coordinate Pos = Selection ? rFile.Cursors[ CurInText[ 0 ] ].SelectionStart : rFile.Cursors[ CurInText[ 0 ] ].Position;
@@ -2206,185 +2983,81 @@ void TextEdit::Tab( File& rFile, bool Shift )
 			}
 		}
 	}
-	else
+	else if( Shift )
 	{
-		for( int i = 0; i < ( int )rFile.Cursors.size(); i++ )
-		{
-			Tab( rFile, Shift, i );
-		}
-	}
-}
-
-//////////////////////////////////////////////////////////////////////////
-
-void TextEdit::Tab( File& rFile, bool Shift, int CursorIndex )
-{
-	Cursor& rCursor = rFile.Cursors[ CursorIndex ];
-
-	if( rCursor.Disabled ) return;
-
-	bool Selection = HasSelection( rFile, CursorIndex );
+		std::vector< TextChange > Changes;
 
-	if( Shift )
-	{
-		if( Selection && rCursor.SelectionStart.y != rCursor.SelectionEnd.y )
+		for( int i = 0; i < ( int )rFile.Cursors.size(); i++ )
 		{
-			for( int j = rCursor.SelectionStart.y; j <= rCursor.SelectionEnd.y; j++ )
-			{
-				Line& rLine = rFile.Lines[ j ];
-
-				if( rLine.empty() ) continue;
-
-				Coordinate Start;
-				Coordinate End;
-
-				std::string Word = GetWordAt( rFile, Coordinate( 0, j ), &Start, &End );
+			const Cursor& rCursor   = rFile.Cursors[ i ];
+			const bool    Selection = HasSelection( rFile, i );
 
-				if( Word.empty() ) continue;
-				if( Word[ 0 ] != ' ' && Word[ 0 ] != '\t' ) continue;
-
-				Coordinate NewCoord = CalculateTabAlignment( rFile, End );
-
-				if( NewCoord == End ) NewCoord.x--;
-
-				if( Start.x > NewCoord.x ) NewCoord.x = Start.x;
-
-				rLine.erase( rLine.begin() + NewCoord.x, rLine.begin() + End.x );
-
-				AdjustCursorIfInText( rFile, rCursor, j, NewCoord.x - End.x );
-			}
-
-			Props.Changes = true;
+			if( rCursor.Disabled ) continue;
 
-			return;
+			if( !Selection || rCursor.SelectionStart.y == rCursor.SelectionEnd.y )
+				OutdentBefore( Selection ? rCursor.SelectionStart : rCursor.Position, Changes );
 		}
 
-		Coordinate Pos = Selection ? rCursor.SelectionStart : rCursor.Position;
-
-		if( Pos.x == 0 ) return;
-
-		Line& rLine = rFile.Lines[ rCursor.Position.y ];
-
-		char Chr = rLine[ Pos.x - 1 ].C;
-
-		if( Chr != ' ' && Chr != '\t' ) return;
-
-		Coordinate Start;
-		Coordinate End;
-
-		GetWordAt( rFile, Coordinate( Pos.x - 1, Pos.y ), &Start, &End );
-
-		if( End != Pos )
+		for( int Line : SelectedLines() )
 		{
-			if( End > Pos )
-			{
-				End = Pos;
-			}
-			else
-			{
-				Start = End;
-				End   = Pos;
-			}
-		}
-
-		Coordinate NewCoord = CalculateTabAlignment( rFile, End );
-
-		if( NewCoord == End ) NewCoord.x--;
-
-		if( Start.x > NewCoord.x ) NewCoord.x = Start.x;
+			if( rFile.Buffer.LineLength( Line ) == 0 ) continue;
 
-		rLine.erase( rLine.begin() + NewCoord.x, rLine.begin() + End.x );
+			Coordinate Start;
+			Coordinate End;
 
-		int Offset = End.x - NewCoord.x;
+			std::string Word = GetWordAt( rFile, Coordinate( 0, Line ), &Start, &End );
 
-		rCursor.Position.x -= Offset;
+			if( Word.empty() ) continue;
+			if( Word[ 0 ] != ' ' && Word[ 0 ] != '\t' ) continue;
 
-		if( Selection )
-		{
-			rCursor.SelectionOrigin.x -= Offset;
-			rCursor.SelectionStart.x -= Offset;
-			rCursor.SelectionEnd.x -= Offset;
+			Changes.push_back( Outdent( Start, End ) );
 		}
 
-		AdjustCursors( rFile, CursorIndex, Offset, 0 );
-
-		Props.Changes = true;
+		ApplyTextChanges( rFile, std::move( Changes ) );
 	}
 	else
 	{
-		if( rFile.CursorMultiMode == MultiCursorMode::Box )
-		{
-			Coordinate Pos   = Selection ? rCursor.SelectionStart : rCursor.Position;
-			Line&      rLine = rFile.Lines[ Pos.y ];
-
-			rLine.insert( rLine.begin() + Pos.x, Glyph( '\t', m_Palette.Default ) );
-
-			rCursor.Position.x += 1;
+		const bool Overwrite = rFile.CursorMode == CursorInputMode::Insert;
 
-			if( Selection )
-			{
-				rCursor.SelectionStart.x += 1;
-				rCursor.SelectionEnd.x += 1;
-				rCursor.SelectionOrigin.x += 1;
-			}
-		}
-		else
-		{
-			if( HasSelection( rFile, CursorIndex ) )
+		// Everything but the selections over several lines is replaced by the tab
+		ApplyCursorEdits( rFile, [ this, &rFile, Overwrite ]( CursorEdit& rEdit )
 			{
-				if( rCursor.SelectionStart.y == rCursor.SelectionEnd.y )
+				if( rEdit.Selection )
 				{
-					DeleteSelection( rFile, CursorIndex );
+					if( rFile.Buffer.LineOf( rEdit.Start ) != rFile.Buffer.LineOf( rEdit.End ) ) return false;
 				}
-				else
+				else if( Overwrite )
 				{
-					for( int j = rCursor.SelectionStart.y; j <= rCursor.SelectionEnd.y; j++ )
-					{
-						Line& rLine = rFile.Lines[ j ];
+					// In insert mode the tab takes the place of the text up to the next tab stop
+					const size_t     Line     = rFile.Buffer.LineOf( rEdit.Start );
+					const Coordinate Position = Coordinate( ( int )( rEdit.Start - rFile.Buffer.LineStart( Line ) ), ( int )Line );
+					const float      Tab      = TabSize * Props.SpaceSize;
+					float            Distance = GetDistance( rFile, Position ) + Tab;
+					float            Fraction = Distance / Tab;
 
-						rLine.insert( rLine.begin(), Glyph( '\t', m_Palette.Default ) );
+					Distance -= Tab * ( Fraction - floorf( Fraction ) );
 
-						AdjustCursorIfInText( rFile, rCursor, j, 1 );
-					}
-
-					Props.Changes = true;
+					Coordinate NewCoord = GetCoordinate( rFile, ImVec2( Distance, Position.y * Props.CharAdvanceY ), false );
 
-					return;
+					rEdit.End = std::max( GetOffset( rFile, NewCoord ), rEdit.Start );
 				}
-			}
-
-			Line& rLine = rFile.Lines[ rCursor.Position.y ];
-
-			if( rFile.CursorMode == CursorInputMode::Normal )
-			{
-				rLine.insert( rLine.begin() + rCursor.Position.x, Glyph( '\t', m_Palette.Default ) );
-
-				AdjustCursors( rFile, CursorIndex, -1, 0 );
-			}
-			else
-			{
-				float CurrentDist = GetDistance( rFile, rCursor.Position );
-				float Tab         = TabSize * Props.SpaceSize;
-
-				CurrentDist += Tab;
 
-				float Fraction = CurrentDist / Tab;
-				Fraction       = Fraction - floorf( Fraction );
+				rEdit.Text  = "\t";
+				rEdit.Caret = 1;
 
-				CurrentDist -= Tab * Fraction;
+				return true;
+			} );
 
-				Coordinate NewCoord = GetCoordinate( rFile, ImVec2( CurrentDist, rCursor.Position.y * Props.CharAdvanceY ), false );
+		std::vector< TextChange > Changes;
 
-				rLine.erase( rLine.begin() + rCursor.Position.x, rLine.begin() + NewCoord.x );
-
-				rLine.insert( rLine.begin() + rCursor.Position.x, Glyph( '\t', m_Palette.Default ) );
-			}
+		for( int Line : SelectedLines() )
+		{
+			const size_t LineStart = rFile.Buffer.LineStart( Line );
 
-			rCursor.Position.x++;
-			rCursor.SelectionOrigin = Coordinate( -1, -1 );
+			Changes.push_back( TextChange { LineStart, LineStart, "\t" } );
 		}
 
-		Props.Changes = true;
+		ApplyTextChanges( rFile, std::move( Changes ) );
 	}
 
 	ScrollToCursor( rFile );
@@ -2397,88 +3070,46 @@ void TextEdit::Tab( File& rFile, bool Shift, int CursorIndex )
 
 void TextEdit::PrepareBoxModeForInput( File& rFile )
 {
-	std::vector< int > CurInText    = CursorsInText( rFile );
-	std::vector< int > CurNotInText = CursorsNotInText( rFile );
-
-	if( HasSelection( rFile, 0 ) )
-	{
-		for( int CursorIndex : CurInText )
-		{
-			DeleteSelection( rFile, CursorIndex );
-		}
-
-		for( int CursorIndex : CurNotInText )
+	ApplyCursorEdits( rFile, []( CursorEdit& rEdit )
 		{
-			Cursor& rCursor = rFile.Cursors[ CursorIndex ];
+			if( !rEdit.Selection && rEdit.Virtual == 0 ) return false;
 
-			rCursor.Position.x      = rCursor.SelectionStart.x;
-			rCursor.SelectionStart  = Coordinate( 0, 0 );
-			rCursor.SelectionEnd    = Coordinate( 0, 0 );
-			rCursor.SelectionOrigin = Coordinate( -1, -1 );
-		}
-	}
+			// The selections are erased, and lines that end before their cursor are padded out to it with spaces
+			rEdit.Text    = std::string( rEdit.Virtual, ' ' );
+			rEdit.Caret   = rEdit.Text.size();
+			rEdit.Virtual = 0;
 
-	for( int CursorIndex : CurNotInText )
-	{
-		Cursor& rCursor = rFile.Cursors[ CursorIndex ];
-		Line&   rLine   = rFile.Lines[ rCursor.Position.y ];
-		int     Count   = rCursor.Position.x - ( int )rLine.size();
+			return true;
+		} );
 
-		rLine.insert( rLine.end(), Count, Glyph( ' ', m_Palette.Default ) );
-	}
 } // PrepareBoxModeForInput
 
 //////////////////////////////////////////////////////////////////////////
 
 void TextEdit::EnterTextStuff( File& rFile, char C )
-{
-	if( rFile.CursorMultiMode == MultiCursorMode::Box )
-	{
-		PrepareBoxModeForInput( rFile );
-	}
-
-	for( int i = 0; i < ( int )rFile.Cursors.size(); i++ )
-	{
-		EnterTextStuff( rFile, C, i );
-	}
-
-} // EnterTextStuff
-
-//////////////////////////////////////////////////////////////////////////
-
-void TextEdit::EnterTextStuff( File& rFile, char C, int CursorIndex )
 {
 	Props.Changes = true;
 
-	Cursor& rCursor = rFile.Cursors[ CursorIndex ];
-
-	if( rCursor.Disabled ) return;
-
-	if( HasSelection( rFile, CursorIndex ) )
+	if( rFile.CursorMultiMode == MultiCursorMode::Box )
 	{
-		DeleteSelection( rFile, CursorIndex );
+		PrepareBoxModeForInput( rFile );
 	}
 
-	Line& rLine = rFile.Lines[ rCursor.Position.y ];
+	const bool Overwrite = rFile.CursorMode == CursorInputMode::Insert;
 
-	bool EndOfLine = rCursor.Position.x >= ( int )rLine.size();
+	ApplyCursorEdits( rFile, [ &rFile, C, Overwrite ]( CursorEdit& rEdit )
+		{
+			const size_t Line = rFile.Buffer.LineOf( rEdit.End );
 
-	if( EndOfLine )
-	{
-		rLine.push_back( Glyph( C, m_Palette.Default ) );
-	}
-	else if( rFile.CursorMode == CursorInputMode::Insert )
-	{
-		rLine[ rCursor.Position.x ].C = C;
-	}
-	else
-	{
-		rLine.insert( rLine.begin() + rCursor.Position.x, Glyph( C, m_Palette.Default ) );
+			// In insert mode the character replaces the one after the cursor, unless the line ends there
+			if( Overwrite && rEdit.End < rFile.Buffer.LineStart( Line ) + rFile.Buffer.LineLength( Line ) )
+				rEdit.End++;
 
-		AdjustCursors( rFile, CursorIndex, -1, 0 );
-	}
+			rEdit.Text  = std::string( 1, C );
+			rEdit.Caret = 1;
 
-	rCursor.Position.x++;
+			return true;
+		} );
 
 	ScrollToCursor( rFile );
 
@@ -2546,9 +3177,9 @@ void TextEdit::MoveUp( File& rFile, bool Shift, bool Alt )
 
 			rCursor.Position.y--;
 
-			Line& rLine = rFile.Lines[ rCursor.Position.y ];
+			const int LineLength = ( int )rFile.Buffer.LineLength( rCursor.Position.y );
 
-			if( rCursor.Position.x > ( int )rLine.size() ) rCursor.Position.x = ( int )rLine.size();
+			if( rCursor.Position.x > LineLength ) rCursor.Position.x = LineLength;
 
 			if( Shift )
 			{
@@ -2634,7 +3265,7 @@ void TextEdit::MoveDown( File& rFile, bool Shift, bool Alt )
 			Line = rRefCursor.Position.y + 1;
 		}
 
-		if( Line >= ( int )rFile.Lines.size() ) return;
+		if( Line >= ( int )rFile.Buffer.LineCount() ) return;
 
 		SetBoxSelection( rFile, Line, XDist );
 	}
@@ -2647,7 +3278,7 @@ void TextEdit::MoveDown( File& rFile, bool Shift, bool Alt )
 
 		for( Cursor& rCursor : rFile.Cursors )
 		{
-			if( rCursor.Position.y == ( int )rFile.Lines.size() - 1 ) continue;
+			if( rCursor.Position.y == ( int )rFile.Buffer.LineCount() - 1 ) continue;
 
 			if( rCursor.SelectionOrigin == Coordinate( -1, -1 ) && Shift )
 			{
@@ -2656,9 +3287,9 @@ void TextEdit::MoveDown( File& rFile, bool Shift, bool Alt )
 
 			rCursor.Position.y++;
 
-			Line& rLine = rFile.Lines[ rCursor.Position.y ];
+			const int LineLength = ( int )rFile.Buffer.LineLength( rCursor.Position.y );
 
-			if( rCursor.Position.x > ( int )rLine.size() ) rCursor.Position.x = ( int )rLine.size();
+			if( rCursor.Position.x > LineLength ) rCursor.Position.x = LineLength;
 
 			if( Shift )
 			{
@@ -2729,9 +3360,9 @@ void TextEdit::MoveRight( File& rFile, bool Ctrl, bool Shift, bool Alt )
 
 		if( Ctrl )
 		{
-			if( Coord.x == ( int )rFile.Lines[ Coord.y ].size() )
+			if( Coord.x == ( int )rFile.Buffer.LineLength( Coord.y ) )
 			{
-				if( Coord.y < ( int )rFile.Lines.size() - 1 )
+				if( Coord.y < ( int )rFile.Buffer.LineCount() - 1 )
 				{
 					Coord.x = 0;
 					Coord.y++;
@@ -2769,11 +3400,9 @@ void TextEdit::MoveRight( File& rFile, bool Ctrl, bool Shift, bool Alt )
 				rCursor.SelectionStart = rCursor.SelectionOrigin = rCursor.Position;
 			}
 
-			Line& rLine = rFile.Lines[ rCursor.Position.y ];
-
-			if( rCursor.Position.x == ( int )rLine.size() )
+			if( rCursor.Position.x == ( int )rFile.Buffer.LineLength( rCursor.Position.y ) )
 			{
-				if( rCursor.Position.y == ( int )rFile.Lines.size() - 1 ) continue;
+				if( rCursor.Position.y == ( int )rFile.Buffer.LineCount() - 1 ) continue;
 
 				rCursor.Position.x = 0;
 				rCursor.Position.y++;
@@ -2870,7 +3499,7 @@ void TextEdit::MoveLeft( File& rFile, bool Ctrl, bool Shift, bool Alt )
 			if( Coord.x == 0 )
 			{
 				Coord.y--;
-				Coord.x = ( int )rFile.Lines[ Coord.y ].size();
+				Coord.x = ( int )rFile.Buffer.LineLength( Coord.y );
 			}
 
 			Coordinate Start;
@@ -2919,8 +3548,7 @@ void TextEdit::MoveLeft( File& rFile, bool Ctrl, bool Shift, bool Alt )
 
 			if( rCursor.Position.x == 0 && rCursor.Position.y != 0 )
 			{
-				Line& rLine        = rFile.Lines[ --rCursor.Position.y ];
-				rCursor.Position.x = LineSize = ( int )rLine.size();
+				rCursor.Position.x = LineSize = ( int )rFile.Buffer.LineLength( --rCursor.Position.y );
 			}
 			else if( !Ctrl )
 			{
@@ -3098,9 +3726,9 @@ void TextEdit::End( File& rFile, bool Ctrl, bool Shift )
 			rCursor.SelectionStart = rCursor.SelectionOrigin = rCursor.Position;
 		}
 
-		Coordinate NewPos( 0, Ctrl ? ( int )rFile.Lines.size() - 1 : rCursor.Position.y );
+		Coordinate NewPos( 0, Ctrl ? ( int )rFile.Buffer.LineCount() - 1 : rCursor.Position.y );
 
-		NewPos.x = ( int )rFile.Lines[ NewPos.y ].size();
+		NewPos.x = ( int )rFile.Buffer.LineLength( NewPos.y );
 
 		if( Shift )
 		{
@@ -3180,56 +3808,56 @@ void TextEdit::Copy( File& rFile, bool Cut )
 
 		if( HasSelection( rFile, ( int )i ) )
 		{
-			if( rCursor.SelectionStart.y == rCursor.SelectionEnd.y )
-			{
-				Line&       rLine = rFile.Lines[ rCursor.SelectionStart.y ];
-				std::string Text  = GetString( rLine, rCursor.SelectionStart.x, rCursor.SelectionEnd.x );
+			const size_t Start = GetOffset( rFile, rCursor.SelectionStart );
+			const size_t End   = GetOffset( rFile, rCursor.SelectionEnd );
 
-				ClipBuffer.append( Text + "\n" );
-			}
-			else
-			{
-				Line&       rFirstLine = rFile.Lines[ rCursor.SelectionStart.y ];
-				std::string Text       = GetString( rFirstLine, rCursor.SelectionStart.x, ( int )rFirstLine.size() );
+			ClipBuffer.append( rFile.Buffer.GetText( Start, End - Start ) + "\n" );
+		}
+		else if( rFile.Cursors.size() == 1 )
+		{
+			std::string Text = rFile.Buffer.GetLine( rCursor.Position.y );
 
-				ClipBuffer.append( Text + "\n" );
+			if( Cut )
+			{
+				const size_t LineStart = rFile.Buffer.LineStart( rCursor.Position.y );
 
-				for( int j = rCursor.SelectionStart.y + 1; j <= rCursor.SelectionEnd.y - 1; j++ )
+				// Take the line break after the line along with it, or the one before it if this is the last line
+				if( rCursor.Position.y + 1 < ( int )rFile.Buffer.LineCount() )
 				{
-					Line& rLine = rFile.Lines[ j ];
-
-					if( rLine.empty() )
-					{
-						ClipBuffer.push_back( '\n' );
-						continue;
-					}
-
-					Text = GetString( rLine, 0, ( int )rLine.size() );
-
-					ClipBuffer.append( Text + "\n" );
+					EraseText( rFile, LineStart, Text.size() + 1 );
 				}
+				else if( LineStart > 0 )
+				{
+					EraseText( rFile, LineStart - 1, Text.size() + 1 );
 
-				Line& rLastLine = rFile.Lines[ rCursor.SelectionEnd.y ];
-				Text            = GetString( rLastLine, 0, rCursor.SelectionEnd.x );
+					rCursor.Position.y--;
+				}
+				else
+				{
+					EraseText( rFile, LineStart, Text.size() );
+				}
 
-				ClipBuffer.append( Text + "\n" );
+				rCursor.Position.x = std::min( rCursor.Position.x, ( int )rFile.Buffer.LineLength( rCursor.Position.y ) );
+				Props.Changes      = true;
 			}
 
-			if( Cut ) DeleteSelection( rFile, ( int )i );
+			ClipBuffer.append( Text + "\n" );
 		}
-		else if( rFile.Cursors.size() == 1 )
-		{
-			Line&       rLine = rFile.Lines[ rCursor.Position.y ];
-			std::string Text  = GetString( rLine, 0, ( int )rLine.size() );
+	}
 
-			if( Cut ) rFile.Lines.erase( rFile.Lines.begin() + rCursor.Position.y );
+	if( Cut && ( rFile.Cursors.size() > 1 || HasSelection( rFile, 0 ) ) )
+	{
+		// The selections are cut, and the cursors without one delete the character after them
+		ApplyCursorEdits( rFile, [ &rFile ]( CursorEdit& rEdit )
+			{
+				if( rEdit.Selection ) return true;
 
-			ClipBuffer.append( Text + "\n" );
-		}
-		else if( Cut )
-		{
-			Del( rFile, ( int )i, true );
-		}
+				if( rEdit.End == rFile.Buffer.Size() ) return false;
+
+				rEdit.End++;
+
+				return true;
+			} );
 	}
 
 	if( !ClipBuffer.empty() )
@@ -3252,77 +3880,57 @@ void TextEdit::Paste( File& rFile )
 
 	if( ClipBoard.empty() ) return;
 
-	int                 NumLinesInClipboard = 0;
-	int                 NumCursors          = ( int )rFile.Cursors.size();
-	std::vector< Line > ClipLines           = SplitLines( ClipBoard, &NumLinesInClipboard );
+	std::string ClipText = std::move( ClipBoard );
+	NormalizeLineBreaks( ClipText );
 
-	if( rFile.CursorMultiMode == MultiCursorMode::Box )
-	{
-		PrepareBoxModeForInput( rFile );
-
-		if( NumCursors >= NumLinesInClipboard )
-		{
-			NumCursors--;
-			for( int i = 0; i < NumLinesInClipboard; i++ )
-			{
-				Cursor& rCursor   = rFile.Cursors[ rFile.BoxModeDir == BoxModeDirection::Down ? i : NumCursors - i ];
-				Line&   rLine     = rFile.Lines[ rCursor.Position.y ];
-				Line&   rClipLine = ClipLines[ i ];
-
-				rLine.insert( rLine.begin() + rCursor.Position.x, rClipLine.begin(), rClipLine.end() );
-			}
-
-			Props.Changes = true;
+	// A line break at the very end does not start another line
+	if( ClipText.back() == '\n' ) ClipText.pop_back();
 
-			return;
-		}
-	}
+	std::vector< std::string_view > ClipLines;
 
-	for( int i = 0; i < NumCursors; i++ )
+	for( size_t Start = 0;; )
 	{
-		Cursor& rCursor = rFile.Cursors[ i ];
-
-		if( rCursor.Disabled ) continue;
+		const size_t End = ClipText.find( '\n', Start );
 
-		if( HasSelection( rFile, ( int )i ) )
-		{
-			DeleteSelection( rFile, ( int )i );
-		}
+		ClipLines.push_back( std::string_view( ClipText ).substr( Start, End - Start ) );
 
-		int   NumLines   = ( int )ClipLines.size();
-		Line& rFirstLine = rFile.Lines[ rCursor.Position.y ];
+		if( End == std::string::npos ) break;
 
-		rFirstLine.insert( rFirstLine.begin() + rCursor.Position.x, ClipLines[ 0 ].begin(), ClipLines[ 0 ].end() );
+		Start = End + 1;
+	}
 
-		if( NumLines > 1 )
-		{
-			int   XOffset        = rCursor.Position.x + ( int )ClipLines[ 0 ].size();
-			Line& rLastClipLine  = ClipLines.back();
-			Line  OgLastClipLine = rLastClipLine;
+	int NumLinesInClipboard = ( int )ClipLines.size();
+	int NumCursors          = ( int )rFile.Cursors.size();
 
-			rLastClipLine.insert( rLastClipLine.end(), rFirstLine.begin() + XOffset, rFirstLine.end() );
-			rFirstLine.erase( rFirstLine.begin() + XOffset, rFirstLine.end() );
+	if( rFile.CursorMultiMode == MultiCursorMode::Box )
+	{
+		PrepareBoxModeForInput( rFile );
 
-			rFile.Lines.insert( rFile.Lines.begin() + rCursor.Position.y + 1, ClipLines.begin() + 1, ClipLines.end() );
+		if( NumCursors >= NumLinesInClipboard )
+		{
+			NumCursors--;
+			for( int i = 0; i < NumLinesInClipboard; i++ )
+			{
+				Cursor& rCursor = rFile.Cursors[ rFile.BoxModeDir == BoxModeDirection::Down ? i : NumCursors - i ];
 
-			ClipLines.back() = OgLastClipLine;
+				InsertText( rFile, GetOffset( rFile, rCursor.Position ), ClipLines[ i ] );
+			}
 
-			AdjustCursors( rFile, ( int )i, XOffset, -( NumLines - 1 ) );
+			Props.Changes = true;
 
-			rCursor.Position.x = ( int )OgLastClipLine.size();
-			rCursor.Position.y += NumLines - 1;
+			return;
 		}
-		else
-		{
-			int XOffset = ( int )ClipLines[ 0 ].size();
+	}
 
-			AdjustCursors( rFile, ( int )i, -XOffset, 0 );
+	ApplyCursorEdits( rFile, [ &ClipText, &ClipLines ]( CursorEdit& rEdit )
+		{
+			rEdit.Text  = ClipText;
+			rEdit.Caret = ClipText.size();
 
-			rCursor.Position.x += XOffset;
-		}
+			if( ClipLines.size() > 1 ) rEdit.Virtual = 0;
 
-		Props.Changes = true;
-	}
+			return true;
+		} );
 
 	ScrollToCursor( rFile );
 
@@ -3411,7 +4019,7 @@ void TextEdit::SwapLines( File& rFile, bool Up )
 				Destination = rBackCursor.Position.y;
 			}
 
-			if( LineToMove + 1 == ( int )rFile.Lines.size() ) return;
+			if( LineToMove + 1 == ( int )rFile.Buffer.LineCount() ) return;
 
 			for( Cursor& rCur : rFile.Cursors )
 			{
@@ -3440,7 +4048,7 @@ void TextEdit::SwapLines( File& rFile, bool Up )
 				Destination = rCursor.Position.y + 2;
 			}
 
-			if( LineToMove + 1 == ( int )rFile.Lines.size() ) return;
+			if( LineToMove + 1 == ( int )rFile.Buffer.LineCount() ) return;
 
 			rCursor.Position.y++;
 
@@ -3453,10 +4061,7 @@ void TextEdit::SwapLines( File& rFile, bool Up )
 		}
 	}
 
-	auto& rLines = rFile.Lines;
-
-	rLines.insert( rLines.begin() + Destination, rLines[ LineToMove ] );
-	rLines.erase( rLines.begin() + LineToMove + ( ( !Up && Selection ) ? 1 : 0 ) );
+	MoveLine( rFile, LineToMove, Destination );
 
 	ScrollToCursor( rFile );
 
@@ -3466,6 +4071,27 @@ void TextEdit::SwapLines( File& rFile, bool Up )
 
 //////////////////////////////////////////////////////////////////////////
 
+void TextEdit::MoveLine( File& rFile, int From, int To )
+{
+	TextBuffer& rBuffer = rFile.Buffer;
+	std::string Text    = rBuffer.GetLine( From );
+
+	// Take the line out along with a line break. That's the one after it, unless it's the last line.
+	if( From + 1 < ( int )rBuffer.LineCount() ) EraseText( rFile, rBuffer.LineStart( From ), Text.size() + 1 );
+	else
+		EraseText( rFile, rBuffer.LineStart( From ) - 1, Text.size() + 1 );
+
+	// To is the line that the moved line should end up above, before the line was taken out
+	if( To > From ) To--;
+
+	if( To < ( int )rBuffer.LineCount() ) InsertText( rFile, rBuffer.LineStart( To ), Text + "\n" );
+	else
+		InsertText( rFile, rBuffer.Size(), "\n" + Text );
+
+} // MoveLine
+
+//////////////////////////////////////////////////////////////////////////
+
 std::vector< int > TextEdit::CursorsInText( File& rFile )
 {
 	std::vector< int > Cursors;
@@ -3480,15 +4106,15 @@ std::vector< int > TextEdit::CursorsInText( File& rFile )
 		{
 			if( rCursor.SelectionStart < rCursor.SelectionEnd )
 			{
-				if( rCursor.SelectionStart.x <= ( int )rFile.Lines[ rCursor.SelectionStart.y ].size() ) Cursors.push_back( i );
+				if( rCursor.SelectionStart.x <= ( int )rFile.Buffer.LineLength( rCursor.SelectionStart.y ) ) Cursors.push_back( i );
 			}
 			else
 			{
-				if( rCursor.SelectionEnd.x <= ( int )rFile.Lines[ rCursor.SelectionStart.y ].size() ) Cursors.push_back( i );
+				if( rCursor.SelectionEnd.x <= ( int )rFile.Buffer.LineLength( rCursor.SelectionStart.y ) ) Cursors.push_back( i );
 				;
 			}
 		}
-		else if( rCursor.Position.x <= ( int )rFile.Lines[ rCursor.Position.y ].size() )
+		else if( rCursor.Position.x <= ( int )rFile.Buffer.LineLength( rCursor.Position.y ) )
 		{
 			Cursors.push_back( i );
 		}
@@ -3513,15 +4139,15 @@ std::vector< int > TextEdit::CursorsNotInText( File& rFile )
 		{
 			if( rCursor.SelectionStart < rCursor.SelectionEnd )
 			{
-				if( rCursor.SelectionStart.x > ( int )rFile.Lines[ rCursor.SelectionStart.y ].size() ) Cursors.push_back( i );
+				if( rCursor.SelectionStart.x > ( int )rFile.Buffer.LineLength( rCursor.SelectionStart.y ) ) Cursors.push_back( i );
 			}
 			else
 			{
-				if( rCursor.SelectionEnd.x > ( int )rFile.Lines[ rCursor.SelectionStart.y ].size() ) Cursors.push_back( i );
+				if( rCursor.SelectionEnd.x > ( int )rFile.Buffer.LineLength( rCursor.SelectionStart.y ) ) Cursors.push_back( i );
 				;
 			}
 		}
-		else if( rCursor.Position.x > ( int )rFile.Lines[ rCursor.Position.y ].size() )
+		else if( rCursor.Position.x > ( int )rFile.Buffer.LineLength( rCursor.Position.y ) )
 		{
 			Cursors.push_back( i );
 		}
@@ -3534,6 +4160,8 @@ std::vector< int > TextEdit::CursorsNotInText( File& rFile )
 
 void TextEdit::ClearSearch( File& rFile )
 {
+	rFile.SearchDiag->Finder.Stop();
+
 	delete rFile.SearchDiag->SearchResult;
 	rFile.SearchDiag->SearchResult = nullptr;
 
@@ -3542,259 +4170,235 @@ void TextEdit::ClearSearch( File& rFile )
 
 //////////////////////////////////////////////////////////////////////////
 
-TextEdit::Coordinate TextEdit::SearchInLine( File& rFile, bool CaseSensitive, const std::string& rSearchString, Coordinate Start, int SearchStringOffset, std::vector< Glyph* >& rMatches )
+void TextEdit::Search( File& rFile, bool CaseSensitive, bool WholeWord, bool RegularExpression, const std::string& rSearchString )
 {
-	Line& rLine = rFile.Lines[ Start.y ];
-
-	int OgX = Start.x;
+	SearchDialog& rDiag = *rFile.SearchDiag;
 
-	if( OgX > ( int )rLine.size() ) return Start;
+	rDiag.ActiveItem = -1;
 
-	for( int i = SearchStringOffset; i < ( int )rSearchString.length(); i++ )
+	// A pattern that doesn't compile leaves its error with the finder, to be shown under the search field
+	if( !rDiag.Finder.Start( rFile.Buffer, TextSearch::Criteria{ rSearchString, CaseSensitive, WholeWord, RegularExpression } ) )
 	{
-		char C     = rSearchString[ i ];
-		int  Index = OgX + ( i - SearchStringOffset );
-		bool EOL   = Index == ( int )rLine.size();
-
-		if( EOL )
-		{
-			return Coordinate( OgX, Start.y );
-		}
-
-		Glyph* pGlyph = &rLine[ Index ];
+		ClearSearch( rFile );
+		return;
+	}
 
-		char GC = pGlyph->C;
+	rDiag.Restarted = !rSearchString.empty();
+} // Search
 
-		if( !CaseSensitive )
-		{
-			GC = ( char )std::tolower( GC );
-			C  = ( char )std::tolower( C );
-		}
+//////////////////////////////////////////////////////////////////////////
 
-		if( GC != C )
-		{
-			return Coordinate( OgX, Start.y );
-		}
+void TextEdit::CollectSearch( File& rFile )
+{
+	SearchDialog& rDiag = *rFile.SearchDiag;
 
-		rMatches.push_back( pGlyph );
+	if( !rDiag.Finder.IsSearching() ) return;
 
-		Start.x++;
+	// So much has been edited since the search started that where its lines went is no longer known
+	if( !rFile.Buffer.CanMapLines( rDiag.Finder.Version() ) )
+	{
+		Search( rFile, rDiag.CaseSensitive, rDiag.WholeWord, rDiag.RegularExpression, rDiag.SearchTerm );
 	}
 
-	return Start;
+	std::vector< TextSearch::Match > Matches;
+	const bool                       Finished = rDiag.Finder.Poll( Matches );
 
-} // SearchInLine
+	if( Matches.empty() && !Finished ) return;
 
-//////////////////////////////////////////////////////////////////////////
+	if( rDiag.Restarted )
+	{
+		delete rDiag.SearchResult;
 
-void TextEdit::SearchWorker( File* pFile, bool CaseSensitive, bool WholeWord, const std::string* pSearchString, int StartLine, int EndLine, std::vector< LineSelectionItem >* pResult, int* pState )
-{
-	Coordinate            Start( 0, StartLine );
-	std::vector< Glyph* > Matches;
+		rDiag.SearchResult = new SearchResultGroups;
+		rDiag.Restarted    = false;
+	}
 
-	while( *pState == SearchInstance::Running )
+	std::vector< LineSelectionItem > Found;
+	Found.reserve( Matches.size() );
+
+	for( const TextSearch::Match& rMatch : Matches )
 	{
-		Coordinate Next = SearchInLine( *pFile, CaseSensitive, *pSearchString, Start, 0, Matches );
+		// The lines that were edited since the search started have been searched again already (see UpdateSearchResults)
+		size_t Line = rMatch.Line;
+		if( !rFile.Buffer.MapLine( rDiag.Finder.Version(), Line ) )
+			continue;
 
-		if( Next == Start )
-		{
-			const Line& rLine = pFile->Lines[ Start.y ];
+		LineSelectionItem& rItem = Found.emplace_back( LineSelectionItem::Search );
 
-			if( Start.x >= ( int )rLine.size() )
-			{
-				if( Start.y >= EndLine )
-				{
-					break;
-				}
+		rItem.Start = Coordinate( ( int )rMatch.Column, ( int )Line );
+		rItem.End   = Coordinate( ( int )( rMatch.Column + rMatch.Length ), ( int )Line );
+	}
 
-				Start.y++;
-				Start.x = 0;
-			}
-			else
-			{
-				Start.x++;
-			}
-		}
-		else
-		{
-			LineSelectionItem Res( LineSelectionItem::Search );
+	rDiag.SearchResult->Insert( Found );
 
-			Res.Start = Start;
-			Res.End   = Next;
+	StatusBar::Instance().SetSearchResultInfo( rDiag.SearchTerm, ( int )rDiag.SearchResult->Size() );
+} // CollectSearch
 
-			if( WholeWord )
-			{
-				auto Cmp = []( char C ) -> bool
-				{
-					return C == '_' || ( C >= 'a' && C <= 'z' ) || ( C >= 'A' && C <= 'Z' ) || ( C >= '0' && C <= '9' );
-				};
+//////////////////////////////////////////////////////////////////////////
+
+void TextEdit::UpdateSearchResults( File& rFile, int FirstLine, int OldLastLine, int NewLastLine )
+{
+	if( !rFile.SearchDiag ) return;
 
-				const Glyph& rFirstGlyph = pFile->Lines[ Start.y ][ Start.x ];
-				const Glyph& rLastGlyph  = pFile->Lines[ Next.y ][ Next.x - 1 ];
+	SearchDialog& rDiag = *rFile.SearchDiag;
 
-				bool Match = true;
+	// A search that is still running goes through the text from before the edit, and what it finds on the edited lines is dropped when it
+	// is handed over. Those lines are searched here instead, so the results of the search before it can't be left standing in the meantime.
+	if( rDiag.Finder.IsSearching() && ( rDiag.Restarted || !rDiag.SearchResult ) )
+	{
+		delete rDiag.SearchResult;
 
-				if( Cmp( rFirstGlyph.C ) )
-				{
-					Coordinate WordStart;
-					GetWordAt( *pFile, Start, &WordStart, nullptr );
+		rDiag.SearchResult = new SearchResultGroups;
+		rDiag.Restarted    = false;
+	}
 
-					Match = WordStart == Start;
-				}
+	if( !rDiag.SearchResult ) return;
 
-				if( Cmp( rLastGlyph.C ) && Match )
-				{
-					Coordinate WordEnd;
-					GetWordAt( *pFile, Coordinate( Next.x - 1, Next.y ), nullptr, &WordEnd );
+	// Matches never span lines, so only the edited lines can have gained or lost any
+	std::vector< TextSearch::Match > Matches;
 
-					Match = WordEnd == Next;
-				}
+	for( int Line = FirstLine; Line <= NewLastLine; ++Line )
+		rDiag.Finder.SearchLine( rFile.Buffer.GetLine( Line ), ( size_t )Line, Matches );
 
-				if( Match )
-				{
-					pResult->push_back( Res );
-				}
-			}
-			else
-			{
-				pResult->push_back( Res );
-			}
+	std::vector< LineSelectionItem > Found;
+	Found.reserve( Matches.size() );
 
-			Start = Next;
-		}
+	for( const TextSearch::Match& rMatch : Matches )
+	{
+		LineSelectionItem& rItem = Found.emplace_back( LineSelectionItem::Search );
+
+		rItem.Start = Coordinate( ( int )rMatch.Column, ( int )rMatch.Line );
+		rItem.End   = Coordinate( ( int )( rMatch.Column + rMatch.Length ), ( int )rMatch.Line );
+	}
 
-		Matches.clear();
+	// The index of the active result doesn't hold up once results come and go before it
+	if( rDiag.ActiveItem != -1 )
+	{
+		rDiag.SearchResult->SetType( rDiag.ActiveItem, LineSelectionItem::Search );
+		rDiag.ActiveItem = -1;
 	}
-} // SearchWorker
+
+	rDiag.SearchResult->ReplaceLines( FirstLine, OldLastLine, NewLastLine, Found );
+
+	StatusBar::Instance().SetSearchResultInfo( rDiag.SearchTerm, ( int )rDiag.SearchResult->Size() );
+} // UpdateSearchResults
 
 //////////////////////////////////////////////////////////////////////////
 
-void TextEdit::SearchManager( File* pFile, bool CaseSensitive, bool WholeWord, SearchInstance* pInstance )
+void TextEdit::ReplaceSearchResults( File& rFile, bool All )
 {
-	const int    NumThreads = std::thread::hardware_concurrency();
-	const double Size       = ( double )( pFile->Lines.size() ) / NumThreads;
-	double       Prev       = 0.0;
+	SearchDialog& rDiag = *rFile.SearchDiag;
 
-	std::vector< std::pair< std::thread, std::vector< LineSelectionItem > > > ThreadPool;
+	// While a search is running its results are those of the text before the last edit
+	if( rDiag.SearchResult == nullptr || rDiag.SearchResult->Empty() || rDiag.Finder.IsSearching() ) return;
 
-	ThreadPool.resize( NumThreads );
+	Regex Pattern;
 
-	for( int i = 0; i < NumThreads; i++ )
-	{
-		const int StartLine = static_cast< int >( Prev );
-		const int EndLine   = static_cast< int >( Prev + Size ) - 1;
-		auto&     rThread   = ThreadPool[ i ];
-		rThread.first       = std::thread( &TextEdit::SearchWorker, this, pFile, CaseSensitive, WholeWord, &pInstance->SearchTerm, StartLine, EndLine, &rThread.second, &pInstance->State );
+	if( rDiag.RegularExpression && !Pattern.Compile( rDiag.SearchTerm, rDiag.CaseSensitive ) ) return;
 
-		Prev += Size;
-	}
+	// The results are copied, since every replacement brings the results of its line up to date
+	const std::vector< LineSelectionItem > Results = rDiag.SearchResult->All();
+	int                                    First   = rDiag.ActiveItem;
 
-	for( int i = 0; i < ( int )ThreadPool.size(); i++ )
+	// Without an active result, the first one after the cursor is replaced, so that replacing over and over goes down the file
+	if( First < 0 )
 	{
-		auto& rThread = ThreadPool[ i ];
+		const Coordinate Position = rFile.Cursors.empty() ? Coordinate() : rFile.Cursors.back().Position;
 
-		rThread.first.join();
+		First = 0;
 
-		for( int j = 0; j < ( int )rThread.second.size() && pInstance->State == SearchInstance::Running; j++ )
-		{
-			pInstance->Result->AddResult( rThread.second[ j ] );
-		}
+		while( First < ( int )Results.size() && Position > Results[ First ].Start )
+			++First;
+
+		if( First == ( int )Results.size() )
+			First = 0;
 	}
 
-	if( pInstance->State == SearchInstance::Running )
-		pInstance->Result->UpdateGroups();
+	if( All )
+		First = 0;
 
-	if( pInstance->State == SearchInstance::Running )
-	{
-		pInstance->State = SearchInstance::HasResult;
-	}
-	else
-	{
-		pInstance->State = SearchInstance::Stopped;
-	}
-}
+	const int             Last    = All ? ( int )Results.size() - 1 : First;
+	std::vector< size_t > Offsets = CursorOffsets( rFile );
+	size_t                Caret   = std::string::npos;
 
-void TextEdit::Search( File& rFile, bool CaseSensitive, bool WholeWord, const std::string& rSearchString )
-{
-	rFile.SearchDiag->ActiveItem = -1;
+	BeginEdit( rFile, EditHistory::Kind::Other );
 
-	for( SearchInstance* pInstance : rFile.SearchDiag->SearchInstances )
+	// Bottom up, so that the results that are yet to be replaced stay where they were found
+	for( int i = Last; i >= First; --i )
 	{
-		if( pInstance->State == SearchInstance::Running )
-		{
-			pInstance->State = SearchInstance::Stopping;
-		}
-	}
+		const LineSelectionItem& rItem = Results[ i ];
 
-	if( rSearchString.empty() ) return;
+		if( rItem.Start.y >= ( int )rFile.Buffer.LineCount() || rItem.End.x > ( int )rFile.Buffer.LineLength( rItem.Start.y ) ) continue;
 
-	SearchInstance* pInstance = new SearchInstance;
+		const size_t Start  = rFile.Buffer.LineStart( rItem.Start.y ) + rItem.Start.x;
+		const size_t Length = ( size_t )( rItem.End.x - rItem.Start.x );
+		std::string  Text   = rDiag.ReplaceTerm;
 
-	pInstance->SearchTerm = rSearchString;
-	pInstance->State      = SearchInstance::Running;
-	pInstance->Result     = new SearchResultGroups;
-	pInstance->Thread     = std::thread( &TextEdit::SearchManager, this, &rFile, CaseSensitive, WholeWord, pInstance );
+		// The groups aren't kept with the results, so the match is made again
+		if( rDiag.RegularExpression )
+		{
+			const std::string Line = rFile.Buffer.GetLine( rItem.Start.y );
+			Regex::Match      Match;
 
-	rFile.SearchDiag->SearchInstances.push_back( pInstance );
-} // Search
+			if( !Pattern.Find( Line, rItem.Start.x, Match ) || Match.Start != ( size_t )rItem.Start.x || Match.End != ( size_t )rItem.End.x ) continue;
 
-//////////////////////////////////////////////////////////////////////////
+			Text = Regex::Expand( rDiag.ReplaceTerm, Line, Match );
+		}
 
-void TextEdit::JoinThreads( File& rFile, bool WaitForUnfinished )
-{
-	std::vector< SearchInstance* >& rInstances = rFile.SearchDiag->SearchInstances;
+		EraseText( rFile, Start, Length );
+		InsertText( rFile, Start, Text );
 
-	if( WaitForUnfinished )
-	{
-		for( SearchInstance* pInstance : rInstances )
+		for( size_t& rOffset : Offsets )
 		{
-			pInstance->State = SearchInstance::Stopping;
+			if( rOffset >= Start + Length ) rOffset = rOffset - Length + Text.size();
+			else if( rOffset > Start )      rOffset = Start + Text.size();
 		}
 
-		for( SearchInstance* pInstance : rInstances )
-		{
-			pInstance->Thread.join();
-			delete pInstance;
-		}
+		Caret = Start + Text.size();
+	}
 
-		rInstances.clear();
-		StatusBar::Instance().SetSearchResultInfo( "", 0 );
+	if( Caret == std::string::npos )
+	{
+		EndEdit( rFile );
+		return;
 	}
-	else
+
+	// A single replacement leaves the cursor after it. The cursors are otherwise kept where they were in the text.
+	if( !All )
+		Offsets = { Caret };
+
+	rFile.Cursors.clear();
+
+	for( size_t Offset : Offsets )
 	{
-		for( int i = 0; i < ( int )rInstances.size(); i++ )
-		{
-			SearchInstance* pInstance = rInstances[ i ];
+		const size_t Line = rFile.Buffer.LineOf( Offset );
+		Cursor       NewCursor;
 
-			if( pInstance->State == SearchInstance::Stopped || pInstance->State == SearchInstance::HasResult )
-			{
-				pInstance->Thread.join();
-				rInstances.erase( rInstances.begin() + i );
+		NewCursor.Position = Coordinate( ( int )( Offset - rFile.Buffer.LineStart( Line ) ), ( int )Line );
+		rFile.Cursors.push_back( NewCursor );
+	}
 
-				if( pInstance->State == SearchInstance::HasResult )
-				{
-					delete rFile.SearchDiag->SearchResult;
+	if( rFile.Cursors.empty() )
+		rFile.Cursors.emplace_back();
 
-					rFile.SearchDiag->SearchResult = pInstance->Result;
+	YeetDuplicateCursors( rFile );
+	EndEdit( rFile );
 
-					StatusBar::Instance().SetSearchResultInfo( pInstance->SearchTerm, ( int )pInstance->Result->Size() );
-				}
+	rFile.CursorMultiMode = MultiCursorMode::Normal;
+	Props.Changes         = true;
 
-				delete pInstance;
-			}
-		}
-	}
-} // JoinThreads
+	ScrollToCursor( rFile );
+} // ReplaceSearchResults
 
 //////////////////////////////////////////////////////////////////////////
 
 void TextEdit::ShowSearchDialog( File& rFile, ImGuiID FocusId, ImGuiWindow* pWindow )
 {
-	JoinThreads( rFile, false );
+	CollectSearch( rFile );
 
 	SearchDialog& rDiag   = *rFile.SearchDiag;
 	float         Width   = 350.0f;
-	float         Height  = 60.0f;
+	float         Height  = rDiag.Finder.Error().empty() ? 86.0f : 108.0f;
 	float         Padding = 4.0f;
 	ImVec2        Cursor  = ImGui::GetCursorPos();
 	ImVec2        Size    = ImGui::GetContentRegionAvail();
@@ -3817,9 +4421,9 @@ void TextEdit::ShowSearchDialog( File& rFile, ImGuiID FocusId, ImGuiWindow* pWin
 		ImGui::SetKeyboardFocusHere( 0 );
 	}
 
-	if( ImGui::InputText( "##SearchTerm", &rDiag.SearchTerm ) || Props.Changes )
+	if( ImGui::InputText( "##SearchTerm", &rDiag.SearchTerm ) )
 	{
-		Search( rFile, rDiag.CaseSensitive, rDiag.WholeWord, rDiag.SearchTerm );
+		Search( rFile, rDiag.CaseSensitive, rDiag.WholeWord, rDiag.RegularExpression, rDiag.SearchTerm );
 
 		if( rDiag.SearchTerm.size() == 0 )
 		{
@@ -3849,16 +4453,14 @@ void TextEdit::ShowSearchDialog( File& rFile, ImGuiID FocusId, ImGuiWindow* pWin
 
 		if( PrevActive != -1 )
 		{
-			LineSelectionItem& rPrev = ( *rDiag.SearchResult )[ PrevActive ];
-			rPrev.Type               = LineSelectionItem::Search;
+			rDiag.SearchResult->SetType( PrevActive, LineSelectionItem::Search );
 		}
 
 		if( rDiag.ActiveItem != -1 )
 		{
-			LineSelectionItem& rCurr = ( *rDiag.SearchResult )[ rDiag.ActiveItem ];
-			rCurr.Type               = LineSelectionItem::SearchActive;
+			rDiag.SearchResult->SetType( rDiag.ActiveItem, LineSelectionItem::SearchActive );
 
-			ScrollTo( rFile, rCurr.Start, pWindow );
+			ScrollTo( rFile, rDiag.SearchResult->Get( rDiag.ActiveItem ).Start, pWindow );
 		}
 	}
 
@@ -3879,16 +4481,14 @@ void TextEdit::ShowSearchDialog( File& rFile, ImGuiID FocusId, ImGuiWindow* pWin
 
 		if( PrevActive != -1 )
 		{
-			LineSelectionItem& rPrev = ( *rDiag.SearchResult )[ PrevActive ];
-			rPrev.Type               = LineSelectionItem::Search;
+			rDiag.SearchResult->SetType( PrevActive, LineSelectionItem::Search );
 		}
 
 		if( rDiag.ActiveItem != -1 )
 		{
-			LineSelectionItem& rCurr = ( *rDiag.SearchResult )[ rDiag.ActiveItem ];
-			rCurr.Type               = LineSelectionItem::SearchActive;
+			rDiag.SearchResult->SetType( rDiag.ActiveItem, LineSelectionItem::SearchActive );
 
-			ScrollTo( rFile, rCurr.Start, pWindow );
+			ScrollTo( rFile, rDiag.SearchResult->Get( rDiag.ActiveItem ).Start, pWindow );
 		}
 	}
 
@@ -3902,7 +4502,6 @@ void TextEdit::ShowSearchDialog( File& rFile, ImGuiID FocusId, ImGuiWindow* pWin
 		rDiag.ActiveItem = -1;
 		rDiag.SearchTerm.clear();
 
-		JoinThreads( rFile, true );
 		ClearSearch( rFile );
 
 		ImGui::SetFocusID( FocusId, pWindow );
@@ -3910,6 +4509,28 @@ void TextEdit::ShowSearchDialog( File& rFile, ImGuiID FocusId, ImGuiWindow* pWin
 
 	ImGui::SetCursorPosX( Padding );
 
+	ImGui::InputText( "##ReplaceTerm", &rDiag.ReplaceTerm );
+
+	ImGui::SameLine();
+
+	ImGui::BeginDisabled( ( rDiag.SearchResult == nullptr ) || ( rDiag.SearchResult->Empty() ) || rDiag.Finder.IsSearching() );
+
+	if( ImGui::Button( "Replace" ) )
+	{
+		ReplaceSearchResults( rFile, false );
+	}
+
+	ImGui::SameLine();
+
+	if( ImGui::Button( "All" ) )
+	{
+		ReplaceSearchResults( rFile, true );
+	}
+
+	ImGui::EndDisabled();
+
+	ImGui::SetCursorPosX( Padding );
+
 	ImGui::TextUnformatted( "Case Sensitive:" );
 
 	ImGui::SameLine();
@@ -3918,7 +4539,7 @@ void TextEdit::ShowSearchDialog( File& rFile, ImGuiID FocusId, ImGuiWindow* pWin
 	{
 		if( !rDiag.SearchTerm.empty() )
 		{
-			Search( rFile, rDiag.CaseSensitive, rDiag.WholeWord, rDiag.SearchTerm );
+			Search( rFile, rDiag.CaseSensitive, rDiag.WholeWord, rDiag.RegularExpression, rDiag.SearchTerm );
 		}
 	}
 
@@ -3932,10 +4553,30 @@ void TextEdit::ShowSearchDialog( File& rFile, ImGuiID FocusId, ImGuiWindow* pWin
 	{
 		if( !rDiag.SearchTerm.empty() )
 		{
-			Search( rFile, rDiag.CaseSensitive, rDiag.WholeWord, rDiag.SearchTerm );
+			Search( rFile, rDiag.CaseSensitive, rDiag.WholeWord, rDiag.RegularExpression, rDiag.SearchTerm );
+		}
+	}
+
+	ImGui::SameLine();
+
+	ImGui::TextUnformatted( "Regex:" );
+
+	ImGui::SameLine();
+
+	if( ImGui::Checkbox( "##RegularExpression", &rDiag.RegularExpression ) )
+	{
+		if( !rDiag.SearchTerm.empty() )
+		{
+			Search( rFile, rDiag.CaseSensitive, rDiag.WholeWord, rDiag.RegularExpression, rDiag.SearchTerm );
 		}
 	}
 
+	if( !rDiag.Finder.Error().empty() )
+	{
+		ImGui::SetCursorPosX( Padding );
+		ImGui::TextColored( ImVec4( 1.0f, 0.4f, 0.4f, 1.0f ), "%s", rDiag.Finder.Error().c_str() );
+	}
+
 	ImGui::PopStyleVar();
 	ImGui::PopStyleVar();
 
@@ -3948,75 +4589,232 @@ void TextEdit::ShowSearchDialog( File& rFile, ImGuiID FocusId, ImGuiWindow* pWin
 
 // Struct Implementations
 
-SearchResultGroups::SearchResultGroups()
+static TextEdit::LineSelectionItem MoveItem( TextEdit::LineSelectionItem Item, int Lines )
 {
-	Groups.emplace_back();
-}
+	Item.Start.y += Lines;
+	Item.End.y   += Lines;
 
-std::vector< TextEdit::LineSelectionItem* >& SearchResultGroups::GetGroup( int LineIndex )
-{
-	int Group = LineIndex / SearchResultGroupSize;
-	GENO_ASSERT( Group < ( int )Groups.size() );
-	return Groups[ Group ];
-}
+	return Item;
 
-bool SearchResultGroups::GroupExist( int LineIndex )
-{
-	int Group = LineIndex / SearchResultGroupSize;
+} // MoveItem
 
-	return Group < ( int )Groups.size();
-}
+//////////////////////////////////////////////////////////////////////////
 
-void SearchResultGroups::AddResult( const TextEdit::LineSelectionItem& Item )
+void SearchResultGroups::Insert( const std::vector< Item >& rItems )
 {
-	Result.push_back( Item );
-}
+	size_t i = 0;
+
+	while( i < rItems.size() )
+	{
+		const int Line = rItems[ i ].Start.y;
+
+		// Results go after the ones that are there already, which is where most of them go while a search is running
+		if( m_Groups.empty() || LastLine( m_Groups.back() ) <= Line )
+		{
+			Append( rItems[ i++ ] );
+			continue;
+		}
+
+		// Otherwise everything up to the next line that has results goes in the same place
+		const Group& rNext    = m_Groups[ FindGroup( Line + 1 ) ];
+		const int    NextLine = rNext.BaseLine + std::partition_point( rNext.Items.begin(), rNext.Items.end(), [ & ]( const Item& rItem ) { return rNext.BaseLine + rItem.Start.y <= Line; } )->Start.y;
+		size_t       End      = i + 1;
+
+		while( End < rItems.size() && rItems[ End ].Start.y < NextLine )
+			++End;
+
+		InsertBefore( Line + 1, rItems.begin() + i, rItems.begin() + End );
+		i = End;
+	}
+
+} // Insert
+
+//////////////////////////////////////////////////////////////////////////
 
-void SearchResultGroups::UpdateGroups()
+void SearchResultGroups::ReplaceLines( int FirstLine, int OldLastLine, int NewLastLine, const std::vector< Item >& rFound )
 {
-	Groups.clear();
-	Groups.emplace_back();
+	const int Delta = NewLastLine - OldLastLine;
+	size_t    Index = FindGroup( FirstLine );
 
-	for( TextEdit::LineSelectionItem& rItem : Result )
+	// The groups that have results on the old lines lose them, and the results after them in the same group move along one by one
+	while( Index < m_Groups.size() && this->FirstLine( m_Groups[ Index ] ) <= OldLastLine )
 	{
-		const TextEdit::Coordinate& Start = rItem.Start;
-		const TextEdit::Coordinate& End   = rItem.End;
+		Group&       rGroup = m_Groups[ Index ];
+		const size_t Before = rGroup.Items.size();
 
-		int StartGroup = Start.y / SearchResultGroupSize;
-		int EndGroup   = End.y / SearchResultGroupSize;
+		std::erase_if( rGroup.Items, [ & ]( const Item& rItem )
+			{
+				const int Line = rGroup.BaseLine + rItem.Start.y;
+
+				return Line >= FirstLine && Line <= OldLastLine;
+			} );
 
-		for( int i = ( int )Groups.size(); i <= EndGroup; i++ )
+		m_Size -= Before - rGroup.Items.size();
+
+		for( Item& rItem : rGroup.Items )
 		{
-			Groups.emplace_back();
+			if( rGroup.BaseLine + rItem.Start.y > OldLastLine )
+				rItem = MoveItem( rItem, Delta );
 		}
 
-		for( int i = StartGroup; i <= EndGroup; i++ )
+		if( rGroup.Items.empty() ) m_Groups.erase( m_Groups.begin() + Index );
+		else                       ++Index;
+	}
+
+	// Every group from here on is below the edit as a whole
+	for( size_t i = Index; i < m_Groups.size(); ++i )
+		m_Groups[ i ].BaseLine += Delta;
+
+	// The new results go in between the results before the edit and the ones after it, which may be in the same group
+	InsertBefore( FirstLine, rFound.begin(), rFound.end() );
+
+} // ReplaceLines
+
+//////////////////////////////////////////////////////////////////////////
+
+void SearchResultGroups::Append( const Item& rItem )
+{
+	if( m_Groups.empty() || m_Groups.back().Items.size() >= SearchResultGroupCapacity )
+		m_Groups.push_back( Group{ rItem.Start.y, { } } );
+
+	Group& rGroup = m_Groups.back();
+
+	rGroup.Items.push_back( MoveItem( rItem, -rGroup.BaseLine ) );
+	++m_Size;
+
+} // Append
+
+//////////////////////////////////////////////////////////////////////////
+
+// Puts [First, Last) in front of the results on LineIndex and the lines below it
+void SearchResultGroups::InsertBefore( int LineIndex, std::vector< Item >::const_iterator First, std::vector< Item >::const_iterator Last )
+{
+	if( First == Last )
+		return;
+
+	size_t Index    = FindGroup( LineIndex );
+	size_t Position = 0;
+
+	if( Index < m_Groups.size() && FirstLine( m_Groups[ Index ] ) < LineIndex )
+	{
+		const Group& rGroup = m_Groups[ Index ];
+
+		Position = static_cast< size_t >( std::partition_point( rGroup.Items.begin(), rGroup.Items.end(), [ & ]( const Item& rItem ) { return rGroup.BaseLine + rItem.Start.y < LineIndex; } ) - rGroup.Items.begin() );
+	}
+	else if( Index > 0 )
+	{
+		Position = m_Groups[ --Index ].Items.size();
+	}
+	else if( m_Groups.empty() )
+	{
+		m_Groups.push_back( Group{ LineIndex, { } } );
+	}
+
+	Group&              rGroup = m_Groups[ Index ];
+	std::vector< Item > Moved;
+
+	Moved.reserve( static_cast< size_t >( Last - First ) );
+
+	for( auto It = First; It != Last; ++It )
+		Moved.push_back( MoveItem( *It, -rGroup.BaseLine ) );
+
+	rGroup.Items.insert( rGroup.Items.begin() + Position, Moved.begin(), Moved.end() );
+	m_Size += Moved.size();
+
+	// A group that has grown too big is split in halves of the most it may hold, all of them counting from the same line
+	if( rGroup.Items.size() > SearchResultGroupCapacity )
+	{
+		std::vector< Group > Pieces;
+
+		for( size_t i = 0; i < rGroup.Items.size(); i += SearchResultGroupCapacity / 2 )
 		{
-			Groups[ i ].push_back( &rItem );
+			const size_t End   = std::min( i + SearchResultGroupCapacity / 2, rGroup.Items.size() );
+			Group&       Piece = Pieces.emplace_back( Group{ rGroup.BaseLine, { } } );
+
+			Piece.Items.assign( rGroup.Items.begin() + i, rGroup.Items.begin() + End );
 		}
+
+		m_Groups.erase( m_Groups.begin() + Index );
+		m_Groups.insert( m_Groups.begin() + Index, std::make_move_iterator( Pieces.begin() ), std::make_move_iterator( Pieces.end() ) );
 	}
-}
 
-void SearchResultGroups::Clear()
+} // InsertBefore
+
+//////////////////////////////////////////////////////////////////////////
+
+void SearchResultGroups::GetLine( int LineIndex, std::vector< Item >& rItems ) const
 {
-	Groups.clear();
-	Result.clear();
-	Groups.emplace_back();
-}
+	// The results of a line with many of them may go on in the next group
+	for( size_t i = FindGroup( LineIndex ); i < m_Groups.size() && FirstLine( m_Groups[ i ] ) <= LineIndex; ++i )
+	{
+		const Group& rGroup = m_Groups[ i ];
+		auto         It     = std::partition_point( rGroup.Items.begin(), rGroup.Items.end(), [ & ]( const Item& rItem ) { return rGroup.BaseLine + rItem.Start.y < LineIndex; } );
+
+		for( ; It != rGroup.Items.end() && rGroup.BaseLine + It->Start.y == LineIndex; ++It )
+			rItems.push_back( MoveItem( *It, rGroup.BaseLine ) );
+	}
+
+} // GetLine
+
+//////////////////////////////////////////////////////////////////////////
 
-size_t SearchResultGroups::Size()
+SearchResultGroups::Item SearchResultGroups::Get( size_t Index ) const
 {
-	return Result.size();
-}
+	const auto [ GroupIndex, Position ] = Locate( Index );
+	const Group& rGroup                 = m_Groups[ GroupIndex ];
+
+	return MoveItem( rGroup.Items[ Position ], rGroup.BaseLine );
+
+} // Get
+
+//////////////////////////////////////////////////////////////////////////
 
-bool SearchResultGroups::Empty()
+void SearchResultGroups::SetType( size_t Index, int Type )
 {
-	return Size() == 0;
-}
+	const auto [ GroupIndex, Position ] = Locate( Index );
+
+	m_Groups[ GroupIndex ].Items[ Position ].Type = Type;
+
+} // SetType
 
-TextEdit::LineSelectionItem& SearchResultGroups::operator[]( int Index )
+//////////////////////////////////////////////////////////////////////////
+
+std::vector< SearchResultGroups::Item > SearchResultGroups::All( void ) const
 {
-	return Result[ Index ];
-}
+	std::vector< Item > Items;
+	Items.reserve( m_Size );
+
+	for( const Group& rGroup : m_Groups )
+	{
+		for( const Item& rItem : rGroup.Items )
+			Items.push_back( MoveItem( rItem, rGroup.BaseLine ) );
+	}
+
+	return Items;
+
+} // All
+
+//////////////////////////////////////////////////////////////////////////
+
+// The first group that has results on the line or below it
+size_t SearchResultGroups::FindGroup( int LineIndex ) const
+{
+	return static_cast< size_t >( std::partition_point( m_Groups.begin(), m_Groups.end(), [ & ]( const Group& rGroup ) { return LastLine( rGroup ) < LineIndex; } ) - m_Groups.begin() );
+
+} // FindGroup
+
+//////////////////////////////////////////////////////////////////////////
+
+// Results are looked up by their index only when going from one to the next, which counts through the groups rather than the results
+std::pair< size_t, size_t > SearchResultGroups::Locate( size_t Index ) const
+{
+	size_t GroupIndex = 0;
+
+	while( Index >= m_Groups[ GroupIndex ].Items.size() )
+		Index -= m_Groups[ GroupIndex++ ].Items.size();
+
+	return { GroupIndex, Index };
+
+} // Locate
 
 //////////////////////////////////////////////////////////////////////////
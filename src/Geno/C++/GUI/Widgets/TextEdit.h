@@ -16,10 +16,21 @@
  */
 
 #pragma once
+#include "Components/EditHistory.h"
+#include "Components/LargeFile.h"
+#include "Components/SyntaxHighlighter.h"
+#include "Components/TextBuffer.h"
+#include "Components/TextSearch.h"
+
+#include <Common/Async/JobSystem.h>
 #include <Common/Macros.h>
 #include <Common/Texture2D.h>
 
+#include <atomic>
 #include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include <thread>
@@ -36,7 +47,6 @@
 class Drop;
 class SearchDialog;
 class SearchResultGroups;
-struct SearchInstance;
 struct ImGuiTabBar;
 
 class TextEdit
@@ -60,16 +70,19 @@ public:
 		unsigned int CurrentLineEdge;
 	};
 
-	struct Glyph
+	// What the lines of a file were separated by on disk. The buffer only ever holds '\n', and the file is saved the way it was loaded.
+	enum class LineEnding
 	{
-		unsigned int Color;
-		char         C;
+		LF,
+		CRLF,
+		CR
+	};
 
-		Glyph( char C, unsigned int Color )
-			: Color( Color )
-			, C( C )
-		{
-		}
+	// A run of text in one color, from Start up to the start of the next span on the same line
+	struct ColorSpan
+	{
+		uint32_t     Start;
+		unsigned int Color;
 	};
 
 	struct Coordinate
@@ -132,7 +145,37 @@ public:
 		bool Disabled = false;
 	};
 
-	typedef std::vector< Glyph > Line;
+	// One cursor's share of an edit that is made at every cursor at once: [Start, End) is replaced by Text, after which
+	// the cursor sits Caret bytes past Start and Virtual columns further out (for cursors past the end of their line, or
+	// selections that start past it).
+	struct CursorEdit
+	{
+		size_t      Start;
+		size_t      End;
+		std::string Text;
+		size_t      Caret     = 0;
+		int         Virtual   = 0;
+		bool        Selection = false;
+	};
+
+	// Returns false to leave the text alone at this cursor
+	using CursorEditFunction = std::function< bool( CursorEdit& rEdit ) >;
+
+	// A change to the text that leaves every cursor where it was in the text around it, selections included
+	struct TextChange
+	{
+		size_t      Start;
+		size_t      End;
+		std::string Text;
+	};
+
+	// The cursors on the visible lines, filed by line in a single pass so that drawing a line only looks at its own
+	struct VisibleCursors
+	{
+		int                               FirstLine;
+		std::vector< std::vector< int > > Positions;
+		std::vector< std::vector< int > > Selections;
+	};
 
 	enum class CursorInputMode
 	{
@@ -174,22 +217,53 @@ public:
 		}
 	};
 
+	// Files past LargeFileSize are never loaded into a buffer. They are shown read-only, straight from disk.
+	struct LargeFileState
+	{
+		std::unique_ptr< LargeFile > pFile;
+		uint64_t                     TopLine  = 0;
+		std::string                  SearchTerm;
+		bool                         NotFound = false;
+	};
+
+	// While a selection is dragged out, only the cursor at its end moves. The ends of the other cursors are sorted once for the length
+	// of the drag, so that each frame only looks at the cursors that the selection reaches.
+	struct SelectionDragState
+	{
+		std::vector< std::pair< Coordinate, int > > Ends;
+		std::vector< int >                          Disabled;
+		int                                         Cursor = -1;
+		bool                                        Valid  = false;
+	};
+
 	struct File
 	{
 		std::filesystem::path Path;
-		std::string           Text;
+		TextBuffer            Buffer;
+		SyntaxHighlighter     Highlighter;
+		EditHistory           History;
+		LineEnding            Ending = LineEnding::LF;
+		LargeFileState        Large;
+		SelectionDragState    SelectionDrag;
+
+		// Colors are kept apart from the text, and only for the lines that were visible when the file was last drawn
+		std::map< int, std::vector< ColorSpan > > LineColors;
 
-		std::vector< Line > Lines;
+		// The distance from the start of a line to each of its bytes (and its end), for the lines that were looked at lately
+		std::map< int, std::vector< float > > XOffsets;
+		uint32_t                              XOffsetsGeneration = 0;
 
 		bool Open    = true;
 		bool Changed = false;
 
 		std::vector< Cursor > Cursors;
 
-		float              LongestLineLength;
-		std::vector< int > LongestLines;
+		// How many lines there are of each width, so the widest is the last one. Edits take out the widths of the lines they replace and
+		// put in those of the new ones, which leaves measuring the whole file to when it's loaded or the font changes.
+		std::map< float, size_t > LineWidths;
+		uint32_t                  LineWidthsGeneration = 0;
 
-		SearchDialog* SearchDiag;
+		std::unique_ptr< SearchDialog > SearchDiag;
 
 		BoxModeDirection BoxModeDir      = BoxModeDirection::None;
 		CursorInputMode  CursorMode      = CursorInputMode::Normal;
@@ -198,7 +272,8 @@ public:
 
 	//////////////////////////////////////////////////////////////////////////
 
-	TextEdit( void );
+	 TextEdit( void );
+	~TextEdit( void );
 
 	//////////////////////////////////////////////////////////////////////////
 
@@ -206,6 +281,7 @@ public:
 	void AddFile( const std::filesystem::path& rPath );
 	void OnDragDrop( const Drop& rDrop, int X, int Y );
 	void SaveFile( File& rFile );
+	void WaitForSaves( void );
 	void ReplaceFile( const std::filesystem::path& rOldPath, const std::filesystem::path& rNewPath );
 
 	const std::filesystem::path& GetActiveFilePath() const { return m_ActiveFilePath; }
@@ -217,10 +293,19 @@ public:
 	std::vector< File > Files = { };
 
 private:
-	void                SplitLines( File& rFile );
-	std::vector< Line > SplitLines( const std::string String, int* Count = nullptr );
-	void                JoinLines( File& rFile );
-	std::string         GetString( const Line& rLine, int Start, int End );
+	static LineEnding NormalizeLineBreaks( std::string& rText );
+
+	void                        InsertText     ( File& rFile, size_t Offset, std::string_view Text );
+	void                        EraseText      ( File& rFile, size_t Offset, size_t Length );
+	void                        InvalidateLines( File& rFile, int FirstLine, int OldLastLine, int NewLastLine );
+	std::vector< ColorSpan >    ColorLine      ( File& rFile, int LineIndex, std::string_view Line );
+	void                        UpdateAdvances ( void );
+	float                       MeasureText    ( std::string_view Text, std::vector< float >* pOffsets ) const;
+	const std::vector< float >& GetXOffsets    ( File& rFile, int LineIndex ) const;
+	void                        BeginEdit      ( File& rFile, EditHistory::Kind Kind );
+	void                        EndEdit        ( File& rFile );
+	std::vector< size_t >       CursorOffsets  ( File& rFile ) const;
+	void                        Undo           ( File& rFile, bool Redo );
 
 	typedef Coordinate Scroll;
 
@@ -238,6 +323,7 @@ private:
 	} Props;
 
 	bool                             RenderEditor( File& rFile );
+	void                             RenderLargeFile( File& rFile );
 	void                             HandleKeyboardInputs( File& rFile );
 	void                             HandleMouseInputs( File& rFile );
 	ImVec2                           GetMousePosition();
@@ -245,18 +331,20 @@ private:
 	void                             ScrollToCursor( File& rFile );
 	void                             ScrollTo( File& rFile, Coordinate Position );
 	void                             ScrollTo( File& rFile, Coordinate Position, ImGuiWindow* pWindow );
-	void                             CheckLineLengths( File& rFile, int FirstLine, int LastLine );
-	float                            GetMaxCursorDistance( File& rFile );
+	void                             CountLineWidths( File& rFile, int FirstLine, int LastLine, bool Add );
+	void                             MeasureAllLines( File& rFile );
+	float                            GetMaxCursorDistance( File& rFile, const VisibleCursors& rVisible );
+	void                             BucketCursors( File& rFile, int FirstLine, int LastLine, VisibleCursors& rVisible ) const;
 	void                             CalculeteLineNumMaxWidth( File& rFile );
 	bool                             HasSelection( File& rFile, int cursor ) const;
 	Cursor*                          IsCoordinateInSelection( File& rFile, Coordinate Coordinate, int Offset = 0 );
 	LineSelectionItem                IsSelectionOnLine( File& rFile, int LineIndex, Coordinate Start, Coordinate End ) const;
-	std::vector< LineSelectionItem > IsLineSelected( File& rFile, int LineIndex ) const;
+	std::vector< LineSelectionItem > IsLineSelected( File& rFile, int LineIndex, const std::vector< int >& rCursors ) const;
+	size_t                           GetOffset( File& rFile, Coordinate Position ) const;
 	float                            GetDistance( File& rFile, Coordinate Position ) const;
 	std::string                      GetWordAt( File& rFile, Cursor& Cursor ) const;
 	std::string                      GetWordAt( File& rFile, Coordinate Position, Coordinate* pStart, Coordinate* pEnd ) const;
 	bool                             IsCoordinateInText( File& rFile, Coordinate Position );
-	void                             AdjustCursorIfInText( File& rFile, Cursor& rCursor, int Line, int XOffset );
 	void                             AdjustCursor( Cursor& Cursor, int XOffset );
 	void                             SetSelectionLine( File& rFile, int Line );
 	void                             SetSelection( File& rFile, Coordinate Start, Coordinate End, int Cursor );
@@ -266,21 +354,18 @@ private:
 	Coordinate                       GetCoordinate( File& rFile, ImVec2 Position, bool AllowPastLine = false );
 	Coordinate                       CalculateTabAlignment( File& rFile, Coordinate FromPosition );
 	float                            CalculateTabAlignmentDistance( File& rFile, Coordinate FromPosition );
-	void                             AdjustCursors( File& rFile, int Cursor, int XOffset, int YOffset );
+	std::vector< int >               SortedCursors( File& rFile ) const;
 	void                             YeetDuplicateCursors( File& rFile );
+	void                             ApplyCursorEdits( File& rFile, const CursorEditFunction& rFunction );
+	void                             ApplyTextChanges( File& rFile, std::vector< TextChange > Changes );
 	void                             DisableIntersectionsInSelection( File& rFile, int Cursor );
 	void                             DeleteDisabledCursor( File& rFile );
-	void                             DeleteSelection( File& rFile, int Cursor );
 	void                             Enter( File& rFile );
 	void                             Backspace( File& rFile );
-	void                             Backspace( File& rFile, int CursorIndex, bool DeleteLine );
 	void                             Del( File& rFile );
-	void                             Del( File& rFile, int CursorIndex, bool DeleteLine );
 	void                             Tab( File& rFile, bool Shift );
-	void                             Tab( File& rFile, bool Shift, int CursorIndex );
 	void                             PrepareBoxModeForInput( File& rFile );
 	void                             EnterTextStuff( File& rFile, char C );
-	void                             EnterTextStuff( File& rFile, char C, int CursorIndex );
 	void                             MoveUp( File& rFile, bool Shift, bool Alt );
 	void                             MoveDown( File& rFile, bool Shift, bool Alt );
 	void                             MoveRight( File& rFile, bool Ctrl, bool Shift, bool Alt );
@@ -291,16 +376,47 @@ private:
 	void                             Copy( File& rFile, bool Cut );
 	void                             Paste( File& rFile );
 	void                             SwapLines( File& rFile, bool Up );
+	void                             MoveLine( File& rFile, int From, int To );
 	std::vector< int >               CursorsInText( File& rFile );
 	std::vector< int >               CursorsNotInText( File& rFile );
 	void                             ClearSearch( File& rFile );
-	Coordinate                       SearchInLine( File& rFile, bool CaseSensitive, const std::string& rSearchString, Coordinate LineStart, int SearchStringOffset, std::vector< Glyph* >& rMatches );
-	void                             SearchWorker( File* pFile, bool CaseSensitive, bool WholeWord, const std::string* pSearchString, int StartLine, int EndLine, std::vector< LineSelectionItem >* pResult, int* pState );
-	void                             SearchManager( File* pFile, bool CaseSensitive, bool WholeWord, SearchInstance* Instance );
-	void                             Search( File& rFile, bool CaseSensitve, bool WholeWord, const std::string& rSearchString );
-	void                             JoinThreads( File& rFile, bool WaitForUnfinished );
+	void                             Search( File& rFile, bool CaseSensitve, bool WholeWord, bool RegularExpression, const std::string& rSearchString );
+	void                             CollectSearch( File& rFile );
+	void                             UpdateSearchResults( File& rFile, int FirstLine, int OldLastLine, int NewLastLine );
+	void                             ReplaceSearchResults( File& rFile, bool All );
 	void                             ShowSearchDialog( File& rFile, ImGuiID FocusId, ImGuiWindow* pWindow );
 
+	// A save that is being written by a job. The job works on a snapshot of the buffer, so the file may be edited or closed meanwhile.
+	struct PendingSave
+	{
+		std::filesystem::path Path;
+		JobSystem::JobPtr     Job;
+		std::atomic< bool >   Done    = false;
+		bool                  Success = false;
+	};
+
+	void CollectSaves( void );
+
+	std::vector< std::shared_ptr< PendingSave > > m_Saves;
+
+	//////////////////////////////////////////////////////////////////////////
+
+	// Advances of the characters of the editor font at its current size, so that text is measured without asking ImGui one run at a
+	// time. With a monospaced font, ASCII text is measured by counting columns.
+	struct GlyphAdvances
+	{
+		const ImFont* pFont        = nullptr;
+		float         Size         = 0.0f;
+		float         Scale        = 1.0f;
+		float         Ascii[ 128 ] = { };
+		bool          Monospace    = false;
+		uint32_t      Generation   = 0; // Bumped whenever the advances change, which makes every measurement out of date
+	};
+
+	GlyphAdvances m_Advances;
+
+	//////////////////////////////////////////////////////////////////////////
+
 	Palette m_Palette;
 
 	//////////////////////////////////////////////////////////////////////////
@@ -315,57 +431,73 @@ private:
 
 //////////////////////////////////////////////////////////////////////////
 
+// The results of a search, in order. They are kept in groups of a few hundred, and every group counts the lines of its results from a
+// base line of its own, so an edit that adds or removes lines moves the groups below it by their base alone. The results of a line are
+// found (and replaced, when it is edited) with a binary search for their group and another one within it.
+//
+// The groups themselves are a plain vector. Moving the groups below an edit, inserting a group and counting through the groups to
+// the n-th result (Locate) all take time in the number of groups, not results: a million results make about four thousand groups,
+// which is a few microseconds of adding to ints or moving small headers for each edit. A tree of line offsets would bring that down
+// to a logarithm at the cost of the splits and merges that it would need as groups come and go, which isn't worth it at these sizes.
 class SearchResultGroups
 {
 public:
-	// Results will be grouped in it's own vector for every 1000 lines
-	std::vector< std::vector< TextEdit::LineSelectionItem* > > Groups;
-	// A vector of all the results in order
-	std::vector< TextEdit::LineSelectionItem > Result;
-
-	SearchResultGroups();
-
-	std::vector< TextEdit::LineSelectionItem* >& GetGroup( int LineIndex );
-	bool                                         GroupExist( int LineIndex );
-	void                                         AddResult( const TextEdit::LineSelectionItem& Item );
-	void                                         UpdateGroups();
-	void                                         Clear();
-	size_t                                       Size();
-	bool                                         Empty();
-
-	TextEdit::LineSelectionItem& operator[]( int Index );
-}; // SearchResultGroups
+	using Item = TextEdit::LineSelectionItem;
 
-//////////////////////////////////////////////////////////////////////////
+	// Adds results that are in order. The ones on a line that has results already go after those.
+	void Insert( const std::vector< Item >& rItems );
 
-struct SearchInstance
-{
-	enum
+	// Lines [FirstLine, OldLastLine] have become [FirstLine, NewLastLine]. Their results are replaced by rFound, which are on the new
+	// lines, and the results below them move along.
+	void ReplaceLines( int FirstLine, int OldLastLine, int NewLastLine, const std::vector< Item >& rFound );
+
+	void                GetLine( int LineIndex, std::vector< Item >& rItems ) const;
+	Item                Get    ( size_t Index ) const;
+	void                SetType( size_t Index, int Type );
+	std::vector< Item > All    ( void ) const;
+	size_t              Size   ( void ) const { return m_Size; }
+	bool                Empty  ( void ) const { return m_Size == 0; }
+
+private:
+
+	struct Group
 	{
-		Running,
-		Stopping,
-		Stopped,
-		HasResult
-	};
+		int                 BaseLine = 0;
+		std::vector< Item > Items; // Never empty, with lines counted from BaseLine
 
-	std::thread         Thread;
-	std::string         SearchTerm;
-	SearchResultGroups* Result;
-	int                 State;
-}; // SearchInstance
+	}; // Group
+
+	int                         FirstLine( const Group& rGroup ) const { return rGroup.BaseLine + rGroup.Items.front().Start.y; }
+	int                         LastLine ( const Group& rGroup ) const { return rGroup.BaseLine + rGroup.Items.back().Start.y; }
+	size_t                      FindGroup( int LineIndex ) const;
+	std::pair< size_t, size_t > Locate   ( size_t Index ) const;
+
+	void Append      ( const Item& rItem );
+	void InsertBefore( int LineIndex, std::vector< Item >::const_iterator First, std::vector< Item >::const_iterator Last );
+
+	std::vector< Group > m_Groups;
+	size_t               m_Size = 0;
+
+}; // SearchResultGroups
 
 //////////////////////////////////////////////////////////////////////////
 
 class SearchDialog
 {
 public:
-	bool Searching     = false;
-	bool CaseSensitive = false;
-	bool WholeWord     = false;
-	int  ActiveItem    = -1;
+	~SearchDialog( void ) { delete SearchResult; }
+
+	bool Searching         = false;
+	bool CaseSensitive     = false;
+	bool WholeWord         = false;
+	bool RegularExpression = false;
+	int  ActiveItem        = -1;
 
 	std::string SearchTerm;
+	std::string ReplaceTerm; // $1 and so on stand for the groups of a regular expression (see Regex::Expand)
 
-	std::vector< SearchInstance* > SearchInstances;
-	SearchResultGroups*            SearchResult = nullptr;
+	// The results of the previous search are shown until the new one has found something (or finished), so they don't flicker while typing
+	TextSearch          Finder;
+	SearchResultGroups* SearchResult = nullptr;
+	bool                Restarted    = false;
 }; // SearchDialog
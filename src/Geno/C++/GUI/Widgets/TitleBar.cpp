@@ -20,10 +20,12 @@
 #include "Application.h"
 #include "Auxiliary/STBAux.h"
 #include "Compilers/ICompiler.h"
+#include "Components/TestRunner.h"
 #include "GUI/MainWindow.h"
 #include "GUI/Modals/NewItemModal.h"
 #include "GUI/Modals/OpenFileModal.h"
 #include "GUI/Widgets/OutputWindow.h"
+#include "GUI/Widgets/RunWindow.h"
 #include "GUI/Widgets/TextEdit.h"
 #include "GUI/Widgets/WorkspaceOutliner.h"
 #include "GUI/Widgets/StatusBar.h"
@@ -115,7 +117,9 @@ void TitleBar::Draw( void )
 		if( ImGui::BeginMenu( "Build", WorkspaceActive ) )
 		{
 			if( ImGui::MenuItem( "Build And Run", "F5" ) ) ActionBuildBuildAndRun();
+			if( ImGui::MenuItem( "Build And Run Tests" ) ) ActionBuildBuildAndRunTests();
 			if( ImGui::MenuItem( "Build", "F7" ) ) ActionBuildBuild();
+			if( ImGui::MenuItem( "Build With Insights" ) ) ActionBuildBuildWithInsights();
 
 			ImGui::EndMenu();
 		}
@@ -127,6 +131,9 @@ void TitleBar::Draw( void )
 			ImGui::MenuItem( "Output", "Alt+O", &ShowOutputWindow );
 
 			ImGui::MenuItem( "Find Files in Workspace", "Alt+J", &ShowFindInWorkspaceWindow );
+			ImGui::MenuItem( "Build Insights", "Alt+I", &ShowBuildInsights );
+			ImGui::MenuItem( "Run", "Alt+R", &ShowRunWindow );
+			ImGui::MenuItem( "Test", "Alt+U", &ShowTestWindow );
 
 			ImGui::EndMenu();
 		}
@@ -187,11 +194,7 @@ void TitleBar::Draw( void )
 
 				if( Pressed )
 				{
-					if( Workspace* pWorkspace = Application::Instance().CurrentWorkspace() )
-					{
-						if( pWorkspace->m_AppProcess )
-							pWorkspace->m_AppProcess->Kill();
-					}
+					MainWindow::Instance().pRunWindow->Stop();
 
 					exit( 0 );
 				}
@@ -332,6 +335,9 @@ void TitleBar::Draw( void )
 		if( ImGui::IsKeyPressed( GLFW_KEY_W ) ) ShowWorkspaceOutliner ^= 1;
 		if( ImGui::IsKeyPressed( GLFW_KEY_O ) ) ShowOutputWindow ^= 1;
 		if( ImGui::IsKeyPressed( GLFW_KEY_J ) ) ShowFindInWorkspaceWindow ^= 1;
+		if( ImGui::IsKeyPressed( GLFW_KEY_I ) ) ShowBuildInsights ^= 1;
+		if( ImGui::IsKeyPressed( GLFW_KEY_R ) ) ShowRunWindow ^= 1;
+		if( ImGui::IsKeyPressed( GLFW_KEY_U ) ) ShowTestWindow ^= 1;
 	}
 	else
 	{
@@ -428,29 +434,59 @@ void TitleBar::ActionBuildBuildAndRun( void )
 
 			for( TextEdit::File& rFile : rTextEdit.Files )
 				rTextEdit.SaveFile( rFile );
+
+			// The compiler has to see what was just saved
+			rTextEdit.WaitForSaves();
 		}
 
-		pWorkspace->Events.BuildFinished += []( Workspace& rWorkspace, std::filesystem::path OutputFile, bool /*Success*/ )
+		// The program gets a terminal of its own in the Run panel, so that this job is done as soon as it has started
+		pWorkspace->Events.BuildFinished += [ this ]( Workspace& /*rWorkspace*/, std::filesystem::path OutputFile, bool Success )
 		{
-			StatusBar::Instance().SetColor( StatusBar::Color::ORANGE );
+			if( !Success )
+				return;
 
-			const std::string OutputString = OutputFile.string();
-			const std::wstring OutputWString = OutputFile.wstring();
+			ShowRunWindow = true;
 
-			std::cout << "=== Running " << OutputString << "===\n";
+			MainWindow::Instance().pRunWindow->Start( OutputFile );
+		};
+
+		pWorkspace->Build();
+	}
 
-			rWorkspace.m_AppProcess = std::make_unique<Process>( OutputWString );
+} // ActionBuildBuildAndRun
+
+//////////////////////////////////////////////////////////////////////////
+
+void TitleBar::ActionBuildBuildAndRunTests( void )
+{
+	if( Workspace* pWorkspace = Application::Instance().CurrentWorkspace() )
+	{
+		MainWindow::Instance().pOutputWindow->ClearCapture();
+
+		// Save all open files before building
+		if( MainWindow::Instance().pTextEdit )
+		{
+			TextEdit& rTextEdit = *MainWindow::Instance().pTextEdit;
+
+			for( TextEdit::File& rFile : rTextEdit.Files )
+				rTextEdit.SaveFile( rFile );
+
+			// The compiler has to see what was just saved
+			rTextEdit.WaitForSaves();
+		}
 
-			const int ExitCode = rWorkspace.m_AppProcess->ResultOf();
-			std::cout << "=== " << OutputString << " finished with exit code " << ExitCode << " ===\n";
+		ShowTestWindow = true;
 
-			StatusBar::Instance().SetColor( StatusBar::Color::RED );
+		pWorkspace->Events.BuildFinished += []( Workspace& rWorkspace, std::filesystem::path /*OutputFile*/, bool Success )
+		{
+			if( Success )
+				TestRunner::Instance().Run( rWorkspace.TestExecutables() );
 		};
 
 		pWorkspace->Build();
 	}
 
-} // ActionBuildBuildAndRun
+} // ActionBuildBuildAndRunTests
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -467,6 +503,9 @@ void TitleBar::ActionBuildBuild( void )
 
 			for( TextEdit::File& rFile : rTextEdit.Files )
 				rTextEdit.SaveFile( rFile );
+
+			// The compiler has to see what was just saved
+			rTextEdit.WaitForSaves();
 		}
 
 		pWorkspace->Build();
@@ -476,6 +515,33 @@ void TitleBar::ActionBuildBuild( void )
 
 //////////////////////////////////////////////////////////////////////////
 
+void TitleBar::ActionBuildBuildWithInsights( void )
+{
+	if( Workspace* pWorkspace = Application::Instance().CurrentWorkspace() )
+	{
+		MainWindow::Instance().pOutputWindow->ClearCapture();
+
+		// Save all open files before building
+		if( MainWindow::Instance().pTextEdit )
+		{
+			TextEdit& rTextEdit = *MainWindow::Instance().pTextEdit;
+
+			for( TextEdit::File& rFile : rTextEdit.Files )
+				rTextEdit.SaveFile( rFile );
+
+			// The compiler has to see what was just saved
+			rTextEdit.WaitForSaves();
+		}
+
+		ShowBuildInsights = true;
+
+		pWorkspace->Build( true );
+	}
+
+} // ActionBuildBuildWithInsights
+
+//////////////////////////////////////////////////////////////////////////
+
 void TitleBar::AddBuildMatrixColumn( BuildMatrix::Column& rColumn )
 {
 	ImGui::Spacing();
@@ -51,6 +51,9 @@ public:
 	bool ShowWorkspaceOutliner     = false;
 	bool ShowGenoDiscordSettings   = false;
 	bool ShowFindInWorkspaceWindow = false;
+	bool ShowBuildInsights         = false;
+	bool ShowRunWindow             = false;
+	bool ShowTestWindow            = false;
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -62,7 +65,9 @@ private:
 	void ActionFileOpenRecentWorkspace( std::filesystem::path Path );
 	void ActionFileCloseWorkspace     ( void );
 	void ActionBuildBuildAndRun       ( void );
+	void ActionBuildBuildAndRunTests  ( void );
 	void ActionBuildBuild             ( void );
+	void ActionBuildBuildWithInsights ( void );
 	void AddBuildMatrixColumn         ( BuildMatrix::Column& rColumn );
 
 //////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "CacheServer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+//////////////////////////////////////////////////////////////////////////
+
+static constexpr size_t MaxBlobSize = 512 * 1024 * 1024;
+
+//////////////////////////////////////////////////////////////////////////
+
+CacheServer::CacheServer( std::filesystem::path Directory )
+	: m_Directory( std::move( Directory ) )
+{
+
+} // CacheServer
+
+//////////////////////////////////////////////////////////////////////////
+
+int CacheServer::Run( const std::vector< std::string >& rEndpoints )
+{
+	std::vector< std::thread > Listeners;
+	std::error_code            Error;
+
+	std::filesystem::create_directories( m_Directory, Error );
+
+	for( const std::string& rEndpoint : rEndpoints )
+	{
+		Socket Listener = Socket::Listen( rEndpoint );
+		if( !Listener )
+			return 1;
+
+		std::cout << "Serving cache " << m_Directory.string() << " on " << rEndpoint << std::endl;
+
+		Listeners.emplace_back( &CacheServer::Listen, this, std::move( Listener ) );
+	}
+
+	for( std::thread& rListener : Listeners )
+		rListener.join();
+
+	return 0;
+
+} // Run
+
+//////////////////////////////////////////////////////////////////////////
+
+void CacheServer::Listen( Socket Listener )
+{
+	while( Listener )
+	{
+		if( Socket Connection = Listener.Accept() )
+			std::thread( &CacheServer::Serve, this, std::move( Connection ) ).detach();
+	}
+
+} // Listen
+
+//////////////////////////////////////////////////////////////////////////
+
+void CacheServer::Serve( Socket Connection )
+{
+	HTTP::Connection HTTPConnection( std::move( Connection ) );
+
+	// Clients may pipeline their requests. Those simply wait in the connection until we get to them, and are answered in order.
+	while( std::optional< HTTP::Request > Request = HTTPConnection.ReceiveRequest( MaxBlobSize ) )
+	{
+		HTTP::Response Response = Handle( *Request );
+		Response.KeepAlive      = Request->KeepAlive;
+
+		if( !HTTPConnection.SendResponse( Response ) || !Response.KeepAlive )
+			break;
+	}
+
+} // Serve
+
+//////////////////////////////////////////////////////////////////////////
+
+HTTP::Response CacheServer::Handle( const HTTP::Request& rRequest )
+{
+	HTTP::Response                               Response;
+	const std::optional< std::filesystem::path > Path = PathFor( rRequest.Path );
+
+	if( !Path )
+	{
+		Response.Status = 400;
+		return Response;
+	}
+
+	if( rRequest.Method == "GET" )
+	{
+		std::ifstream File( *Path, std::ios::binary );
+
+		if( !File )
+		{
+			Response.Status = 404;
+			return Response;
+		}
+
+		std::stringstream Stream;
+		Stream << File.rdbuf();
+
+		Response.Status = 200;
+		Response.Body   = Stream.str();
+	}
+	else if( rRequest.Method == "PUT" )
+	{
+		// Write to a temporary file first, so that concurrent readers never see a partial blob
+		const std::filesystem::path UploadPath = m_Directory / ( ".upload-" + std::to_string( m_NextUploadID++ ) );
+		std::error_code             Error;
+
+		std::filesystem::create_directories( Path->parent_path(), Error );
+
+		{
+			std::ofstream File( UploadPath, std::ios::binary | std::ios::trunc );
+			File.write( rRequest.Body.data(), static_cast< std::streamsize >( rRequest.Body.size() ) );
+
+			if( !File )
+			{
+				Response.Status = 500;
+				return Response;
+			}
+		}
+
+		std::filesystem::rename( UploadPath, *Path, Error );
+
+		Response.Status = Error ? 500 : 200;
+	}
+	else
+	{
+		Response.Status = 405;
+	}
+
+	return Response;
+
+} // Handle
+
+//////////////////////////////////////////////////////////////////////////
+
+std::optional< std::filesystem::path > CacheServer::PathFor( std::string_view RequestPath ) const
+{
+	while( !RequestPath.empty() && RequestPath.front() == '/' )
+		RequestPath.remove_prefix( 1 );
+
+	if( RequestPath.empty() )
+		return std::nullopt;
+
+	// Keys are hashes under an optional prefix, so anything else (in particular '..') is rejected rather than escaped
+	for( const char C : RequestPath )
+	{
+		if( !std::isalnum( static_cast< unsigned char >( C ) ) && C != '/' && C != '-' && C != '_' && C != '.' )
+			return std::nullopt;
+	}
+
+	std::filesystem::path Path = m_Directory;
+
+	for( size_t Start = 0; Start <= RequestPath.size(); )
+	{
+		const size_t           End     = std::min( RequestPath.find( '/', Start ), RequestPath.size() );
+		const std::string_view Segment = RequestPath.substr( Start, End - Start );
+
+		if( Segment.empty() || Segment.front() == '.' )
+			return std::nullopt;
+
+		Path  /= Segment;
+		Start  = End + 1;
+	}
+
+	return Path;
+
+} // PathFor
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include <Common/Macros.h>
+#include <Common/Network/HTTP.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Stand-in for a remote artifact cache. Blobs are stored as files below a directory and served with plain GET/PUT, in the
+// same way as the HTTP interfaces of bazel-remote and sccache.
+class CacheServer
+{
+	GENO_DISABLE_COPY_AND_MOVE( CacheServer );
+
+//////////////////////////////////////////////////////////////////////////
+
+public:
+
+	explicit CacheServer( std::filesystem::path Directory );
+
+//////////////////////////////////////////////////////////////////////////
+
+	int Run( const std::vector< std::string >& rEndpoints );
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	void                                   Listen ( Socket Listener );
+	void                                   Serve  ( Socket Connection );
+	HTTP::Response                         Handle ( const HTTP::Request& rRequest );
+	std::optional< std::filesystem::path > PathFor( std::string_view RequestPath ) const;
+
+//////////////////////////////////////////////////////////////////////////
+
+	std::filesystem::path   m_Directory;
+	std::atomic< uint64_t > m_NextUploadID = 0;
+
+}; // CacheServer
@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "Worker.h"
+
+#include <Common/Process.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+//////////////////////////////////////////////////////////////////////////
+
+// Every request compiles the same file in a directory of its own, so nothing that a client sends ends up in a path
+static constexpr std::string_view InputFileName = "input.ii";
+
+// Flags that are passed on to the compiler as they are. Anything else is refused, since a compiler can be told to run other programs,
+// to load plugins or to write files wherever it is told to.
+static constexpr std::string_view SafeFlags[]        = { "-c", "-v", "-w", "-time", "-pipe", "-ansi", "-pedantic", "-pedantic-errors" };
+static constexpr std::string_view SafeFlagPrefixes[] = { "-O", "-g", "-f", "-m", "-W", "-std=", "-D", "-U" };
+
+// Within the above, the ones that run or load code, read files of the worker, or write files of their own choosing
+static constexpr std::string_view UnsafeFlagPrefixes[] = { "-fplugin", "-fmodule", "-fdump", "-fopt-info", "-fcallgraph-info", "-fcompare-debug", "-fprofile", "-fauto-profile",
+                                                           "-fdeps", "-fdiagnostics-format", "-fdiagnostics-add-output", "-fdiagnostics-set-output", "-fuse-ld" };
+
+//////////////////////////////////////////////////////////////////////////
+
+static std::string ReadWholeFile( const std::filesystem::path& rPath )
+{
+	std::ifstream     File( rPath, std::ios::binary );
+	std::stringstream Stream;
+
+	if( File )
+		Stream << File.rdbuf();
+
+	return Stream.str();
+
+} // ReadWholeFile
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool IsSafeFlag( std::string_view Flag )
+{
+	const auto StartsWith = [ Flag ]( std::string_view Prefix ) { return Flag.starts_with( Prefix ); };
+
+	if( std::find( std::begin( SafeFlags ), std::end( SafeFlags ), Flag ) != std::end( SafeFlags ) )
+		return true;
+
+	if( std::none_of( std::begin( SafeFlagPrefixes ), std::end( SafeFlagPrefixes ), StartsWith ) || std::any_of( std::begin( UnsafeFlagPrefixes ), std::end( UnsafeFlagPrefixes ), StartsWith ) )
+		return false;
+
+	// -Wa, -Wl and -Wp pass options on to the assembler, the linker and the preprocessor
+	return !( Flag.starts_with( "-W" ) && Flag.find( ',' ) != std::string_view::npos );
+
+} // IsSafeFlag
+
+//////////////////////////////////////////////////////////////////////////
+
+// The output may only be named through its placeholder, and the input only ever is the placeholder
+static std::optional< std::string_view > FindUnsafeArgument( const std::vector< std::string >& rArguments )
+{
+	for( size_t i = 0; i < rArguments.size(); ++i )
+	{
+		const std::string_view Argument = rArguments[ i ];
+		const bool             HasValue = ( i + 1 < rArguments.size() );
+
+		if( Argument == RemoteCompile::InputPlaceholder )
+			continue;
+
+		if( ( Argument == "-o" && HasValue && rArguments[ i + 1 ] == RemoteCompile::OutputPlaceholder ) || ( Argument == "-x" && HasValue ) )
+		{
+			++i;
+			continue;
+		}
+
+		if( !IsSafeFlag( Argument ) )
+			return Argument;
+	}
+
+	return std::nullopt;
+
+} // FindUnsafeArgument
+
+//////////////////////////////////////////////////////////////////////////
+
+Worker::Worker( Options Options )
+	: m_Options( std::move( Options ) )
+{
+
+} // Worker
+
+//////////////////////////////////////////////////////////////////////////
+
+int Worker::Run( void )
+{
+	std::vector< std::thread > Listeners;
+
+	for( const std::string& rEndpoint : m_Options.Endpoints )
+	{
+		Socket Listener = Socket::Listen( rEndpoint );
+		if( !Listener )
+			return 1;
+
+		std::cout << "Listening on " << rEndpoint << " with " << m_Options.Slots << " slot(s)" << std::endl;
+
+		// There is no authentication, so whoever can connect gets to use the compilers
+		if( !rEndpoint.starts_with( "unix:" ) && !rEndpoint.starts_with( "127." ) && !rEndpoint.starts_with( "localhost:" ) && !rEndpoint.starts_with( "[::1]:" ) )
+			std::cerr << "Warning: " << rEndpoint << " accepts jobs from other machines, and anyone who can reach it may run the allowed compilers\n";
+
+		Listeners.emplace_back( &Worker::Listen, this, std::move( Listener ) );
+	}
+
+	for( std::thread& rListener : Listeners )
+		rListener.join();
+
+	return 0;
+
+} // Run
+
+//////////////////////////////////////////////////////////////////////////
+
+void Worker::Listen( Socket Listener )
+{
+	while( Listener )
+	{
+		Socket Connection = Listener.Accept();
+
+		// Each client keeps its connection open for as long as it has work, so give every connection a thread of its own
+		if( Connection )
+			std::thread( &Worker::Serve, this, std::move( Connection ) ).detach();
+	}
+
+} // Listen
+
+//////////////////////////////////////////////////////////////////////////
+
+void Worker::Serve( Socket Connection )
+{
+	while( std::optional< std::string > Frame = Connection.ReceiveFrame( RemoteCompile::MaxFrameSize ) )
+	{
+		const std::optional< RemoteCompile::MessageType > Type = RemoteCompile::TypeOf( *Frame );
+		if( !Type )
+			break;
+
+		switch( *Type )
+		{
+			case RemoteCompile::MessageType::Hello:
+			{
+				std::optional< RemoteCompile::Hello > Hello = RemoteCompile::DecodeHello( *Frame );
+				if( !Hello )
+					return;
+
+				// Clients speaking another version of the protocol are told ours, and are expected to hang up
+				Hello->Version = RemoteCompile::ProtocolVersion;
+				Hello->Slots   = m_Options.Slots;
+
+				if( !Connection.SendFrame( RemoteCompile::Encode( *Hello ) ) )
+					return;
+
+			} break;
+
+			case RemoteCompile::MessageType::CompileRequest:
+			{
+				std::optional< RemoteCompile::CompileRequest > Request = RemoteCompile::DecodeCompileRequest( *Frame );
+				if( !Request )
+					return;
+
+				if( !Connection.SendFrame( RemoteCompile::Encode( Compile( *Request ) ) ) )
+					return;
+
+			} break;
+
+			default:
+			{
+				std::cerr << "Unexpected message " << static_cast< int >( *Type ) << ", closing connection\n";
+				return;
+			}
+		}
+	}
+
+} // Serve
+
+//////////////////////////////////////////////////////////////////////////
+
+RemoteCompile::CompileResult Worker::Compile( const RemoteCompile::CompileRequest& rRequest )
+{
+	RemoteCompile::CompileResult Result;
+
+	const std::filesystem::path* pCompiler = FindCompiler( rRequest.Compiler );
+
+	if( !pCompiler )
+	{
+		Result.Diagnostics = "geno-worker: refusing to run '" + rRequest.Compiler + "', which is not one of the allowed compilers\n";
+		return Result;
+	}
+
+	if( std::optional< std::string_view > Refused = FindUnsafeArgument( rRequest.Arguments ) )
+	{
+		Result.Diagnostics = "geno-worker: refusing to pass '" + std::string( *Refused ) + "' to the compiler\n";
+		return Result;
+	}
+
+	const uint64_t              JobID           = m_NextJobID++;
+	const std::filesystem::path JobDir          = m_Options.TempDir / ( "job-" + std::to_string( JobID ) );
+	const std::filesystem::path InputPath       = JobDir / InputFileName;
+	const std::filesystem::path OutputPath      = JobDir / "output.o";
+	const std::filesystem::path DiagnosticsPath = JobDir / "diagnostics.txt";
+	std::error_code             Error;
+
+	std::filesystem::create_directories( JobDir, Error );
+
+	{
+		std::ofstream Input( InputPath, std::ios::binary | std::ios::trunc );
+		Input.write( rRequest.Source.data(), static_cast< std::streamsize >( rRequest.Source.size() ) );
+
+		if( !Input )
+		{
+			Result.Diagnostics = "geno-worker: failed to write " + InputPath.string() + "\n";
+			std::filesystem::remove_all( JobDir, Error );
+			return Result;
+		}
+	}
+
+	// The compiler is started directly, so the arguments reach it as they are and nothing is up for a shell to interpret
+	std::vector< std::string > Arguments = { pCompiler->string() };
+
+	for( const std::string& rArgument : rRequest.Arguments )
+	{
+		if( rArgument == RemoteCompile::InputPlaceholder )
+			Arguments.push_back( InputPath.string() );
+		else if( rArgument == RemoteCompile::OutputPlaceholder )
+			Arguments.push_back( OutputPath.string() );
+		else
+			Arguments.push_back( rArgument );
+	}
+
+	FILE* pDiagnostics = fopen( DiagnosticsPath.string().c_str(), "wb" );
+
+	if( !pDiagnostics )
+	{
+		Result.Diagnostics = "geno-worker: failed to open " + DiagnosticsPath.string() + "\n";
+		std::filesystem::remove_all( JobDir, Error );
+		return Result;
+	}
+
+	AcquireSlot();
+
+	const auto Start = std::chrono::steady_clock::now();
+	Process    CompileProcess;
+
+	CompileProcess.SetArguments( std::move( Arguments ) );
+	Result.ExitCode = CompileProcess.Start( pDiagnostics ) ? CompileProcess.Wait() : -1;
+
+	ReleaseSlot();
+
+	fclose( pDiagnostics );
+
+	const auto Duration = std::chrono::duration_cast< std::chrono::milliseconds >( std::chrono::steady_clock::now() - Start );
+
+	Result.Diagnostics = ReadWholeFile( DiagnosticsPath );
+
+	if( Result.ExitCode == 0 )
+		Result.Object = ReadWholeFile( OutputPath );
+
+	std::cout << "Job " << JobID << ": exit code " << Result.ExitCode << " after " << Duration.count() << " ms" << std::endl;
+
+	std::filesystem::remove_all( JobDir, Error );
+
+	return Result;
+
+} // Compile
+
+//////////////////////////////////////////////////////////////////////////
+
+const std::filesystem::path* Worker::FindCompiler( std::string_view Name ) const
+{
+	// Only the compilers that we were told to trust run, from where they were found when the worker started
+	for( const std::filesystem::path& rCompiler : m_Options.Compilers )
+	{
+		if( rCompiler.filename().string() == Name || rCompiler.stem().string() == Name )
+			return &rCompiler;
+	}
+
+	return nullptr;
+
+} // FindCompiler
+
+//////////////////////////////////////////////////////////////////////////
+
+void Worker::AcquireSlot( void )
+{
+	std::unique_lock Lock( m_SlotsMutex );
+
+	m_SlotsAvailable.wait( Lock, [ this ]( void ) { return m_SlotsInUse < m_Options.Slots; } );
+
+	++m_SlotsInUse;
+
+} // AcquireSlot
+
+//////////////////////////////////////////////////////////////////////////
+
+void Worker::ReleaseSlot( void )
+{
+	{
+		std::scoped_lock Lock( m_SlotsMutex );
+		--m_SlotsInUse;
+	}
+
+	m_SlotsAvailable.notify_one();
+
+} // ReleaseSlot
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+#include <Common/Macros.h>
+#include <Common/Network/RemoteCompile.h>
+#include <Common/Network/Socket.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Worker
+{
+	GENO_DISABLE_COPY_AND_MOVE( Worker );
+
+//////////////////////////////////////////////////////////////////////////
+
+public:
+
+	struct Options
+	{
+		std::vector< std::string >           Endpoints;
+		std::vector< std::filesystem::path > Compilers; // Full paths. Requests pick one by its file name.
+		std::filesystem::path                TempDir;
+		uint32_t                             Slots = 1;
+
+	}; // Options
+
+//////////////////////////////////////////////////////////////////////////
+
+	explicit Worker( Options Options );
+
+//////////////////////////////////////////////////////////////////////////
+
+	int Run( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+private:
+
+	void                         Listen      ( Socket Listener );
+	void                         Serve       ( Socket Connection );
+	RemoteCompile::CompileResult Compile     ( const RemoteCompile::CompileRequest& rRequest );
+	const std::filesystem::path* FindCompiler( std::string_view Name ) const;
+	void                         AcquireSlot ( void );
+	void                         ReleaseSlot ( void );
+
+//////////////////////////////////////////////////////////////////////////
+
+	Options                 m_Options;
+
+	std::mutex              m_SlotsMutex;
+	std::condition_variable m_SlotsAvailable;
+	uint32_t                m_SlotsInUse = 0;
+
+	std::atomic< uint64_t > m_NextJobID  = 0;
+
+}; // Worker
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2021 Sebastian Kylander https://gaztin.com/
+ *
+ * This software is provided 'as-is', without any express or implied warranty. In no event will
+ * the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+ *    original software. If you use this software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+ *    being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "CacheServer.h"
+#include "Worker.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#if defined( _WIN32 )
+#include <process.h>
+#define getpid _getpid
+#elif defined( __linux__ ) || defined( __APPLE__ ) // _WIN32
+#include <unistd.h>
+#endif // __linux__ || __APPLE__
+
+//////////////////////////////////////////////////////////////////////////
+
+static constexpr std::string_view DefaultCacheEndpoint = "127.0.0.1:7830";
+
+#if defined( _WIN32 )
+static constexpr char PathSeparator = ';';
+#else // _WIN32
+static constexpr char PathSeparator = ':';
+#endif // !_WIN32
+
+//////////////////////////////////////////////////////////////////////////
+
+static void PrintUsage( void )
+{
+	std::cout << "Usage: geno-worker [options]\n"
+	          << "  --listen <endpoint>  Accept jobs on 'host:port' or 'unix:/path'. May be repeated. Default: " << RemoteCompile::DefaultEndpoint << "\n"
+	          << "  --slots <count>      Number of jobs to run concurrently. Default: number of hardware threads\n"
+	          << "  --temp <directory>   Where to keep the files of running jobs\n"
+	          << "  --allow <compiler>   Also accept jobs for this compiler, by path or by name in PATH. Default: gcc, g++, cc, c++\n"
+	          << "  --cache <directory>  Instead of compiling, serve a GET/PUT artifact cache from this directory. Default endpoint: " << DefaultCacheEndpoint << "\n";
+
+} // PrintUsage
+
+//////////////////////////////////////////////////////////////////////////
+
+// Requests name a compiler by its file name alone, so every compiler is pinned to a full path up front. Names without a directory are
+// looked up in PATH the way a shell would, and the first one found is the only one that runs.
+static std::filesystem::path FindExecutable( const std::filesystem::path& rName )
+{
+	std::error_code Error;
+
+	if( rName.has_parent_path() )
+		return std::filesystem::is_regular_file( rName, Error ) ? std::filesystem::absolute( rName, Error ) : std::filesystem::path();
+
+	const char*      pPath = std::getenv( "PATH" );
+	std::string_view Path  = pPath ? pPath : "";
+
+	while( !Path.empty() )
+	{
+		const size_t           End       = std::min( Path.find( PathSeparator ), Path.size() );
+		const std::string_view Directory = Path.substr( 0, End );
+
+		Path.remove_prefix( std::min( End + 1, Path.size() ) );
+
+		if( Directory.empty() )
+			continue;
+
+		std::filesystem::path Candidate = std::filesystem::path( Directory ) / rName;
+
+#if defined( _WIN32 )
+		if( !Candidate.has_extension() )
+			Candidate += ".exe";
+#endif // _WIN32
+
+		if( std::filesystem::is_regular_file( Candidate, Error ) )
+			return std::filesystem::absolute( Candidate, Error );
+	}
+
+	return { };
+
+} // FindExecutable
+
+//////////////////////////////////////////////////////////////////////////
+
+int main( int NumArgs, char** ppArgs )
+{
+	Worker::Options                      Options;
+	std::filesystem::path                CacheDir;
+	std::vector< std::filesystem::path > Compilers = { "gcc", "g++", "cc", "c++" };
+	Options.Slots                                  = std::max( 1u, std::thread::hardware_concurrency() );
+
+	for( int i = 1; i < NumArgs; ++i )
+	{
+		const std::string_view Arg      = ppArgs[ i ];
+		const bool             HasValue = ( i + 1 < NumArgs );
+
+		if( Arg == "--listen" && HasValue )
+		{
+			Options.Endpoints.emplace_back( ppArgs[ ++i ] );
+		}
+		else if( Arg == "--slots" && HasValue )
+		{
+			const std::string_view Value = ppArgs[ ++i ];
+
+			if( std::from_chars( Value.data(), Value.data() + Value.size(), Options.Slots ).ec != std::errc() || Options.Slots == 0 )
+			{
+				std::cerr << "Invalid slot count: " << Value << "\n";
+				return 1;
+			}
+		}
+		else if( Arg == "--temp" && HasValue )
+		{
+			Options.TempDir = ppArgs[ ++i ];
+		}
+		else if( Arg == "--allow" && HasValue )
+		{
+			Compilers.emplace_back( ppArgs[ ++i ] );
+		}
+		else if( Arg == "--cache" && HasValue )
+		{
+			CacheDir = ppArgs[ ++i ];
+		}
+		else
+		{
+			PrintUsage();
+			return ( Arg == "--help" || Arg == "-h" ) ? 0 : 1;
+		}
+	}
+
+	if( !CacheDir.empty() )
+	{
+		if( Options.Endpoints.empty() )
+			Options.Endpoints.emplace_back( DefaultCacheEndpoint );
+
+		return CacheServer( std::move( CacheDir ) ).Run( Options.Endpoints );
+	}
+
+	if( Options.Endpoints.empty() )
+		Options.Endpoints.emplace_back( RemoteCompile::DefaultEndpoint );
+
+	for( const std::filesystem::path& rCompiler : Compilers )
+	{
+		if( std::filesystem::path Executable = FindExecutable( rCompiler ); !Executable.empty() )
+			Options.Compilers.push_back( std::move( Executable ) );
+		else
+			std::cerr << "Compiler " << rCompiler << " was not found\n";
+	}
+
+	// Several workers may run on the same machine, so keep their files apart
+	if( Options.TempDir.empty() )
+	{
+		std::error_code Error;
+		Options.TempDir = std::filesystem::temp_directory_path( Error ) / ( "geno-worker-" + std::to_string( getpid() ) );
+	}
+
+	return Worker( std::move( Options ) ).Run();
+
+} // main